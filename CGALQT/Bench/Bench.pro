@@ -0,0 +1,18 @@
+# the console benchmarks, qmake then make in this directory
+TEMPLATE      = subdirs
+SUBDIRS       = bench_obj.pro \
+	bench_off.pro \
+	bench_cache.pro \
+	bench_write.pro \
+	bench_archive.pro \
+	bench_fan.pro \
+	bench_subdivision.pro \
+	bench_kernel.pro \
+	bench_reorder.pro \
+	bench_allocator.pro \
+	bench_smooth.pro \
+	bench_refine.pro \
+	bench_schemes.pro \
+	bench_stencils.pro \
+	bench_compressed.pro \
+
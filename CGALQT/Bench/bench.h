@@ -0,0 +1,323 @@
+/************************************************************************/
+/* bench.h                                                              */
+/* timer, command line, model loading and the operations of the       */
+/* Subdivision menu, the same way GLMdiChild runs them, for any mesh    */
+/* and kernel                                                           */
+/************************************************************************/
+#ifndef BENCH_H
+#define BENCH_H
+
+//stl
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <string>
+#include <algorithm>
+
+//cgal
+#include "parser_off.h"
+#include "parser_obj.h"
+#include "sqrt3.h"
+#include "quad-triangle.h"
+#include "subdivision.h"
+#include <CGAL/Subdivision_method_3.h>
+
+//boost
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <boost/filesystem/operations.hpp>
+
+//posix_fadvise
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/************************************************************************/
+/* timing                                                               */
+/************************************************************************/
+class Stopwatch
+{
+public:
+	Stopwatch() { m_start = boost::posix_time::microsec_clock::local_time(); }
+	double ms() const
+	{
+		return (boost::posix_time::microsec_clock::local_time() - m_start).total_microseconds() / 1000.0;
+	}
+private:
+	boost::posix_time::ptime m_start;
+};
+
+struct Timing
+{
+	double build;
+	double subdivide;
+	double normals;
+	std::size_t facets;
+	bool ok;
+	Timing() : build(0.0), subdivide(0.0), normals(0.0), facets(0), ok(false) {}
+};
+
+/************************************************************************/
+/* command line and model                                               */
+/************************************************************************/
+
+// model [iterations] [max threads] [repeats], no max threads or 0 for
+// every core
+struct Bench_args
+{
+	const char *pModel;
+	int iter;
+	unsigned int max_threads;
+	int repeats;
+
+	Bench_args(int default_iter, int default_repeats = 1)
+		: pModel(NULL), iter(default_iter), max_threads(0), repeats(default_repeats) {}
+
+	// false after printing the usage when the model is missing,
+	// 'pOptions' are the arguments the benchmark reads after it
+	bool parse(int argc, char *argv[], const char *pOptions = "[iterations] [max threads] [repeats]")
+	{
+		if(argc < 2)
+		{
+			std::cerr << "usage: " << argv[0] << " model.off|model.obj " << pOptions << std::endl;
+			return false;
+		}
+		pModel = argv[1];
+		if(argc > 2)
+			iter = std::atoi(argv[2]);
+		if(argc > 3)
+			max_threads = (unsigned int)std::atoi(argv[3]);
+		if(max_threads == 0)
+			max_threads = ParallelUtils::nb_threads();
+		if(argc > 4)
+			repeats = std::max(1,std::atoi(argv[4]));
+		return true;
+	}
+};
+
+// .obj through Parser_obj, anything else through Parser_off, both
+// may be .gz or .zst
+template <class Kernel>
+bool read_model(const char *pFilename, Indexed_mesh<typename Kernel::FT>& arrays, std::string& error)
+{
+	std::string name(pFilename);
+	if(Compression::from_filename(pFilename) != Compression::NONE)
+		name.erase(name.rfind('.'));
+	std::string extension = name.substr(std::min(name.size(),name.rfind('.')));
+
+	if(StringUtils::CompareNoCase(extension,".obj") == 0)
+	{
+		Parser_obj<Kernel,Enriched_items> parser;
+		if(parser.read(pFilename,arrays))
+			return true;
+		error = parser.error();
+		return false;
+	}
+	Parser_off<typename Kernel::FT> parser;
+	if(parser.read(pFilename,arrays))
+		return true;
+	error = parser.error();
+	return false;
+}
+
+// read_model(), false after printing the error, otherwise the size of
+// the model is printed
+template <class Kernel>
+bool load_model(const char *pFilename, Indexed_mesh<typename Kernel::FT>& arrays)
+{
+	std::string error;
+	if(!read_model<Kernel>(pFilename,arrays,error))
+	{
+		std::cerr << pFilename << ": " << error << std::endl;
+		return false;
+	}
+	std::cout << pFilename << ": " << arrays.size_of_vertices() << " vertices, "
+		<< arrays.size_of_facets() << " facets" << std::endl;
+	return true;
+}
+
+// 'copies' copies of the model side by side along x, one bounding
+// box width apart, to scale a model up
+template <class FT>
+void replicate(const Indexed_mesh<FT>& model, int copies, Indexed_mesh<FT>& arrays)
+{
+	FT lo = 0, hi = 0;
+	for(std::size_t i = 0; i < model.points.size(); i += 3)
+	{
+		lo = i ? std::min(lo,model.points[i]) : model.points[i];
+		hi = i ? std::max(hi,model.points[i]) : model.points[i];
+	}
+	FT width = (hi - lo) * (FT)1.1;
+
+	std::size_t nb_vertices = model.size_of_vertices();
+	arrays.clear();
+	arrays.reserve(copies*nb_vertices,copies*model.size_of_facets(),copies*model.size_of_indices());
+	for(int c = 0; c < copies; c++)
+	{
+		for(std::size_t i = 0; i < model.points.size(); i += 3)
+		{
+			arrays.points.push_back(model.points[i] + c*width);
+			arrays.points.push_back(model.points[i+1]);
+			arrays.points.push_back(model.points[i+2]);
+		}
+		for(std::size_t f = 0; f < model.size_of_facets(); f++)
+		{
+			for(unsigned int i = model.facet_begin[f]; i < model.facet_begin[f+1]; i++)
+				arrays.facet_vertices.push_back(model.facet_vertices[i] + (int)(c*nb_vertices));
+			arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+		}
+	}
+}
+
+// a new file name in the temporary directory, 'pSuffix' gives the format
+inline std::string temporary_filename(const char *pSuffix)
+{
+	boost::filesystem::path path = boost::filesystem::temp_directory_path() /
+		boost::filesystem::unique_path(std::string("cgalqt-%%%%%%%%") + pSuffix);
+	return path.string();
+}
+
+// the size of a file in MB
+inline double file_mb(const std::string& filename)
+{
+	return boost::filesystem::file_size(filename)/(1024.0*1024.0);
+}
+
+// drops the pages of the file from the page cache so that the next
+// read comes from the disk, false where the system can not
+inline bool drop_cache(const char *pFilename)
+{
+#if defined(_WIN32) || !defined(POSIX_FADV_DONTNEED)
+	(void)pFilename;
+	return false;
+#else
+	int fd = open(pFilename,O_RDONLY);
+	if(fd < 0)
+		return false;
+	// written pages must be clean to be dropped
+	fdatasync(fd);
+	bool ok = posix_fadvise(fd,0,0,POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+	return ok;
+#endif
+}
+
+/************************************************************************/
+/* operations                                                           */
+/************************************************************************/
+template <class Mesh, class kernel>
+struct Sqrt3_op
+{
+	static bool run(Mesh *&pMesh, int iter)
+	{
+		CSubdivider_sqrt3<Mesh,kernel> subdivider;
+		return subdivider.subdivide(*pMesh,iter);
+	}
+};
+
+template <class Mesh, class kernel>
+struct Quad_triangle_op
+{
+	static bool run(Mesh *&pMesh, int iter)
+	{
+		CSubdivider_quad_triangle<Mesh,kernel> subdivider;
+		for(int i = 0; i < iter; i++)
+		{
+			Mesh *pNewMesh = new Mesh;
+			subdivider.subdivide(*pMesh,*pNewMesh,true);
+			pNewMesh->copy_bounding_box(pMesh);
+			delete pMesh;
+			pMesh = pNewMesh;
+		}
+		return true;
+	}
+};
+
+// CGAL::Subdivision_method_3 works on Polyhedron_3 only and edits
+// the HalfedgeDS directly, the cached degrees are counted again
+template <class Polyhedron>
+struct Doosabin_op
+{
+	static bool run(Polyhedron *&pMesh, int iter) { CGAL::Subdivision_method_3::DooSabin_subdivision(*pMesh,iter); pMesh->compute_degrees(); return true; }
+};
+template <class Polyhedron>
+struct Catmullclark_op
+{
+	static bool run(Polyhedron *&pMesh, int iter) { CGAL::Subdivision_method_3::CatmullClark_subdivision(*pMesh,iter); pMesh->compute_degrees(); return true; }
+};
+template <class Polyhedron>
+struct Loop_op
+{
+	static bool run(Polyhedron *&pMesh, int iter) { CGAL::Subdivision_method_3::Loop_subdivision(*pMesh,iter); pMesh->compute_degrees(); return true; }
+};
+
+// the same schemes on flat arrays, for both meshes
+template <class Mesh, class kernel>
+struct Doosabin_arrays_op
+{
+	static bool run(Mesh *&pMesh, int iter) { CSubdivider_doo_sabin<Mesh,kernel> subdivider; return subdivider.subdivide(*pMesh,iter); }
+};
+template <class Mesh, class kernel>
+struct Catmullclark_arrays_op
+{
+	static bool run(Mesh *&pMesh, int iter) { CSubdivider_catmull_clark<Mesh,kernel> subdivider; return subdivider.subdivide(*pMesh,iter); }
+};
+template <class Mesh, class kernel>
+struct Loop_arrays_op
+{
+	static bool run(Mesh *&pMesh, int iter) { CSubdivider_loop<Mesh,kernel> subdivider; return subdivider.subdivide(*pMesh,iter); }
+};
+
+// builds the mesh from 'arrays', runs Op and computes the normals,
+// the mesh is kept in *ppResult if asked for
+template <class Mesh, class Op, class Arrays>
+Timing bench(const Arrays& arrays, int iter, Mesh **ppResult = NULL)
+{
+	Timing t;
+	std::string error;
+	Mesh *pMesh = new Mesh;
+
+	Stopwatch build;
+	if(!pMesh->build(arrays,error))
+	{
+		std::cerr << "build: " << error << std::endl;
+		delete pMesh;
+		return t;
+	}
+	pMesh->compute_bounding_box();
+	t.build = build.ms();
+
+	Stopwatch subdivide;
+	t.ok = Op::run(pMesh,iter);
+	t.subdivide = subdivide.ms();
+
+	Stopwatch normals;
+	pMesh->compute_type();
+	pMesh->compute_normals();
+	pMesh->compute_bounding_box();
+	t.normals = normals.ms();
+
+	t.facets = pMesh->size_of_facets();
+	if(ppResult)
+		*ppResult = pMesh;
+	else
+		delete pMesh;
+	return t;
+}
+
+inline void print_timing(const char *pName, const Timing& t)
+{
+	std::cout << "  " << std::left << std::setw(14) << pName << std::right;
+	if(!t.ok)
+	{
+		std::cout << "failed" << std::endl;
+		return;
+	}
+	std::cout << std::fixed << std::setprecision(2)
+		<< "build " << std::setw(10) << t.build << " ms  "
+		<< "subdivide " << std::setw(10) << t.subdivide << " ms  "
+		<< "normals " << std::setw(9) << t.normals << " ms  "
+		<< t.facets << " facets" << std::endl;
+}
+
+#endif
@@ -0,0 +1,32 @@
+# shared by the console benchmarks: each .pro sets TARGET, its source
+# and the headers it adds, then includes this file
+TEMPLATE      = app
+CONFIG       += console stl
+CONFIG       -= app_bundle
+
+HEADERS += ./bench.h \
+	../CGAL/enriched_polyhedron.h \
+	../CGAL/mesh_kernel.h \
+	../CGAL/mesh_render.h \
+	../CGAL/indexed_mesh.h \
+	../CGAL/sqrt3.h \
+	../CGAL/quad-triangle.h \
+	../CGAL/subdivision.h \
+	../CGAL/parser_off.h \
+	../CGAL/parser_obj.h \
+	../Util/compressedfile.h \
+
+SOURCES += ../Util/uglyfont.cpp
+
+QT           += opengl
+
+INCLUDEPATH += .. ../CGAL ../Util $(BOOSTROOT) $(CGALROOT)/include
+
+LIBS += -L$(CGALROOT)/lib -L$(BOOSTROOT)/stage/lib
+
+# the libraries of ../CGALQT.pro, and date_time for the Stopwatch
+#DEFINES += CGALQT_NO_ZSTD
+unix:LIBS += -lboost_iostreams -lboost_filesystem -lboost_thread -lboost_date_time -lboost_system -lz
+unix:!contains(DEFINES, CGALQT_NO_ZSTD):LIBS += -lzstd
+
+win32:DEFINES += NOMINMAX _SECURE_SCL=0 _CRT_SECURE_NO_DEPRECATE _SCL_SECURE_NO_DEPRECATE
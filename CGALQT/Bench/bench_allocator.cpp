@@ -0,0 +1,130 @@
+/************************************************************************/
+/* bench_allocator                                                      */
+/* sqrt3 and quad-triangle on Polyhedron with the node pools of         */
+/* mesh_allocator.h and with std::allocator: heap calls for the nodes,  */
+/* subdivision and deletion times                                       */
+/*                                                                      */
+/* usage: bench_allocator model [iterations]                            */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <memory>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+// std::allocator counting its calls
+struct Heap_calls
+{
+	static std::size_t& allocations() { static std::size_t n = 0; return n; }
+	static std::size_t& frees() { static std::size_t n = 0; return n; }
+};
+
+template <class T>
+class Counting_allocator : public std::allocator<T>
+{
+public:
+	typedef typename std::allocator<T>::pointer pointer;
+	typedef typename std::allocator<T>::size_type size_type;
+
+	template <class U>
+	struct rebind { typedef Counting_allocator<U> other; };
+
+	Counting_allocator() {}
+	Counting_allocator(const Counting_allocator& a) : std::allocator<T>(a) {}
+	template <class U>
+	Counting_allocator(const Counting_allocator<U>&) {}
+
+	pointer allocate(size_type n, const void * = 0)
+	{
+		Heap_calls::allocations()++;
+		return std::allocator<T>::allocate(n);
+	}
+	void deallocate(pointer p, size_type n)
+	{
+		Heap_calls::frees()++;
+		std::allocator<T>::deallocate(p,n);
+	}
+};
+
+typedef Enriched_polyhedron<K,Enriched_items> Pool_polyhedron;
+typedef Enriched_polyhedron<K,Enriched_items,Counting_allocator<int> > Heap_polyhedron;
+
+struct Run
+{
+	Timing timing;
+	double destroy;
+	std::size_t heap_calls;
+	std::size_t nodes;
+	Run() : destroy(0.0), heap_calls(0), nodes(0) {}
+};
+
+void print_run(const char *pName, const Run& r)
+{
+	print_timing(pName,r.timing);
+	if(r.timing.ok)
+		std::cout << "                delete " << std::setw(9) << r.destroy << " ms  "
+			<< r.heap_calls << " heap calls, " << r.nodes << " nodes in the result" << std::endl;
+}
+
+template <class Op>
+Run run_heap(const Mesh_arrays& arrays, int iter)
+{
+	Run r;
+	std::size_t allocations = Heap_calls::allocations();
+	Heap_polyhedron *pMesh = NULL;
+	r.timing = bench<Heap_polyhedron,Op>(arrays,iter,&pMesh);
+	if(pMesh)
+	{
+		r.nodes = pMesh->size_of_vertices() + pMesh->size_of_halfedges()/2 + pMesh->size_of_facets();
+		std::size_t frees = Heap_calls::frees();
+		Stopwatch destroy;
+		delete pMesh;
+		r.destroy = destroy.ms();
+		r.heap_calls = Heap_calls::allocations() - allocations + Heap_calls::frees() - frees;
+	}
+	return r;
+}
+
+template <class Op>
+Run run_pool(const Mesh_arrays& arrays, int iter)
+{
+	Run r;
+	std::size_t allocations = Node_pools::statistics().heap_allocations;
+	Pool_polyhedron *pMesh = NULL;
+	r.timing = bench<Pool_polyhedron,Op>(arrays,iter,&pMesh);
+	if(pMesh)
+	{
+		r.nodes = pMesh->size_of_vertices() + pMesh->size_of_halfedges()/2 + pMesh->size_of_facets();
+		// a slab is allocated and freed once
+		r.heap_calls = 2*(Node_pools::statistics().heap_allocations - allocations);
+		Stopwatch destroy;
+		delete pMesh;
+		r.destroy = destroy.ms();
+	}
+	return r;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(3);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv,"[iterations]") || !load_model<K>(args.pModel,arrays))
+		return 1;
+	int iter = args.iter;
+
+	std::cout << "Sqrt3" << std::endl;
+	print_run("new/delete",run_heap<Sqrt3_op<Heap_polyhedron,K> >(arrays,iter));
+	print_run("Node_pool",run_pool<Sqrt3_op<Pool_polyhedron,K> >(arrays,iter));
+
+	std::cout << "Quad-Triangle" << std::endl;
+	print_run("new/delete",run_heap<Quad_triangle_op<Heap_polyhedron,K> >(arrays,iter));
+	print_run("Node_pool",run_pool<Quad_triangle_op<Pool_polyhedron,K> >(arrays,iter));
+	return 0;
+}
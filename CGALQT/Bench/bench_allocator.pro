@@ -0,0 +1,6 @@
+# console benchmark of the Polyhedron node pools, see CGAL/mesh_allocator.h
+TARGET        = bench_allocator
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_allocator.h
+SOURCES += ./bench_allocator.cpp
@@ -0,0 +1,133 @@
+/************************************************************************/
+/* bench_archive                                                        */
+/* the .cqz archive of every .off and .obj model of a directory: bits  */
+/* per vertex with the connectivity alone (2 bits per coordinate), at   */
+/* 12 bits and at the given bits, encode and decode throughput at the   */
+/* given bits, and the decoded counts and degrees against the model     */
+/*                                                                      */
+/* usage: bench_archive models|model [bits] [repeats]                   */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "mesh_archive.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+// the number of facets of each degree
+std::vector<std::size_t> degrees(const Mesh_arrays& arrays)
+{
+	std::vector<std::size_t> histogram;
+	for(std::size_t f = 0; f < arrays.size_of_facets(); f++)
+	{
+		unsigned int degree = arrays.degree(f);
+		if(histogram.size() <= degree)
+			histogram.resize(degree+1);
+		histogram[degree]++;
+	}
+	return histogram;
+}
+
+// the bits per vertex of the archive, -1 if it can not be written
+double bits_per_vertex(Polyhedron& mesh, const std::string& filename, unsigned int bits)
+{
+	Mesh_archive_writer<Polyhedron> writer;
+	if(!writer.write(filename.c_str(),mesh,bits))
+		return -1.0;
+	return 8.0*boost::filesystem::file_size(filename)/std::max<std::size_t>(mesh.size_of_vertices(),1);
+}
+
+void run(const std::string& model, unsigned int bits, int repeats)
+{
+	std::string name = boost::filesystem::path(model).filename().string();
+	std::cout << std::left << std::setw(22) << name << std::right;
+
+	Mesh_arrays arrays;
+	Polyhedron mesh;
+	std::string error;
+	if(!read_model<K>(model.c_str(),arrays,error) || !mesh.build(arrays,error))
+	{
+		std::cout << error << std::endl;
+		return;
+	}
+
+	std::string filename = temporary_filename(".cqz");
+	double connectivity = bits_per_vertex(mesh,filename,Mesh_archive_header::MIN_BITS);
+	double bpv12 = bits_per_vertex(mesh,filename,12);
+	double encode_ms = 0.0, decode_ms = 0.0, bpv = 0.0;
+	Mesh_arrays decoded;
+	for(int r = 0; r < repeats; r++)
+	{
+		Stopwatch encode;
+		bpv = bits_per_vertex(mesh,filename,bits);
+		encode_ms += encode.ms();
+
+		Mesh_archive_reader<K::FT> reader;
+		decoded.clear();
+		Stopwatch decode;
+		if(!reader.read(filename.c_str(),decoded))
+		{
+			std::cout << reader.error() << std::endl;
+			boost::filesystem::remove(filename);
+			return;
+		}
+		decode_ms += decode.ms();
+	}
+	boost::filesystem::remove(filename);
+
+	bool same = decoded.size_of_vertices() == arrays.size_of_vertices() &&
+		decoded.size_of_facets() == arrays.size_of_facets() &&
+		decoded.size_of_indices() == arrays.size_of_indices() &&
+		degrees(decoded) == degrees(arrays);
+	double mv = arrays.size_of_vertices()*repeats/1000.0;
+	std::cout << std::setw(8) << arrays.size_of_vertices() << std::setw(8) << arrays.size_of_facets()
+		<< std::fixed << std::setprecision(2)
+		<< std::setw(9) << connectivity << std::setw(9) << bpv12 << std::setw(9) << bpv
+		<< std::setw(10) << mv/std::max(encode_ms,1e-3) << std::setw(10) << mv/std::max(decode_ms,1e-3)
+		<< (same ? "" : "  DECODED COUNTS DIFFER") << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " models|model.off|model.obj [bits] [repeats]" << std::endl;
+		return 1;
+	}
+	unsigned int bits = argc > 2 ? (unsigned int)std::atoi(argv[2]) : Mesh_archive_header::DEFAULT_BITS;
+	int repeats = argc > 3 ? std::max(1,std::atoi(argv[3])) : 10;
+
+	// a directory gives its .off and .obj models by name
+	std::vector<std::string> models;
+	boost::filesystem::path path(argv[1]);
+	if(boost::filesystem::is_directory(path))
+	{
+		for(boost::filesystem::directory_iterator it(path), end; it != end; ++it)
+		{
+			std::string extension = it->path().extension().string();
+			if(StringUtils::CompareNoCase(extension,".off") == 0 ||
+			   StringUtils::CompareNoCase(extension,".obj") == 0)
+				models.push_back(it->path().string());
+		}
+		std::sort(models.begin(),models.end());
+	}
+	else
+		models.push_back(argv[1]);
+
+	std::cout << "bits per vertex at 2 (connectivity), 12 and " << bits
+		<< " bits, encode and decode in Mvertices/s at " << bits << " bits" << std::endl;
+	std::cout << "model                 vertices  facets     conn.       12"
+		<< std::setw(9) << bits << "    encode    decode" << std::endl;
+	for(std::size_t i = 0; i < models.size(); i++)
+		run(models[i],bits,repeats);
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of the .cqz archive over a directory of models, see CGAL/mesh_archive.h
+TARGET        = bench_archive
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_archive.h
+SOURCES += ./bench_archive.cpp
@@ -0,0 +1,165 @@
+/************************************************************************/
+/* bench_cache                                                          */
+/* the loads of MeshLoader::loadMesh for the model replicated side by   */
+/* side in a temporary .off: first open parsing the text and writing    */
+/* the .cqm sidecar cache, second open from the cache, and the mapping  */
+/* of the cache alone, each from a cold page cache and from a warm one  */
+/*                                                                      */
+/* usage: bench_cache model [copies] [max threads] [repeats]            */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "mesh_text.h"
+#include "mesh_view.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+typedef Indexed_view<K::FT> View;
+
+// the text model up to the display, as loadMesh does without cache
+bool open_text(const std::string& filename, View& view)
+{
+	std::string error;
+	if(!view.read_off(filename.c_str(),error))
+	{
+		std::cout << "  " << error << std::endl;
+		return false;
+	}
+	view.reorder_if_scattered();
+	view.compute_type();
+	view.compute_normals();
+	view.compute_bounding_box();
+	return true;
+}
+
+// the same from a fresh cache, which carries the normals
+bool open_cache(const std::string& filename, const std::string& cache, View& view)
+{
+	std::string error;
+	bool has_normals = false;
+	if(!Binary_mesh_view::is_fresh(cache.c_str(),filename.c_str()) ||
+	   !view.read_binary(cache.c_str(),error,has_normals))
+	{
+		std::cout << "  cache: " << error << std::endl;
+		return false;
+	}
+	view.compute_type();
+	if(!has_normals)
+		view.compute_normals();
+	view.compute_bounding_box();
+	return true;
+}
+
+// the mean time over 'repeats' runs of one of the opens, -1 if it failed
+template <class Open>
+double time_open(const std::string& filename, const std::string& cache, bool cold, int repeats, Open open)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		if(cold)
+		{
+			drop_cache(filename.c_str());
+			drop_cache(cache.c_str());
+		}
+		Stopwatch stopwatch;
+		if(!open(filename,cache))
+			return -1.0;
+		ms += stopwatch.ms()/repeats;
+	}
+	return ms;
+}
+
+struct Text_open
+{
+	bool operator()(const std::string& filename, const std::string&) const
+	{
+		View view;
+		return open_text(filename,view);
+	}
+};
+struct Cache_open
+{
+	bool operator()(const std::string& filename, const std::string& cache) const
+	{
+		View view;
+		return open_cache(filename,cache,view);
+	}
+};
+struct Map_open
+{
+	bool operator()(const std::string&, const std::string& cache) const
+	{
+		Binary_mesh_view view;
+		std::string error;
+		return view.open(cache.c_str(),error);
+	}
+};
+
+template <class Open>
+void print_open(const char *pName, const std::string& filename, const std::string& cache, int repeats, Open open)
+{
+	double cold_ms = time_open(filename,cache,true,repeats,open);
+	double warm_ms = time_open(filename,cache,false,repeats,open);
+	std::cout << "  " << std::left << std::setw(16) << pName << std::right << std::fixed << std::setprecision(2);
+	if(cold_ms < 0.0 || warm_ms < 0.0)
+		std::cout << "failed" << std::endl;
+	else
+		std::cout << "cold " << std::setw(10) << cold_ms << " ms  warm " << std::setw(10) << warm_ms << " ms" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(64,3);
+	Mesh_arrays model;
+	if(!args.parse(argc,argv,"[copies] [max threads] [repeats]") || !load_model<K>(args.pModel,model))
+		return 1;
+	ParallelUtils::set_nb_threads(args.max_threads);
+
+	std::string filename = temporary_filename(".off");
+	std::string cache = filename + ".cqm";
+	{
+		Mesh_arrays arrays;
+		replicate(model,args.iter,arrays);
+		std::string error;
+		Polyhedron mesh;
+		Text_mesh_writer<Polyhedron> writer;
+		if(!mesh.build(arrays,error) || !writer.write_off(filename.c_str(),mesh))
+		{
+			std::cerr << filename << ": can not write the copies" << std::endl;
+			return 1;
+		}
+	}
+
+	// the first open writes the cache
+	View view;
+	if(!open_text(filename,view))
+		return 1;
+	Stopwatch write;
+	if(!view.write_binary(cache.c_str(),filename.c_str()))
+	{
+		std::cerr << cache << ": can not write the cache" << std::endl;
+		return 1;
+	}
+	double write_ms = write.ms();
+	std::cout << args.iter << " copies: " << view.size_of_vertices() << " vertices, "
+		<< view.size_of_facets() << " facets, " << std::fixed << std::setprecision(1)
+		<< file_mb(filename) << " MB of text, " << file_mb(cache) << " MB of cache written in "
+		<< std::setprecision(2) << write_ms << " ms, " << args.max_threads << " thread(s)" << std::endl;
+
+	print_open("text",filename,cache,args.repeats,Text_open());
+	print_open("cache",filename,cache,args.repeats,Cache_open());
+	print_open("cache mapping",filename,cache,args.repeats,Map_open());
+
+	ParallelUtils::set_nb_threads(0);
+	boost::filesystem::remove(cache);
+	boost::filesystem::remove(filename);
+	return 0;
+}
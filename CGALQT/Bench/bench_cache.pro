@@ -0,0 +1,8 @@
+# console benchmark of the .cqm sidecar cache against parsing the text model, see CGAL/mesh_binary.h
+TARGET        = bench_cache
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_text.h \
+	../CGAL/mesh_view.h \
+	../CGAL/mesh_binary.h
+SOURCES += ./bench_cache.cpp
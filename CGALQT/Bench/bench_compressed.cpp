@@ -0,0 +1,107 @@
+/************************************************************************/
+/* bench_compressed                                                     */
+/* writes .gz and .zst copies of the model through OutputFile, then     */
+/* loads the model and its copies from a cold page cache and from a     */
+/* warm one: the decompression thread against reading the plain file,  */
+/* the throughputs are in MB of the plain file per second               */
+/*                                                                      */
+/* usage: bench_compressed model [repeats]                              */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "bench.h"
+
+//boost
+#include <boost/filesystem/operations.hpp>
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+// the mean load time over 'repeats' runs, the page cache dropped
+// before each one if 'cold', -1 if the load failed
+double load(const std::string& filename, bool cold, int repeats, std::size_t& facets)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		if(cold)
+			drop_cache(filename.c_str());
+		Mesh_arrays arrays;
+		std::string error;
+		Stopwatch read;
+		if(!read_model<K>(filename.c_str(),arrays,error))
+		{
+			std::cout << "  " << filename << ": " << error << std::endl;
+			return -1.0;
+		}
+		ms += read.ms()/repeats;
+		facets = arrays.size_of_facets();
+	}
+	return ms;
+}
+
+// copies the file through OutputFile, compressed by its suffix
+double compress(const char *pFilename, const std::string& copy)
+{
+	MappedFile file;
+	OutputFile out;
+	Stopwatch write;
+	if(!file.open(pFilename) || !out.open(copy.c_str()) ||
+	   !out.write(file.begin(),file.size()) || !out.close())
+		return -1.0;
+	return write.ms();
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " model.off|model.obj [repeats]" << std::endl;
+		return 1;
+	}
+	int repeats = argc > 2 ? std::max(1,std::atoi(argv[2])) : 3;
+	Mesh_arrays arrays;
+	if(!load_model<K>(argv[1],arrays))
+		return 1;
+	if(!drop_cache(argv[1]))
+		std::cout << "no posix_fadvise, the cold loads are warm" << std::endl;
+
+	const char *suffixes[] = { "", ".gz", ".zst" };
+	std::string plain(argv[1]);
+	double plain_mb = boost::filesystem::file_size(plain)/(1024.0*1024.0);
+	std::cout << "                    MB   write ms    cold ms  (MB/s)    warm ms  (MB/s)" << std::endl;
+	for(int i = 0; i < 3; i++)
+	{
+		std::string filename = plain + suffixes[i];
+		double write_ms = 0.0;
+		if(i > 0 && (write_ms = compress(argv[1],filename)) < 0.0)
+		{
+			std::cout << "  " << std::left << std::setw(6) << suffixes[i] << std::right
+				<< "can not write, built without it?" << std::endl;
+			continue;
+		}
+
+		std::size_t cold_facets = 0, warm_facets = 0;
+		double cold_ms = load(filename,true,repeats,cold_facets);
+		double warm_ms = load(filename,false,repeats,warm_facets);
+		if(cold_ms < 0.0 || warm_ms < 0.0)
+			continue;
+		double mb = boost::filesystem::file_size(filename)/(1024.0*1024.0);
+		std::cout << "  " << std::left << std::setw(6) << (i ? suffixes[i] : "plain") << std::right
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(12) << mb << std::setw(11) << write_ms
+			<< std::setw(11) << cold_ms << std::setw(8) << std::setprecision(0) << plain_mb/std::max(cold_ms,1e-3)*1000.0
+			<< std::setprecision(2) << std::setw(11) << warm_ms << std::setw(8) << std::setprecision(0) << plain_mb/std::max(warm_ms,1e-3)*1000.0
+			<< ((cold_facets == arrays.size_of_facets() && warm_facets == cold_facets) ? "" : "  FACET COUNTS DIFFER")
+			<< std::endl;
+		if(i > 0)
+			boost::filesystem::remove(filename);
+	}
+	return 0;
+}
@@ -0,0 +1,5 @@
+# console benchmark of the .gz and .zst models from a cold page cache, see Util/compressedfile.h
+TARGET        = bench_compressed
+include(bench.pri)
+
+SOURCES += ./bench_compressed.cpp
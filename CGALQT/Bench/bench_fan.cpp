@@ -0,0 +1,171 @@
+/************************************************************************/
+/* bench_fan                                                            */
+/* the closed bipyramid of 2n triangles, whose two apexes have valence  */
+/* n, built through Enriched_polyhedron_incremental_builder_3 walking   */
+/* around the vertices and with its edge map, then through              */
+/* Polyhedron::build() on one thread, which picks between the two,     */
+/* for n from 1000 up to the given valence by factors of 4              */
+/*                                                                      */
+/* usage: bench_fan [max valence] [repeats]                             */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <string>
+#include <cmath>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "builder.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+typedef Polyhedron::HalfedgeDS HDS;
+
+// apexes 0 and n+1 over the rim 1..n
+void bipyramid(std::size_t n, Mesh_arrays& arrays)
+{
+	arrays.clear();
+	arrays.reserve(n+2,2*n,6*n);
+	arrays.points.push_back(0); arrays.points.push_back(0); arrays.points.push_back(1);
+	for(std::size_t i = 0; i < n; i++)
+	{
+		double angle = 2.0*3.14159265358979323846*i/n;
+		arrays.points.push_back((K::FT)std::cos(angle));
+		arrays.points.push_back((K::FT)std::sin(angle));
+		arrays.points.push_back(0);
+	}
+	arrays.points.push_back(0); arrays.points.push_back(0); arrays.points.push_back(-1);
+
+	int top = 0, bottom = (int)n+1;
+	for(int i = 1; i <= (int)n; i++)
+	{
+		int next = i % (int)n + 1;
+		arrays.facet_vertices.push_back(top);
+		arrays.facet_vertices.push_back(i);
+		arrays.facet_vertices.push_back(next);
+		arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+		arrays.facet_vertices.push_back(bottom);
+		arrays.facet_vertices.push_back(next);
+		arrays.facet_vertices.push_back(i);
+		arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+	}
+}
+
+// the arrays facet by facet through the incremental builder, the
+// halfedge between two vertices found by walking around the first
+// one or in the edge map
+class Fan_builder : public CGAL::Modifier_base<HDS>
+{
+private:
+	typedef HDS::Vertex::Point Point;
+	typedef CGAL::Enriched_polyhedron_incremental_builder_3<HDS> builder;
+	const Mesh_arrays *m_pArrays;
+	bool m_edge_map;
+	bool m_error;
+
+public:
+	Fan_builder(const Mesh_arrays *pArrays, bool edge_map)
+		: m_pArrays(pArrays), m_edge_map(edge_map), m_error(false) {}
+
+	bool error() const { return m_error; }
+
+	void operator()(HDS& hds)
+	{
+		const Mesh_arrays& arrays = *m_pArrays;
+		builder B(hds,true);
+		std::size_t nb_halfedges = 0;
+		std::size_t max_valence = 0;
+		if(!B.test_facets(&arrays.facet_begin[0],arrays.size_of_facets(),
+			&arrays.facet_vertices[0],arrays.size_of_vertices(),nb_halfedges,max_valence))
+		{
+			m_error = true;
+			return;
+		}
+		B.use_edge_map(m_edge_map);
+		B.begin_surface(arrays.size_of_vertices(),arrays.size_of_facets(),nb_halfedges);
+		for(std::size_t i = 0; i < arrays.points.size(); i += 3)
+			B.add_vertex(Point(arrays.points[i],arrays.points[i+1],arrays.points[i+2]));
+		for(std::size_t f = 0; f < arrays.size_of_facets() && !B.error(); f++)
+		{
+			B.begin_facet();
+			for(unsigned int i = arrays.facet_begin[f]; i < arrays.facet_begin[f+1]; i++)
+				B.add_vertex_to_facet((std::size_t)arrays.facet_vertices[i]);
+			B.end_facet();
+		}
+		if(B.error())
+		{
+			B.rollback();
+			m_error = true;
+			return;
+		}
+		B.end_surface();
+	}
+};
+
+// the mean time of 'repeats' builds, -1 if one failed, 'halfedges'
+// those of the last mesh
+double time_builder(const Mesh_arrays& arrays, bool edge_map, int repeats, std::size_t& halfedges)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Polyhedron mesh;
+		Fan_builder builder(&arrays,edge_map);
+		Stopwatch build;
+		mesh.delegate(builder);
+		ms += build.ms()/repeats;
+		if(builder.error())
+			return -1.0;
+		halfedges = mesh.size_of_halfedges();
+	}
+	return ms;
+}
+
+double time_build(const Mesh_arrays& arrays, int repeats, std::size_t& halfedges)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Polyhedron mesh;
+		std::string error;
+		Stopwatch build;
+		if(!mesh.build(arrays,error))
+		{
+			std::cout << "  build: " << error << std::endl;
+			return -1.0;
+		}
+		ms += build.ms()/repeats;
+		halfedges = mesh.size_of_halfedges();
+	}
+	return ms;
+}
+
+int main(int argc, char *argv[])
+{
+	std::size_t max_valence = argc > 1 ? (std::size_t)std::max(1000,std::atoi(argv[1])) : 64000;
+	int repeats = argc > 2 ? std::max(1,std::atoi(argv[2])) : 1;
+
+	// the builder path of build()
+	ParallelUtils::set_nb_threads(1);
+	std::cout << "valence    facets      walk ms  edge map ms     build ms   walk/map" << std::endl;
+	for(std::size_t n = 1000; n <= max_valence; n *= 4)
+	{
+		Mesh_arrays arrays;
+		bipyramid(n,arrays);
+		std::size_t walk_halfedges = 0, map_halfedges = 0, build_halfedges = 0;
+		double walk_ms = time_builder(arrays,false,repeats,walk_halfedges);
+		double map_ms = time_builder(arrays,true,repeats,map_halfedges);
+		double build_ms = time_build(arrays,repeats,build_halfedges);
+		bool same = walk_halfedges == 6*n && map_halfedges == 6*n && build_halfedges == 6*n;
+		std::cout << std::setw(7) << n << std::setw(10) << arrays.size_of_facets()
+			<< std::fixed << std::setprecision(2)
+			<< std::setw(13) << walk_ms << std::setw(13) << map_ms << std::setw(13) << build_ms
+			<< std::setw(11) << walk_ms/std::max(map_ms,1e-3)
+			<< (same ? "" : "  HALFEDGE COUNTS DIFFER") << std::endl;
+	}
+	ParallelUtils::set_nb_threads(0);
+	return 0;
+}
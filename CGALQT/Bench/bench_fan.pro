@@ -0,0 +1,6 @@
+# console benchmark of the incremental builder around high valence vertices, see CGAL/builder.h
+TARGET        = bench_fan
+include(bench.pri)
+
+HEADERS += ../CGAL/builder.h
+SOURCES += ./bench_fan.cpp
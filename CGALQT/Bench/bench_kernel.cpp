@@ -0,0 +1,137 @@
+/************************************************************************/
+/* bench_kernel                                                         */
+/* times every subdivision scheme and compute_normals on Polyhedron     */
+/* with the kernels of mesh_kernel.h, and measures how far the points   */
+/* and normals drift from the Cartesian<double> ones                    */
+/*                                                                      */
+/* usage: bench_kernel model [iterations]                               */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <cmath>
+#include <vector>
+
+//cgal
+#include <CGAL/Cartesian.h>
+#include <CGAL/Simple_cartesian.h>
+#include "enriched_polyhedron.h"
+#include "bench.h"
+
+typedef Indexed_mesh<double> Mesh_arrays;
+
+enum Scheme { SQRT3, QUAD_TRIANGLE, DOOSABIN, CATMULLCLARK, LOOP, NB_SCHEMES };
+static const char *scheme_names[NB_SCHEMES] = { "Sqrt3", "Quad-Triangle", "DooSabin", "CatmullClark", "Loop" };
+
+// the vertices of a result in iteration order, the same for every kernel
+struct Mesh_sample
+{
+	std::vector<double> points;
+	std::vector<double> normals;
+
+	template <class Mesh>
+	void take(Mesh& mesh)
+	{
+		points.clear();
+		normals.clear();
+		for(typename Mesh::Vertex_iterator pVertex = mesh.vertices_begin();
+			pVertex != mesh.vertices_end();
+			pVertex++)
+			for(int k = 0; k < 3; k++)
+			{
+				points.push_back(pVertex->point()[k]);
+				normals.push_back(pVertex->normal()[k]);
+			}
+	}
+
+	// largest distance between matching triples, -1 if the meshes differ
+	static double max_distance(const std::vector<double>& a, const std::vector<double>& b)
+	{
+		if(a.size() != b.size())
+			return -1.0;
+		double max = 0.0;
+		for(std::size_t i = 0; i < a.size(); i += 3)
+		{
+			double d = 0.0;
+			for(int k = 0; k < 3; k++)
+				d += (a[i+k]-b[i+k])*(a[i+k]-b[i+k]);
+			max = std::max(max,std::sqrt(d));
+		}
+		return max;
+	}
+};
+
+template <class kernel>
+Timing run(Scheme scheme, const Mesh_arrays& arrays, int iter, Mesh_sample& sample)
+{
+	typedef Enriched_polyhedron<kernel,Enriched_items> Mesh;
+	Mesh *pMesh = NULL;
+	Timing t;
+	switch(scheme)
+	{
+	case SQRT3:         t = bench<Mesh,Sqrt3_op<Mesh,kernel> >(arrays,iter,&pMesh); break;
+	case QUAD_TRIANGLE: t = bench<Mesh,Quad_triangle_op<Mesh,kernel> >(arrays,iter,&pMesh); break;
+	case DOOSABIN:      t = bench<Mesh,Doosabin_op<Mesh> >(arrays,iter,&pMesh); break;
+	case CATMULLCLARK:  t = bench<Mesh,Catmullclark_op<Mesh> >(arrays,iter,&pMesh); break;
+	default:            t = bench<Mesh,Loop_op<Mesh> >(arrays,iter,&pMesh); break;
+	}
+	if(pMesh)
+	{
+		sample.take(*pMesh);
+		delete pMesh;
+	}
+	return t;
+}
+
+// the errors are relative to the diagonal of the model
+void print_error(const Mesh_sample& sample, const Mesh_sample& reference, double diagonal)
+{
+	double points = Mesh_sample::max_distance(sample.points,reference.points);
+	double normals = Mesh_sample::max_distance(sample.normals,reference.normals);
+	if(points < 0.0)
+	{
+		std::cout << "                not the same mesh as Cartesian<double>" << std::endl;
+		return;
+	}
+	std::cout << "                max point error " << std::scientific << std::setprecision(2)
+		<< points/diagonal << "  max normal error " << normals << std::fixed << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	// every kernel builds from the same double coordinates
+	Bench_args args(1);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv,"[iterations]") || !load_model<CGAL::Simple_cartesian<double> >(args.pModel,arrays))
+		return 1;
+	int iter = args.iter;
+
+	double lo[3], hi[3];
+	for(int k = 0; k < 3; k++)
+		lo[k] = hi[k] = arrays.points.empty() ? 0.0 : arrays.points[k];
+	for(std::size_t i = 0; i < arrays.points.size(); i++)
+	{
+		lo[i%3] = std::min(lo[i%3],arrays.points[i]);
+		hi[i%3] = std::max(hi[i%3],arrays.points[i]);
+	}
+	double diagonal = std::sqrt((hi[0]-lo[0])*(hi[0]-lo[0]) + (hi[1]-lo[1])*(hi[1]-lo[1]) + (hi[2]-lo[2])*(hi[2]-lo[2]));
+	if(diagonal == 0.0)
+		diagonal = 1.0;
+
+	for(int s = 0; s < NB_SCHEMES; s++)
+	{
+		Scheme scheme = (Scheme)s;
+		Mesh_sample reference, sample;
+		std::cout << scheme_names[s] << std::endl;
+
+		print_timing("Cartesian<d>",run< CGAL::Cartesian<double> >(scheme,arrays,iter,reference));
+
+		print_timing("Simple<d>",run< CGAL::Simple_cartesian<double> >(scheme,arrays,iter,sample));
+		print_error(sample,reference,diagonal);
+
+		print_timing("Simple<f>",run< CGAL::Simple_cartesian<float> >(scheme,arrays,iter,sample));
+		print_error(sample,reference,diagonal);
+	}
+	return 0;
+}
@@ -0,0 +1,5 @@
+# console benchmark of the mesh kernels, see CGAL/mesh_kernel.h
+TARGET        = bench_kernel
+include(bench.pri)
+
+SOURCES += ./bench_kernel.cpp
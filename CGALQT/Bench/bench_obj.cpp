@@ -0,0 +1,140 @@
+/************************************************************************/
+/* bench_obj                                                            */
+/* writes the model replicated side by side to a temporary .obj, then   */
+/* times its parsing: the fgets and sscanf scan of the Builder_obj the  */
+/* parser replaced, then Parser_obj alone and with the mesh build from  */
+/* 1 to N threads                                                       */
+/*                                                                      */
+/* usage: bench_obj model [copies] [max threads] [repeats]              */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <cstdio>
+#include <cctype>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "mesh_text.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+// the scan of the replaced Builder_obj, without its builder: two
+// passes of fgets into a 512 byte line and sscanf
+bool scan_fgets(const char *pFilename, Mesh_arrays& arrays)
+{
+	FILE *pFile = fopen(pFilename,"rt");
+	if(pFile == NULL)
+		return false;
+	arrays.clear();
+	char pLine[512];
+	while(fgets(pLine,512,pFile))
+		if(pLine[0] == 'v')
+		{
+			float x,y,z;
+			if(sscanf(pLine,"v %f %f %f",&x,&y,&z) == 3)
+			{
+				arrays.points.push_back(x);
+				arrays.points.push_back(y);
+				arrays.points.push_back(z);
+			}
+		}
+	fseek(pFile,0,SEEK_SET);
+	while(fgets(pLine,512,pFile))
+		if(pLine[0] == 'f')
+		{
+			char *p = pLine + 2;
+			int index, n;
+			while(sscanf(p,"%d%n",&index,&n) == 1)
+			{
+				arrays.facet_vertices.push_back(index-1);
+				for(p += n; *p && !isspace((unsigned char)*p); p++)
+					;
+			}
+			arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+		}
+	fclose(pFile);
+	return true;
+}
+
+void print_line(const char *pName, double ms, double mb, std::size_t facets, double reference_ms)
+{
+	std::cout << "  " << std::left << std::setw(22) << pName << std::right
+		<< std::fixed << std::setprecision(2) << std::setw(10) << ms << " ms  "
+		<< std::setprecision(0) << std::setw(6) << mb/std::max(ms,1e-3)*1000.0 << " MB/s  "
+		<< std::setprecision(2) << std::setw(6) << facets/std::max(ms,1e-3)/1000.0 << " Mfacets/s  "
+		<< "speedup " << std::setw(6) << reference_ms/std::max(ms,1e-3) << "x" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(256,3);
+	Mesh_arrays model;
+	if(!args.parse(argc,argv,"[copies] [max threads] [repeats]") || !load_model<K>(args.pModel,model))
+		return 1;
+
+	Mesh_arrays arrays;
+	replicate(model,args.iter,arrays);
+	std::string filename = temporary_filename(".obj");
+	{
+		std::string error;
+		Polyhedron mesh;
+		Text_mesh_writer<Polyhedron> writer;
+		if(!mesh.build(arrays,error) || !writer.write_obj(filename.c_str(),mesh))
+		{
+			std::cerr << filename << ": can not write the copies" << std::endl;
+			return 1;
+		}
+	}
+	std::size_t facets = arrays.size_of_facets();
+	double mb = file_mb(filename);
+	std::cout << args.iter << " copies: " << arrays.size_of_vertices() << " vertices, "
+		<< facets << " facets, " << std::fixed << std::setprecision(1) << mb << " MB" << std::endl;
+
+	double fgets_ms = 0.0;
+	for(int r = 0; r < args.repeats; r++)
+	{
+		Mesh_arrays scanned;
+		Stopwatch scan;
+		scan_fgets(filename.c_str(),scanned);
+		fgets_ms += scan.ms()/args.repeats;
+		if(scanned.size_of_facets() != facets)
+			std::cout << "  fgets+sscanf read " << scanned.size_of_facets() << " facets" << std::endl;
+	}
+	print_line("fgets+sscanf",fgets_ms,mb,facets,fgets_ms);
+
+	for(unsigned int nb_threads = 1; nb_threads <= args.max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		double parse_ms = 0.0, build_ms = 0.0;
+		std::size_t parsed = 0;
+		for(int r = 0; r < args.repeats; r++)
+		{
+			Mesh_arrays read;
+			std::string error;
+			Polyhedron mesh;
+			Stopwatch parse;
+			Parser_obj<K,Enriched_items> parser;
+			if(!parser.read(filename.c_str(),read))
+			{
+				std::cout << "  " << parser.error() << std::endl;
+				break;
+			}
+			parse_ms += parse.ms()/args.repeats;
+			if(!mesh.build(read,error))
+				std::cout << "  build: " << error << std::endl;
+			build_ms += parse.ms()/args.repeats;
+			parsed = read.size_of_facets();
+		}
+		std::cout << "  " << nb_threads << " thread(s)" << (parsed == facets ? "" : "  FACET COUNTS DIFFER") << std::endl;
+		print_line("  Parser_obj",parse_ms,mb,facets,fgets_ms);
+		print_line("  Parser_obj + build",build_ms,mb,facets,fgets_ms);
+	}
+	ParallelUtils::set_nb_threads(0);
+	boost::filesystem::remove(filename);
+	return 0;
+}
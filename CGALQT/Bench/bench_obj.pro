@@ -0,0 +1,6 @@
+# console benchmark of the OBJ parser on a model scaled up, see CGAL/parser_obj.h
+TARGET        = bench_obj
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_text.h
+SOURCES += ./bench_obj.cpp
@@ -0,0 +1,103 @@
+/************************************************************************/
+/* bench_off                                                            */
+/* writes the model replicated side by side to a temporary .off, then   */
+/* times its loading: the CGAL stream operator loadFile used before,   */
+/* then Parser_off alone and with the mesh build from 1 to N threads    */
+/*                                                                      */
+/* usage: bench_off model [copies] [max threads] [repeats]              */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <fstream>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "mesh_text.h"
+#include "bench.h"
+#include <CGAL/IO/Polyhedron_iostream.h>
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+void print_line(const char *pName, double ms, double mb, std::size_t facets, double reference_ms)
+{
+	std::cout << "  " << std::left << std::setw(22) << pName << std::right
+		<< std::fixed << std::setprecision(2) << std::setw(10) << ms << " ms  "
+		<< std::setprecision(0) << std::setw(6) << mb/std::max(ms,1e-3)*1000.0 << " MB/s  "
+		<< std::setprecision(2) << std::setw(6) << facets/std::max(ms,1e-3)/1000.0 << " Mfacets/s  "
+		<< "speedup " << std::setw(6) << reference_ms/std::max(ms,1e-3) << "x" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(12000,3);
+	Mesh_arrays model;
+	if(!args.parse(argc,argv,"[copies] [max threads] [repeats]") || !load_model<K>(args.pModel,model))
+		return 1;
+
+	// the copies are only kept in the file
+	std::string filename = temporary_filename(".off");
+	std::size_t facets = model.size_of_facets()*args.iter;
+	{
+		Mesh_arrays arrays;
+		replicate(model,args.iter,arrays);
+		std::string error;
+		Polyhedron mesh;
+		Text_mesh_writer<Polyhedron> writer;
+		if(!mesh.build(arrays,error) || !writer.write_off(filename.c_str(),mesh))
+		{
+			std::cerr << filename << ": can not write the copies" << std::endl;
+			return 1;
+		}
+	}
+	double mb = file_mb(filename);
+	std::cout << args.iter << " copies: " << model.size_of_vertices()*args.iter << " vertices, "
+		<< facets << " facets, " << std::fixed << std::setprecision(1) << mb << " MB" << std::endl;
+
+	double stream_ms = 0.0;
+	for(int r = 0; r < args.repeats; r++)
+	{
+		Polyhedron mesh;
+		Stopwatch read;
+		std::ifstream stream(filename.c_str());
+		stream >> mesh;
+		stream_ms += read.ms()/args.repeats;
+		if(mesh.size_of_facets() != facets)
+			std::cout << "  operator>> read " << mesh.size_of_facets() << " facets" << std::endl;
+	}
+	print_line("operator>>",stream_ms,mb,facets,stream_ms);
+
+	for(unsigned int nb_threads = 1; nb_threads <= args.max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		double parse_ms = 0.0, build_ms = 0.0;
+		std::size_t built = 0;
+		for(int r = 0; r < args.repeats; r++)
+		{
+			Mesh_arrays read;
+			std::string error;
+			Polyhedron mesh;
+			Stopwatch parse;
+			Parser_off<K::FT> parser;
+			if(!parser.read(filename.c_str(),read))
+			{
+				std::cout << "  " << parser.error() << std::endl;
+				break;
+			}
+			parse_ms += parse.ms()/args.repeats;
+			if(!mesh.build(read,error))
+				std::cout << "  build: " << error << std::endl;
+			build_ms += parse.ms()/args.repeats;
+			built = mesh.size_of_facets();
+		}
+		std::cout << "  " << nb_threads << " thread(s)" << (built == facets ? "" : "  FACET COUNTS DIFFER") << std::endl;
+		print_line("  Parser_off",parse_ms,mb,facets,stream_ms);
+		print_line("  Parser_off + build",build_ms,mb,facets,stream_ms);
+	}
+	ParallelUtils::set_nb_threads(0);
+	boost::filesystem::remove(filename);
+	return 0;
+}
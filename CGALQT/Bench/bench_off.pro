@@ -0,0 +1,6 @@
+# console benchmark of the OFF parser against the CGAL stream operator, see CGAL/parser_off.h
+TARGET        = bench_off
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_text.h
+SOURCES += ./bench_off.cpp
@@ -0,0 +1,105 @@
+/************************************************************************/
+/* bench_refine                                                         */
+/* one quad-triangle refinement level of the subdivided model through  */
+/* the incremental builder (CModifierQuadTriangle) and through the      */
+/* arrays of CRefinerQuadTriangle built in bulk, from 1 to N threads    */
+/*                                                                      */
+/* usage: bench_refine model [iterations] [max threads] [repeats]       */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "surface_mesh.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+template <class Mesh>
+double refine_builder(Mesh& mesh, int repeats, std::size_t& facets)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Mesh *pNewMesh = new Mesh;
+		Stopwatch refine;
+		CModifierQuadTriangle<typename Mesh::HalfedgeDS,Mesh,K> builder(&mesh);
+		pNewMesh->delegate(builder);
+		ms += refine.ms()/repeats;
+		facets = pNewMesh->size_of_facets();
+		delete pNewMesh;
+	}
+	return ms;
+}
+
+template <class Mesh>
+double refine_arrays(Mesh& mesh, int repeats, std::size_t& facets, double& arrays_ms)
+{
+	double ms = 0.0;
+	arrays_ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Mesh *pNewMesh = new Mesh;
+		typename CRefinerQuadTriangle<Mesh,K>::Mesh_arrays arrays;
+		std::string error;
+		Stopwatch refine;
+		CRefinerQuadTriangle<Mesh,K>::refine(mesh,arrays);
+		arrays_ms += refine.ms()/repeats;
+		if(!pNewMesh->build(arrays,error))
+			std::cerr << "  build: " << error << std::endl;
+		ms += refine.ms()/repeats;
+		facets = pNewMesh->size_of_facets();
+		delete pNewMesh;
+	}
+	return ms;
+}
+
+template <class Mesh>
+void run(const char *pName, const Mesh_arrays& arrays, int iter, unsigned int max_threads, int repeats)
+{
+	std::cout << pName << std::endl;
+	Mesh *pMesh = NULL;
+	if(!bench<Mesh,Quad_triangle_op<Mesh,K> >(arrays,iter,&pMesh).ok)
+	{
+		std::cout << "  quad-triangle failed" << std::endl;
+		delete pMesh;
+		return;
+	}
+	std::cout << "  " << pMesh->size_of_facets() << " facets after "
+		<< iter << " quad-triangle step(s)" << std::endl;
+
+	for(unsigned int nb_threads = 1; nb_threads <= max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		std::size_t builder_facets = 0, arrays_facets = 0;
+		double refine_ms = 0.0;
+		double builder_ms = refine_builder(*pMesh,repeats,builder_facets);
+		double arrays_ms = refine_arrays(*pMesh,repeats,arrays_facets,refine_ms);
+		std::cout << "  " << std::setw(2) << nb_threads << " thread(s) "
+			<< std::fixed << std::setprecision(2)
+			<< "builder " << std::setw(9) << builder_ms << " ms  "
+			<< "arrays " << std::setw(9) << arrays_ms << " ms "
+			<< "(refine " << std::setw(8) << refine_ms << " ms)  "
+			<< "speedup " << std::setw(5) << builder_ms/std::max(arrays_ms,1e-3) << "x  "
+			<< (builder_facets == arrays_facets ? "" : "FACET COUNTS DIFFER") << std::endl;
+	}
+	ParallelUtils::set_nb_threads(0);
+	delete pMesh;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(3,3);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv) || !load_model<K>(args.pModel,arrays))
+		return 1;
+
+	run<Polyhedron>("Polyhedron",arrays,args.iter,args.max_threads,args.repeats);
+	run<Surface_mesh>("Surface_mesh",arrays,args.iter,args.max_threads,args.repeats);
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of the quad-triangle refinement into arrays, see CGAL/quad-triangle.h
+TARGET        = bench_refine
+include(bench.pri)
+
+HEADERS += ../CGAL/surface_mesh.h
+SOURCES += ./bench_refine.cpp
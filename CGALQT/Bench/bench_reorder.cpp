@@ -0,0 +1,171 @@
+/************************************************************************/
+/* bench_reorder                                                        */
+/* subdivides with sqrt3, which leaves the new vertices far from their  */
+/* neighbours, then times compute_normals, a smoothing pass and the     */
+/* draw traversal before and after the Hilbert reordering               */
+/*                                                                      */
+/* usage: bench_reorder model [sqrt3 steps] [repeats]                   */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "surface_mesh.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+struct Traversal
+{
+	double normals;
+	double smooth;
+	double draw;
+	Traversal() : normals(0.0), smooth(0.0), draw(0.0) {}
+};
+
+// one umbrella averaging pass, the walk of the sqrt3 and quad-triangle
+// smoothing steps
+template <class Mesh>
+void smooth(Mesh& mesh, std::vector<typename Mesh::Point>& points)
+{
+	typedef typename Mesh::Vector Vector;
+	points.clear();
+	for(typename Mesh::Vertex_iterator pVertex = mesh.vertices_begin();
+		pVertex != mesh.vertices_end();
+		pVertex++)
+	{
+		Vector sum = CGAL::NULL_VECTOR;
+		int degree = 0;
+		typename Mesh::Halfedge_around_vertex_circulator h = pVertex->vertex_begin();
+		do
+		{
+			sum = sum + (h->opposite()->vertex()->point() - CGAL::ORIGIN);
+			degree++;
+		}
+		while(++h != pVertex->vertex_begin());
+		points.push_back(CGAL::ORIGIN + ((pVertex->point() - CGAL::ORIGIN)*0.5 + sum*(0.5/degree)));
+	}
+	std::size_t i = 0;
+	for(typename Mesh::Vertex_iterator pVertex = mesh.vertices_begin();
+		pVertex != mesh.vertices_end();
+		pVertex++)
+		pVertex->point() = points[i++];
+}
+
+// what Mesh_renderer::gl_draw reads with smooth shading, into an array
+template <class Mesh>
+void draw(Mesh& mesh, std::vector<float>& buffer)
+{
+	buffer.clear();
+	for(typename Mesh::Facet_iterator pFacet = mesh.facets_begin();
+		pFacet != mesh.facets_end();
+		pFacet++)
+	{
+		typename Mesh::Halfedge_around_facet_circulator h = pFacet->facet_begin();
+		do
+		{
+			typename Mesh::Vector normal = h->vertex()->normal();
+			const typename Mesh::Point& point = h->vertex()->point();
+			for(int k = 0; k < 3; k++)
+			{
+				buffer.push_back((float)normal[k]);
+				buffer.push_back((float)point[k]);
+			}
+		}
+		while(++h != pFacet->facet_begin());
+	}
+}
+
+template <class Mesh>
+Traversal traverse(Mesh& mesh, int repeats)
+{
+	Traversal t;
+	std::vector<typename Mesh::Point> points;
+	std::vector<float> buffer;
+	for(int r = 0; r < repeats; r++)
+	{
+		Stopwatch normals;
+		mesh.compute_normals();
+		t.normals += normals.ms()/repeats;
+		Stopwatch smoothing;
+		smooth(mesh,points);
+		t.smooth += smoothing.ms()/repeats;
+		Stopwatch drawing;
+		draw(mesh,buffer);
+		t.draw += drawing.ms()/repeats;
+	}
+	return t;
+}
+
+void print_traversal(const char *pName, double scattering, const Traversal& t)
+{
+	std::cout << "  " << std::left << std::setw(14) << pName << std::right
+		<< std::fixed << std::setprecision(2)
+		<< "far edges " << std::setw(5) << 100.0*scattering << " %  "
+		<< "normals " << std::setw(9) << t.normals << " ms  "
+		<< "smooth " << std::setw(9) << t.smooth << " ms  "
+		<< "draw " << std::setw(9) << t.draw << " ms" << std::endl;
+}
+
+template <class Mesh>
+void run(const char *pName, const Mesh_arrays& arrays, int steps, int repeats)
+{
+	std::cout << pName << std::endl;
+	Mesh *pMesh = NULL;
+	if(!bench<Mesh,Sqrt3_op<Mesh,K> >(arrays,steps,&pMesh).ok)
+	{
+		std::cout << "  sqrt3 failed" << std::endl;
+		delete pMesh;
+		return;
+	}
+	std::cout << "  " << pMesh->size_of_vertices() << " vertices after "
+		<< steps << " sqrt3 step(s)" << std::endl;
+
+	double scattering = pMesh->scattering();
+	Traversal before = traverse(*pMesh,repeats);
+	print_traversal("creation",scattering,before);
+
+	std::string error;
+	Stopwatch reorder;
+	if(!pMesh->reorder(error))
+	{
+		std::cout << "  reorder: " << error << std::endl;
+		delete pMesh;
+		return;
+	}
+	double reorder_ms = reorder.ms();
+	scattering = pMesh->scattering();
+	Traversal after = traverse(*pMesh,repeats);
+	print_traversal("Hilbert",scattering,after);
+
+	std::cout << "  reorder " << reorder_ms << " ms  speedup normals "
+		<< std::setprecision(2) << before.normals/std::max(after.normals,1e-3) << "x  smooth "
+		<< before.smooth/std::max(after.smooth,1e-3) << "x  draw "
+		<< before.draw/std::max(after.draw,1e-3) << "x" << std::endl;
+	delete pMesh;
+}
+
+int main(int argc, char *argv[])
+{
+	if(argc < 2)
+	{
+		std::cerr << "usage: " << argv[0] << " model.off|model.obj [sqrt3 steps] [repeats]" << std::endl;
+		return 1;
+	}
+	int steps = argc > 2 ? std::atoi(argv[2]) : 3;
+	int repeats = argc > 3 ? std::max(1,std::atoi(argv[3])) : 10;
+
+	Mesh_arrays arrays;
+	if(!load_model<K>(argv[1],arrays))
+		return 1;
+
+	run<Polyhedron>("Polyhedron",arrays,steps,repeats);
+	run<Surface_mesh>("Surface_mesh",arrays,steps,repeats);
+	return 0;
+}
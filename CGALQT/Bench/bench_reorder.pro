@@ -0,0 +1,7 @@
+# console benchmark of the Hilbert reordering, see CGAL/mesh_reorder.h
+TARGET        = bench_reorder
+include(bench.pri)
+
+HEADERS += ../CGAL/surface_mesh.h \
+	../CGAL/mesh_reorder.h
+SOURCES += ./bench_reorder.cpp
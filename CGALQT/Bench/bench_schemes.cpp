@@ -0,0 +1,219 @@
+/************************************************************************/
+/* bench_schemes                                                        */
+/* Loop, Catmull-Clark and Doo-Sabin through CGAL::Subdivision_method_3 */
+/* and through the arrays of CGAL/subdivision.h from 1 to N threads,   */
+/* and checks the arrays give the mesh of CGAL: the same points and    */
+/* facets in the same order, or else the same facets, corner by corner */
+/* and oriented alike, between the same points in another order         */
+/*                                                                      */
+/* usage: bench_schemes model [iterations] [max threads] [repeats]      */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "surface_mesh.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+typedef K::FT FT;
+
+enum Match { DIFFERENT, SAME_MESH, SAME_ORDER };
+
+// the points and the facets in iteration order, each facet from its
+// halfedge
+template <class Mesh>
+void get_mesh(Mesh& mesh, Mesh_arrays& arrays)
+{
+	arrays.clear();
+	get_points(mesh,arrays.points);
+	mesh.set_index_vertices();
+	for(typename Mesh::Facet_iterator pFacet = mesh.facets_begin();
+		pFacet != mesh.facets_end();
+		pFacet++)
+	{
+		typename Mesh::Halfedge_around_facet_circulator h = pFacet->facet_begin();
+		do
+			arrays.facet_vertices.push_back(h->vertex()->tag());
+		while(++h != pFacet->facet_begin());
+		arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+	}
+}
+
+// orders the vertex indices by x,y,z
+struct Point_less
+{
+	const std::vector<FT> *pPoints;
+	bool operator()(int a, int b) const
+	{
+		const FT *pa = &(*pPoints)[3*a];
+		const FT *pb = &(*pPoints)[3*b];
+		return std::lexicographical_compare(pa,pa+3,pb,pb+3);
+	}
+};
+
+// the vertices sorted by point, false if two share a point
+bool sort_vertices(const Mesh_arrays& arrays, std::vector<int>& order)
+{
+	std::size_t nb_vertices = arrays.size_of_vertices();
+	order.resize(nb_vertices);
+	for(std::size_t v = 0; v < nb_vertices; v++)
+		order[v] = (int)v;
+	Point_less less;
+	less.pPoints = &arrays.points;
+	std::sort(order.begin(),order.end(),less);
+	for(std::size_t i = 1; i < nb_vertices; i++)
+		if(!less(order[i-1],order[i]))
+			return false;
+	return true;
+}
+
+// the facets through 'label', each rotated to start at its lowest
+// vertex, then sorted
+void canonical_facets(const Mesh_arrays& arrays, const std::vector<int>& label,
+					  std::vector<std::vector<int> >& facets)
+{
+	facets.resize(arrays.size_of_facets());
+	for(std::size_t f = 0; f < facets.size(); f++)
+	{
+		std::vector<int>& facet = facets[f];
+		facet.clear();
+		for(unsigned int i = arrays.facet_begin[f]; i < arrays.facet_begin[f+1]; i++)
+			facet.push_back(label[arrays.facet_vertices[i]]);
+		std::rotate(facet.begin(),std::min_element(facet.begin(),facet.end()),facet.end());
+	}
+	std::sort(facets.begin(),facets.end());
+}
+
+// the vertices of 'arrays' are matched to those of 'cgal' by point,
+// bit for bit, then the facets are compared through that match
+Match compare(const Mesh_arrays& arrays, const Mesh_arrays& cgal)
+{
+	if(arrays.points == cgal.points &&
+	   arrays.facet_begin == cgal.facet_begin &&
+	   arrays.facet_vertices == cgal.facet_vertices)
+		return SAME_ORDER;
+	if(arrays.size_of_vertices() != cgal.size_of_vertices() ||
+	   arrays.size_of_facets() != cgal.size_of_facets())
+		return DIFFERENT;
+
+	std::vector<int> order, cgal_order;
+	if(!sort_vertices(arrays,order) || !sort_vertices(cgal,cgal_order))
+	{
+		std::cout << "  (two vertices share a point, the facets are not compared)" << std::endl;
+		return DIFFERENT;
+	}
+	std::vector<int> label(order.size()), cgal_label(order.size());
+	for(std::size_t i = 0; i < order.size(); i++)
+	{
+		if(!std::equal(&arrays.points[3*order[i]],&arrays.points[3*order[i]]+3,
+					   &cgal.points[3*cgal_order[i]]))
+			return DIFFERENT;
+		label[order[i]] = (int)i;
+		cgal_label[cgal_order[i]] = (int)i;
+	}
+	std::vector<std::vector<int> > facets, cgal_facets;
+	canonical_facets(arrays,label,facets);
+	canonical_facets(cgal,cgal_label,cgal_facets);
+	return facets == cgal_facets ? SAME_MESH : DIFFERENT;
+}
+
+const char *match_name(Match match)
+{
+	switch(match)
+	{
+	case SAME_ORDER: return "same as CGAL";
+	case SAME_MESH: return "same mesh as CGAL, other order";
+	default: return "DIFFERENT FROM CGAL";
+	}
+}
+
+// the mean time of Op over 'repeats' runs, the last result in *ppResult
+template <class Mesh, class Op>
+double time_op(const Mesh_arrays& arrays, int iter, int repeats, Mesh **ppResult)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Mesh *pMesh = NULL;
+		Timing t = bench<Mesh,Op>(arrays,iter,&pMesh);
+		if(!t.ok)
+		{
+			delete pMesh;
+			return -1.0;
+		}
+		ms += t.subdivide/repeats;
+		if(r+1 < repeats)
+			delete pMesh;
+		else
+			*ppResult = pMesh;
+	}
+	return ms;
+}
+
+template <template <class> class Cgal_op, template <class,class> class Arrays_op>
+void run(const char *pName, const Mesh_arrays& arrays, int iter,
+		 unsigned int max_threads, int repeats)
+{
+	std::cout << pName << std::endl;
+	Polyhedron *pCgal = NULL;
+	double cgal_ms = time_op<Polyhedron,Cgal_op<Polyhedron> >(arrays,iter,repeats,&pCgal);
+	if(cgal_ms < 0.0)
+	{
+		std::cout << "  CGAL failed" << std::endl;
+		return;
+	}
+	Mesh_arrays cgal_mesh;
+	get_mesh(*pCgal,cgal_mesh);
+	std::cout << "  CGAL         " << std::fixed << std::setprecision(2)
+		<< std::setw(9) << cgal_ms << " ms  " << pCgal->size_of_facets() << " facets" << std::endl;
+
+	for(unsigned int nb_threads = 1; nb_threads <= max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		Polyhedron *pPolyhedron = NULL;
+		Surface_mesh *pSurface = NULL;
+		double polyhedron_ms = time_op<Polyhedron,Arrays_op<Polyhedron,K> >(arrays,iter,repeats,&pPolyhedron);
+		double surface_ms = time_op<Surface_mesh,Arrays_op<Surface_mesh,K> >(arrays,iter,repeats,&pSurface);
+		if(polyhedron_ms < 0.0 || surface_ms < 0.0)
+		{
+			std::cout << "  " << std::setw(2) << nb_threads << " thread(s) arrays refused the mesh" << std::endl;
+			delete pPolyhedron;
+			delete pSurface;
+			continue;
+		}
+
+		Mesh_arrays polyhedron_mesh, surface_mesh;
+		get_mesh(*pPolyhedron,polyhedron_mesh);
+		get_mesh(*pSurface,surface_mesh);
+		std::cout << "  " << std::setw(2) << nb_threads << " thread(s) "
+			<< "Polyhedron " << std::setw(9) << polyhedron_ms << " ms  "
+			<< "Surface_mesh " << std::setw(9) << surface_ms << " ms  "
+			<< "speedup " << std::setw(5) << cgal_ms/std::max(polyhedron_ms,1e-3) << "x" << std::endl
+			<< "             Polyhedron " << match_name(compare(polyhedron_mesh,cgal_mesh))
+			<< ", Surface_mesh " << match_name(compare(surface_mesh,cgal_mesh)) << std::endl;
+		delete pPolyhedron;
+		delete pSurface;
+	}
+	ParallelUtils::set_nb_threads(0);
+	delete pCgal;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(3,3);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv) || !load_model<K>(args.pModel,arrays))
+		return 1;
+
+	run<Loop_op,Loop_arrays_op>("Loop",arrays,args.iter,args.max_threads,args.repeats);
+	run<Catmullclark_op,Catmullclark_arrays_op>("CatmullClark",arrays,args.iter,args.max_threads,args.repeats);
+	run<Doosabin_op,Doosabin_arrays_op>("DooSabin",arrays,args.iter,args.max_threads,args.repeats);
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of Loop, Catmull-Clark and Doo-Sabin, CGAL against CGAL/subdivision.h
+TARGET        = bench_schemes
+include(bench.pri)
+
+HEADERS += ../CGAL/surface_mesh.h
+SOURCES += ./bench_schemes.cpp
@@ -0,0 +1,80 @@
+/************************************************************************/
+/* bench_smooth                                                         */
+/* times the quad-triangle smoothing pass from 1 to N threads on the   */
+/* quad-triangle subdivided model, and checks the positions are the     */
+/* same bits as with one thread                                         */
+/*                                                                      */
+/* usage: bench_smooth model [iterations] [max threads] [repeats]       */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <vector>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "surface_mesh.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+typedef K::FT FT;
+
+template <class Mesh>
+void run(const char *pName, const Mesh_arrays& arrays, int iter, unsigned int max_threads, int repeats)
+{
+	typedef CModifierQuadTriangle<typename Mesh::HalfedgeDS,Mesh,K> Modifier;
+
+	std::cout << pName << std::endl;
+	Mesh *pMesh = NULL;
+	if(!bench<Mesh,Quad_triangle_op<Mesh,K> >(arrays,iter,&pMesh).ok)
+	{
+		std::cout << "  quad-triangle failed" << std::endl;
+		delete pMesh;
+		return;
+	}
+	std::cout << "  " << pMesh->size_of_vertices() << " vertices after "
+		<< iter << " quad-triangle step(s)" << std::endl;
+
+	std::vector<FT> original, serial, smoothed;
+	get_points(*pMesh,original);
+	double serial_ms = 0.0;
+	for(unsigned int nb_threads = 1; nb_threads <= max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		double ms = 0.0;
+		for(int r = 0; r < repeats; r++)
+		{
+			set_points(*pMesh,original);
+			Stopwatch smooth;
+			Modifier::smooth(pMesh,true);
+			ms += smooth.ms()/repeats;
+		}
+		get_points(*pMesh,smoothed);
+		if(nb_threads == 1)
+		{
+			serial = smoothed;
+			serial_ms = ms;
+		}
+		std::cout << "  " << std::setw(2) << nb_threads << " thread(s) "
+			<< std::fixed << std::setprecision(2)
+			<< "smooth " << std::setw(9) << ms << " ms  "
+			<< "speedup " << std::setw(5) << serial_ms/std::max(ms,1e-3) << "x  "
+			<< (smoothed == serial ? "same bits" : "DIFFERENT") << std::endl;
+	}
+	ParallelUtils::set_nb_threads(0);
+	delete pMesh;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(3,5);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv) || !load_model<K>(args.pModel,arrays))
+		return 1;
+
+	run<Polyhedron>("Polyhedron",arrays,args.iter,args.max_threads,args.repeats);
+	run<Surface_mesh>("Surface_mesh",arrays,args.iter,args.max_threads,args.repeats);
+	return 0;
+}
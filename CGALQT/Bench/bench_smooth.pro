@@ -0,0 +1,6 @@
+# console benchmark of the parallel quad-triangle smoothing, see CGAL/quad-triangle.h
+TARGET        = bench_smooth
+include(bench.pri)
+
+HEADERS += ../CGAL/surface_mesh.h
+SOURCES += ./bench_smooth.cpp
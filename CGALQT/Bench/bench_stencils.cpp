@@ -0,0 +1,124 @@
+/************************************************************************/
+/* bench_stencils                                                       */
+/* builds the stencil tables of Loop, Catmull-Clark, quad/triangle and  */
+/* sqrt3 to a level, moves the control points, then compares a full     */
+/* subdivision of the moved mesh with one product of the table from    */
+/* 1 to N threads, and the largest difference between their points     */
+/*                                                                      */
+/* usage: bench_stencils model [levels] [max threads] [repeats]         */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "stencil_table.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+typedef K::FT FT;
+typedef CStencil_builder<Polyhedron,K> Builder;
+
+// every coordinate moved by up to 'amount' of the bounding box
+void move_points(Mesh_arrays& arrays, FT amount)
+{
+	std::size_t nb = arrays.points.size();
+	if(nb == 0)
+		return;
+	FT lo = *std::min_element(arrays.points.begin(),arrays.points.end());
+	FT hi = *std::max_element(arrays.points.begin(),arrays.points.end());
+	std::srand(1);
+	for(std::size_t i = 0; i < nb; i++)
+		arrays.points[i] += amount * (hi - lo) * ((FT)std::rand()/RAND_MAX - (FT)0.5);
+}
+
+template <template <class,class> class Op>
+void run(const char *pName, typename Builder::Scheme scheme,
+		 const Mesh_arrays& arrays, const Mesh_arrays& moved,
+		 int levels, unsigned int max_threads, int repeats)
+{
+	std::cout << pName << std::endl;
+	std::string error;
+	Polyhedron refined;
+	if(!refined.build(arrays,error))
+	{
+		std::cout << "  build: " << error << std::endl;
+		return;
+	}
+
+	Builder builder;
+	Builder::Table table;
+	Stopwatch build;
+	if(!builder.build(refined,scheme,levels,table))
+	{
+		std::cout << "  the table refused the mesh" << std::endl;
+		return;
+	}
+	std::cout << "  table        " << std::fixed << std::setprecision(2)
+		<< std::setw(9) << build.ms() << " ms  " << table.size_of_rows() << " rows  "
+		<< table.size_of_weights() << " weights  " << table.bytes()/1024 << " KB" << std::endl;
+
+	// the moved mesh subdivided again
+	Polyhedron *pSubdivided = NULL;
+	Timing t = bench<Polyhedron,Op<Polyhedron,K> >(moved,levels,&pSubdivided);
+	if(!t.ok || pSubdivided->size_of_vertices() != table.size_of_rows())
+	{
+		std::cout << "  subdivision failed" << std::endl;
+		delete pSubdivided;
+		return;
+	}
+	std::vector<FT> expected;
+	get_points(*pSubdivided,expected);
+	delete pSubdivided;
+	std::cout << "  subdivide    " << std::setw(9) << t.subdivide << " ms" << std::endl;
+
+	std::vector<FT> controls(moved.points.begin(),moved.points.end());
+	std::vector<FT> points(expected.size());
+	for(unsigned int nb_threads = 1; nb_threads <= max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		double ms = 0.0;
+		for(int r = 0; r < repeats; r++)
+		{
+			Stopwatch apply;
+			table.apply(&controls[0],&points[0]);
+			ms += apply.ms()/repeats;
+		}
+		FT difference = 0;
+		for(std::size_t i = 0; i < points.size(); i++)
+			difference = std::max(difference,(FT)std::fabs(points[i] - expected[i]));
+		std::cout << "  " << std::setw(2) << nb_threads << " thread(s) "
+			<< "apply " << std::setw(9) << ms << " ms  "
+			<< "speedup " << std::setw(7) << t.subdivide/std::max(ms,1e-3) << "x  "
+			<< "difference " << std::scientific << std::setprecision(1) << difference
+			<< std::fixed << std::setprecision(2) << std::endl;
+	}
+	ParallelUtils::set_nb_threads(0);
+
+	Stopwatch set;
+	set_points(refined,points);
+	std::cout << "  set points   " << std::setw(9) << set.ms() << " ms" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(4,10);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv,"[levels] [max threads] [repeats]") || !load_model<K>(args.pModel,arrays))
+		return 1;
+	Mesh_arrays moved = arrays;
+	move_points(moved,(FT)0.01);
+
+	run<Loop_arrays_op>("Loop",Builder::LOOP,arrays,moved,args.iter,args.max_threads,args.repeats);
+	run<Catmullclark_arrays_op>("CatmullClark",Builder::CATMULL_CLARK,arrays,moved,args.iter,args.max_threads,args.repeats);
+	run<Quad_triangle_op>("QuadTriangle",Builder::QUAD_TRIANGLE,arrays,moved,args.iter,args.max_threads,args.repeats);
+	run<Sqrt3_op>("Sqrt3",Builder::SQRT3,arrays,moved,args.iter,args.max_threads,args.repeats);
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of the stencil tables of CGAL/stencil_table.h against subdividing again
+TARGET        = bench_stencils
+include(bench.pri)
+
+HEADERS += ../CGAL/stencil_table.h
+SOURCES += ./bench_stencils.cpp
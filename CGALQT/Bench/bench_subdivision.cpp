@@ -0,0 +1,69 @@
+/************************************************************************/
+/* bench_subdivision                                                    */
+/* times every operation of the Subdivision menu on both mesh backends: */
+/* the list based Polyhedron and the index based Surface_mesh           */
+/*                                                                      */
+/* usage: bench_subdivision model [iterations]                          */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "surface_mesh.h"
+#include "bench.h"
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+void print_speedup(const Timing& polyhedron, const Timing& surface)
+{
+	if(polyhedron.ok && surface.ok && surface.subdivide > 0.0)
+		std::cout << "  speedup       " << std::setprecision(2)
+			<< polyhedron.subdivide / surface.subdivide << "x" << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(1);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv,"[iterations]") || !load_model<K>(args.pModel,arrays))
+		return 1;
+	int iter = args.iter;
+
+	Timing p, s;
+
+	std::cout << "Sqrt3" << std::endl;
+	print_timing("Polyhedron",p = bench<Polyhedron,Sqrt3_op<Polyhedron,K> >(arrays,iter));
+	print_timing("Surface_mesh",s = bench<Surface_mesh,Sqrt3_op<Surface_mesh,K> >(arrays,iter));
+	print_speedup(p,s);
+
+	std::cout << "Quad-Triangle" << std::endl;
+	print_timing("Polyhedron",p = bench<Polyhedron,Quad_triangle_op<Polyhedron,K> >(arrays,iter));
+	print_timing("Surface_mesh",s = bench<Surface_mesh,Quad_triangle_op<Surface_mesh,K> >(arrays,iter));
+	print_speedup(p,s);
+
+	// CGAL::Subdivision_method_3 needs a Polyhedron_3, the arrays
+	// versions run on both
+	std::cout << "DooSabin" << std::endl;
+	print_timing("Polyhedron",p = bench<Polyhedron,Doosabin_op<Polyhedron> >(arrays,iter));
+	print_timing("arrays",s = bench<Polyhedron,Doosabin_arrays_op<Polyhedron,K> >(arrays,iter));
+	print_speedup(p,s);
+	print_timing("Surface_mesh",bench<Surface_mesh,Doosabin_arrays_op<Surface_mesh,K> >(arrays,iter));
+
+	std::cout << "CatmullClark" << std::endl;
+	print_timing("Polyhedron",p = bench<Polyhedron,Catmullclark_op<Polyhedron> >(arrays,iter));
+	print_timing("arrays",s = bench<Polyhedron,Catmullclark_arrays_op<Polyhedron,K> >(arrays,iter));
+	print_speedup(p,s);
+	print_timing("Surface_mesh",bench<Surface_mesh,Catmullclark_arrays_op<Surface_mesh,K> >(arrays,iter));
+
+	std::cout << "Loop" << std::endl;
+	print_timing("Polyhedron",p = bench<Polyhedron,Loop_op<Polyhedron> >(arrays,iter));
+	print_timing("arrays",s = bench<Polyhedron,Loop_arrays_op<Polyhedron,K> >(arrays,iter));
+	print_speedup(p,s);
+	print_timing("Surface_mesh",bench<Surface_mesh,Loop_arrays_op<Surface_mesh,K> >(arrays,iter));
+
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of the Subdivision menu on both mesh backends
+TARGET        = bench_subdivision
+include(bench.pri)
+
+HEADERS += ../CGAL/surface_mesh.h
+SOURCES += ./bench_subdivision.cpp
@@ -0,0 +1,175 @@
+/************************************************************************/
+/* bench_write                                                          */
+/* saves the Catmull-Clark subdivided model as .obj and .off: the       */
+/* replaced write_obj and CGAL stream operator, then Text_mesh_writer   */
+/* from 1 to N threads, against one fwrite of the same bytes, left in  */
+/* the page cache and synced to the disk                                */
+/*                                                                      */
+/* usage: bench_write model [levels] [max threads] [repeats]            */
+/************************************************************************/
+#include <QtOpenGL>
+
+//stl
+#include <iostream>
+#include <fstream>
+#include <cstdio>
+#include <string>
+
+//cgal
+#include "enriched_polyhedron.h"
+#include "mesh_text.h"
+#include "bench.h"
+#include <CGAL/IO/Polyhedron_iostream.h>
+
+typedef Indexed_mesh<Enriched_Polyhedron_kernel::FT> Mesh_arrays;
+typedef Enriched_Polyhedron_kernel K;
+
+// the write_obj Text_mesh_writer replaced, one std::endl per line
+void write_obj_endl(const char *pFilename, Polyhedron& mesh)
+{
+	std::ofstream stream(pFilename);
+	for(Polyhedron::Vertex_iterator pVertex = mesh.vertices_begin();
+		pVertex != mesh.vertices_end();
+		pVertex++)
+		stream << 'v' << ' ' << pVertex->point().x() << ' ' <<
+		pVertex->point().y() << ' ' <<
+		pVertex->point().z() << std::endl;
+
+	int index = 0;
+	for(Polyhedron::Vertex_iterator pVertex = mesh.vertices_begin();
+		pVertex != mesh.vertices_end();
+		pVertex++)
+		pVertex->tag(index++);
+
+	for(Polyhedron::Facet_iterator pFacet = mesh.facets_begin();
+		pFacet != mesh.facets_end();
+		pFacet++)
+	{
+		stream << 'f';
+		Polyhedron::Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
+		do
+		stream << ' ' << pHalfedge->vertex()->tag()+1;
+		while(++pHalfedge != pFacet->facet_begin());
+		stream << std::endl;
+	}
+}
+
+// the OFF save Text_mesh_writer replaced
+void write_off_stream(const char *pFilename, Polyhedron& mesh)
+{
+	std::ofstream stream(pFilename);
+	stream << mesh;
+}
+
+// the bytes of 'filename' written again in one fwrite, what the page
+// cache or with 'sync' the disk takes without any formatting
+double write_raw(const std::string& filename, const std::string& copy, bool sync)
+{
+	MappedFile file;
+	if(!file.open(filename.c_str()))
+		return -1.0;
+	Stopwatch write;
+	FILE *pFile = fopen(copy.c_str(),"wb");
+	if(pFile == NULL)
+		return -1.0;
+	bool ok = fwrite(file.begin(),1,file.size(),pFile) == file.size();
+#ifndef _WIN32
+	if(sync)
+		ok = fflush(pFile) == 0 && fdatasync(fileno(pFile)) == 0 && ok;
+#endif
+	ok = fclose(pFile) == 0 && ok;
+	double ms = write.ms();
+	boost::filesystem::remove(copy);
+	return ok ? ms : -1.0;
+}
+
+template <class Write>
+double time_write(const std::string& filename, int repeats, Write write)
+{
+	double ms = 0.0;
+	for(int r = 0; r < repeats; r++)
+	{
+		Stopwatch stopwatch;
+		write(filename.c_str());
+		ms += stopwatch.ms()/repeats;
+	}
+	return ms;
+}
+
+struct Endl_obj
+{
+	Polyhedron *pMesh;
+	void operator()(const char *pFilename) const { write_obj_endl(pFilename,*pMesh); }
+};
+struct Stream_off
+{
+	Polyhedron *pMesh;
+	void operator()(const char *pFilename) const { write_off_stream(pFilename,*pMesh); }
+};
+struct Writer_obj
+{
+	Polyhedron *pMesh;
+	void operator()(const char *pFilename) const { Text_mesh_writer<Polyhedron> writer; writer.write_obj(pFilename,*pMesh); }
+};
+struct Writer_off
+{
+	Polyhedron *pMesh;
+	void operator()(const char *pFilename) const { Text_mesh_writer<Polyhedron> writer; writer.write_off(pFilename,*pMesh); }
+};
+
+void print_line(const char *pName, double ms, double mb, double raw_ms)
+{
+	std::cout << "  " << std::left << std::setw(22) << pName << std::right
+		<< std::fixed << std::setprecision(2) << std::setw(10) << ms << " ms  "
+		<< std::setprecision(0) << std::setw(6) << mb/std::max(ms,1e-3)*1000.0 << " MB/s  "
+		<< std::setprecision(2) << std::setw(6) << ms/std::max(raw_ms,1e-3) << "x the fwrite" << std::endl;
+}
+
+template <class Baseline, class Writer>
+void run(const char *pFormat, const char *pBaseline, Polyhedron *pMesh, const Bench_args& args)
+{
+	std::string filename = temporary_filename(pFormat);
+	Baseline baseline = { pMesh };
+	Writer writer = { pMesh };
+
+	// the file of the writer gives the size and the fwrite time
+	writer(filename.c_str());
+	double mb = file_mb(filename);
+	double raw_ms = write_raw(filename,filename + ".raw",false);
+	double sync_ms = write_raw(filename,filename + ".raw",true);
+	std::cout << pFormat << ": " << std::fixed << std::setprecision(1) << mb << " MB" << std::endl;
+	print_line("fwrite",raw_ms,mb,raw_ms);
+	print_line("fwrite + fdatasync",sync_ms,mb,raw_ms);
+	print_line(pBaseline,time_write(filename,args.repeats,baseline),mb,raw_ms);
+	for(unsigned int nb_threads = 1; nb_threads <= args.max_threads; nb_threads++)
+	{
+		ParallelUtils::set_nb_threads(nb_threads);
+		std::string name = "Text_mesh_writer " + StringUtils::to_string(nb_threads);
+		print_line(name.c_str(),time_write(filename,args.repeats,writer),mb,raw_ms);
+	}
+	ParallelUtils::set_nb_threads(0);
+	boost::filesystem::remove(filename);
+}
+
+int main(int argc, char *argv[])
+{
+	Bench_args args(4,3);
+	Mesh_arrays arrays;
+	if(!args.parse(argc,argv,"[levels] [max threads] [repeats]") || !load_model<K>(args.pModel,arrays))
+		return 1;
+
+	Polyhedron *pMesh = NULL;
+	if(!bench<Polyhedron,Catmullclark_arrays_op<Polyhedron,K> >(arrays,args.iter,&pMesh).ok)
+	{
+		std::cerr << "Catmull-Clark failed" << std::endl;
+		delete pMesh;
+		return 1;
+	}
+	std::cout << args.iter << " Catmull-Clark level(s): " << pMesh->size_of_vertices() << " vertices, "
+		<< pMesh->size_of_facets() << " facets" << std::endl;
+
+	run<Endl_obj,Writer_obj>(".obj","write_obj, std::endl",pMesh,args);
+	run<Stream_off,Writer_off>(".off","operator<<",pMesh,args);
+	delete pMesh;
+	return 0;
+}
@@ -0,0 +1,6 @@
+# console benchmark of the OBJ and OFF writers against the disk, see CGAL/mesh_text.h
+TARGET        = bench_write
+include(bench.pri)
+
+HEADERS += ../CGAL/mesh_text.h
+SOURCES += ./bench_write.cpp
@@ -30,6 +30,8 @@ Enriched incremental builder for CGAL Polyhedral Surfaces.
 #include <CGAL/IO/Verbose_ostream.h>
 #include <vector>
 #include <cstddef>
+#include <algorithm>
+#include <boost/cstdint.hpp>
 
 CGAL_BEGIN_NAMESPACE
 
@@ -79,6 +81,17 @@ protected:
     bool                      first_vertex;
     bool                      last_vertex;
 
+    // Optional hash map from the vertex index pair (w,v) to the halfedge
+    // from w to v, see use_edge_map(). Open addressing, a power of 2
+    // slots, at most half full.
+    struct Edge_slot {
+        boost::uint64_t       key;
+        Halfedge_handle       h;   // 0 denotes an empty slot.
+    };
+    bool                      m_use_edge_map;
+    std::vector< Edge_slot>   edge_map;
+    size_type                 edge_map_size;
+
     CGAL_assertion_code( int check_protocoll;)  // use to check protocoll.
     // states for checking: 0 = created, 1 = constructing, 2 = make face.
 
@@ -142,6 +155,53 @@ protected:
         set_vertex_to_edge_map( i, h, Supports_vertex_halfedge());
     }
 
+    // The edge map.
+    // ----------------------------------------------------
+    static boost::uint64_t edge_key( size_type w, size_type v) {
+        return ( boost::uint64_t( w) << 32) | boost::uint64_t( v);
+    }
+    std::size_t edge_slot( boost::uint64_t key) const {
+        std::size_t mask = edge_map.size() - 1;
+        boost::uint32_t hash = boost::uint32_t( key >> 32) * 0x9E3779B1u
+                             ^ boost::uint32_t( key) * 0x85EBCA77u;
+        std::size_t i = ( hash ^ ( hash >> 15)) & mask;
+        while ( edge_map[i].h != Halfedge_handle() && edge_map[i].key != key)
+            i = ( i + 1) & mask;
+        return i;
+    }
+    void initialize_edge_map( size_type h) {
+        edge_map.clear();
+        edge_map_size = 0;
+        if ( ! m_use_edge_map)
+            return;
+        std::size_t n = 16;
+        while ( n < 2 * h)
+            n *= 2;
+        Edge_slot empty;
+        empty.key = 0;
+        edge_map.resize( n, empty);
+    }
+    Halfedge_handle find_edge( size_type w, size_type v) const {
+        return edge_map[ edge_slot( edge_key( w, v))].h;
+    }
+    void insert_edge( size_type w, size_type v, Halfedge_handle h) {
+        if ( 2 * ( edge_map_size + 1) > edge_map.size()) {
+            std::vector< Edge_slot> old;
+            old.swap( edge_map);
+            Edge_slot empty;
+            empty.key = 0;
+            edge_map.resize( 2 * old.size(), empty);
+            for ( std::size_t i = 0; i < old.size(); ++i)
+                if ( old[i].h != Halfedge_handle())
+                    edge_map[ edge_slot( old[i].key)] = old[i];
+        }
+        Edge_slot& slot = edge_map[ edge_slot( edge_key( w, v))];
+        if ( slot.h == Halfedge_handle())
+            ++edge_map_size;
+        slot.key = edge_key( w, v);
+        slot.h = h;
+    }
+
 // An Incremental Builder for Polyhedral Surfaces
 // ----------------------------------------------
 // DEFINITION
@@ -173,7 +233,8 @@ public:
         // internal state. The previous polyhedral surface in `h'
         // remains unchanged. The incremental builder adds the new
         // polyhedral surface to the old one.
-      : m_error( false), m_verbose( verbose), hds(h) {
+      : m_error( false), m_verbose( verbose), hds(h),
+        m_use_edge_map( false), edge_map_size( 0) {
         CGAL_assertion_code(check_protocoll = 0;)
     }
 
@@ -184,6 +245,27 @@ public:
 // OPERATIONS
     enum { CGAL_RELATIVE = 0, CGAL_ABSOLUTE = 1};
 
+    // valence from which the edge map pays for its memory
+    enum { EDGE_MAP_VALENCE = 32 };
+
+    void use_edge_map( bool b) { m_use_edge_map = b; }
+        // with b, the halfedge between two vertices is found in a hash
+        // map keyed by their indices instead of by walking around the
+        // first vertex, the building is then linear in the valence.
+        // To be called before begin_surface().
+
+    template <class BeginIterator, class IndexIterator>
+    bool test_facets( BeginIterator facet_begin, std::size_t nf,
+                      IndexIterator indices, std::size_t nv,
+                      std::size_t& h, std::size_t& max_valence);
+        // tests the nf facets given as index lists, facet i being
+        // indices[facet_begin[i]..facet_begin[i+1]), before any of them
+        // is added: at least 3 vertices, indices in [0,nv), no vertex
+        // twice in a facet and no halfedge in two facets. h is then the
+        // exact number of halfedges, border included, and max_valence
+        // the largest number of facets around a vertex. Non-manifold
+        // vertices are still reported by add_vertex_to_facet().
+
 
     void begin_surface( std::size_t v, std::size_t f, std::size_t h = 0,
                         int mode = CGAL_RELATIVE);
@@ -387,7 +469,24 @@ protected:
         CGAL_assertion( ! last_vertex);
         HalfedgeDS_items_decorator<HDS> decorator;
         Halfedge_handle e = get_vertex_to_edge_map( w);
-        if ( e != Halfedge_handle()) {
+        if ( e != Halfedge_handle() && ! edge_map.empty()) {
+            // same checks as the walk below on the halfedge from the map
+            if ( current_face != Face_handle()
+                 && current_face == decorator.get_face(e)) {
+                Verbose_ostream verr( m_verbose);
+                verr << " " << std::endl;
+                verr << "CGAL::Enriched_polyhedron_incremental_builder_3<HDS>::"
+                     << std::endl;
+                verr << "lookup_halfedge(): input error: facet "
+                     << new_faces << " has a self intersection at vertex "
+                     << w << "." << std::endl;
+                m_error = true;
+                return Halfedge_handle();
+            }
+            Halfedge_handle g = find_edge( w, v);
+            if ( g != Halfedge_handle())
+                return use_halfedge( decorator.get_prev( g), w, v);
+        } else if ( e != Halfedge_handle()) {
             CGAL_assertion( e->vertex() == index_to_vertex_map[w]);
             // check that the facet has no self intersections
             if ( current_face != Face_handle()
@@ -404,42 +503,8 @@ protected:
             }
             Halfedge_handle start_edge( e);
             do {
-                if ( e->next()->vertex() == index_to_vertex_map[v]) {
-                    if ( ! e->next()->is_border()) {
-                        Verbose_ostream verr( m_verbose);
-                        verr << " " << std::endl;
-                        verr << "CGAL::Enriched_polyhedron_incremental_builder_3"
-                                "<HDS>::" << std::endl;
-                        verr << "lookup_halfedge(): input error: facet "
-                             << new_faces << " shares a halfedge from "
-                                "vertex " <<  w << " to vertex " << v
-                             << " with";
-                        if (  m_verbose && current_face != Face_handle())
-                            verr << " facet "
-                                 << find_facet( decorator.get_face(e->next()))
-                                 << '.' << std::endl;
-                        else
-                            verr << " another facet." << std::endl;
-                        m_error = true;
-                        return Halfedge_handle();
-                    }
-                    CGAL_assertion( ! e->next()->opposite()->is_border());
-                    if ( current_face != Face_handle() && current_face ==
-                         decorator.get_face( e->next()->opposite())) {
-                        Verbose_ostream verr( m_verbose);
-                        verr << " " << std::endl;
-                        verr << "CGAL::Enriched_polyhedron_incremental_builder_3"
-                                "<HDS>::" << std::endl;
-                        verr << "lookup_halfedge(): input error: facet "
-                             << new_faces << " has a self intersection "
-                                "at the halfedge from vertex " << w
-                             << " to vertex " << v << "." << std::endl;
-                        m_error = true;
-                        return Halfedge_handle();
-                    }
-                    decorator.set_face( e->next(), current_face);
-                    return e;
-                }
+                if ( e->next()->vertex() == index_to_vertex_map[v])
+                    return use_halfedge( e, w, v);
                 e = e->next()->opposite();
             } while ( e != start_edge);
         }
@@ -462,12 +527,56 @@ protected:
         e->HBase::set_vertex( index_to_vertex_map[v]);
         e->HBase::set_next( Halfedge_handle());
         decorator.set_prev( e, e->opposite());
+        if ( ! edge_map.empty()) {
+            insert_edge( w, v, e);
+            insert_edge( v, w, e->opposite());
+        }
         e = e->opposite();
         e->HBase::set_vertex( index_to_vertex_map[w]);
         e->HBase::set_next( e->opposite());
         return e;
     }
 
+    Halfedge_handle use_halfedge( Halfedge_handle e, size_type w, size_type v) {
+        // Case a of lookup_halfedge(), e->next() is the existing
+        // halfedge from w to v.
+        HalfedgeDS_items_decorator<HDS> decorator;
+        if ( ! e->next()->is_border()) {
+            Verbose_ostream verr( m_verbose);
+            verr << " " << std::endl;
+            verr << "CGAL::Enriched_polyhedron_incremental_builder_3"
+                    "<HDS>::" << std::endl;
+            verr << "lookup_halfedge(): input error: facet "
+                 << new_faces << " shares a halfedge from "
+                    "vertex " <<  w << " to vertex " << v
+                 << " with";
+            if (  m_verbose && current_face != Face_handle())
+                verr << " facet "
+                     << find_facet( decorator.get_face(e->next()))
+                     << '.' << std::endl;
+            else
+                verr << " another facet." << std::endl;
+            m_error = true;
+            return Halfedge_handle();
+        }
+        CGAL_assertion( ! e->next()->opposite()->is_border());
+        if ( current_face != Face_handle() && current_face ==
+             decorator.get_face( e->next()->opposite())) {
+            Verbose_ostream verr( m_verbose);
+            verr << " " << std::endl;
+            verr << "CGAL::Enriched_polyhedron_incremental_builder_3"
+                    "<HDS>::" << std::endl;
+            verr << "lookup_halfedge(): input error: facet "
+                 << new_faces << " has a self intersection "
+                    "at the halfedge from vertex " << w
+                 << " to vertex " << v << "." << std::endl;
+            m_error = true;
+            return Halfedge_handle();
+        }
+        decorator.set_face( e->next(), current_face);
+        return e;
+    }
+
     Halfedge_handle lookup_hole( Halfedge_handle e) {
         // Halfedge e points to a vertex w. Walk around w to find a hole
         // in the facet structure. Report an error if none exist. Return
@@ -521,6 +630,8 @@ rollback() {
         while ( rollback_f != hds.size_of_faces())
             hds.faces_pop_back();
     }
+    edge_map.clear();
+    edge_map_size = 0;
     m_error = false;
     CGAL_assertion_code( check_protocoll = 0;)
 }
@@ -561,12 +672,102 @@ begin_surface( std::size_t v, std::size_t f, std::size_t h, int mode) {
         index_to_vertex_map = Random_access_index( hds.vertices_end());
         index_to_vertex_map.reserve(v);
         initialize_vertex_to_edge_map( v, false);
+        initialize_edge_map( h);
     } else {
         index_to_vertex_map = Random_access_index( hds.vertices_begin(),
                                                    hds.vertices_end());
         index_to_vertex_map.reserve( hds.size_of_vertices() + v);
         initialize_vertex_to_edge_map( hds.size_of_vertices() + v, true);
+        initialize_edge_map( hds.size_of_halfedges() + h);
+        if ( m_use_edge_map) {
+            // the halfedges of the old surface are in the map too
+            typedef Unique_hash_map< Vertex_iterator, size_type> V_index;
+            V_index v_index( size_type(0), hds.size_of_vertices());
+            size_type i = 0;
+            for ( Vertex_iterator vi = hds.vertices_begin();
+                  vi != hds.vertices_end();
+                  ++vi)
+                v_index[vi] = i++;
+            for ( Halfedge_iterator hi = hds.halfedges_begin();
+                  hi != hds.halfedges_end();
+                  ++hi)
+                insert_edge( v_index[ hi->opposite()->vertex()],
+                             v_index[ hi->vertex()], hi);
+        }
+    }
+}
+
+template < class HDS>
+template < class BeginIterator, class IndexIterator>
+bool
+Enriched_polyhedron_incremental_builder_3<HDS>::
+test_facets( BeginIterator facet_begin, std::size_t nf,
+             IndexIterator indices, std::size_t nv,
+             std::size_t& h, std::size_t& max_valence) {
+    // one key w << 32 | v per halfedge, sorted, a key found twice is a
+    // halfedge in two facets and a key without its reverse a border
+    Verbose_ostream verr( m_verbose);
+    std::vector< boost::uint64_t> keys;
+    keys.reserve( std::size_t( facet_begin[nf] - facet_begin[0]));
+    std::vector< std::size_t> valence( nv, 0);
+    std::vector< std::size_t> facet;
+    for ( std::size_t f = 0; f < nf; ++f) {
+        std::size_t first = std::size_t( facet_begin[f]);
+        std::size_t last = std::size_t( facet_begin[f+1]);
+        if ( last < first + 3) {
+            verr << "CGAL::Enriched_polyhedron_incremental_builder_3<HDS>::"
+                 << std::endl;
+            verr << "test_facets(): input error: facet " << f
+                 << " has less than 3 vertices." << std::endl;
+            return false;
+        }
+        facet.clear();
+        for ( std::size_t i = first; i < last; ++i) {
+            if ( indices[i] < 0 || std::size_t( indices[i]) >= nv) {
+                verr << "CGAL::Enriched_polyhedron_incremental_builder_3<HDS>::"
+                     << std::endl;
+                verr << "test_facets(): input error: vertex index "
+                     << indices[i] << " of facet " << f
+                     << " is out-of-range [0," << nv << ")." << std::endl;
+                return false;
+            }
+            std::size_t w = std::size_t( indices[i]);
+            std::size_t v = std::size_t( indices[ i+1 < last ? i+1 : first]);
+            keys.push_back( edge_key( w, v));
+            facet.push_back( w);
+            ++valence[w];
+        }
+        std::sort( facet.begin(), facet.end());
+        if ( std::adjacent_find( facet.begin(), facet.end()) != facet.end()) {
+            verr << "CGAL::Enriched_polyhedron_incremental_builder_3<HDS>::"
+                 << std::endl;
+            verr << "test_facets(): input error: facet " << f
+                 << " has a self intersection at vertex "
+                 << *std::adjacent_find( facet.begin(), facet.end())
+                 << "." << std::endl;
+            return false;
+        }
+    }
+    std::sort( keys.begin(), keys.end());
+    std::vector< boost::uint64_t>::iterator twice =
+        std::adjacent_find( keys.begin(), keys.end());
+    if ( twice != keys.end()) {
+        verr << "CGAL::Enriched_polyhedron_incremental_builder_3<HDS>::"
+             << std::endl;
+        verr << "test_facets(): input error: two facets share the halfedge "
+                "from vertex " << ( *twice >> 32) << " to vertex "
+             << ( *twice & 0xFFFFFFFFu) << "." << std::endl;
+        return false;
     }
+    h = keys.size();
+    for ( std::size_t i = 0; i < keys.size(); ++i) {
+        boost::uint64_t reverse = ( keys[i] << 32) | ( keys[i] >> 32);
+        if ( ! std::binary_search( keys.begin(), keys.end(), reverse))
+            ++h;
+    }
+    max_valence = valence.empty() ? 0
+        : *std::max_element( valence.begin(), valence.end());
+    return true;
 }
 
 template < class HDS>
@@ -817,6 +1018,14 @@ remove_unconnected_vertices( Tag_true) {
     return true;
 }
 
+// Mesh_builder<HDS>::type is the incremental builder used to fill `HDS'.
+// A mesh that is not a Polyhedron_3 specializes it with its own builder
+// of the same interface, see Enriched_surface_mesh.
+template < class HDS>
+struct Mesh_builder {
+    typedef Enriched_polyhedron_incremental_builder_3<HDS> type;
+};
+
 CGAL_END_NAMESPACE
 
 #endif // CGAL_USE_POLYHEDRON_DESIGN_ONE //
@@ -8,18 +8,27 @@
 #define POLYGON_MESH_H
 
 #include "config.h"
-#include <CGAL/Cartesian.h>
 #include <CGAL/Polyhedron_3.h>
+#include "mesh_kernel.h"
+#include "mesh_allocator.h"
 #include <list>
 #include <vector>
+#include <iterator>
 #include <string>
 #include "uglyfont.h"
 #include "stringutils.h"
-
-// tag for processhits
-struct processhits_normal{};
-struct processhits_plus{};
-struct processhits_minus{};
+#include "indexed_mesh.h"
+#include "parser_off.h"
+#include "mesh_binary.h"
+#include "mesh_archive.h"
+#include "mesh_text.h"
+#include "mesh_ply.h"
+#include "mesh_stl.h"
+#include "mesh_weld.h"
+#include "mesh_view.h"
+#include "mesh_render.h"
+#include "mesh_reorder.h"
+#include "color.h"
 
 
 // a refined facet with a normal and a tag
@@ -36,6 +45,9 @@ class Enriched_facet : public CGAL::HalfedgeDS_face_base<Refs, T>
 
 	bool m_selected;
 
+	// number of halfedges, see Enriched_polyhedron::compute_degrees()
+	unsigned int m_degree;
+
 public:
 
 	Enriched_facet()
@@ -44,6 +56,7 @@ public:
 		m_tag = -1;
 		m_normal = CGAL::NULL_VECTOR;
 		m_selected = false;
+		m_degree = 0;
 	}
 
 	int& id() {return m_id;}
@@ -60,6 +73,10 @@ public:
 	// selected
 	const bool& selected() const{ return m_selected; }
 	void selected(bool sel) { m_selected = sel; }
+
+	// degree
+	unsigned int degree() const { return m_degree; }
+	void degree(unsigned int d) { m_degree = d; }
 };
 
 // a refined halfedge with a general tag and 
@@ -112,11 +129,12 @@ class Enriched_vertex : public CGAL::HalfedgeDS_vertex_base<Refs, T, P>
 	// tag
 	int m_tag; 
 
+	// number of edges, see Enriched_polyhedron::compute_degrees()
+	unsigned int m_valence;
+
 	// normal
 	Norm m_normal;
 
-	Norm m_lap;
-
 public:
 	Enriched_vertex()  
 	{
@@ -124,7 +142,7 @@ public:
 		m_dirty = false;
 		m_tag = -1;
 		m_normal = CGAL::NULL_VECTOR;
-		m_lap = CGAL::NULL_VECTOR;
+		m_valence = 0;
 	}
 
 	Enriched_vertex(const P& pt)
@@ -134,9 +152,10 @@ public:
 		m_dirty = false;
 		m_tag = -1;
 		m_normal = CGAL::NULL_VECTOR;
-		m_lap = CGAL::NULL_VECTOR;
+		m_valence = 0;
 	}
 
+	// also gives the color read from the file, see Enriched_polyhedron::vertex_color()
 	int& id() {return m_id;}
 	int id() const {return m_id; }
 
@@ -155,9 +174,9 @@ public:
 	const int& tag() const {  return m_tag; }
 	void tag(const int& t)  { m_tag = t; }
 
-	//lap
-	Normal_3& lap() { return m_lap; }
-	const Normal_3& lap() const { return m_lap; }
+	// valence
+	unsigned int valence() const { return m_valence; }
+	void valence(unsigned int v) { m_valence = v; }
 };
 
 // A redefined items class for the Polyhedron_3 
@@ -208,20 +227,28 @@ struct Enriched_items : public CGAL::Polyhedron_items_3
 
 
 //*********************************************************
-template <class kernel, class items>
-class Enriched_polyhedron : public CGAL::Polyhedron_3<kernel,items>
+// the nodes come from the pools of mesh_allocator.h, std::allocator<int>
+// gives back one heap allocation per node
+template <class kernel, class items, class alloc = Node_pool_allocator<int> >
+class Enriched_polyhedron : public CGAL::Polyhedron_3<kernel,items,CGAL::HalfedgeDS_default,alloc>
 {
 public :
+	typedef CGAL::Polyhedron_3<kernel,items,CGAL::HalfedgeDS_default,alloc> Base;
 	typedef typename kernel::FT FT;
 	typedef typename kernel::Point_3 Point;
 	typedef typename kernel::Vector_3 Vector;
 	typedef typename kernel::Iso_cuboid_3 Iso_cuboid;
+	typedef Mesh_renderer< Enriched_polyhedron<kernel,items,alloc> > Renderer;
+	// an edge flip erases the edge and a facet and appends the new ones,
+	// see CSubdivider_sqrt3::refine()
+	enum { FLIPS_IN_PLACE = 0 };
 
 public :
 	Enriched_polyhedron() 
 	{
 		m_pure_quad = false;
 		m_pure_triangle = false;
+		m_vertex_normals = false;
 	}
 	virtual ~Enriched_polyhedron() 
 	{
@@ -265,7 +292,7 @@ public:
 			xmax,ymax,zmax);
 	}
 
-	void copy_bounding_box(Enriched_polyhedron<kernel,items> *pMesh)
+	void copy_bounding_box(Enriched_polyhedron<kernel,items,alloc> *pMesh)
 	{
 		m_bbox = pMesh->bbox();
 	}
@@ -289,16 +316,157 @@ public:
 	bool is_pure_triangle() { return m_pure_triangle; }
 	bool is_pure_quad() { return m_pure_quad; }
 
-	// degree of a face
+	// true if the vertex normals come from the file
+	bool has_vertex_normals() const { return m_vertex_normals; }
+
+	// true if the vertex colors come from the file. They are kept by the
+	// mesh, a vertex gives its color by id() and the vertices created
+	// since the file was read have the default one.
+	bool has_vertex_colors() const { return !m_colors.empty(); }
+	CColor vertex_color(Vertex_const_handle pVertex) const
+	{
+		int id = pVertex->id();
+		return id >= 0 && id < (int)m_colors.size() ? m_colors[id] : MESHCOLOR;
+	}
+
+	// degree of a face, cached
 	static unsigned int degree(Facet_handle pFace)
 	{
-		return CGAL::circulator_size(pFace->facet_begin());    
+		CGAL_expensive_assertion(pFace->degree() == CGAL::circulator_size(pFace->facet_begin()));
+		return pFace->degree();
 	}
 
-	// valence of a vertex
+	// valence of a vertex, cached
 	static unsigned int valence(Vertex_handle pVertex)
 	{
-		return CGAL::circulator_size(pVertex->vertex_begin());
+		CGAL_expensive_assertion(pVertex->valence() == CGAL::circulator_size(pVertex->vertex_begin()));
+		return pVertex->valence();
+	}
+
+	// number of facets of degree d
+	std::size_t size_of_facets_of_degree(unsigned int d) const
+	{
+		return d < m_degrees.size() ? m_degrees[d] : 0;
+	}
+
+	// the facet degrees, vertex valences and facets per degree from
+	// scratch. delegate() and the Euler operations below keep them up
+	// to date, code editing the HalfedgeDS some other way (such as
+	// CGAL::Subdivision_method_3) calls this after
+	void compute_degrees()
+	{
+		for(Vertex_iterator pVertex = vertices_begin();
+			pVertex != vertices_end();
+			pVertex++)
+			pVertex->valence(0);
+		for(Facet_iterator pFacet = facets_begin();
+			pFacet != facets_end();
+			pFacet++)
+			pFacet->degree(0);
+		for(Halfedge_iterator pHalfedge = halfedges_begin();
+			pHalfedge != halfedges_end();
+			pHalfedge++)
+		{
+			Vertex_handle pVertex = pHalfedge->vertex();
+			pVertex->valence(pVertex->valence()+1);
+			if(!pHalfedge->is_border())
+				pHalfedge->facet()->degree(pHalfedge->facet()->degree()+1);
+		}
+		m_degrees.clear();
+		for(Facet_iterator pFacet = facets_begin();
+			pFacet != facets_end();
+			pFacet++)
+			count_facet(pFacet);
+	}
+
+	/************************************************************************/
+	/* Polyhedron_3 operations keeping the degrees                          */
+	/************************************************************************/
+	// the builders, the degrees are counted once the modifier is done
+	void delegate(CGAL::Modifier_base<HalfedgeDS>& modifier)
+	{
+		Base::delegate(modifier);
+		compute_degrees();
+	}
+
+	void clear()
+	{
+		Base::clear();
+		m_degrees.clear();
+		m_vertex_normals = false;
+		m_colors.clear();
+	}
+
+	Halfedge_handle split_facet(Halfedge_handle h, Halfedge_handle g)
+	{
+		uncount_facet(h->facet());
+		Halfedge_handle e = Base::split_facet(h,g);
+		set_degree(e->facet());
+		set_degree(e->opposite()->facet());
+		e->vertex()->valence(e->vertex()->valence()+1);
+		e->opposite()->vertex()->valence(e->opposite()->vertex()->valence()+1);
+		return e;
+	}
+
+	Halfedge_handle join_facet(Halfedge_handle h)
+	{
+		if(!h->is_border())
+			uncount_facet(h->facet());
+		if(!h->opposite()->is_border())
+			uncount_facet(h->opposite()->facet());
+		Vertex_handle a = h->vertex();
+		Vertex_handle b = h->opposite()->vertex();
+		Halfedge_handle e = Base::join_facet(h);
+		if(!e->is_border())
+			set_degree(e->facet());
+		a->valence(a->valence()-1);
+		b->valence(b->valence()-1);
+		return e;
+	}
+
+	// the returned halfedge points to the new vertex
+	Halfedge_handle create_center_vertex(Halfedge_handle h)
+	{
+		uncount_facet(h->facet());
+		Halfedge_handle e = Base::create_center_vertex(h);
+		unsigned int n = 0;
+		Halfedge_around_vertex_circulator pHalfedge = e->vertex()->vertex_begin();
+		do
+		{
+			set_degree(pHalfedge->facet());
+			Vertex_handle pVertex = pHalfedge->opposite()->vertex();
+			pVertex->valence(pVertex->valence()+1);
+			n++;
+		}
+		while(++pHalfedge != e->vertex()->vertex_begin());
+		e->vertex()->valence(n);
+		return e;
+	}
+
+	// the facets of h and g get one more halfedge, the edges of
+	// the vertex are shared between the two vertices
+	Halfedge_handle split_vertex(Halfedge_handle h, Halfedge_handle g)
+	{
+		bool h_facet = !h->is_border();
+		bool g_facet = !g->is_border() && !(h_facet && g->facet() == h->facet());
+		if(h_facet)
+			uncount_facet(h->facet());
+		if(g_facet)
+			uncount_facet(g->facet());
+		Halfedge_handle e = Base::split_vertex(h,g);
+		if(h_facet)
+			set_degree(h->facet());
+		if(g_facet)
+			set_degree(g->facet());
+		set_valence(e->vertex());
+		set_valence(e->opposite()->vertex());
+		return e;
+	}
+
+	// the Polyhedron_3 definition, through split_vertex above
+	Halfedge_handle split_edge(Halfedge_handle h)
+	{
+		return split_vertex(h->prev(),h->opposite())->opposite();
 	}
 
 	// check wether a vertex is on a boundary or not
@@ -456,36 +624,182 @@ public:
 		return (2*c+e-b-f-v)/2;
 	}
 
+	/************************************************************************/
+	/* memory order                                                         */
+	/************************************************************************/
+	// fraction of the edges joining vertices far apart in
+	// memory, see Mesh_reorder. The vertex tags are overwritten
+	double scattering()
+	{
+		return Mesh_reorder< Enriched_polyhedron<kernel,items,alloc> >::scattering(*this);
+	}
+
+	// rebuild with the vertices and facets along a Hilbert curve
+	bool reorder(std::string& error)
+	{
+		return Mesh_reorder< Enriched_polyhedron<kernel,items,alloc> >::reorder(*this,error);
+	}
+
+	// called after the loads and subdivisions, true if reordered
+	bool reorder_if_scattered(double threshold = Indexed_reorder<FT>::threshold())
+	{
+		return Mesh_reorder< Enriched_polyhedron<kernel,items,alloc> >::reorder_if_scattered(*this,threshold);
+	}
+
 	/************************************************************************/
 	/* file io                                                              */
 	/************************************************************************/
-	void write_obj(const char *pFilename,int incr  = 1) // 1-based by default
+	// OFF, COFF and NOFF files, on failure 'error' tells the
+	// line and the reason. With weld_epsilon >= 0 the vertices
+	// closer than weld_epsilon are merged first
+	bool read_off(const char *pFilename, std::string& error, double weld_epsilon = -1.0)
 	{
-		std::ofstream stream(pFilename);
+		typedef Indexed_mesh<FT> Mesh;
+		Mesh indexed_mesh;
+		Parser_off<FT> parser;
+		if(!parser.read(pFilename,indexed_mesh))
+		{
+			error = parser.error();
+			return false;
+		}
+		if(weld_epsilon >= 0.0)
+		{
+			Vertex_welder<FT> welder;
+			welder.weld(indexed_mesh,weld_epsilon);
+		}
 
-		// output vertices
-		for(Point_iterator pPoint = points_begin();
-			pPoint != points_end(); 
-			pPoint++) 
-			stream << 'v' << ' ' << pPoint->x() << ' ' <<
-			pPoint->y() << ' ' <<
-			pPoint->z() << std::endl;
+		return build(indexed_mesh,error);
+	}
 
-		// precompute vertex indices
-		this->set_index_vertices(); 
+	// STL, ascii or binary. The triangles do not share their
+	// vertices in the file, they are always welded
+	bool read_stl(const char *pFilename, std::string& error, double weld_epsilon = 0.0)
+	{
+		Indexed_mesh<FT> indexed_mesh;
+		Parser_stl<FT> parser;
+		if(!parser.read(pFilename,indexed_mesh))
+		{
+			error = parser.error();
+			return false;
+		}
+		Vertex_welder<FT> welder;
+		welder.weld(indexed_mesh,std::max(0.0,weld_epsilon));
+		return build(indexed_mesh,error);
+	}
 
-		// output facets
-		for(Facet_iterator pFacet = facets_begin();
-			pFacet != facets_end(); 
-			pFacet++) 
+	bool write_stl(const char *pFilename, bool binary = true)
+	{
+		Stl_mesh_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write(pFilename,*this,binary);
+	}
+
+	// CGALQT binary mesh (.cqm), the arrays are read in place from
+	// the mapped file. has_normals tells if normals were stored
+	bool read_binary(const char *pFilename, std::string& error, bool& has_normals)
+	{
+		Binary_mesh_view view;
+		if(!view.open(pFilename,error))
+			return false;
+		has_normals = view.has_vertex_normals() && view.has_facet_normals();
+		return build(view,error);
+	}
+
+	// PLY, ascii or binary. has_normals tells if the file had vertex
+	// normals, the facet normals are then computed here
+	bool read_ply(const char *pFilename, std::string& error, bool& has_normals)
+	{
+		Indexed_mesh<FT> indexed_mesh;
+		Parser_ply<FT> parser;
+		if(!parser.read(pFilename,indexed_mesh))
 		{
-			stream << 'f';
-			Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
-			do 
-			stream << ' ' << pHalfedge->vertex()->tag()+incr;
-			while(++pHalfedge != pFacet->facet_begin());
-			stream << std::endl;
-		}  
+			error = parser.error();
+			return false;
+		}
+		if(!build(indexed_mesh,error))
+			return false;
+		has_normals = indexed_mesh.has_vertex_normals();
+		if(has_normals)
+			compute_normals_per_facet();
+		return true;
+	}
+
+	bool write_ply(const char *pFilename, bool binary = true)
+	{
+		Ply_mesh_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write(pFilename,*this,binary);
+	}
+
+	// with pSourceFilename the file is a sidecar cache of that model
+	bool write_binary(const char *pFilename, const char *pSourceFilename = NULL)
+	{
+		Binary_mesh_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write(pFilename,*this,true,pSourceFilename);
+	}
+
+	// compressed archive (.cqz), the positions are quantized to
+	// bits per coordinate, the connectivity is kept exactly
+	bool write_archive(const char *pFilename, unsigned int bits = Mesh_archive_header::DEFAULT_BITS)
+	{
+		Mesh_archive_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write(pFilename,*this,bits);
+	}
+
+	bool read_archive(const char *pFilename, std::string& error)
+	{
+		Indexed_mesh<FT> indexed_mesh;
+		Mesh_archive_reader<FT> reader;
+		if(!reader.read(pFilename,indexed_mesh))
+		{
+			error = reader.error();
+			return false;
+		}
+		return build(indexed_mesh,error);
+	}
+
+	// append an indexed face set (Indexed_mesh or Binary_mesh_view),
+	// with its connectivity if already built (build_halfedges())
+	template <class Mesh>
+	bool build(const Mesh& indexed_mesh, std::string& error,
+	           Mesh_halfedges *pHalfedges = NULL)
+	{
+		std::size_t first = size_of_vertices();
+		Builder_indexed<HalfedgeDS,Mesh> builder(&indexed_mesh,pHalfedges);
+		delegate(builder);
+		if(builder.error())
+		{
+			error = builder.message();
+			return false;
+		}
+
+		// the new vertices come after the ones already there
+		m_vertex_normals = indexed_mesh.has_vertex_normals();
+		m_colors.clear();
+		if(indexed_mesh.has_vertex_colors())
+		{
+			std::size_t nb_vertices = indexed_mesh.size_of_vertices();
+			m_colors.reserve(nb_vertices);
+			Vertex_iterator pVertex = vertices_begin();
+			std::advance(pVertex,first);
+			for(std::size_t v = 0; v < nb_vertices; v++, pVertex++)
+			{
+				const unsigned char *pColor = &indexed_mesh.vertex_colors[3*v];
+				m_colors.push_back(CColor(pColor[0],pColor[1],pColor[2]));
+				pVertex->id() = (int)v;
+			}
+		}
+		return true;
+	}
+
+	bool write_obj(const char *pFilename,int incr  = 1) // 1-based by default
+	{
+		Text_mesh_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write_obj(pFilename,*this,incr);
+	}
+
+	bool write_off(const char *pFilename)
+	{
+		Text_mesh_writer< Enriched_polyhedron<kernel,items,alloc> > writer;
+		return writer.write_off(pFilename,*this);
 	}
 
 	bool euler_split_facet()
@@ -571,258 +885,66 @@ public:
 	/************************************************************************/
 	/* opengl part                                                          */
 	/************************************************************************/
-	void gl_draw(bool smooth_shading, bool use_normals)
+	void gl_draw(bool smooth_shading, bool use_normals, bool use_colors = false)
 	{
-		int i = 0;
-		Facet_iterator pFacet = facets_begin();
-		for(;pFacet != facets_end();pFacet++)
-		{
-			glLoadName(i);
-			glBegin(GL_POLYGON);
-			gl_draw_facet(pFacet,smooth_shading,use_normals);
-			glEnd();
-			i++;
-		}
-		glFlush();
+		Renderer::gl_draw(*this,smooth_shading,use_normals,use_colors);
 	}
 
-	void gl_draw_number()
-	{
-		std::vector<Facet_handle> facets;
+	void gl_draw_number() { Renderer::gl_draw_number(*this); }
+	void gl_draw_selectedfaces() { Renderer::gl_draw_selectedfaces(*this); }
+	void gl_draw_lines() { Renderer::gl_draw_lines(*this); }
+	void gl_draw_points() { Renderer::gl_draw_points(*this); }
+	void gl_draw_bounding_box() { Renderer::gl_draw_bounding_box(*this); }
 
-		Facet_iterator pFacet = facets_begin();
-		for(;pFacet != facets_end();pFacet++)
-		{
-			if(pFacet->selected())
-			{
-				gl_draw_facet_tag(pFacet);
-				facets.push_back(pFacet);
-			}
-		}
-		glFlush();
-
-		//set the dirty flag
-		std::vector<Facet_handle>::iterator f = facets.begin();
-		std::vector<Facet_handle>::iterator last_f = facets.end();
-		for(;f != last_f; ++f)
-		{
-			Halfedge_around_facet_circulator pHalfedge = (*f)->facet_begin();
-			do
-			{
-				Vertex_handle v = pHalfedge->vertex();
-				v->dirty(false);
-			}
-			while(++pHalfedge != (*f)->facet_begin());
-		}
-	}
-
-	void gl_draw_selectedfaces()
-	{
-		Facet_iterator pFacet = facets_begin();
-		for(;pFacet != facets_end();pFacet++)
-		{
-			if(pFacet->selected())
-			{
-				glBegin(GL_POLYGON);
-				gl_draw_facet(pFacet, false , false);
-				glEnd();
-			}
-		}
-		glFlush();
-	}
-
-	void gl_draw_lines()
+	//process hits
+	template <class Mode>
+	void gl_processhits(GLint hits, GLuint buffer[], Mode mode)
 	{
-		glBegin(GL_LINES);
-		for(Edge_iterator h = edges_begin();
-			h != edges_end();
-			h++)
-		{
-			const Point& p1 = h->prev()->vertex()->point();
-			const Point& p2 = h->vertex()->point();
-			glVertex3f(p1[0],p1[1],p1[2]);
-			glVertex3f(p2[0],p2[1],p2[2]);
-		}
-		glEnd();
+		Renderer::gl_processhits(*this,hits,buffer,mode);
 	}
 
-	void gl_draw_points()
-	{
-		glBegin(GL_POINTS);
-		for(Point_iterator pPoint = points_begin();
-			pPoint != points_end();
-			pPoint++)
-			glVertex3f(pPoint->x(),pPoint->y(),pPoint->z());
-		glEnd();
-	}
-
-	void gl_draw_bounding_box()
+private:
+	void compute_normals_per_facet()
 	{
-		glBegin(GL_LINES);
-
-		// along x axis
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmax());
-
-		// along y axis
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmax());
-
-		// along z axis
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmin(),m_bbox.ymax(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymin(),m_bbox.zmax());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmin());
-		glVertex3f(m_bbox.xmax(),m_bbox.ymax(),m_bbox.zmax());
-
-		glEnd();
+		std::for_each(facets_begin(),facets_end(),Facet_normal());
 	}
-
-	//process hits
-	void gl_processhits(GLint hits, GLuint buffer[], processhits_normal)
+	void compute_normals_per_vertex()
 	{
-		if(hits == 0)
-			return;
-
-		if(false) //legacy code
-		{
-			clear_selectedfaces();
-			for (int i = 0; i < hits; i++)
-			{
-				int names = buffer[i*4];
-				CGAL_assertion(names == 1);
-
-				int faceidx = buffer[i*4 + 3];
-				Facet_iterator pFacet = facets_begin();
-				advance(pFacet,faceidx);
-				pFacet->selected(true);
-			}
-		}
-		else
-		{
-			size_t facesz = size_of_facets();
-			int* bitmark = new int[facesz];
-			memset(bitmark,0,sizeof(int)*facesz);
-
-			for (int i = 0; i < hits; i++)
-			{
-				int names = buffer[i*4];
-				CGAL_assertion(names == 1);
-
-				int faceidx = buffer[i*4 + 3];
-				bitmark[faceidx] = 1;
-			}
-
-			Facet_iterator pFacet = facets_begin();
-			for(int i = 0;pFacet != facets_end();pFacet++,i++)
-			{
-				pFacet->selected(false);
-				if(bitmark[i] == 1)
-					pFacet->selected(true);
-			}
-
-			CGALQT_DELETE_ARRAY(bitmark);
-		}	
+		std::for_each(vertices_begin(),vertices_end(),Vertex_normal());
 	}
 
-	void gl_processhits(GLint hits, GLuint buffer[], processhits_plus)
+	bool is_pure_degree(unsigned int d)
 	{
-		if(hits == 0)
-			return;
-
-		size_t facesz = size_of_facets();
-		int* bitmark = new int[facesz];
-		memset(bitmark,0,sizeof(int)*facesz);
-
-		for (int i = 0; i < hits; i++)
-		{
-			int names = buffer[i*4];
-			CGAL_assertion(names == 1);
-
-			int faceidx = buffer[i*4 + 3];
-			bitmark[faceidx] = 1;
-		}
-
-		Facet_iterator pFacet = facets_begin();
-		for(int i = 0;pFacet != facets_end();pFacet++,i++)
-		{
-			if(bitmark[i] == 1)
-				pFacet->selected(true);
-		}
-
-		CGALQT_DELETE_ARRAY(bitmark);
+		return size_of_facets_of_degree(d) == size_of_facets();
 	}
 
-	void gl_processhits(GLint hits, GLuint buffer[], processhits_minus)
+	void count_facet(Facet_handle pFacet)
 	{
-		if(hits == 0)
-			return;
-
-		size_t facesz = size_of_facets();
-		int* bitmark = new int[facesz];
-		memset(bitmark,0,sizeof(int)*facesz);
-
-		for (int i = 0; i < hits; i++)
-		{
-			int names = buffer[i*4];
-			CGAL_assertion(names == 1);
-
-			int faceidx = buffer[i*4 + 3];
-			bitmark[faceidx] = 1;
-		}
-
-		Facet_iterator pFacet = facets_begin();
-		for(int i = 0;pFacet != facets_end();pFacet++,i++)
-		{
-			if(bitmark[i] == 1)
-				pFacet->selected(!pFacet->selected());
-		}
-
-		CGALQT_DELETE_ARRAY(bitmark);
+		unsigned int d = pFacet->degree();
+		if(d >= m_degrees.size())
+			m_degrees.resize(d+1,0);
+		m_degrees[d]++;
 	}
 
-private:
-	void clear_selectedfaces(void)
+	// the cached degree is stale if the facet was last changed some
+	// other way (an Euler operation not overridden above, a HalfedgeDS
+	// decorator), the counts are then off until compute_degrees()
+	void uncount_facet(Facet_handle pFacet)
 	{
-		Facet_iterator pFacet = facets_begin();
-		for(;pFacet != facets_end();pFacet++)
-		{
-			pFacet->selected(false);
-		}
+		unsigned int d = pFacet->degree();
+		if(d < m_degrees.size() && m_degrees[d] > 0)
+			m_degrees[d]--;
 	}
 
-	void compute_normals_per_facet()
+	void set_degree(Facet_handle pFacet)
 	{
-		std::for_each(facets_begin(),facets_end(),Facet_normal());
-	}
-	void compute_normals_per_vertex()
-	{
-		std::for_each(vertices_begin(),vertices_end(),Vertex_normal());
+		pFacet->degree(CGAL::circulator_size(pFacet->facet_begin()));
+		count_facet(pFacet);
 	}
 
-	bool is_pure_degree(unsigned int d)
+	void set_valence(Vertex_handle pVertex)
 	{
-		for(Facet_iterator pFace  = facets_begin();
-			pFace != facets_end();
-			pFace++)
-			if(degree(pFace) != d)
-				return false;
-		return true;
+		pVertex->valence(CGAL::circulator_size(pVertex->vertex_begin()));
 	}
 
 	// compute average edge length around a vertex
@@ -843,65 +965,6 @@ private:
 		return sum / (FT) degree;
 	}
 
-	/************************************************************************/
-	/* opengl part                                                          */
-	/************************************************************************/
-	void gl_draw_facet_tag(Facet_handle pFacet)
-	{
-		Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
-		//const Point& point  = pHalfedge->vertex()->point();
-		static float scale_ratio = -1.0;
-		if(scale_ratio < 0.0)
-			//scale_ratio = (fabsf(point[0])+fabsf(point[1])+fabsf(point[2]))/(3.0*4);
-			scale_ratio = average_edge_length_around(pHalfedge->vertex())/3.0;
-		do
-		{
-			Vertex_handle v = pHalfedge->vertex();
-			if(v->dirty())
-				continue;
-			v->dirty() = true;
-			int tag  = v->tag();
-			std::string tagstr = StringUtils::to_string(tag);
-			const Point& point  = v->point();
-
-			glPushMatrix();
-			glTranslatef(point[0],point[1],point[2]);
-			glScalef(scale_ratio,scale_ratio,scale_ratio);
-			YsDrawUglyFont(tagstr.c_str(),0);
-			glPopMatrix();
-		}
-		while(++pHalfedge != pFacet->facet_begin());
-	}
-
-	void gl_draw_facet(Facet_handle pFacet, bool smooth_shading,bool use_normals)
-	{
-		// one normal per face
-		if(use_normals && !smooth_shading)
-		{
-			const Facet::Normal_3& normal = pFacet->normal();
-			glNormal3f(normal[0],normal[1],normal[2]);
-		}
-
-		// revolve around current face to get vertices
-		Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
-		do
-		{
-			// one normal per vertex
-			if(use_normals && smooth_shading)
-			{
-				const Facet::Normal_3& normal = pHalfedge->vertex()->normal();
-				glNormal3f(normal[0],normal[1],normal[2]);
-			}
-
-			// polygon assembly is performed per vertex
-			const Point& point  = pHalfedge->vertex()->point();
-			glVertex3d(point[0],point[1],point[2]);
-		}
-		while(++pHalfedge != pFacet->facet_begin());
-	}
-
-
-	
 #if 0
 	/************************************************************************/
 	/* legacy opengl code                                                  */
@@ -996,6 +1059,14 @@ private :
 	// type
 	bool m_pure_quad;
 	bool m_pure_triangle;
+
+	bool m_vertex_normals;
+
+	// vertex colors read from the file, by vertex id()
+	std::vector<CColor> m_colors;
+
+	// m_degrees[d] facets of degree d
+	std::vector<std::size_t> m_degrees;
 };
 
 // compute facet normal 
@@ -1036,8 +1107,8 @@ struct Vertex_normal // (functor)
     void operator()(Vertex& v)
     {
         typename Vertex::Normal_3 normal = CGAL::NULL_VECTOR;
-        Vertex::Halfedge_around_vertex_const_circulator pHalfedge = v.vertex_begin();
-        Vertex::Halfedge_around_vertex_const_circulator begin = pHalfedge;
+        typename Vertex::Halfedge_around_vertex_const_circulator pHalfedge = v.vertex_begin();
+        typename Vertex::Halfedge_around_vertex_const_circulator begin = pHalfedge;
         CGAL_For_all(pHalfedge,begin) 
           if(!pHalfedge->is_border())
             normal = normal + pHalfedge->facet()->normal();
@@ -1050,7 +1121,8 @@ struct Vertex_normal // (functor)
 };
 
 
-typedef CGAL::Cartesian<double> Enriched_Polyhedron_kernel;
+// the kernel is chosen in mesh_kernel.h
 typedef Enriched_polyhedron<Enriched_Polyhedron_kernel,Enriched_items> Polyhedron;
+typedef Indexed_view<Enriched_Polyhedron_kernel::FT> Polyhedron_view;
 
 #endif
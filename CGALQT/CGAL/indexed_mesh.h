@@ -0,0 +1,303 @@
+/***************************************************************************
+indexed_mesh.h  -  flat indexed face set
+----------------------------------------------------------------------------
+Vertex coordinates and facet index lists stored in contiguous arrays, the
+common output of the file parsers. Builder_indexed feeds it to a
+Polyhedron_3, through the bulk half-edge construction of Mesh_halfedges
+when several threads are available.
+***************************************************************************/
+
+#ifndef INDEXED_MESH_H
+#define INDEXED_MESH_H
+
+#include "config.h"
+#include <vector>
+#include <string>
+#include "builder.h"
+#include "mesh_halfedges.h"
+
+template <class FT>
+class Indexed_mesh
+{
+public:
+  typedef FT Coord;
+
+  // x,y,z per vertex
+  std::vector<FT> points;
+  // facet i uses facet_vertices[facet_begin[i]..facet_begin[i+1])
+  std::vector<unsigned int> facet_begin;
+  // 0-based vertex indices
+  std::vector<int> facet_vertices;
+  // optional nx,ny,nz per vertex, empty when the file has none
+  std::vector<FT> vertex_normals;
+  // optional r,g,b per vertex
+  std::vector<unsigned char> vertex_colors;
+  // optional nx,ny,nz per facet
+  std::vector<FT> facet_normals;
+  // optional control_edge flag of the halfedge pointing
+  // to facet_vertices[i] inside its facet
+  std::vector<unsigned char> control_edges;
+
+public:
+  Indexed_mesh() { clear(); }
+  ~Indexed_mesh() {}
+
+  void clear()
+  {
+    points.clear();
+    facet_begin.clear();
+    facet_begin.push_back(0);
+    facet_vertices.clear();
+    vertex_normals.clear();
+    vertex_colors.clear();
+    facet_normals.clear();
+    control_edges.clear();
+  }
+
+  void reserve(std::size_t nb_vertices,
+               std::size_t nb_facets,
+               std::size_t nb_indices)
+  {
+    points.reserve(3*nb_vertices);
+    facet_begin.reserve(nb_facets+1);
+    facet_vertices.reserve(nb_indices);
+  }
+
+  std::size_t size_of_vertices() const { return points.size()/3; }
+  std::size_t size_of_facets() const { return facet_begin.size()-1; }
+  std::size_t size_of_indices() const { return facet_vertices.size(); }
+  bool has_vertex_normals() const { return !vertex_normals.empty(); }
+  bool has_vertex_colors() const { return !vertex_colors.empty(); }
+  bool has_facet_normals() const { return !facet_normals.empty(); }
+  bool has_control_edges() const { return !control_edges.empty(); }
+
+  unsigned int degree(std::size_t f) const
+  {
+    return facet_begin[f+1] - facet_begin[f];
+  }
+
+  // check that facet_begin goes from 0 to the number of indices
+  // without decreasing and that every facet has at least 3 valid
+  // vertex indices
+  bool is_valid() const
+  {
+    if(facet_begin.empty() || facet_begin[0] != 0 ||
+       facet_begin.back() != facet_vertices.size())
+      return false;
+    int nv = (int)size_of_vertices();
+    for(std::size_t f = 0; f < size_of_facets(); f++)
+      if(facet_begin[f+1] < facet_begin[f] || degree(f) < 3)
+        return false;
+    for(std::size_t i = 0; i < facet_vertices.size(); i++)
+      if(facet_vertices[i] < 0 || facet_vertices[i] >= nv)
+        return false;
+    return true;
+  }
+
+  // the connectivity of the facets, false with 'error' set if they are
+  // not a manifold oriented surface. Given to build(), the mesh takes
+  // it instead of building it again, so that the facets can be checked
+  // before the mesh they replace is cleared.
+  bool build_halfedges(Mesh_halfedges& halfedges, std::string& error) const
+  {
+    if(halfedges.build(&facet_begin[0],size_of_facets(),
+                       size_of_indices() ? &facet_vertices[0] : NULL,
+                       size_of_vertices()))
+      return true;
+    error = halfedges.error();
+    return false;
+  }
+};
+
+// the points of a mesh by vertex, x,y,z as in Indexed_mesh::points
+template <class Mesh, class FT>
+void get_points(Mesh& mesh, std::vector<FT>& points)
+{
+  points.resize(3*mesh.size_of_vertices());
+  std::size_t i = 0;
+  for(typename Mesh::Vertex_iterator pVertex = mesh.vertices_begin();
+      pVertex != mesh.vertices_end();
+      pVertex++, i += 3)
+  {
+    points[i]   = pVertex->point().x();
+    points[i+1] = pVertex->point().y();
+    points[i+2] = pVertex->point().z();
+  }
+}
+
+// on one thread: with CGAL::Cartesian the points share reference
+// counted coordinates
+template <class Mesh, class FT>
+void set_points(Mesh& mesh, const std::vector<FT>& points)
+{
+  typedef typename Mesh::Point Point;
+  CGAL_assertion(points.size() == 3*mesh.size_of_vertices());
+  std::size_t i = 0;
+  for(typename Mesh::Vertex_iterator pVertex = mesh.vertices_begin();
+      pVertex != mesh.vertices_end();
+      pVertex++, i += 3)
+    pVertex->point() = Point(points[i],points[i+1],points[i+2]);
+}
+
+template <class HDS,class Mesh>
+class Builder_indexed : public CGAL::Modifier_base<HDS>
+{
+private:
+  typedef typename HDS::Vertex Vertex;
+  typedef typename HDS::Vertex::Point Point;
+  typedef typename HDS::Vertex::Normal_3 Normal;
+  typedef typename HDS::Vertex_handle Vertex_handle;
+  typedef typename HDS::Halfedge_handle Halfedge_handle;
+  typedef typename CGAL::Enriched_polyhedron_incremental_builder_3<HDS> builder;
+  const Mesh *m_pIndexedMesh;
+  Mesh_halfedges *m_pHalfedges;
+  bool m_error;
+  std::string m_message;
+
+public:
+  // pHalfedges, if any, is the connectivity already built from the
+  // facets by Indexed_mesh::build_halfedges(), it is used up
+  Builder_indexed(const Mesh *pIndexedMesh,
+                  Mesh_halfedges *pHalfedges = NULL)
+  {
+    CGAL_assertion(pIndexedMesh != NULL);
+    m_pIndexedMesh = pIndexedMesh;
+    m_pHalfedges = pHalfedges;
+    m_error = false;
+  }
+  ~Builder_indexed() {}
+
+  bool error() const { return m_error; }
+  const std::string& message() const { return m_message; }
+
+  // several threads build the connectivity in bulk, a single one
+  // goes facet by facet through the incremental builder, faster there
+  // unless the connectivity is already built
+  void operator()(HDS& hds)
+  {
+    if(m_pHalfedges != NULL || ParallelUtils::nb_threads() > 1)
+      build_bulk(hds);
+    else
+      build_incremental(hds);
+  }
+
+private:
+  void build_bulk(HDS& hds)
+  {
+    const Mesh& mesh = *m_pIndexedMesh;
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_facets = mesh.size_of_facets();
+
+    // the whole connectivity first, nothing is added to hds
+    // if the facets are not a manifold
+    // (Indexed_mesh keeps vectors and Binary_mesh_view pointers)
+    Mesh_halfedges built;
+    Mesh_halfedges& halfedges = m_pHalfedges ? *m_pHalfedges : built;
+    if(m_pHalfedges == NULL &&
+       !halfedges.build(&mesh.facet_begin[0],nb_facets,
+                        mesh.size_of_indices() ? &mesh.facet_vertices[0] : NULL,
+                        nb_vertices))
+    {
+      m_error = true;
+      m_message = halfedges.error();
+      return;
+    }
+    hds.reserve(hds.size_of_vertices()+nb_vertices,
+                hds.size_of_halfedges()+halfedges.size_of_halfedges(),
+                hds.size_of_faces()+nb_facets);
+
+    CGAL::HalfedgeDS_decorator<HDS> decorator(hds);
+    std::vector<Vertex_handle> vertices(nb_vertices);
+    const typename Mesh::Coord *pPoint = nb_vertices ? &mesh.points[0] : NULL;
+    for(std::size_t v = 0; v < nb_vertices; v++, pPoint += 3)
+      vertices[v] = decorator.vertices_push_back(Vertex(Point(pPoint[0],pPoint[1],pPoint[2])));
+    set_vertex_attributes(vertices);
+
+    Halfedge_linker<HDS> linker;
+    linker.link(hds,halfedges,vertices,nb_facets);
+    // the halfedge of a facet points to its first vertex
+    for(std::size_t f = 0; f < nb_facets; f++)
+      set_facet_attributes(f,linker.facet(f)->halfedge());
+  }
+
+  void build_incremental(HDS& hds)
+  {
+    const Mesh& mesh = *m_pIndexedMesh;
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_facets = mesh.size_of_facets();
+
+    // facets tested all at once, which also counts the halfedges,
+    // border included, and tells whether a vertex is a high valence
+    // one the builder should not walk around
+    builder B(hds,true);
+    std::size_t nb_halfedges = 0;
+    std::size_t max_valence = 0;
+    if(!B.test_facets(&mesh.facet_begin[0],nb_facets,
+                      mesh.size_of_indices() ? &mesh.facet_vertices[0] : NULL,
+                      nb_vertices,nb_halfedges,max_valence))
+    {
+      m_error = true;
+      m_message = "non-manifold or inconsistently oriented facets";
+      return;
+    }
+    B.use_edge_map(max_valence > builder::EDGE_MAP_VALENCE);
+    B.begin_surface(nb_vertices,nb_facets,nb_halfedges);
+
+    std::vector<Vertex_handle> vertices(nb_vertices);
+    const typename Mesh::Coord *pPoint = nb_vertices ? &mesh.points[0] : NULL;
+    for(std::size_t v = 0; v < nb_vertices; v++, pPoint += 3)
+      vertices[v] = B.add_vertex(Point(pPoint[0],pPoint[1],pPoint[2]));
+    set_vertex_attributes(vertices);
+
+    for(std::size_t f = 0; f < nb_facets && !B.error(); f++)
+    {
+      B.begin_facet();
+      unsigned int first = mesh.facet_begin[f];
+      unsigned int last = mesh.facet_begin[f+1];
+      for(unsigned int i = first; i < last; i++)
+        B.add_vertex_to_facet((std::size_t)mesh.facet_vertices[i]);
+      // the returned halfedge points to the first vertex
+      Halfedge_handle h = B.end_facet();
+      if(!B.error())
+        set_facet_attributes(f,h);
+    }
+
+    if(B.error())
+    {
+      B.rollback();
+      m_error = true;
+      m_message = "non-manifold or inconsistently oriented facets";
+      return;
+    }
+    B.end_surface();
+  }
+
+  // normals read from the file, the colors are kept by the mesh
+  // (Enriched_polyhedron::build())
+  void set_vertex_attributes(const std::vector<Vertex_handle>& vertices)
+  {
+    const Mesh& mesh = *m_pIndexedMesh;
+    if(mesh.has_vertex_normals())
+    {
+      const typename Mesh::Coord *pNormal = &mesh.vertex_normals[0];
+      for(std::size_t v = 0; v < vertices.size(); v++, pNormal += 3)
+        vertices[v]->normal() = Normal(pNormal[0],pNormal[1],pNormal[2]);
+    }
+  }
+
+  // h points to the first vertex of facet f
+  void set_facet_attributes(std::size_t f, Halfedge_handle h)
+  {
+    const Mesh& mesh = *m_pIndexedMesh;
+    if(mesh.has_facet_normals())
+    {
+      const typename Mesh::Coord *pNormal = &mesh.facet_normals[3*f];
+      h->facet()->normal() = Normal(pNormal[0],pNormal[1],pNormal[2]);
+    }
+    if(mesh.has_control_edges())
+      for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++, h = h->next())
+        h->control_edge(mesh.control_edges[i] != 0);
+  }
+};
+
+#endif
@@ -0,0 +1,227 @@
+/***************************************************************************
+mesh_allocator.h  -  slab allocator for the Polyhedron_3 nodes
+----------------------------------------------------------------------------
+The list based HalfedgeDS allocates every vertex and face on its own and
+the halfedges by opposite pairs, so a subdivision makes millions of heap
+calls and deleting the mesh as many frees. Node_pool_allocator takes the
+nodes from one Node_pool per node size: slabs of up to 64K nodes carved
+in creation order, freed nodes go to a list that the next ones reuse. A
+pool gives all its slabs back to the heap at once when its last node is
+freed, which happens when the last mesh goes. The allocator is stateless,
+all the meshes share the pools under one lock.
+The pools and the lock are created through boost::call_once: function
+local statics are not constructed thread safely by the C++03 compilers
+this code targets (MSVC 2005), and the loader threads build meshes at
+the same time. The lock is taken for every node allocated or freed, a
+few tens of nanoseconds when no other thread holds it; meshes loaded or
+subdivided on several threads at once serialize their node allocations
+on it, while their parsing and the rest of their building run in
+parallel.
+***************************************************************************/
+
+#ifndef MESH_ALLOCATOR_H
+#define MESH_ALLOCATOR_H
+
+#include "config.h"
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/once.hpp>
+
+// what the pools asked from the heap and hold, for the benchmarks
+struct Node_pool_statistics
+{
+  std::size_t heap_allocations;
+  std::size_t node_allocations;
+  std::size_t bytes;
+  Node_pool_statistics() : heap_allocations(0), node_allocations(0), bytes(0) {}
+};
+
+// a class template so that its static members can be defined in this
+// header; they are statically initialized, before any thread starts
+template <class Dummy>
+class Node_pools_base
+{
+public:
+  static boost::mutex& mutex() { boost::call_once(s_once,&create); return *s_pMutex; }
+  static Node_pool_statistics& statistics() { boost::call_once(s_once,&create); return *s_pStatistics; }
+
+private:
+  // never deleted, the pools may free nodes after the static destructors
+  static void create()
+  {
+    s_pMutex = new boost::mutex;
+    s_pStatistics = new Node_pool_statistics;
+  }
+
+private:
+  static boost::once_flag s_once;
+  static boost::mutex *s_pMutex;
+  static Node_pool_statistics *s_pStatistics;
+};
+
+template <class Dummy>
+boost::once_flag Node_pools_base<Dummy>::s_once = BOOST_ONCE_INIT;
+template <class Dummy>
+boost::mutex *Node_pools_base<Dummy>::s_pMutex = NULL;
+template <class Dummy>
+Node_pool_statistics *Node_pools_base<Dummy>::s_pStatistics = NULL;
+
+typedef Node_pools_base<void> Node_pools;
+
+template <std::size_t Size>
+class Node_pool
+{
+private:
+  enum { FIRST_SLAB = 1 << 10, MAX_SLAB = 1 << 16 };
+
+  // aligned for any node
+  union Node
+  {
+    Node *pNext;
+    double d;
+    long long l;
+    void *p;
+    char data[Size];
+  };
+
+public:
+  static Node_pool& instance() { boost::call_once(s_once,&create); return *s_pInstance; }
+
+  void *allocate()
+  {
+    boost::mutex::scoped_lock lock(Node_pools::mutex());
+    if(m_pFree == NULL)
+      grow();
+    Node *pNode = m_pFree;
+    m_pFree = pNode->pNext;
+    m_live++;
+    Node_pools::statistics().node_allocations++;
+    return pNode;
+  }
+
+  void deallocate(void *p)
+  {
+    boost::mutex::scoped_lock lock(Node_pools::mutex());
+    Node *pNode = static_cast<Node*>(p);
+    pNode->pNext = m_pFree;
+    m_pFree = pNode;
+    if(--m_live == 0)
+      release();
+  }
+
+private:
+  Node_pool() : m_pFree(NULL), m_live(0), m_slab_size(FIRST_SLAB), m_bytes(0) {}
+  ~Node_pool() { free_slabs(); }
+
+  // never deleted either, the slabs go back to the heap with the last
+  // node (release())
+  static void create() { s_pInstance = new Node_pool; }
+
+  // the nodes of a new slab are listed in address order
+  void grow()
+  {
+    Node *pSlab = static_cast<Node*>(::operator new(m_slab_size*sizeof(Node)));
+    m_slabs.push_back(pSlab);
+    for(std::size_t i = 0; i+1 < m_slab_size; i++)
+      pSlab[i].pNext = &pSlab[i+1];
+    pSlab[m_slab_size-1].pNext = m_pFree;
+    m_pFree = pSlab;
+
+    Node_pool_statistics& statistics = Node_pools::statistics();
+    statistics.heap_allocations++;
+    statistics.bytes += m_slab_size*sizeof(Node);
+    m_bytes += m_slab_size*sizeof(Node);
+    if(m_slab_size < MAX_SLAB)
+      m_slab_size *= 2;
+  }
+
+  void release()
+  {
+    Node_pools::statistics().bytes -= m_bytes;
+    free_slabs();
+  }
+
+  void free_slabs()
+  {
+    for(std::size_t i = 0; i < m_slabs.size(); i++)
+      ::operator delete(m_slabs[i]);
+    std::vector<Node*>().swap(m_slabs);
+    m_pFree = NULL;
+    m_slab_size = FIRST_SLAB;
+    m_bytes = 0;
+  }
+
+private:
+  Node *m_pFree;
+  std::size_t m_live;
+  std::size_t m_slab_size;
+  std::size_t m_bytes;
+  std::vector<Node*> m_slabs;
+
+  static boost::once_flag s_once;
+  static Node_pool *s_pInstance;
+};
+
+template <std::size_t Size>
+boost::once_flag Node_pool<Size>::s_once = BOOST_ONCE_INIT;
+template <std::size_t Size>
+Node_pool<Size> *Node_pool<Size>::s_pInstance = NULL;
+
+// std::allocator interface, single nodes and the halfedge pairs come
+// from the pools, larger arrays from the heap
+template <class T>
+class Node_pool_allocator
+{
+public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T& reference;
+  typedef const T& const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+
+  template <class U>
+  struct rebind { typedef Node_pool_allocator<U> other; };
+
+public:
+  Node_pool_allocator() {}
+  Node_pool_allocator(const Node_pool_allocator&) {}
+  template <class U>
+  Node_pool_allocator(const Node_pool_allocator<U>&) {}
+
+  pointer address(reference x) const { return &x; }
+  const_pointer address(const_reference x) const { return &x; }
+  size_type max_size() const { return size_type(-1)/sizeof(T); }
+
+  pointer allocate(size_type n, const void * = 0)
+  {
+    if(n == 1)
+      return static_cast<pointer>(Node_pool<sizeof(T)>::instance().allocate());
+    if(n == 2)
+      return static_cast<pointer>(Node_pool<2*sizeof(T)>::instance().allocate());
+    return static_cast<pointer>(::operator new(n*sizeof(T)));
+  }
+
+  void deallocate(pointer p, size_type n)
+  {
+    if(n == 1)
+      Node_pool<sizeof(T)>::instance().deallocate(p);
+    else if(n == 2)
+      Node_pool<2*sizeof(T)>::instance().deallocate(p);
+    else
+      ::operator delete(p);
+  }
+
+  void construct(pointer p, const T& value) { new(p) T(value); }
+  void destroy(pointer p) { p->~T(); }
+};
+
+template <class T, class U>
+bool operator==(const Node_pool_allocator<T>&, const Node_pool_allocator<U>&) { return true; }
+template <class T, class U>
+bool operator!=(const Node_pool_allocator<T>&, const Node_pool_allocator<U>&) { return false; }
+
+#endif
@@ -0,0 +1,1221 @@
+/***************************************************************************
+mesh_archive.h  -  compressed mesh archive (.cqz)
+----------------------------------------------------------------------------
+The connectivity is coded by a traversal and the positions are quantized
+and predicted, both through an adaptive binary range coder:
+
+  header          Mesh_archive_header
+  payload         range coded labels, then the residuals of the vertices
+
+The traversal grows a region facet by facet from a seed facet. Its
+border is a stack of loops of halfedges, the gate is the current
+halfedge of the top loop. Holes are attached like facets, so the
+halfedge across the gate is either outside the region (FACET and HOLE,
+with their degree) or on a loop, it is then glued to the gate: RIGHT
+and LEFT for its neighbours, END_LOOP when the loop closes, SPLIT with
+a signed distance on the same loop and MERGE with the loop and the
+position on it (handles). The other vertices of an attached facet are
+new provisional vertices, gluing identifies them and the first copy of
+a vertex numbers it. Triangles, quads and mixed meshes are coded the
+same way, only the degrees change.
+
+The positions are quantized to 'bits' per coordinate in the bounding
+box and coded after the connectivity in vertex order, each predicted
+from the facet across the gate (parallelogram for triangles, grid for
+quads) or from the previous vertex.
+***************************************************************************/
+
+#ifndef MESH_ARCHIVE_H
+#define MESH_ARCHIVE_H
+
+#include "config.h"
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include "indexed_mesh.h"
+#include "mesh_binary.h"
+
+#define MESH_ARCHIVE_MAGIC "CGALQTZ"
+#define MESH_ARCHIVE_VERSION 1
+
+struct Mesh_archive_header
+{
+  enum
+  {
+    MIN_BITS = 2,
+    MAX_BITS = 30,
+    DEFAULT_BITS = 16
+  };
+
+  char magic[8];
+  boost::uint32_t version;
+  boost::uint32_t byte_order;
+  // quantization of each coordinate
+  boost::uint32_t bits;
+  boost::uint32_t reserved;
+  boost::uint64_t nb_vertices;
+  boost::uint64_t nb_facets;
+  boost::uint64_t nb_indices;
+  double bbox_min[3];
+  double bbox_max[3];
+
+  Mesh_archive_header()
+  {
+    memset(this,0,sizeof(Mesh_archive_header));
+    strcpy(magic,MESH_ARCHIVE_MAGIC);
+    version = MESH_ARCHIVE_VERSION;
+    byte_order = BINARY_MESH_BYTE_ORDER;
+    bits = DEFAULT_BITS;
+  }
+
+  bool is_valid() const
+  {
+    return strcmp(magic,MESH_ARCHIVE_MAGIC) == 0 &&
+           version == MESH_ARCHIVE_VERSION &&
+           byte_order == BINARY_MESH_BYTE_ORDER &&
+           bits >= MIN_BITS && bits <= MAX_BITS;
+  }
+
+  boost::uint32_t max_quantized() const { return (boost::uint32_t)((1u << bits) - 1); }
+
+  boost::uint32_t quantize(double x, int axis) const
+  {
+    double extent = bbox_max[axis] - bbox_min[axis];
+    if(extent <= 0.0)
+      return 0;
+    double q = floor((x - bbox_min[axis]) / extent * max_quantized() + 0.5);
+    return (boost::uint32_t)std::max(0.0,std::min(q,(double)max_quantized()));
+  }
+
+  double dequantize(boost::uint32_t q, int axis) const
+  {
+    double extent = bbox_max[axis] - bbox_min[axis];
+    return bbox_min[axis] + extent * q / max_quantized();
+  }
+};
+
+// adaptive binary range coder (LZMA style) with 11 bit probabilities,
+// the bytes are collected in bytes() and moved out by the caller
+class Archive_encoder
+{
+public:
+  typedef boost::uint16_t Prob;
+  enum
+  {
+    PROB_BITS = 11,
+    MOVE_BITS = 5,
+    TOP = 1 << 24
+  };
+
+public:
+  Archive_encoder()
+  {
+    m_low = 0;
+    m_range = 0xFFFFFFFFu;
+    m_cache = 0;
+    m_cache_size = 1;
+  }
+  ~Archive_encoder() {}
+
+  static void reset(Prob *pProbs, std::size_t n)
+  {
+    std::fill(pProbs,pProbs+n,(Prob)(1 << (PROB_BITS-1)));
+  }
+
+  void bit(Prob& prob, int b)
+  {
+    boost::uint32_t bound = (m_range >> PROB_BITS) * prob;
+    if(b == 0)
+    {
+      m_range = bound;
+      prob += ((1 << PROB_BITS) - prob) >> MOVE_BITS;
+    }
+    else
+    {
+      m_low += bound;
+      m_range -= bound;
+      prob -= prob >> MOVE_BITS;
+    }
+    normalize();
+  }
+
+  // equiprobable bits, most significant first
+  void direct(boost::uint32_t value, int nb_bits)
+  {
+    while(nb_bits-- > 0)
+    {
+      m_range >>= 1;
+      if((value >> nb_bits) & 1)
+        m_low += m_range;
+      normalize();
+    }
+  }
+
+  // nb_bits symbol through a binary tree of 2^nb_bits probabilities
+  void symbol(Prob *pTree, int nb_bits, int value)
+  {
+    int node = 1;
+    for(int i = nb_bits-1; i >= 0; i--)
+    {
+      int b = (value >> i) & 1;
+      bit(pTree[node],b);
+      node = 2*node + b;
+    }
+  }
+
+  // Elias gamma code of value+1, the length in unary with the 33
+  // adaptive probabilities of pLength, the mantissa direct
+  void number(Prob *pLength, boost::uint32_t value)
+  {
+    boost::uint64_t x = (boost::uint64_t)value + 1;
+    int length = 0;
+    while((x >> (length+1)) != 0)
+      length++;
+    for(int i = 0; i < length; i++)
+      bit(pLength[i],1);
+    if(length < 32)
+      bit(pLength[length],0);
+    direct((boost::uint32_t)x,length);
+  }
+
+  void finish()
+  {
+    for(int i = 0; i < 5; i++)
+      shift_low();
+  }
+
+  std::vector<unsigned char>& bytes() { return m_bytes; }
+
+private:
+  void normalize()
+  {
+    while(m_range < TOP)
+    {
+      m_range <<= 8;
+      shift_low();
+    }
+  }
+
+  void shift_low()
+  {
+    if((boost::uint32_t)m_low < 0xFF000000u || (m_low >> 32) != 0)
+    {
+      unsigned char carry = (unsigned char)(m_low >> 32);
+      unsigned char byte = m_cache;
+      do
+      {
+        m_bytes.push_back((unsigned char)(byte + carry));
+        byte = 0xFF;
+      }
+      while(--m_cache_size != 0);
+      m_cache = (unsigned char)((boost::uint32_t)m_low >> 24);
+    }
+    m_cache_size++;
+    m_low = (boost::uint32_t)((boost::uint32_t)m_low << 8);
+  }
+
+private:
+  boost::uint64_t m_low;
+  boost::uint32_t m_range;
+  unsigned char m_cache;
+  boost::uint64_t m_cache_size;
+  std::vector<unsigned char> m_bytes;
+};
+
+// reads what Archive_encoder wrote from a file, block by block
+class Archive_decoder
+{
+public:
+  typedef Archive_encoder::Prob Prob;
+
+public:
+  Archive_decoder(FILE *pFile)
+  {
+    m_pFile = pFile;
+    m_buffer.resize(1<<16);
+    m_pos = m_size = 0;
+    m_overrun = 0;
+    m_range = 0xFFFFFFFFu;
+    m_code = 0;
+    for(int i = 0; i < 5; i++)
+      m_code = (m_code << 8) | next_byte();
+  }
+  ~Archive_decoder() {}
+
+  int bit(Prob& prob)
+  {
+    boost::uint32_t bound = (m_range >> Archive_encoder::PROB_BITS) * prob;
+    int b;
+    if(m_code < bound)
+    {
+      m_range = bound;
+      prob += ((1 << Archive_encoder::PROB_BITS) - prob) >> Archive_encoder::MOVE_BITS;
+      b = 0;
+    }
+    else
+    {
+      m_code -= bound;
+      m_range -= bound;
+      prob -= prob >> Archive_encoder::MOVE_BITS;
+      b = 1;
+    }
+    normalize();
+    return b;
+  }
+
+  boost::uint32_t direct(int nb_bits)
+  {
+    boost::uint32_t value = 0;
+    while(nb_bits-- > 0)
+    {
+      m_range >>= 1;
+      boost::uint32_t b = 0;
+      if(m_code >= m_range)
+      {
+        m_code -= m_range;
+        b = 1;
+      }
+      value = (value << 1) | b;
+      normalize();
+    }
+    return value;
+  }
+
+  int symbol(Prob *pTree, int nb_bits)
+  {
+    int node = 1;
+    for(int i = 0; i < nb_bits; i++)
+      node = 2*node + bit(pTree[node]);
+    return node - (1 << nb_bits);
+  }
+
+  boost::uint32_t number(Prob *pLength)
+  {
+    int length = 0;
+    while(length < 32 && bit(pLength[length]))
+      length++;
+    boost::uint64_t x = ((boost::uint64_t)1 << length) | direct(length);
+    return (boost::uint32_t)(x - 1);
+  }
+
+  // read past the end of the file, the stream is truncated or corrupted
+  bool overrun() const { return m_overrun > 8; }
+
+private:
+  void normalize()
+  {
+    while(m_range < Archive_encoder::TOP)
+    {
+      m_range <<= 8;
+      m_code = (m_code << 8) | next_byte();
+    }
+  }
+
+  boost::uint32_t next_byte()
+  {
+    if(m_pos == m_size)
+    {
+      m_size = fread(&m_buffer[0],1,m_buffer.size(),m_pFile);
+      m_pos = 0;
+      if(m_size == 0)
+      {
+        m_overrun++;
+        return 0;
+      }
+    }
+    return m_buffer[m_pos++];
+  }
+
+private:
+  FILE *m_pFile;
+  std::vector<unsigned char> m_buffer;
+  std::size_t m_pos;
+  std::size_t m_size;
+  std::size_t m_overrun;
+  boost::uint32_t m_range;
+  boost::uint32_t m_code;
+};
+
+// the traversal state, the encoder and the decoder take the same steps
+class Archive_traversal
+{
+public:
+  enum Label
+  {
+    FACET = 0,
+    HOLE,
+    RIGHT,
+    LEFT,
+    SPLIT,
+    MERGE,
+    END_LOOP,
+    END,
+    NB_LABELS
+  };
+
+  // loop elements, element e is the border halfedge from vertex[e]
+  // to vertex[next[e]], before[e] is the vertex preceding vertex[e]
+  // in its facet (-1 in a hole) and loop[e] its loop id (-1 once glued)
+  std::vector<int> next;
+  std::vector<int> prev;
+  std::vector<int> vertex;
+  std::vector<int> before;
+  std::vector<int> loop;
+  // provisional vertices, union-find parent (the root is the first
+  // copy) and the prediction p0 + p1 - p2 of each, p0 = -1 for the
+  // previous vertex in the coding order
+  std::vector<int> parent;
+  std::vector<int> predictors;
+
+private:
+  struct Loop
+  {
+    int id;
+    int gate;
+    std::size_t size;
+  };
+  std::vector<Loop> m_loops;
+  int m_nb_ids;
+
+public:
+  Archive_traversal() { m_nb_ids = 0; }
+  ~Archive_traversal() {}
+
+  // the gate of the top loop, -1 when the component is done
+  int gate() const { return m_loops.empty() ? -1 : m_loops.back().gate; }
+
+  std::size_t size_of_vertices() const { return parent.size(); }
+  std::size_t size_of_elements() const { return next.size(); }
+
+  // a seed facet of a new component, its vertices are all new and its
+  // elements are numbered from the returned one in facet order
+  int seed(int degree, std::vector<int>& vertices)
+  {
+    vertices.clear();
+    for(int k = 0; k < degree; k++)
+    {
+      int previous = k == 0 ? -1 : vertices[k-1];
+      vertices.push_back(add_vertex(previous,previous,previous));
+    }
+    Loop part;
+    part.id = m_nb_ids++;
+    part.size = degree;
+    int first = (int)next.size();
+    for(int k = 0; k < degree; k++)
+      add_element(vertices[k],vertices[(k+degree-1)%degree],part.id);
+    for(int k = 0; k < degree; k++)
+      link(first+k,first+(k+1)%degree);
+    part.gate = first + degree - 1;
+    m_loops.push_back(part);
+    return first;
+  }
+
+  // attach the facet or hole across g, its vertices are listed from
+  // the end of g (b, a, new vertices), its degree-1 other halfedges
+  // replace g and are numbered from the returned element
+  int attach(int g, int degree, bool hole, std::vector<int>& vertices)
+  {
+    int a = vertex[g];
+    int b = vertex[next[g]];
+    int c = before[g];
+    vertices.clear();
+    vertices.push_back(b);
+    vertices.push_back(a);
+    for(int j = 1; j <= degree-2; j++)
+    {
+      int w1 = vertices[j];
+      int w2 = vertices[j-1];
+      int w;
+      if(hole)
+        w = add_vertex(w1,w1,w2);
+      else if(j > 1)
+        w = degree == 4 ? add_vertex(w1,b,a) : add_vertex(w1,w1,w2);
+      else if(c < 0)
+        w = add_vertex(a,a,a);
+      else
+        w = degree == 3 ? add_vertex(a,b,c) : add_vertex(a,a,c);
+      vertices.push_back(w);
+    }
+
+    Loop& current = m_loops.back();
+    int first = (int)next.size();
+    for(int k = 0; k < degree-1; k++)
+      add_element(vertices[k+1],hole ? -1 : vertices[k],current.id);
+    int p = prev[g];
+    int n = next[g];
+    link(p,first);
+    for(int k = 0; k < degree-2; k++)
+      link(first+k,first+k+1);
+    link(first+degree-2,n);
+    loop[g] = -1;
+    current.size += degree - 2;
+    current.gate = first;
+    return first;
+  }
+
+  // the label gluing g to t and its parameters, for the encoder
+  Label classify(int g, int t, int& param0, int& param1) const
+  {
+    param0 = param1 = 0;
+    if(loop[t] == loop[g])
+    {
+      if(next[g] == t)
+        return prev[g] == t ? END_LOOP : RIGHT;
+      if(prev[g] == t)
+        return LEFT;
+      // the shorter way round, the distance is at least 2
+      int forward = next[g];
+      int backward = prev[g];
+      for(param1 = 1; ; param1++)
+      {
+        if(forward == t)
+          return SPLIT;
+        if(backward == t)
+        {
+          param0 = 1;
+          return SPLIT;
+        }
+        forward = next[forward];
+        backward = prev[backward];
+      }
+    }
+
+    // the loop of t counted from the top and its offset from that gate
+    int i = (int)m_loops.size() - 1;
+    while(m_loops[i].id != loop[t])
+      i--;
+    param0 = (int)m_loops.size() - 1 - i;
+    for(int e = m_loops[i].gate; e != t; e = next[e])
+      param1++;
+    return MERGE;
+  }
+
+  // the element glued to g, for the decoder, -1 if the parameters
+  // do not fit the loops (corrupted stream)
+  int find(Label label, int g, int param0, int param1) const
+  {
+    const Loop& current = m_loops.back();
+    switch(label)
+    {
+    case END_LOOP:
+      return current.size == 2 ? next[g] : -1;
+    case RIGHT:
+      return current.size >= 3 ? next[g] : -1;
+    case LEFT:
+      return current.size >= 3 ? prev[g] : -1;
+    case SPLIT:
+      {
+        if(param1 < 2 || (std::size_t)param1 + 2 > current.size)
+          return -1;
+        int t = g;
+        for(int d = 0; d < param1; d++)
+          t = param0 ? prev[t] : next[t];
+        return t;
+      }
+    case MERGE:
+      {
+        if(param0 < 1 || (std::size_t)param0 >= m_loops.size())
+          return -1;
+        const Loop& other = m_loops[m_loops.size()-1-param0];
+        if((std::size_t)param1 >= other.size)
+          return -1;
+        int t = other.gate;
+        for(int d = 0; d < param1; d++)
+          t = next[t];
+        return t;
+      }
+    default:
+      return -1;
+    }
+  }
+
+  // glue g and t, they are the two halfedges of one edge
+  void glue(int g, int t, Label label, int param0, int param1)
+  {
+    unite(vertex[t],vertex[next[g]]);
+    unite(vertex[next[t]],vertex[g]);
+    int p = prev[g];
+    int n = next[g];
+    int pt = prev[t];
+    int nt = next[t];
+    loop[g] = loop[t] = -1;
+
+    std::size_t top = m_loops.size() - 1;
+    switch(label)
+    {
+    case END_LOOP:
+      m_loops.pop_back();
+      break;
+    case RIGHT:
+      link(p,nt);
+      m_loops[top].size -= 2;
+      m_loops[top].gate = p;
+      break;
+    case LEFT:
+      link(pt,n);
+      m_loops[top].size -= 2;
+      m_loops[top].gate = n;
+      break;
+    case SPLIT:
+      {
+        // n..pt and nt..p, the part walked by classify is the smaller,
+        // it gets a new id and is traversed first
+        link(pt,n);
+        link(p,nt);
+        Loop part;
+        part.id = m_nb_ids++;
+        part.size = param1 - 1;
+        int e = param0 == 0 ? n : nt;
+        for(std::size_t i = 0; i < part.size; i++, e = next[e])
+          loop[e] = part.id;
+        part.gate = param0 == 0 ? n : p;
+        m_loops[top].size -= part.size + 2;
+        m_loops[top].gate = param0 == 0 ? p : n;
+        m_loops.push_back(part);
+      }
+      break;
+    case MERGE:
+      {
+        std::size_t i = top - param0;
+        std::size_t size = m_loops[i].size;
+        int e = nt;
+        for(std::size_t k = 1; k < size; k++, e = next[e])
+          loop[e] = m_loops[top].id;
+        if(size == 1)
+          link(p,n);
+        else
+        {
+          link(p,nt);
+          link(pt,n);
+        }
+        m_loops[top].size += size - 2;
+        m_loops[top].gate = n;
+        m_loops.erase(m_loops.begin()+i);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  // a vertex of no facet
+  int isolated() { return add_vertex(-1,-1,-1); }
+
+  int find_root(int v)
+  {
+    while(parent[v] != v)
+    {
+      parent[v] = parent[parent[v]];
+      v = parent[v];
+    }
+    return v;
+  }
+
+private:
+  int add_vertex(int p0, int p1, int p2)
+  {
+    int v = (int)parent.size();
+    parent.push_back(v);
+    predictors.push_back(p0);
+    predictors.push_back(p1);
+    predictors.push_back(p2);
+    return v;
+  }
+
+  void add_element(int v, int b, int id)
+  {
+    next.push_back(-1);
+    prev.push_back(-1);
+    vertex.push_back(v);
+    before.push_back(b);
+    loop.push_back(id);
+  }
+
+  void link(int e, int f)
+  {
+    next[e] = f;
+    prev[f] = e;
+  }
+
+  // the root of a class stays its first copy
+  void unite(int a, int b)
+  {
+    a = find_root(a);
+    b = find_root(b);
+    if(a < b)
+      parent[b] = a;
+    else if(b < a)
+      parent[a] = b;
+  }
+};
+
+// adaptive probabilities shared by the encoder and the decoder
+struct Archive_models
+{
+  typedef Archive_encoder::Prob Prob;
+  enum { START_CONTEXT = Archive_traversal::NB_LABELS };
+
+  // label tree in the context of the previous label
+  Prob labels[Archive_traversal::NB_LABELS+1][Archive_traversal::NB_LABELS];
+  // degree of a facet and of a hole, same as the previous one or coded
+  Prob same_degree[2];
+  Prob degree[2][33];
+  Prob direction;
+  Prob distance[33];
+  Prob loop[33];
+  Prob offset[33];
+  // residual of each coordinate
+  Prob residual[3][33];
+
+  Archive_models()
+  {
+    Archive_encoder::reset(&labels[0][0],sizeof(labels)/sizeof(Prob));
+    Archive_encoder::reset(same_degree,2);
+    Archive_encoder::reset(&degree[0][0],sizeof(degree)/sizeof(Prob));
+    Archive_encoder::reset(&direction,1);
+    Archive_encoder::reset(distance,33);
+    Archive_encoder::reset(loop,33);
+    Archive_encoder::reset(offset,33);
+    Archive_encoder::reset(&residual[0][0],sizeof(residual)/sizeof(Prob));
+  }
+
+  static boost::uint32_t zigzag(boost::int64_t r)
+  {
+    return (boost::uint32_t)(r >= 0 ? 2*r : -2*r-1);
+  }
+
+  static boost::int64_t unzigzag(boost::uint32_t z)
+  {
+    return (z & 1) ? -(boost::int64_t)(z >> 1) - 1 : (boost::int64_t)(z >> 1);
+  }
+
+  // prediction of provisional vertex v from the quantized positions
+  // of the provisional vertices, last is the previous coded vertex
+  template <class Positions>
+  static void predict(const Archive_traversal& traversal,
+                      int v,
+                      const Positions& positions,
+                      const boost::uint32_t *last,
+                      boost::uint32_t max_quantized,
+                      boost::uint32_t *prediction)
+  {
+    const int *p = &traversal.predictors[3*v];
+    if(p[0] < 0)
+    {
+      std::copy(last,last+3,prediction);
+      return;
+    }
+    const boost::uint32_t *q0 = positions(p[0]);
+    const boost::uint32_t *q1 = positions(p[1]);
+    const boost::uint32_t *q2 = positions(p[2]);
+    for(int i = 0; i < 3; i++)
+    {
+      boost::int64_t q = (boost::int64_t)q0[i] + q1[i] - q2[i];
+      prediction[i] = (boost::uint32_t)std::max<boost::int64_t>(0,std::min<boost::int64_t>(q,max_quantized));
+    }
+  }
+};
+
+// halfedge table of a mesh to archive, see Mesh_archive_writer
+struct Archive_mesh
+{
+  // per halfedge: the next one in its facet or hole, the opposite one,
+  // its target vertex and its facet (-1 in a hole)
+  std::vector<int> next;
+  std::vector<int> opposite;
+  std::vector<int> vertex;
+  std::vector<int> facet;
+  // a halfedge of each facet
+  std::vector<int> facet_halfedge;
+  // quantized x,y,z of each vertex
+  std::vector<boost::uint32_t> positions;
+};
+
+// encodes an Archive_mesh, the bytes are written as they are produced
+class Mesh_archive_output : public Binary_mesh_output
+{
+private:
+  // positions of the provisional vertices through their mesh vertex
+  struct Positions
+  {
+    const Archive_mesh *pMesh;
+    const std::vector<int> *pVertices;
+    const boost::uint32_t* operator()(int v) const { return &pMesh->positions[3*(*pVertices)[v]]; }
+  };
+
+public:
+  Mesh_archive_output() {}
+  ~Mesh_archive_output() {}
+
+public:
+  // header has the counts, the bits and the bounding box filled in
+  bool encode(const char *pFilename,
+              const Archive_mesh& mesh,
+              const Mesh_archive_header& header)
+  {
+    if(!open(pFilename))
+      return false;
+    put(&header,sizeof(Mesh_archive_header));
+
+    Archive_encoder coder;
+    Archive_models models;
+    Archive_traversal traversal;
+    std::size_t nb_facets = mesh.facet_halfedge.size();
+    std::vector<bool> attached(nb_facets,false);
+    // element of each halfedge on a loop and back
+    std::vector<int> halfedge_element(mesh.next.size(),-1);
+    std::vector<int> element_halfedge;
+    // mesh vertex of each provisional vertex
+    std::vector<int> vertex_of;
+    std::vector<int> cycle, vertices;
+    int last_degree[2] = { 0, 0 };
+    int context = Archive_models::START_CONTEXT;
+
+    for(std::size_t f = 0; f < nb_facets; f++)
+    {
+      if(attached[f])
+        continue;
+      attached[f] = true;
+      facet_cycle(mesh,mesh.facet_halfedge[f],cycle);
+      coder.symbol(models.labels[context],3,Archive_traversal::FACET);
+      put_degree(coder,models,last_degree,0,(int)cycle.size());
+      context = Archive_traversal::FACET;
+      int first = traversal.seed((int)cycle.size(),vertices);
+      for(std::size_t k = 0; k < cycle.size(); k++)
+      {
+        set_element(element_halfedge,halfedge_element,first+(int)k,cycle[k]);
+        vertex_of.push_back(mesh.vertex[mesh.opposite[cycle[k]]]);
+      }
+
+      int g;
+      while((g = traversal.gate()) >= 0)
+      {
+        int h = element_halfedge[g];
+        int o = mesh.opposite[h];
+        int t = halfedge_element[o];
+        halfedge_element[h] = -1;
+        if(t < 0)
+        {
+          bool hole = mesh.facet[o] < 0;
+          facet_cycle(mesh,o,cycle);
+          int label = hole ? Archive_traversal::HOLE : Archive_traversal::FACET;
+          coder.symbol(models.labels[context],3,label);
+          put_degree(coder,models,last_degree,hole ? 1 : 0,(int)cycle.size());
+          context = label;
+          first = traversal.attach(g,(int)cycle.size(),hole,vertices);
+          for(std::size_t k = 1; k < cycle.size(); k++)
+            set_element(element_halfedge,halfedge_element,first+(int)k-1,cycle[k]);
+          for(std::size_t k = 1; k + 1 < cycle.size(); k++)
+            vertex_of.push_back(mesh.vertex[cycle[k]]);
+          if(!hole)
+            attached[mesh.facet[o]] = true;
+        }
+        else
+        {
+          halfedge_element[o] = -1;
+          int param0, param1;
+          Archive_traversal::Label label = traversal.classify(g,t,param0,param1);
+          coder.symbol(models.labels[context],3,label);
+          if(label == Archive_traversal::SPLIT)
+          {
+            coder.bit(models.direction,param0);
+            coder.number(models.distance,param1-2);
+          }
+          else if(label == Archive_traversal::MERGE)
+          {
+            coder.number(models.loop,param0-1);
+            coder.number(models.offset,param1);
+          }
+          context = label;
+          traversal.glue(g,t,label,param0,param1);
+        }
+        drain(coder);
+      }
+    }
+    coder.symbol(models.labels[context],3,Archive_traversal::END);
+
+    // every provisional vertex is a copy of its root and no vertex
+    // has two roots, anything else is not a 2-manifold
+    std::size_t nb_vertices = mesh.positions.size()/3;
+    std::vector<bool> numbered(nb_vertices,false);
+    for(std::size_t v = 0; v < traversal.size_of_vertices(); v++)
+    {
+      int root = traversal.find_root((int)v);
+      if(vertex_of[root] != vertex_of[v])
+        m_ok = false;
+      else if(root == (int)v)
+      {
+        if(numbered[vertex_of[v]])
+          m_ok = false;
+        numbered[vertex_of[v]] = true;
+      }
+    }
+    // the isolated vertices come last, predicted by the previous one
+    for(std::size_t v = 0; v < nb_vertices; v++)
+      if(!numbered[v])
+      {
+        traversal.isolated();
+        vertex_of.push_back((int)v);
+      }
+
+    Positions positions;
+    positions.pMesh = &mesh;
+    positions.pVertices = &vertex_of;
+    boost::uint32_t last[3] = { 0, 0, 0 };
+    for(std::size_t v = 0; m_ok && v < traversal.size_of_vertices(); v++)
+    {
+      if(traversal.parent[v] != (int)v)
+        continue;
+      boost::uint32_t prediction[3];
+      Archive_models::predict(traversal,(int)v,positions,last,header.max_quantized(),prediction);
+      const boost::uint32_t *q = positions((int)v);
+      for(int i = 0; i < 3; i++)
+        coder.number(models.residual[i],Archive_models::zigzag((boost::int64_t)q[i] - prediction[i]));
+      std::copy(q,q+3,last);
+      drain(coder);
+    }
+
+    coder.finish();
+    drain(coder,true);
+    return close(pFilename);
+  }
+
+  // the halfedges of the facet or hole of h, from h
+  static void facet_cycle(const Archive_mesh& mesh, int h, std::vector<int>& cycle)
+  {
+    cycle.clear();
+    int e = h;
+    do
+    {
+      cycle.push_back(e);
+      e = mesh.next[e];
+    }
+    while(e != h && cycle.size() <= mesh.next.size());
+  }
+
+private:
+  static void set_element(std::vector<int>& element_halfedge,
+                          std::vector<int>& halfedge_element,
+                          int e, int h)
+  {
+    if(element_halfedge.size() <= (std::size_t)e)
+      element_halfedge.resize(e+1);
+    element_halfedge[e] = h;
+    halfedge_element[h] = e;
+  }
+
+  static void put_degree(Archive_encoder& coder,
+                         Archive_models& models,
+                         int *last_degree,
+                         int kind,
+                         int degree)
+  {
+    coder.bit(models.same_degree[kind],degree != last_degree[kind]);
+    if(degree != last_degree[kind])
+      coder.number(models.degree[kind],degree-1);
+    last_degree[kind] = degree;
+  }
+
+  void drain(Archive_encoder& coder, bool all = false)
+  {
+    std::vector<unsigned char>& bytes = coder.bytes();
+    if(!bytes.empty() && (all || bytes.size() >= (1<<16)))
+    {
+      put(&bytes[0],bytes.size());
+      bytes.clear();
+    }
+  }
+};
+
+// write a polyhedron with Enriched_items as .cqz, bits per coordinate
+template <class Polyhedron>
+class Mesh_archive_writer : public Mesh_archive_output
+{
+private:
+  typedef typename Polyhedron::Vertex_iterator    Vertex_iterator;
+  typedef typename Polyhedron::Halfedge_iterator  Halfedge_iterator;
+  typedef typename Polyhedron::Facet_iterator     Facet_iterator;
+
+public:
+  Mesh_archive_writer() {}
+  ~Mesh_archive_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             Polyhedron& mesh,
+             unsigned int bits = Mesh_archive_header::DEFAULT_BITS)
+  {
+    Mesh_archive_header header;
+    header.bits = std::max<unsigned int>(Mesh_archive_header::MIN_BITS,
+                                         std::min<unsigned int>(bits,Mesh_archive_header::MAX_BITS));
+    header.nb_vertices = mesh.size_of_vertices();
+    header.nb_facets = mesh.size_of_facets();
+
+    // the indices are stored in the tags
+    mesh.set_index_vertices();
+    mesh.set_index_facets();
+    int index = 0;
+    for(Halfedge_iterator pHalfedge = mesh.halfedges_begin();
+        pHalfedge != mesh.halfedges_end();
+        pHalfedge++)
+      pHalfedge->tag(index++);
+
+    Archive_mesh table;
+    std::size_t nb_halfedges = mesh.size_of_halfedges();
+    table.next.resize(nb_halfedges);
+    table.opposite.resize(nb_halfedges);
+    table.vertex.resize(nb_halfedges);
+    table.facet.resize(nb_halfedges);
+    for(Halfedge_iterator pHalfedge = mesh.halfedges_begin();
+        pHalfedge != mesh.halfedges_end();
+        pHalfedge++)
+    {
+      int h = pHalfedge->tag();
+      table.next[h] = pHalfedge->next()->tag();
+      table.opposite[h] = pHalfedge->opposite()->tag();
+      table.vertex[h] = pHalfedge->vertex()->tag();
+      table.facet[h] = pHalfedge->is_border() ? -1 : pHalfedge->facet()->tag();
+      if(!pHalfedge->is_border())
+        header.nb_indices++;
+    }
+    table.facet_halfedge.resize(mesh.size_of_facets());
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+      table.facet_halfedge[pFacet->tag()] = pFacet->halfedge()->tag();
+
+    for(int i = 0; i < 3; i++)
+    {
+      header.bbox_min[i] = 0.0;
+      header.bbox_max[i] = 0.0;
+    }
+    bool first = true;
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++, first = false)
+      for(int i = 0; i < 3; i++)
+      {
+        double x = pVertex->point()[i];
+        header.bbox_min[i] = first ? x : std::min(header.bbox_min[i],x);
+        header.bbox_max[i] = first ? x : std::max(header.bbox_max[i],x);
+      }
+    table.positions.reserve(3*mesh.size_of_vertices());
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++)
+      for(int i = 0; i < 3; i++)
+        table.positions.push_back(header.quantize(pVertex->point()[i],i));
+
+    return encode(pFilename,table,header);
+  }
+};
+
+// read a .cqz into an indexed face set, the vertices and the facets
+// come in traversal order
+template <class FT>
+class Mesh_archive_reader
+{
+private:
+  // positions of the provisional vertices through their root
+  struct Positions
+  {
+    Archive_traversal *pTraversal;
+    const std::vector<int> *pNumbers;
+    const std::vector<boost::uint32_t> *pQuantized;
+    const boost::uint32_t* operator()(int v) const
+    {
+      return &(*pQuantized)[3*(*pNumbers)[pTraversal->find_root(v)]];
+    }
+  };
+
+public:
+  Mesh_archive_reader() {}
+  ~Mesh_archive_reader() {}
+
+  const std::string& error() const { return m_error; }
+
+  bool read(const char *pFilename, Indexed_mesh<FT>& mesh)
+  {
+    FILE *pFile = fopen(pFilename,"rb");
+    if(pFile == NULL)
+    {
+      m_error = "can not open file";
+      return false;
+    }
+    bool ok = read(pFile,mesh);
+    fclose(pFile);
+    return ok;
+  }
+
+private:
+  bool read(FILE *pFile, Indexed_mesh<FT>& mesh)
+  {
+    Mesh_archive_header header;
+    if(fread(&header,sizeof(Mesh_archive_header),1,pFile) != 1 || !header.is_valid())
+    {
+      m_error = "not a CGALQT mesh archive or unsupported version";
+      return false;
+    }
+
+    Archive_decoder coder(pFile);
+    Archive_models models;
+    Archive_traversal traversal;
+    // facets with provisional vertices
+    std::vector<unsigned int> facet_begin(1,0);
+    std::vector<int> facet_vertices;
+    std::vector<int> vertices;
+    boost::uint64_t hole_indices = 0;
+    int last_degree[2] = { 0, 0 };
+    int context = Archive_models::START_CONTEXT;
+    for(;;)
+    {
+      if(coder.overrun() ||
+         facet_vertices.size() > header.nb_indices ||
+         hole_indices > header.nb_indices)
+      {
+        m_error = "truncated or corrupted file";
+        return false;
+      }
+
+      int g = traversal.gate();
+      int label = coder.symbol(models.labels[context],3);
+      context = label;
+      if(g < 0)
+      {
+        if(label == Archive_traversal::END)
+          break;
+        int degree = get_degree(coder,models,last_degree,0);
+        if(label != Archive_traversal::FACET || degree < 3 ||
+           (boost::uint64_t)degree > header.nb_indices)
+        {
+          m_error = "corrupted connectivity";
+          return false;
+        }
+        traversal.seed(degree,vertices);
+        facet_vertices.insert(facet_vertices.end(),vertices.begin(),vertices.end());
+        facet_begin.push_back((unsigned int)facet_vertices.size());
+      }
+      else if(label == Archive_traversal::FACET || label == Archive_traversal::HOLE)
+      {
+        bool hole = label == Archive_traversal::HOLE;
+        int degree = get_degree(coder,models,last_degree,hole ? 1 : 0);
+        if(degree < (hole ? 2 : 3) || (boost::uint64_t)degree > header.nb_indices)
+        {
+          m_error = "corrupted connectivity";
+          return false;
+        }
+        traversal.attach(g,degree,hole,vertices);
+        if(hole)
+          hole_indices += degree;
+        else
+        {
+          facet_vertices.insert(facet_vertices.end(),vertices.begin(),vertices.end());
+          facet_begin.push_back((unsigned int)facet_vertices.size());
+        }
+      }
+      else
+      {
+        int param0 = 0;
+        int param1 = 0;
+        if(label == Archive_traversal::SPLIT)
+        {
+          param0 = coder.bit(models.direction);
+          param1 = (int)std::min<boost::uint32_t>(coder.number(models.distance),1u << 30) + 2;
+        }
+        else if(label == Archive_traversal::MERGE)
+        {
+          param0 = (int)std::min<boost::uint32_t>(coder.number(models.loop),1u << 30) + 1;
+          param1 = (int)std::min<boost::uint32_t>(coder.number(models.offset),1u << 30);
+        }
+        int t = traversal.find((Archive_traversal::Label)label,g,param0,param1);
+        if(t < 0)
+        {
+          m_error = "corrupted connectivity";
+          return false;
+        }
+        traversal.glue(g,t,(Archive_traversal::Label)label,param0,param1);
+      }
+    }
+    if(facet_begin.size()-1 != header.nb_facets ||
+       facet_vertices.size() != header.nb_indices)
+    {
+      m_error = "corrupted connectivity";
+      return false;
+    }
+
+    // the roots are the vertices, numbered in order, then the
+    // isolated vertices
+    std::vector<int> numbers(traversal.size_of_vertices(),-1);
+    std::size_t nb_vertices = 0;
+    for(std::size_t v = 0; v < numbers.size(); v++)
+      if(traversal.find_root((int)v) == (int)v)
+        numbers[v] = (int)nb_vertices++;
+    if(nb_vertices > header.nb_vertices)
+    {
+      m_error = "corrupted connectivity";
+      return false;
+    }
+    while(nb_vertices < header.nb_vertices)
+    {
+      traversal.isolated();
+      numbers.push_back((int)nb_vertices++);
+    }
+
+    std::vector<boost::uint32_t> quantized(3*nb_vertices);
+    Positions positions;
+    positions.pTraversal = &traversal;
+    positions.pNumbers = &numbers;
+    positions.pQuantized = &quantized;
+    boost::uint32_t last[3] = { 0, 0, 0 };
+    boost::uint32_t max_quantized = header.max_quantized();
+    for(std::size_t v = 0; v < numbers.size(); v++)
+    {
+      if(numbers[v] < 0)
+        continue;
+      boost::uint32_t prediction[3];
+      Archive_models::predict(traversal,(int)v,positions,last,max_quantized,prediction);
+      boost::uint32_t *q = &quantized[3*numbers[v]];
+      for(int i = 0; i < 3; i++)
+      {
+        boost::int64_t value = prediction[i] + Archive_models::unzigzag(coder.number(models.residual[i]));
+        q[i] = (boost::uint32_t)std::max<boost::int64_t>(0,std::min<boost::int64_t>(value,max_quantized));
+      }
+      std::copy(q,q+3,last);
+    }
+    if(coder.overrun())
+    {
+      m_error = "truncated or corrupted file";
+      return false;
+    }
+
+    mesh.clear();
+    mesh.reserve(nb_vertices,(std::size_t)header.nb_facets,(std::size_t)header.nb_indices);
+    for(std::size_t v = 0; v < nb_vertices; v++)
+      for(int i = 0; i < 3; i++)
+        mesh.points.push_back((FT)header.dequantize(quantized[3*v+i],i));
+    mesh.facet_begin.assign(facet_begin.begin(),facet_begin.end());
+    mesh.facet_vertices.resize(facet_vertices.size());
+    for(std::size_t i = 0; i < facet_vertices.size(); i++)
+      mesh.facet_vertices[i] = numbers[traversal.find_root(facet_vertices[i])];
+    return true;
+  }
+
+  static int get_degree(Archive_decoder& coder,
+                        Archive_models& models,
+                        int *last_degree,
+                        int kind)
+  {
+    if(coder.bit(models.same_degree[kind]))
+      last_degree[kind] = (int)std::min<boost::uint32_t>(coder.number(models.degree[kind]),1u << 30) + 1;
+    return last_degree[kind];
+  }
+
+private:
+  std::string m_error;
+};
+
+#endif // MESH_ARCHIVE_H
@@ -0,0 +1,596 @@
+/***************************************************************************
+mesh_binary.h  -  binary mesh container (.cqm)
+----------------------------------------------------------------------------
+Little endian, versioned, every array 8 bytes aligned so that a mapped
+file is read in place:
+
+  header
+  points          double[3*#vertices]
+  facet_begin     uint32[#facets+1]
+  facet_vertices  int32[#indices]
+  vertex_normals  double[3*#vertices]   (optional)
+  vertex_colors   uint8[3*#vertices]    (optional) r,g,b
+  facet_normals   double[3*#facets]     (optional)
+  control_edges   uint8[#indices]       (optional) flag of the halfedge
+                                        pointing to facet_vertices[i]
+
+A file written as the sidecar cache of a text model also records the
+size and modification time of that model.
+***************************************************************************/
+
+#ifndef MESH_BINARY_H
+#define MESH_BINARY_H
+
+#include "config.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+#include "mappedfile.h"
+
+#define BINARY_MESH_MAGIC "CGALQTM"
+#define BINARY_MESH_VERSION 2
+#define BINARY_MESH_BYTE_ORDER 0x01020304
+
+struct Binary_mesh_header
+{
+  enum
+  {
+    VERTEX_NORMALS = 1,
+    FACET_NORMALS = 2,
+    CONTROL_EDGES = 4,
+    VERTEX_COLORS = 8
+  };
+  enum
+  {
+    POINTS = 0,
+    FACET_BEGIN,
+    FACET_VERTICES,
+    VERTEX_NORMALS_ARRAY,
+    FACET_NORMALS_ARRAY,
+    CONTROL_EDGES_ARRAY,
+    VERTEX_COLORS_ARRAY,
+    NB_ARRAYS
+  };
+
+  char magic[8];
+  boost::uint32_t version;
+  boost::uint32_t byte_order;
+  boost::uint32_t flags;
+  boost::uint32_t reserved;
+  boost::uint64_t nb_vertices;
+  boost::uint64_t nb_facets;
+  boost::uint64_t nb_indices;
+  // sidecar cache key, 0 otherwise
+  boost::uint64_t source_size;
+  boost::int64_t source_mtime;
+  // byte offset of each array from the start of the file
+  boost::uint64_t offsets[NB_ARRAYS];
+
+  Binary_mesh_header()
+  {
+    memset(this,0,sizeof(Binary_mesh_header));
+    strcpy(magic,BINARY_MESH_MAGIC);
+    version = BINARY_MESH_VERSION;
+    byte_order = BINARY_MESH_BYTE_ORDER;
+  }
+
+  static boost::uint64_t align(boost::uint64_t offset)
+  {
+    return (offset + 7) & ~(boost::uint64_t)7;
+  }
+
+  // lay the arrays out after the header, returns the file size
+  boost::uint64_t layout()
+  {
+    boost::uint64_t sizes[NB_ARRAYS];
+    sizes[POINTS] = 3*nb_vertices*sizeof(double);
+    sizes[FACET_BEGIN] = (nb_facets+1)*sizeof(boost::uint32_t);
+    sizes[FACET_VERTICES] = nb_indices*sizeof(boost::int32_t);
+    sizes[VERTEX_NORMALS_ARRAY] = (flags & VERTEX_NORMALS) ? 3*nb_vertices*sizeof(double) : 0;
+    sizes[FACET_NORMALS_ARRAY] = (flags & FACET_NORMALS) ? 3*nb_facets*sizeof(double) : 0;
+    sizes[CONTROL_EDGES_ARRAY] = (flags & CONTROL_EDGES) ? nb_indices : 0;
+    sizes[VERTEX_COLORS_ARRAY] = (flags & VERTEX_COLORS) ? 3*nb_vertices : 0;
+
+    boost::uint64_t offset = align(sizeof(Binary_mesh_header));
+    for(int i = 0; i < NB_ARRAYS; i++)
+    {
+      offsets[i] = offset;
+      offset = align(offset + sizes[i]);
+    }
+    return offset;
+  }
+
+  bool is_valid() const
+  {
+    return strcmp(magic,BINARY_MESH_MAGIC) == 0 &&
+           version == BINARY_MESH_VERSION &&
+           byte_order == BINARY_MESH_BYTE_ORDER;
+  }
+};
+
+// read only view of a mapped .cqm file, the arrays point into the
+// mapping (no copy) and stay valid as long as the view is open.
+// Same interface as Indexed_mesh so that Builder_indexed takes both.
+class Binary_mesh_view
+{
+public:
+  typedef double Coord;
+
+  const double *points;
+  const boost::uint32_t *facet_begin;
+  const boost::int32_t *facet_vertices;
+  const double *vertex_normals;
+  const double *facet_normals;
+  const unsigned char *control_edges;
+  const unsigned char *vertex_colors;
+
+public:
+  Binary_mesh_view() { reset(); }
+  ~Binary_mesh_view() {}
+
+private:
+  Binary_mesh_view(const Binary_mesh_view&);
+  Binary_mesh_view& operator=(const Binary_mesh_view&);
+
+public:
+  bool open(const char *pFilename, std::string& error)
+  {
+    reset();
+    if(!m_file.open(pFilename))
+    {
+      error = "can not open file";
+      return false;
+    }
+    if(m_file.size() < sizeof(Binary_mesh_header))
+    {
+      error = "truncated header";
+      return false;
+    }
+    memcpy(&m_header,m_file.begin(),sizeof(Binary_mesh_header));
+    if(!m_header.is_valid())
+    {
+      error = "not a CGALQT binary mesh or unsupported version";
+      return false;
+    }
+    // indices are 32 bit and every facet has at least 3 of them,
+    // this also keeps layout() from overflowing
+    if(m_header.nb_vertices > 0x7fffffff ||
+       m_header.nb_indices > 0xffffffff ||
+       m_header.nb_facets > m_header.nb_indices / 3)
+    {
+      error = "corrupted header";
+      return false;
+    }
+    Binary_mesh_header layout = m_header;
+    if(layout.layout() > m_file.size() ||
+       memcmp(layout.offsets,m_header.offsets,sizeof(m_header.offsets)) != 0)
+    {
+      error = "truncated or corrupted file";
+      return false;
+    }
+
+    const char *pData = m_file.begin();
+    points = (const double*)(pData + m_header.offsets[Binary_mesh_header::POINTS]);
+    facet_begin = (const boost::uint32_t*)(pData + m_header.offsets[Binary_mesh_header::FACET_BEGIN]);
+    facet_vertices = (const boost::int32_t*)(pData + m_header.offsets[Binary_mesh_header::FACET_VERTICES]);
+    if(m_header.flags & Binary_mesh_header::VERTEX_NORMALS)
+      vertex_normals = (const double*)(pData + m_header.offsets[Binary_mesh_header::VERTEX_NORMALS_ARRAY]);
+    if(m_header.flags & Binary_mesh_header::FACET_NORMALS)
+      facet_normals = (const double*)(pData + m_header.offsets[Binary_mesh_header::FACET_NORMALS_ARRAY]);
+    if(m_header.flags & Binary_mesh_header::CONTROL_EDGES)
+      control_edges = (const unsigned char*)(pData + m_header.offsets[Binary_mesh_header::CONTROL_EDGES_ARRAY]);
+    if(m_header.flags & Binary_mesh_header::VERTEX_COLORS)
+      vertex_colors = (const unsigned char*)(pData + m_header.offsets[Binary_mesh_header::VERTEX_COLORS_ARRAY]);
+
+    if(!check_facets())
+    {
+      error = "corrupted facet table";
+      reset();
+      return false;
+    }
+    return true;
+  }
+
+  void close() { reset(); }
+
+  const Binary_mesh_header& header() const { return m_header; }
+
+  std::size_t size_of_vertices() const { return (std::size_t)m_header.nb_vertices; }
+  std::size_t size_of_facets() const { return (std::size_t)m_header.nb_facets; }
+  std::size_t size_of_indices() const { return (std::size_t)m_header.nb_indices; }
+  unsigned int degree(std::size_t f) const { return facet_begin[f+1] - facet_begin[f]; }
+  bool has_vertex_normals() const { return vertex_normals != NULL; }
+  bool has_facet_normals() const { return facet_normals != NULL; }
+  bool has_control_edges() const { return control_edges != NULL; }
+  bool has_vertex_colors() const { return vertex_colors != NULL; }
+
+  // true if pCacheFilename is a valid cache of pSourceFilename
+  // in its current state (same size and modification time)
+  static bool is_fresh(const char *pCacheFilename, const char *pSourceFilename)
+  {
+    Binary_mesh_header header;
+    FILE *pFile = fopen(pCacheFilename,"rb");
+    if(pFile == NULL)
+      return false;
+    bool ok = fread(&header,sizeof(Binary_mesh_header),1,pFile) == 1;
+    fclose(pFile);
+    if(!ok || !header.is_valid())
+      return false;
+
+    boost::uint64_t size;
+    boost::int64_t mtime;
+    if(!source_key(pSourceFilename,size,mtime))
+      return false;
+    return header.source_size == size && header.source_mtime == mtime;
+  }
+
+  static bool source_key(const char *pSourceFilename,
+                         boost::uint64_t& size,
+                         boost::int64_t& mtime)
+  {
+    try
+    {
+      size = (boost::uint64_t)boost::filesystem::file_size(pSourceFilename);
+      mtime = (boost::int64_t)boost::filesystem::last_write_time(pSourceFilename);
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  // same checks as Indexed_mesh::is_valid(), the renderer and the
+  // builders index the mapped arrays without bounds checks
+  bool check_facets() const
+  {
+    std::size_t nb_facets = size_of_facets();
+    if(facet_begin[0] != 0 || facet_begin[nb_facets] != m_header.nb_indices)
+      return false;
+    for(std::size_t f = 0; f < nb_facets; f++)
+      if(facet_begin[f+1] < facet_begin[f] || degree(f) < 3)
+        return false;
+    boost::int32_t nb_vertices = (boost::int32_t)m_header.nb_vertices;
+    std::size_t nb_indices = size_of_indices();
+    for(std::size_t i = 0; i < nb_indices; i++)
+      if(facet_vertices[i] < 0 || facet_vertices[i] >= nb_vertices)
+        return false;
+    return true;
+  }
+
+  void reset()
+  {
+    m_file.close();
+    m_header = Binary_mesh_header();
+    points = NULL;
+    facet_begin = NULL;
+    facet_vertices = NULL;
+    vertex_normals = NULL;
+    facet_normals = NULL;
+    control_edges = NULL;
+    vertex_colors = NULL;
+  }
+
+private:
+  MappedFile m_file;
+  Binary_mesh_header m_header;
+};
+
+// buffered output of a .cqm file, shared by the writers. The file is
+// written under a temporary name next to pFilename and renamed over it
+// once complete, so that a reader never maps a partial file, such as
+// another load of the same model finding the sidecar cache being written
+class Binary_mesh_output
+{
+protected:
+  FILE *m_pFile;
+  std::string m_temporary;
+  std::vector<char> m_buffer;
+  boost::uint64_t m_offset;
+  bool m_ok;
+
+public:
+  Binary_mesh_output() { m_pFile = NULL; m_offset = 0; m_ok = true; }
+  ~Binary_mesh_output()
+  {
+    if(m_pFile)
+    {
+      fclose(m_pFile);
+      remove(m_temporary.c_str());
+    }
+  }
+
+protected:
+  bool open(const char *pFilename)
+  {
+    try
+    {
+      m_temporary = boost::filesystem::unique_path(std::string(pFilename) + ".%%%%%%%%.tmp").string();
+    }
+    catch(std::exception&)
+    {
+      return false;
+    }
+    m_pFile = fopen(m_temporary.c_str(),"wb");
+    if(m_pFile == NULL)
+      return false;
+    m_buffer.clear();
+    m_buffer.reserve(1<<20);
+    m_offset = 0;
+    m_ok = true;
+    return true;
+  }
+
+  // the temporary file replaces pFilename, it is removed if anything failed
+  bool close(const char *pFilename)
+  {
+    pad(Binary_mesh_header::align(m_offset));
+    flush();
+    bool ok = (fclose(m_pFile) == 0) && m_ok;
+    m_pFile = NULL;
+    if(ok)
+    {
+      try
+      {
+        boost::filesystem::rename(m_temporary,pFilename);
+      }
+      catch(std::exception&)
+      {
+        ok = false;
+      }
+    }
+    if(!ok)
+      remove(m_temporary.c_str());
+    return ok;
+  }
+
+  template <class V>
+  void put_xyz(const V& v)
+  {
+    double xyz[3] = { v[0], v[1], v[2] };
+    put(xyz,sizeof(xyz));
+  }
+
+  void put(const void *pData, std::size_t size)
+  {
+    const char *p = (const char*)pData;
+    m_buffer.insert(m_buffer.end(),p,p+size);
+    m_offset += size;
+    if(m_buffer.size() >= (1<<20))
+      flush();
+  }
+
+  // zero fill up to offset
+  void pad(boost::uint64_t offset)
+  {
+    static const char zeros[8] = { 0 };
+    while(m_offset < offset)
+      put(zeros,(std::size_t)std::min<boost::uint64_t>(8,offset-m_offset));
+  }
+
+  void flush()
+  {
+    if(!m_buffer.empty() &&
+       fwrite(&m_buffer[0],1,m_buffer.size(),m_pFile) != m_buffer.size())
+      m_ok = false;
+    m_buffer.clear();
+  }
+};
+
+// write a polyhedron with Enriched_items as .cqm
+template <class Polyhedron>
+class Binary_mesh_writer : public Binary_mesh_output
+{
+private:
+  typedef typename Polyhedron::Vertex_iterator                    Vertex_iterator;
+  typedef typename Polyhedron::Facet_iterator                     Facet_iterator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator   HF_circulator;
+
+public:
+  Binary_mesh_writer() {}
+  ~Binary_mesh_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             Polyhedron& mesh,
+             bool with_normals = true,
+             const char *pSourceFilename = NULL)
+  {
+    Binary_mesh_header header;
+    header.nb_vertices = mesh.size_of_vertices();
+    header.nb_facets = mesh.size_of_facets();
+    header.nb_indices = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+      header.nb_indices += Polyhedron::degree(pFacet);
+    header.flags = Binary_mesh_header::CONTROL_EDGES;
+    if(with_normals)
+      header.flags |= Binary_mesh_header::VERTEX_NORMALS |
+                      Binary_mesh_header::FACET_NORMALS;
+    if(mesh.has_vertex_colors())
+      header.flags |= Binary_mesh_header::VERTEX_COLORS;
+    if(pSourceFilename != NULL &&
+       !Binary_mesh_view::source_key(pSourceFilename,header.source_size,header.source_mtime))
+      return false;
+    header.layout();
+
+    if(!open(pFilename))
+      return false;
+
+    put(&header,sizeof(Binary_mesh_header));
+
+    // points
+    pad(header.offsets[Binary_mesh_header::POINTS]);
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++)
+      put_xyz(pVertex->point());
+
+    // facets, vertex indices are stored in vertex tags
+    mesh.set_index_vertices();
+    pad(header.offsets[Binary_mesh_header::FACET_BEGIN]);
+    boost::uint32_t begin = 0;
+    put(&begin,sizeof(begin));
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      begin += Polyhedron::degree(pFacet);
+      put(&begin,sizeof(begin));
+    }
+    pad(header.offsets[Binary_mesh_header::FACET_VERTICES]);
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      HF_circulator pHalfedge = pFacet->facet_begin();
+      do
+      {
+        boost::int32_t index = pHalfedge->vertex()->tag();
+        put(&index,sizeof(index));
+      }
+      while(++pHalfedge != pFacet->facet_begin());
+    }
+
+    if(with_normals)
+    {
+      pad(header.offsets[Binary_mesh_header::VERTEX_NORMALS_ARRAY]);
+      for(Vertex_iterator pVertex = mesh.vertices_begin();
+          pVertex != mesh.vertices_end();
+          pVertex++)
+        put_xyz(pVertex->normal());
+      pad(header.offsets[Binary_mesh_header::FACET_NORMALS_ARRAY]);
+      for(Facet_iterator pFacet = mesh.facets_begin();
+          pFacet != mesh.facets_end();
+          pFacet++)
+        put_xyz(pFacet->normal());
+    }
+
+    pad(header.offsets[Binary_mesh_header::CONTROL_EDGES_ARRAY]);
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      HF_circulator pHalfedge = pFacet->facet_begin();
+      do
+      {
+        unsigned char flag = pHalfedge->control_edge() ? 1 : 0;
+        put(&flag,1);
+      }
+      while(++pHalfedge != pFacet->facet_begin());
+    }
+
+    if(mesh.has_vertex_colors())
+    {
+      pad(header.offsets[Binary_mesh_header::VERTEX_COLORS_ARRAY]);
+      for(Vertex_iterator pVertex = mesh.vertices_begin();
+          pVertex != mesh.vertices_end();
+          pVertex++)
+      {
+        CColor color = mesh.vertex_color(pVertex);
+        unsigned char rgb[3] = { color.r(), color.g(), color.b() };
+        put(rgb,3);
+      }
+    }
+    return close(pFilename);
+  }
+};
+
+// write an Indexed_mesh as .cqm, the arrays are written as they are.
+// Missing control edge flags are written as 1, like the halfedge default
+template <class Mesh>
+class Binary_indexed_writer : public Binary_mesh_output
+{
+public:
+  Binary_indexed_writer() {}
+  ~Binary_indexed_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             const Mesh& mesh,
+             const char *pSourceFilename = NULL)
+  {
+    Binary_mesh_header header;
+    header.nb_vertices = mesh.size_of_vertices();
+    header.nb_facets = mesh.size_of_facets();
+    header.nb_indices = mesh.size_of_indices();
+    header.flags = Binary_mesh_header::CONTROL_EDGES;
+    if(mesh.has_vertex_normals())
+      header.flags |= Binary_mesh_header::VERTEX_NORMALS;
+    if(mesh.has_facet_normals())
+      header.flags |= Binary_mesh_header::FACET_NORMALS;
+    if(mesh.has_vertex_colors())
+      header.flags |= Binary_mesh_header::VERTEX_COLORS;
+    if(pSourceFilename != NULL &&
+       !Binary_mesh_view::source_key(pSourceFilename,header.source_size,header.source_mtime))
+      return false;
+    header.layout();
+
+    if(!open(pFilename))
+      return false;
+
+    put(&header,sizeof(Binary_mesh_header));
+    pad(header.offsets[Binary_mesh_header::POINTS]);
+    put_array(mesh.points,3*header.nb_vertices);
+    pad(header.offsets[Binary_mesh_header::FACET_BEGIN]);
+    put_array(mesh.facet_begin,header.nb_facets+1);
+    pad(header.offsets[Binary_mesh_header::FACET_VERTICES]);
+    put_array(mesh.facet_vertices,header.nb_indices);
+    if(mesh.has_vertex_normals())
+    {
+      pad(header.offsets[Binary_mesh_header::VERTEX_NORMALS_ARRAY]);
+      put_array(mesh.vertex_normals,3*header.nb_vertices);
+    }
+    if(mesh.has_facet_normals())
+    {
+      pad(header.offsets[Binary_mesh_header::FACET_NORMALS_ARRAY]);
+      put_array(mesh.facet_normals,3*header.nb_facets);
+    }
+    pad(header.offsets[Binary_mesh_header::CONTROL_EDGES_ARRAY]);
+    if(mesh.has_control_edges())
+      put_array(mesh.control_edges,header.nb_indices);
+    else
+      for(boost::uint64_t i = 0; i < header.nb_indices; i++)
+      {
+        unsigned char flag = 1;
+        put(&flag,1);
+      }
+    if(mesh.has_vertex_colors())
+    {
+      pad(header.offsets[Binary_mesh_header::VERTEX_COLORS_ARRAY]);
+      put_array(mesh.vertex_colors,3*header.nb_vertices);
+    }
+    return close(pFilename);
+  }
+
+private:
+  // the stored types: double coordinates, uint32 and int32 indices
+  void put_array(const std::vector<double>& values, boost::uint64_t nb) { put_values(values,nb); }
+  void put_array(const std::vector<float>& values, boost::uint64_t nb)
+  {
+    for(std::size_t i = 0; i < nb; i++)
+    {
+      double v = values[i];
+      put(&v,sizeof(v));
+    }
+  }
+  void put_array(const std::vector<unsigned int>& values, boost::uint64_t nb) { put_values(values,nb); }
+  void put_array(const std::vector<int>& values, boost::uint64_t nb) { put_values(values,nb); }
+  void put_array(const std::vector<unsigned char>& values, boost::uint64_t nb) { put_values(values,nb); }
+
+  template <class T>
+  void put_values(const std::vector<T>& values, boost::uint64_t nb)
+  {
+    if(nb > 0)
+      put(&values[0],(std::size_t)nb*sizeof(T));
+  }
+};
+
+#endif
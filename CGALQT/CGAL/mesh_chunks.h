@@ -0,0 +1,930 @@
+/***************************************************************************
+mesh_chunks.h  -  out-of-core viewing of a model split in chunks (.cqc)
+----------------------------------------------------------------------------
+Chunked_mesh_writer sorts the facets of a model by a kd split of their
+centroids and writes every leaf (at most MAX_FACETS facets) as a small
+self contained indexed mesh with its own vertices, facet normals and
+bounding box. Little endian, every array 8 bytes aligned:
+
+  header
+  chunk table     Chunk_record[#chunks]
+  chunks          points          double[3*#vertices]
+                  facet_begin     uint32[#facets+1]
+                  facet_vertices  int32[#indices]      (chunk local)
+                  facet_normals   double[3*#facets]
+                  vertex_colors   uint8[3*#vertices]   (optional)
+
+Chunked_mesh keeps the table in memory and loads the chunks on demand:
+update() takes the chunks inside the view frustum, the largest on the
+screen first, up to a memory budget, and queues the missing ones for
+its loader thread; it only reads the disk from there. The loaded chunks
+are handed over at the next update(), after a call to the
+Chunk_listener if there is one. The least recently wanted chunks are
+dropped to make room. Only the loaded chunks are drawn and picked, the
+facet selection of the whole model is kept as one bit per facet.
+The writer reads a .cqm through its mapping, so the model itself never
+has to fit in memory, only 16 bytes per facet and 8 per vertex.
+***************************************************************************/
+
+#ifndef MESH_CHUNKS_H
+#define MESH_CHUNKS_H
+
+#include "config.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include "mesh_binary.h"
+#include "mesh_view.h"
+#include "parallelutils.h"
+
+#define CHUNKED_MESH_MAGIC "CGALQTC"
+#define CHUNKED_MESH_VERSION 1
+
+struct Chunked_mesh_header
+{
+  enum { VERTEX_COLORS = 1 };
+
+  char magic[8];
+  boost::uint32_t version;
+  boost::uint32_t byte_order;
+  boost::uint32_t flags;
+  boost::uint32_t reserved;
+  boost::uint64_t nb_chunks;
+  // of the source model, the chunks duplicate their shared vertices
+  boost::uint64_t nb_vertices;
+  boost::uint64_t nb_facets;
+  // sidecar key of the source model, 0 otherwise
+  boost::uint64_t source_size;
+  boost::int64_t source_mtime;
+  double bbox_min[3];
+  double bbox_max[3];
+
+  Chunked_mesh_header()
+  {
+    memset(this,0,sizeof(Chunked_mesh_header));
+    strcpy(magic,CHUNKED_MESH_MAGIC);
+    version = CHUNKED_MESH_VERSION;
+    byte_order = BINARY_MESH_BYTE_ORDER;
+  }
+
+  bool is_valid() const
+  {
+    return strcmp(magic,CHUNKED_MESH_MAGIC) == 0 &&
+           version == CHUNKED_MESH_VERSION &&
+           byte_order == BINARY_MESH_BYTE_ORDER;
+  }
+
+  static bool read(const char *pFilename, Chunked_mesh_header& header)
+  {
+    FILE *pFile = fopen(pFilename,"rb");
+    if(pFile == NULL)
+      return false;
+    bool ok = fread(&header,sizeof(Chunked_mesh_header),1,pFile) == 1;
+    fclose(pFile);
+    return ok && header.is_valid();
+  }
+};
+
+struct Chunk_record
+{
+  double bbox_min[3];
+  double bbox_max[3];
+  // index of the first facet of the chunk in the chunk order
+  boost::uint64_t first_facet;
+  // of the chunk data from the start of the file
+  boost::uint64_t offset;
+  boost::uint32_t nb_vertices;
+  boost::uint32_t nb_facets;
+  boost::uint32_t nb_indices;
+  boost::uint32_t reserved;
+
+  enum { POINTS = 0, FACET_BEGIN, FACET_VERTICES, FACET_NORMALS, VERTEX_COLORS, NB_ARRAYS };
+
+  Chunk_record() { memset(this,0,sizeof(Chunk_record)); }
+
+  // bytes of each array, unaligned
+  boost::uint64_t array_size(int array, bool colors) const
+  {
+    switch(array)
+    {
+    case POINTS: return 3*(boost::uint64_t)nb_vertices*sizeof(double);
+    case FACET_BEGIN: return ((boost::uint64_t)nb_facets+1)*sizeof(boost::uint32_t);
+    case FACET_VERTICES: return (boost::uint64_t)nb_indices*sizeof(boost::int32_t);
+    case FACET_NORMALS: return 3*(boost::uint64_t)nb_facets*sizeof(double);
+    default: return colors ? 3*(boost::uint64_t)nb_vertices : 0;
+    }
+  }
+
+  boost::uint64_t size(bool colors) const
+  {
+    boost::uint64_t size = 0;
+    for(int i = 0; i < NB_ARRAYS; i++)
+      size += Binary_mesh_header::align(array_size(i,colors));
+    return size;
+  }
+};
+
+// write any indexed face set (Indexed_mesh, Binary_mesh_view) as .cqc
+template <class Mesh>
+class Chunked_mesh_writer : public Binary_mesh_output
+{
+public:
+  enum { MAX_FACETS = 1<<16 };
+
+private:
+  // float centroids of [begin,end)
+  struct Centroids
+  {
+    const Mesh *pMesh;
+    float *pCentroids;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      const Mesh& mesh = *pMesh;
+      for(std::size_t f = begin; f < end; f++)
+      {
+        double sum[3] = { 0.0, 0.0, 0.0 };
+        unsigned int degree = mesh.facet_begin[f+1] - mesh.facet_begin[f];
+        for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++)
+          for(int k = 0; k < 3; k++)
+            sum[k] += mesh.points[3*mesh.facet_vertices[i]+k];
+        for(int k = 0; k < 3; k++)
+          pCentroids[3*f+k] = (float)(sum[k]/degree);
+      }
+    }
+  };
+
+  struct Less_centroid
+  {
+    const float *pCentroids;
+    int axis;
+    bool operator()(boost::uint32_t a, boost::uint32_t b) const
+    {
+      return pCentroids[3*a+axis] < pCentroids[3*b+axis];
+    }
+  };
+
+public:
+  Chunked_mesh_writer() {}
+  ~Chunked_mesh_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             const Mesh& mesh,
+             const char *pSourceFilename = NULL,
+             std::size_t max_facets = MAX_FACETS)
+  {
+    Chunked_mesh_header header;
+    header.nb_vertices = mesh.size_of_vertices();
+    header.nb_facets = mesh.size_of_facets();
+    bool colors = mesh.has_vertex_colors();
+    if(colors)
+      header.flags |= Chunked_mesh_header::VERTEX_COLORS;
+    if(pSourceFilename != NULL &&
+       !Binary_mesh_view::source_key(pSourceFilename,header.source_size,header.source_mtime))
+      return false;
+
+    std::vector<boost::uint32_t> order;
+    std::vector<std::size_t> leaves;
+    split(mesh,std::max<std::size_t>(1,max_facets),order,leaves);
+
+    // first pass for the vertex counts and the bounding boxes
+    std::size_t nb_chunks = leaves.size()-1;
+    std::vector<Chunk_record> records(nb_chunks);
+    std::vector<boost::uint32_t> stamp(mesh.size_of_vertices(),0xFFFFFFFF);
+    std::vector<boost::int32_t> local(mesh.size_of_vertices());
+    std::vector<boost::int32_t> vertices;
+    boost::uint64_t offset = Binary_mesh_header::align(sizeof(Chunked_mesh_header) +
+                                                       nb_chunks*sizeof(Chunk_record));
+    for(std::size_t c = 0; c < nb_chunks; c++)
+    {
+      Chunk_record& record = records[c];
+      chunk_vertices(mesh,order,leaves[c],leaves[c+1],(boost::uint32_t)c,stamp,local,vertices);
+      record.first_facet = leaves[c];
+      record.nb_facets = (boost::uint32_t)(leaves[c+1] - leaves[c]);
+      record.nb_vertices = (boost::uint32_t)vertices.size();
+      for(std::size_t i = leaves[c]; i < leaves[c+1]; i++)
+        record.nb_indices += mesh.degree(order[i]);
+      for(int k = 0; k < 3; k++)
+        record.bbox_min[k] = record.bbox_max[k] = mesh.points[3*vertices[0]+k];
+      for(std::size_t i = 1; i < vertices.size(); i++)
+        for(int k = 0; k < 3; k++)
+        {
+          double x = mesh.points[3*vertices[i]+k];
+          record.bbox_min[k] = std::min(record.bbox_min[k],x);
+          record.bbox_max[k] = std::max(record.bbox_max[k],x);
+        }
+      for(int k = 0; k < 3; k++)
+      {
+        header.bbox_min[k] = c == 0 ? record.bbox_min[k] : std::min(header.bbox_min[k],record.bbox_min[k]);
+        header.bbox_max[k] = c == 0 ? record.bbox_max[k] : std::max(header.bbox_max[k],record.bbox_max[k]);
+      }
+      record.offset = offset;
+      offset += record.size(colors);
+    }
+    header.nb_chunks = nb_chunks;
+
+    if(!open(pFilename))
+      return false;
+    put(&header,sizeof(Chunked_mesh_header));
+    if(nb_chunks > 0)
+      put(&records[0],nb_chunks*sizeof(Chunk_record));
+
+    // second pass writes the chunks with the same vertex numbering
+    std::fill(stamp.begin(),stamp.end(),0xFFFFFFFF);
+    for(std::size_t c = 0; c < nb_chunks; c++)
+    {
+      const Chunk_record& record = records[c];
+      chunk_vertices(mesh,order,leaves[c],leaves[c+1],(boost::uint32_t)c,stamp,local,vertices);
+      pad(record.offset);
+      for(std::size_t i = 0; i < vertices.size(); i++)
+        put_xyz(&mesh.points[3*vertices[i]]);
+
+      pad(Binary_mesh_header::align(m_offset));
+      boost::uint32_t begin = 0;
+      put(&begin,sizeof(begin));
+      for(std::size_t i = leaves[c]; i < leaves[c+1]; i++)
+      {
+        begin += mesh.degree(order[i]);
+        put(&begin,sizeof(begin));
+      }
+
+      pad(Binary_mesh_header::align(m_offset));
+      for(std::size_t i = leaves[c]; i < leaves[c+1]; i++)
+      {
+        std::size_t f = order[i];
+        for(unsigned int j = mesh.facet_begin[f]; j < mesh.facet_begin[f+1]; j++)
+          put(&local[mesh.facet_vertices[j]],sizeof(boost::int32_t));
+      }
+
+      pad(Binary_mesh_header::align(m_offset));
+      for(std::size_t i = leaves[c]; i < leaves[c+1]; i++)
+      {
+        double normal[3];
+        Indexed_view<double>::facet_normal(mesh,order[i],normal);
+        put(normal,sizeof(normal));
+      }
+
+      if(colors)
+      {
+        pad(Binary_mesh_header::align(m_offset));
+        for(std::size_t i = 0; i < vertices.size(); i++)
+          put(&mesh.vertex_colors[3*vertices[i]],3);
+      }
+    }
+    return close(pFilename);
+  }
+
+private:
+  // facet order of the kd split, chunk c is order[leaves[c]..leaves[c+1])
+  void split(const Mesh& mesh,
+             std::size_t max_facets,
+             std::vector<boost::uint32_t>& order,
+             std::vector<std::size_t>& leaves)
+  {
+    std::size_t nb_facets = mesh.size_of_facets();
+    std::vector<float> centroids(3*nb_facets);
+    Centroids functor;
+    functor.pMesh = &mesh;
+    functor.pCentroids = nb_facets > 0 ? &centroids[0] : NULL;
+    ParallelUtils::parallel_for(0,nb_facets,functor,1<<14);
+
+    order.resize(nb_facets);
+    for(std::size_t f = 0; f < nb_facets; f++)
+      order[f] = (boost::uint32_t)f;
+
+    // depth first so that the neighbour leaves stay close in the file
+    leaves.clear();
+    leaves.push_back(0);
+    std::vector<std::pair<std::size_t,std::size_t> > stack;
+    if(nb_facets > 0)
+      stack.push_back(std::make_pair((std::size_t)0,nb_facets));
+    while(!stack.empty())
+    {
+      std::size_t begin = stack.back().first;
+      std::size_t end = stack.back().second;
+      stack.pop_back();
+      if(end - begin <= max_facets)
+      {
+        leaves.push_back(end);
+        continue;
+      }
+
+      // split the longest side of the centroid box at the median
+      float lo[3], hi[3];
+      for(int k = 0; k < 3; k++)
+        lo[k] = hi[k] = centroids[3*order[begin]+k];
+      for(std::size_t i = begin+1; i < end; i++)
+        for(int k = 0; k < 3; k++)
+        {
+          float x = centroids[3*order[i]+k];
+          lo[k] = std::min(lo[k],x);
+          hi[k] = std::max(hi[k],x);
+        }
+      Less_centroid less;
+      less.pCentroids = &centroids[0];
+      less.axis = 0;
+      for(int k = 1; k < 3; k++)
+        if(hi[k]-lo[k] > hi[less.axis]-lo[less.axis])
+          less.axis = k;
+      std::size_t middle = begin + (end-begin)/2;
+      std::nth_element(order.begin()+begin,order.begin()+middle,order.begin()+end,less);
+      stack.push_back(std::make_pair(middle,end));
+      stack.push_back(std::make_pair(begin,middle));
+    }
+  }
+
+  // the vertices of the facets order[begin..end) in order of first use,
+  // local[v] is the index of v in vertices
+  static void chunk_vertices(const Mesh& mesh,
+                             const std::vector<boost::uint32_t>& order,
+                             std::size_t begin,
+                             std::size_t end,
+                             boost::uint32_t chunk,
+                             std::vector<boost::uint32_t>& stamp,
+                             std::vector<boost::int32_t>& local,
+                             std::vector<boost::int32_t>& vertices)
+  {
+    vertices.clear();
+    for(std::size_t i = begin; i < end; i++)
+    {
+      std::size_t f = order[i];
+      for(unsigned int j = mesh.facet_begin[f]; j < mesh.facet_begin[f+1]; j++)
+      {
+        boost::int32_t v = mesh.facet_vertices[j];
+        if(stamp[v] != chunk)
+        {
+          stamp[v] = chunk;
+          local[v] = (boost::int32_t)vertices.size();
+          vertices.push_back(v);
+        }
+      }
+    }
+  }
+};
+
+// told by the loader thread of a Chunked_mesh that chunks wait for the
+// next update(), at most once between two updates
+class Chunk_listener
+{
+public:
+  virtual ~Chunk_listener() {}
+  virtual void chunks_loaded() = 0;
+};
+
+class Chunked_mesh
+{
+public:
+  typedef Indexed_view<double> Chunk;
+
+  // bytes of loaded chunks and the screen size in pixels below which
+  // a chunk is not worth loading
+  enum { DEFAULT_BUDGET = 256<<20, MIN_PIXELS = 2 };
+
+private:
+  struct Chunk_state
+  {
+    Chunk *pChunk;
+    // last update() that wanted the chunk, for the LRU order
+    unsigned int last_used;
+    bool visible;
+    // not loaded again once its read failed
+    bool failed;
+  };
+
+public:
+  Chunked_mesh()
+  {
+    m_budget = DEFAULT_BUDGET;
+    m_loaded_bytes = 0;
+    m_loaded_facets = 0;
+    m_update = 0;
+    m_pThread = NULL;
+    m_pListener = NULL;
+    m_loading = NONE;
+    m_notified = false;
+    m_stop = false;
+  }
+  ~Chunked_mesh() { close(); }
+
+private:
+  Chunked_mesh(const Chunked_mesh&);
+  Chunked_mesh& operator=(const Chunked_mesh&);
+
+public:
+  bool open(const char *pFilename, std::string& error)
+  {
+    close();
+    m_file.open(pFilename,std::ios::in | std::ios::binary);
+    if(!m_file)
+    {
+      error = "can not open file";
+      return false;
+    }
+    m_file.read((char*)&m_header,sizeof(Chunked_mesh_header));
+    if(!m_file || !m_header.is_valid())
+    {
+      error = "not a CGALQT chunked mesh or unsupported version";
+      close();
+      return false;
+    }
+    m_records.resize((std::size_t)m_header.nb_chunks);
+    if(!m_records.empty())
+      m_file.read((char*)&m_records[0],m_records.size()*sizeof(Chunk_record));
+    if(!m_file || !is_valid_table())
+    {
+      error = "truncated or corrupted chunk table";
+      close();
+      return false;
+    }
+
+    Chunk_state state;
+    state.pChunk = NULL;
+    state.last_used = 0;
+    state.visible = false;
+    state.failed = false;
+    m_states.assign(m_records.size(),state);
+    m_selected.assign((std::size_t)m_header.nb_facets,false);
+    m_stop = false;
+    m_pThread = new boost::thread(boost::bind(&Chunked_mesh::run,this));
+    return true;
+  }
+
+  void close()
+  {
+    if(m_pThread)
+    {
+      {
+        boost::mutex::scoped_lock lock(m_mutex);
+        m_stop = true;
+        m_wanted.notify_one();
+      }
+      m_pThread->join();
+      delete m_pThread;
+      m_pThread = NULL;
+    }
+    m_queue.clear();
+    for(std::size_t i = 0; i < m_loaded.size(); i++)
+      delete m_loaded[i].second;
+    m_loaded.clear();
+    m_loading = NONE;
+    m_notified = false;
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      CGALQT_DELETE(m_states[c].pChunk);
+    m_states.clear();
+    m_records.clear();
+    std::vector<bool>().swap(m_selected);
+    m_header = Chunked_mesh_header();
+    m_loaded_bytes = 0;
+    m_loaded_facets = 0;
+    if(m_file.is_open())
+      m_file.close();
+    m_file.clear();
+  }
+
+  // true if pChunkFilename was written from pSourceFilename
+  // in its current state (same size and modification time)
+  static bool is_fresh(const char *pChunkFilename, const char *pSourceFilename)
+  {
+    Chunked_mesh_header header;
+    if(!Chunked_mesh_header::read(pChunkFilename,header))
+      return false;
+    boost::uint64_t size;
+    boost::int64_t mtime;
+    if(!Binary_mesh_view::source_key(pSourceFilename,size,mtime))
+      return false;
+    return header.source_size == size && header.source_mtime == mtime;
+  }
+
+  // of the whole model
+  std::size_t size_of_vertices() const { return (std::size_t)m_header.nb_vertices; }
+  std::size_t size_of_facets() const { return (std::size_t)m_header.nb_facets; }
+  std::size_t size_of_chunks() const { return m_records.size(); }
+  // of the chunks in memory, the ones drawn and picked
+  std::size_t size_of_loaded_facets() const { return m_loaded_facets; }
+  boost::uint64_t loaded_bytes() const { return m_loaded_bytes; }
+  bool has_vertex_colors() const { return (m_header.flags & Chunked_mesh_header::VERTEX_COLORS) != 0; }
+
+  void set_budget(boost::uint64_t bytes) { m_budget = bytes; }
+  // called from the loader thread, see Chunk_listener
+  void set_listener(Chunk_listener *pListener)
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_pListener = pListener;
+  }
+  boost::uint64_t budget() const { return m_budget; }
+
+  double xmin() const { return m_header.bbox_min[0]; }
+  double xmax() const { return m_header.bbox_max[0]; }
+  double ymin() const { return m_header.bbox_min[1]; }
+  double ymax() const { return m_header.bbox_max[1]; }
+  double zmin() const { return m_header.bbox_min[2]; }
+  double zmax() const { return m_header.bbox_max[2]; }
+
+  /************************************************************************/
+  /* chunk cache                                                          */
+  /************************************************************************/
+  // choose the chunks for the current opengl matrices and viewport,
+  // take the ones the loader thread has read and queue the missing
+  // ones for it, false once every wanted chunk is in memory. Nothing is
+  // read here, the caller draws what is loaded and calls update() again
+  // when the listener says more chunks are ready
+  bool update()
+  {
+    GLdouble modelview[16], projection[16];
+    GLint viewport[4];
+    glGetDoublev(GL_MODELVIEW_MATRIX,modelview);
+    glGetDoublev(GL_PROJECTION_MATRIX,projection);
+    glGetIntegerv(GL_VIEWPORT,viewport);
+    double matrix[16];
+    for(int col = 0; col < 4; col++)
+      for(int row = 0; row < 4; row++)
+      {
+        double sum = 0.0;
+        for(int k = 0; k < 4; k++)
+          sum += projection[4*k+row]*modelview[4*col+k];
+        matrix[4*col+row] = sum;
+      }
+
+    // visible chunks by decreasing screen size
+    m_update++;
+    std::vector<std::pair<double,std::size_t> > candidates;
+    for(std::size_t c = 0; c < m_records.size(); c++)
+    {
+      double pixels;
+      m_states[c].visible = project(m_records[c],matrix,viewport,pixels);
+      if(m_states[c].visible && pixels >= MIN_PIXELS)
+        candidates.push_back(std::make_pair(-pixels,c));
+    }
+    std::sort(candidates.begin(),candidates.end());
+
+    // the wanted chunks fit in the budget, the first one in any case
+    boost::uint64_t wanted = 0;
+    std::size_t nb_wanted = 0;
+    for(; nb_wanted < candidates.size(); nb_wanted++)
+    {
+      boost::uint64_t bytes = memory_size(m_records[candidates[nb_wanted].second]);
+      if(nb_wanted > 0 && wanted + bytes > m_budget)
+        break;
+      wanted += bytes;
+      m_states[candidates[nb_wanted].second].last_used = m_update;
+    }
+    while(m_loaded_bytes > m_budget && evict())
+      ;
+
+    boost::mutex::scoped_lock lock(m_mutex);
+    std::vector<std::pair<std::size_t,Chunk*> > loaded;
+    loaded.swap(m_loaded);
+    m_notified = false;
+    for(std::size_t i = 0; i < loaded.size(); i++)
+      adopt(loaded[i].first,loaded[i].second);
+
+    // the queue follows the current view, a chunk no longer wanted is
+    // not read
+    m_queue.clear();
+    for(std::size_t i = 0; i < nb_wanted; i++)
+    {
+      std::size_t c = candidates[i].second;
+      if(m_states[c].pChunk == NULL && !m_states[c].failed && c != m_loading)
+        m_queue.push_back(c);
+    }
+    std::reverse(m_queue.begin(),m_queue.end());
+    if(!m_queue.empty())
+      m_wanted.notify_one();
+    return !m_queue.empty() || m_loading != NONE;
+  }
+
+  /************************************************************************/
+  /* opengl part                                                          */
+  /************************************************************************/
+  // chunks have facet normals only, they are always flat shaded
+  void gl_draw(bool, bool use_normals, bool use_colors = false)
+  {
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(is_drawn(c))
+        m_states[c].pChunk->gl_draw(false,use_normals,use_colors,(std::size_t)m_records[c].first_facet);
+  }
+
+  void gl_draw_lines()
+  {
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(is_drawn(c))
+        m_states[c].pChunk->gl_draw_lines();
+  }
+
+  void gl_draw_points()
+  {
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(is_drawn(c))
+        m_states[c].pChunk->gl_draw_points();
+  }
+
+  void gl_draw_bounding_box()
+  {
+    gl_draw_box(m_header.bbox_min,m_header.bbox_max);
+  }
+
+  // the boxes of the visible chunks still on the disk
+  void gl_draw_missing()
+  {
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(m_states[c].visible && m_states[c].pChunk == NULL)
+        gl_draw_box(m_records[c].bbox_min,m_records[c].bbox_max);
+  }
+
+  void gl_draw_selectedfaces()
+  {
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(is_drawn(c))
+        m_states[c].pChunk->gl_draw_selectedfaces();
+  }
+
+  //process hits, the names are the facet indices in the chunk order
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_normal)
+  {
+    if(hits == 0)
+      return;
+    m_selected.assign(m_selected.size(),false);
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(m_states[c].pChunk)
+        m_states[c].pChunk->clear_selection();
+    for(int i = 0; i < hits; i++)
+      select(buffer[i*4 + 3],true);
+  }
+
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_plus)
+  {
+    for(int i = 0; i < hits; i++)
+      select(buffer[i*4 + 3],true);
+  }
+
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_minus)
+  {
+    for(int i = 0; i < hits; i++)
+      select(buffer[i*4 + 3],!m_selected[buffer[i*4 + 3]]);
+  }
+
+private:
+  bool is_drawn(std::size_t c) const
+  {
+    return m_states[c].visible && m_states[c].pChunk != NULL;
+  }
+
+  bool is_valid_table() const
+  {
+    boost::uint64_t first_facet = 0;
+    bool colors = has_vertex_colors();
+    for(std::size_t c = 0; c < m_records.size(); c++)
+    {
+      const Chunk_record& record = m_records[c];
+      if(record.first_facet != first_facet || record.nb_facets == 0)
+        return false;
+      first_facet += record.nb_facets;
+      if(record.offset + record.size(colors) < record.offset)
+        return false;
+    }
+    return first_facet == m_header.nb_facets;
+  }
+
+  // in memory: the arrays, the edges (one pair per two
+  // indices) and the selection
+  boost::uint64_t memory_size(const Chunk_record& record) const
+  {
+    return record.size(has_vertex_colors()) +
+           4*(boost::uint64_t)record.nb_indices + record.nb_facets;
+  }
+
+  // false if the box is outside the frustum, pixels is the larger side
+  // of its projection, unbounded when the box crosses the eye plane
+  static bool project(const Chunk_record& record,
+                      const double matrix[16],
+                      const GLint viewport[4],
+                      double& pixels)
+  {
+    int outside = 0x3F;
+    bool behind = false;
+    double lo[2] = { 0.0, 0.0 }, hi[2] = { 0.0, 0.0 };
+    for(int corner = 0; corner < 8; corner++)
+    {
+      double p[3], clip[4];
+      for(int k = 0; k < 3; k++)
+        p[k] = (corner & (1<<k)) ? record.bbox_max[k] : record.bbox_min[k];
+      for(int row = 0; row < 4; row++)
+        clip[row] = matrix[row]*p[0] + matrix[4+row]*p[1] + matrix[8+row]*p[2] + matrix[12+row];
+      double w = clip[3];
+      int code = 0;
+      for(int k = 0; k < 3; k++)
+      {
+        if(clip[k] < -w) code |= 1 << (2*k);
+        if(clip[k] > w) code |= 2 << (2*k);
+      }
+      outside &= code;
+      if(w <= 0.0)
+      {
+        behind = true;
+        continue;
+      }
+      for(int k = 0; k < 2; k++)
+      {
+        double x = (clip[k]/w + 1.0)*0.5*viewport[2+k];
+        lo[k] = corner == 0 ? x : std::min(lo[k],x);
+        hi[k] = corner == 0 ? x : std::max(hi[k],x);
+      }
+    }
+    pixels = behind ? 1e30 : std::max(hi[0]-lo[0],hi[1]-lo[1]);
+    return outside == 0;
+  }
+
+  // the loader thread: reads the chunks of m_queue, the last one first,
+  // into m_loaded; m_file and m_records are its own once open() is done
+  void run()
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    for(;;)
+    {
+      while(!m_stop && m_queue.empty())
+        m_wanted.wait(lock);
+      if(m_stop)
+        return;
+      m_loading = m_queue.back();
+      m_queue.pop_back();
+      lock.unlock();
+      Chunk *pChunk = load(m_loading);
+      lock.lock();
+      m_loaded.push_back(std::make_pair(m_loading,pChunk));
+      m_loading = NONE;
+      if(m_pListener != NULL && !m_notified)
+      {
+        m_notified = true;
+        m_pListener->chunks_loaded();
+      }
+    }
+  }
+
+  // the chunk read from the file, NULL if the read failed
+  Chunk *load(std::size_t c)
+  {
+    const Chunk_record& record = m_records[c];
+    Chunk *pChunk = new Chunk();
+    Chunk::Mesh& mesh = pChunk->mesh();
+    mesh.points.resize(3*(std::size_t)record.nb_vertices);
+    mesh.facet_begin.resize((std::size_t)record.nb_facets+1);
+    mesh.facet_vertices.resize((std::size_t)record.nb_indices);
+    mesh.facet_normals.resize(3*(std::size_t)record.nb_facets);
+    if(has_vertex_colors())
+      mesh.vertex_colors.resize(3*(std::size_t)record.nb_vertices);
+
+    m_file.clear();
+    m_file.seekg((std::streamoff)record.offset);
+    bool colors = has_vertex_colors();
+    boost::uint64_t offset = record.offset;
+    read_array(mesh.points,record.array_size(Chunk_record::POINTS,colors),offset);
+    read_array(mesh.facet_begin,record.array_size(Chunk_record::FACET_BEGIN,colors),offset);
+    read_array(mesh.facet_vertices,record.array_size(Chunk_record::FACET_VERTICES,colors),offset);
+    read_array(mesh.facet_normals,record.array_size(Chunk_record::FACET_NORMALS,colors),offset);
+    read_array(mesh.vertex_colors,record.array_size(Chunk_record::VERTEX_COLORS,colors),offset);
+    if(!m_file || !mesh.is_valid() ||
+       mesh.facet_begin[0] != 0 || mesh.facet_begin[record.nb_facets] != record.nb_indices)
+    {
+      delete pChunk;
+      return NULL;
+    }
+
+    pChunk->compute_type();
+    pChunk->compute_bounding_box();
+    return pChunk;
+  }
+
+  // a chunk from the loader thread, kept if this update() wants it
+  void adopt(std::size_t c, Chunk *pChunk)
+  {
+    const Chunk_record& record = m_records[c];
+    if(pChunk == NULL)
+    {
+      m_states[c].failed = true;
+      return;
+    }
+    boost::uint64_t bytes = memory_size(record);
+    if(m_states[c].pChunk != NULL || m_states[c].last_used != m_update)
+    {
+      delete pChunk;
+      return;
+    }
+    while(m_loaded_bytes + bytes > m_budget && evict())
+      ;
+    std::size_t first_facet = (std::size_t)record.first_facet;
+    for(std::size_t f = 0; f < record.nb_facets; f++)
+      if(m_selected[first_facet+f])
+        pChunk->select(f,true);
+    m_states[c].pChunk = pChunk;
+    m_loaded_bytes += bytes;
+    m_loaded_facets += record.nb_facets;
+  }
+
+  template <class T>
+  void read_array(std::vector<T>& values, boost::uint64_t size, boost::uint64_t& offset)
+  {
+    if(size > 0)
+      m_file.read((char*)&values[0],(std::streamsize)size);
+    boost::uint64_t next = Binary_mesh_header::align(offset + size);
+    if(next != offset + size)
+      m_file.seekg((std::streamoff)(next - offset - size),std::ios::cur);
+    offset = next;
+  }
+
+  // drop the least recently wanted chunk not wanted by this update
+  bool evict()
+  {
+    std::size_t victim = m_states.size();
+    for(std::size_t c = 0; c < m_states.size(); c++)
+      if(m_states[c].pChunk != NULL && m_states[c].last_used != m_update &&
+         (victim == m_states.size() || m_states[c].last_used < m_states[victim].last_used))
+        victim = c;
+    if(victim == m_states.size())
+      return false;
+    CGALQT_DELETE(m_states[victim].pChunk);
+    m_loaded_bytes -= memory_size(m_records[victim]);
+    m_loaded_facets -= m_records[victim].nb_facets;
+    return true;
+  }
+
+  // facet in the chunk order
+  void select(std::size_t facet, bool selected)
+  {
+    m_selected[facet] = selected;
+    std::size_t c = chunk_of(facet);
+    if(m_states[c].pChunk)
+      m_states[c].pChunk->select(facet - (std::size_t)m_records[c].first_facet,selected);
+  }
+
+  std::size_t chunk_of(std::size_t facet) const
+  {
+    std::size_t lo = 0, hi = m_records.size();
+    while(hi - lo > 1)
+    {
+      std::size_t middle = (lo + hi)/2;
+      if(m_records[middle].first_facet <= facet)
+        lo = middle;
+      else
+        hi = middle;
+    }
+    return lo;
+  }
+
+  static void gl_draw_box(const double *bbox_min, const double *bbox_max)
+  {
+    glBegin(GL_LINES);
+    for(int k = 0; k < 3; k++)
+    {
+      int a = (k+1)%3, b = (k+2)%3;
+      for(int corner = 0; corner < 4; corner++)
+      {
+        double p[3];
+        p[a] = (corner & 1) ? bbox_max[a] : bbox_min[a];
+        p[b] = (corner & 2) ? bbox_max[b] : bbox_min[b];
+        p[k] = bbox_min[k];
+        glVertex3d(p[0],p[1],p[2]);
+        p[k] = bbox_max[k];
+        glVertex3d(p[0],p[1],p[2]);
+      }
+    }
+    glEnd();
+  }
+
+private:
+  std::ifstream m_file;
+  Chunked_mesh_header m_header;
+  std::vector<Chunk_record> m_records;
+  std::vector<Chunk_state> m_states;
+  // one bit per facet of the model, in the chunk order
+  std::vector<bool> m_selected;
+
+  boost::uint64_t m_budget;
+  boost::uint64_t m_loaded_bytes;
+  std::size_t m_loaded_facets;
+  unsigned int m_update;
+
+  // shared with the loader thread under m_mutex
+  static const std::size_t NONE = ~(std::size_t)0;
+  boost::thread *m_pThread;
+  boost::mutex m_mutex;
+  boost::condition_variable m_wanted;
+  Chunk_listener *m_pListener;
+  // to read, the next one at the back
+  std::vector<std::size_t> m_queue;
+  std::size_t m_loading;
+  // read, not taken by update() yet
+  std::vector<std::pair<std::size_t,Chunk*> > m_loaded;
+  bool m_notified;
+  bool m_stop;
+};
+
+#endif
@@ -0,0 +1,681 @@
+/***************************************************************************
+mesh_halfedges.h  -  half-edge connectivity of a face soup in bulk
+----------------------------------------------------------------------------
+Mesh_halfedges turns flat facet index arrays into half-edge connectivity
+without the facet by facet incremental builder. Every facet corner is one
+halfedge, created in parallel with its next and an undirected edge key.
+The keys are radix sorted in parallel (stable, so the result does not
+depend on the thread count) and equal keys give the pairs of opposite
+halfedges. An edge seen once is a border, an edge seen in two facets with
+the same orientation or in more than two facets is reported. Border
+halfedges are then linked around the holes and every vertex is checked to
+have a single umbrella. Halfedge_linker creates the facets and halfedges
+in a Polyhedron_3 HalfedgeDS and sets their links in parallel.
+***************************************************************************/
+
+#ifndef MESH_HALFEDGES_H
+#define MESH_HALFEDGES_H
+
+#include "config.h"
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <CGAL/HalfedgeDS_decorator.h>
+#include "parallelutils.h"
+
+class Mesh_halfedges
+{
+public:
+  enum { NONE = 0xFFFFFFFFu };
+
+  // built from the facets, halfedge i < size_of_indices() is the one of
+  // facet corner i, it points to facet_vertices[i] and comes from the
+  // previous corner, the border halfedges follow. Filled by hand
+  // (CSubdivider_sqrt3::refine()) the halfedges come in any order.
+  std::vector<unsigned int> next;
+  std::vector<unsigned int> opposite;
+  std::vector<unsigned int> vertex;
+  // NONE for border halfedges
+  std::vector<unsigned int> facet;
+  // a halfedge pointing to each vertex, NONE for isolated vertices
+  std::vector<unsigned int> vertex_halfedge;
+  // the halfedge of each facet, pointing to its first vertex, empty for
+  // the first corner
+  std::vector<unsigned int> facet_halfedge;
+
+private:
+  enum { RADIX_BITS = 11, RADIX = 1 << RADIX_BITS };
+  enum { FACET_ERROR, EDGE_ERROR, VERTEX_ERROR };
+
+  // lowest error found in a range, NONE if none
+  struct Range_error
+  {
+    unsigned int type;
+    unsigned int item;
+    Range_error() : type(NONE), item(NONE) {}
+    bool operator<(const Range_error& e) const
+    {
+      return type < e.type || (type == e.type && item < e.item);
+    }
+  };
+
+  // edge key and halfedge index, packed in m_keys under the key when
+  // both fit in 64 bits, m_id_bits is then the width of the index
+  std::vector<boost::uint64_t> m_keys, m_keys_tmp;
+  std::vector<unsigned int> m_ids, m_ids_tmp;
+  unsigned int m_id_bits;
+  std::vector<unsigned int> m_counts;
+  std::vector<unsigned int> m_border_out;
+  std::vector<Range_error> m_errors;
+  unsigned int m_vertex_bits;
+  std::string m_error;
+
+public:
+  Mesh_halfedges() : m_id_bits(0), m_vertex_bits(1) {}
+  ~Mesh_halfedges() {}
+
+  std::size_t size_of_halfedges() const { return next.size(); }
+  const std::string& error() const { return m_error; }
+
+  // facet f uses facet_vertices[facet_begin[f]..facet_begin[f+1]),
+  // facet_begin[0] is 0. false with error() set if the facets are not
+  // a manifold oriented surface.
+  template <class Begin,class Index>
+  bool build(const Begin *facet_begin,
+             std::size_t nb_facets,
+             const Index *facet_vertices,
+             std::size_t nb_vertices)
+  {
+    clear();
+    CGAL_assertion(facet_begin[0] == 0);
+    std::size_t nb_indices = facet_begin[nb_facets];
+    if(nb_indices >= NONE/2 || nb_vertices >= NONE)
+    {
+      m_error = "too many facets";
+      return false;
+    }
+    m_vertex_bits = 1;
+    while(m_vertex_bits < 32 && (std::size_t(1) << m_vertex_bits) < nb_vertices)
+      m_vertex_bits++;
+    m_id_bits = 1;
+    while((std::size_t(1) << m_id_bits) < nb_indices)
+      m_id_bits++;
+    if(2*m_vertex_bits + m_id_bits > 64)
+      m_id_bits = 0;
+
+    next.resize(nb_indices);
+    opposite.resize(nb_indices);
+    vertex.resize(nb_indices);
+    facet.resize(nb_indices);
+    m_keys.resize(nb_indices);
+    if(m_id_bits == 0)
+      m_ids.resize(nb_indices);
+
+    // corners, next links and edge keys
+    std::size_t grain = 1 << 13;
+    m_errors.assign(ParallelUtils::nb_ranges(nb_facets,grain),Range_error());
+    Corner_maker<Begin,Index> corners;
+    corners.pFacetBegin = facet_begin;
+    corners.pFacetVertices = facet_vertices;
+    corners.nb_vertices = nb_vertices;
+    corners.pHalfedges = this;
+    ParallelUtils::parallel_for(0,nb_facets,corners,grain);
+    if(failed())
+      return false;
+
+    sort_keys();
+
+    // opposite halfedges, border halfedges counted per range
+    grain = 1 << 14;
+    std::size_t nb_ranges = ParallelUtils::nb_ranges(nb_indices,grain);
+    m_errors.assign(nb_ranges,Range_error());
+    m_counts.assign(nb_ranges+1,0);
+    Edge_pairer pairer;
+    pairer.pHalfedges = this;
+    pairer.assign_borders = false;
+    ParallelUtils::parallel_for(0,nb_indices,pairer,grain);
+    if(failed())
+      return false;
+    std::size_t nb_borders = ParallelUtils::prefix_sum(m_counts);
+    if(nb_indices + nb_borders >= NONE)
+    {
+      m_error = "too many facets";
+      return false;
+    }
+
+    // border halfedges in sorted edge order
+    next.resize(nb_indices+nb_borders);
+    opposite.resize(nb_indices+nb_borders);
+    vertex.resize(nb_indices+nb_borders);
+    facet.resize(nb_indices+nb_borders,(unsigned int)NONE);
+    pairer.assign_borders = true;
+    ParallelUtils::parallel_for(0,nb_indices,pairer,grain);
+    std::vector<boost::uint64_t>().swap(m_keys);
+    std::vector<boost::uint64_t>().swap(m_keys_tmp);
+    std::vector<unsigned int>().swap(m_ids);
+    std::vector<unsigned int>().swap(m_ids_tmp);
+
+    // a border halfedge is followed by the border halfedge leaving its
+    // vertex, vertices left by several of them are done afterwards
+    m_border_out.assign(nb_vertices,(unsigned int)NONE);
+    std::vector<boost::uint64_t> shared;
+    for(std::size_t h = nb_indices; h < next.size(); h++)
+    {
+      unsigned int from = vertex[opposite[h]];
+      if(m_border_out[from] != NONE)
+        shared.push_back((boost::uint64_t(from) << 32) | h);
+      else
+        m_border_out[from] = (unsigned int)h;
+    }
+    m_errors.assign(ParallelUtils::nb_ranges(nb_borders,grain),Range_error());
+    Border_linker borders;
+    borders.pHalfedges = this;
+    ParallelUtils::parallel_for(nb_indices,next.size(),borders,grain);
+    if(failed())
+      return false;
+    link_shared_borders(shared);
+    std::vector<unsigned int>().swap(m_border_out);
+
+    // incoming halfedges per vertex, then the umbrella of every vertex
+    // must go through all of them
+    vertex_halfedge.assign(nb_vertices,(unsigned int)NONE);
+    m_counts.assign(nb_vertices,0);
+    for(std::size_t h = 0; h < next.size(); h++)
+    {
+      vertex_halfedge[vertex[h]] = (unsigned int)h;
+      m_counts[vertex[h]]++;
+    }
+    m_errors.assign(ParallelUtils::nb_ranges(nb_vertices,grain),Range_error());
+    Umbrella_checker umbrellas;
+    umbrellas.pHalfedges = this;
+    ParallelUtils::parallel_for(0,nb_vertices,umbrellas,grain);
+    if(failed())
+      return false;
+    std::vector<unsigned int>().swap(m_counts);
+    return true;
+  }
+
+  void clear()
+  {
+    next.clear();
+    opposite.clear();
+    vertex.clear();
+    facet.clear();
+    vertex_halfedge.clear();
+    facet_halfedge.clear();
+    m_ids.clear();
+    m_error.clear();
+  }
+
+private:
+  boost::uint64_t edge_key(unsigned int a, unsigned int b) const
+  {
+    if(a > b)
+      std::swap(a,b);
+    return (boost::uint64_t(a) << m_vertex_bits) | b;
+  }
+  boost::uint64_t key(std::size_t i) const
+  {
+    return m_keys[i] >> m_id_bits;
+  }
+  unsigned int id(std::size_t i) const
+  {
+    if(m_id_bits == 0)
+      return m_ids[i];
+    return (unsigned int)(m_keys[i] & ((boost::uint64_t(1) << m_id_bits)-1));
+  }
+
+  void set_error(unsigned int type, unsigned int item)
+  {
+    std::ostringstream stream;
+    switch(type)
+    {
+    case FACET_ERROR:
+      stream << "facet " << item << " has less than 3 vertices, a vertex "
+                "index out of range or the same vertex twice";
+      break;
+    case EDGE_ERROR:
+      stream << "an edge of facet " << facet[item] << " is shared by more "
+                "than two facets or by two inconsistently oriented facets";
+      break;
+    default:
+      stream << "vertex " << item << " is non-manifold";
+      break;
+    }
+    m_error = stream.str();
+  }
+
+  // A vertex where several open fans meet has one border halfedge in
+  // and out per fan. As in the incremental builder, the fans are joined
+  // in a single umbrella: the border halfedge ending fan i is followed by
+  // the one starting fan i+1.
+  void link_shared_borders(std::vector<boost::uint64_t>& shared)
+  {
+    if(shared.empty())
+      return;
+    std::size_t nb = shared.size();
+    for(std::size_t i = 0; i < nb; i++)
+    {
+      unsigned int v = (unsigned int)(shared[i] >> 32);
+      shared.push_back((boost::uint64_t(v) << 32) | m_border_out[v]);
+    }
+    std::sort(shared.begin(),shared.end());
+    shared.erase(std::unique(shared.begin(),shared.end()),shared.end());
+    for(std::size_t first = 0; first < shared.size(); )
+    {
+      std::size_t last = first+1;
+      while(last < shared.size() && (shared[last] >> 32) == (shared[first] >> 32))
+        last++;
+      for(std::size_t i = first; i < last; i++)
+      {
+        // around the fan from its first border halfedge to its last
+        unsigned int h = opposite[(unsigned int)shared[i]];
+        while(facet[h] != NONE)
+          h = opposite[next[h]];
+        std::size_t j = i+1 < last ? i+1 : first;
+        next[h] = (unsigned int)shared[j];
+      }
+      first = last;
+    }
+  }
+
+  // the lowest error over the ranges, the same for any thread count
+  bool failed()
+  {
+    std::vector<Range_error>::const_iterator e =
+      std::min_element(m_errors.begin(),m_errors.end());
+    if(e == m_errors.end() || e->type == NONE)
+      return false;
+    set_error(e->type,e->item);
+    return true;
+  }
+
+  template <class Begin,class Index>
+  struct Corner_maker
+  {
+    const Begin *pFacetBegin;
+    const Index *pFacetVertices;
+    std::size_t nb_vertices;
+    Mesh_halfedges *pHalfedges;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Mesh_halfedges& m = *pHalfedges;
+      for(std::size_t f = begin; f < end; f++)
+      {
+        unsigned int first = (unsigned int)pFacetBegin[f];
+        unsigned int last = (unsigned int)pFacetBegin[f+1];
+        if(last < first + 3 || !valid_facet(first,last))
+        {
+          m.m_errors[range].type = FACET_ERROR;
+          m.m_errors[range].item = (unsigned int)f;
+          return;
+        }
+        unsigned int from = (unsigned int)pFacetVertices[last-1];
+        for(unsigned int i = first; i < last; i++)
+        {
+          unsigned int to = (unsigned int)pFacetVertices[i];
+          m.next[i] = i+1 < last ? i+1 : first;
+          m.vertex[i] = to;
+          m.facet[i] = (unsigned int)f;
+          if(m.m_id_bits == 0)
+          {
+            m.m_keys[i] = m.edge_key(from,to);
+            m.m_ids[i] = i;
+          }
+          else
+            m.m_keys[i] = (m.edge_key(from,to) << m.m_id_bits) | i;
+          from = to;
+        }
+      }
+    }
+
+    bool valid_facet(unsigned int first, unsigned int last) const
+    {
+      for(unsigned int i = first; i < last; i++)
+        if(pFacetVertices[i] < 0 || std::size_t(pFacetVertices[i]) >= nb_vertices)
+          return false;
+      if(last - first <= 16)
+      {
+        for(unsigned int i = first+1; i < last; i++)
+          for(unsigned int j = first; j < i; j++)
+            if(pFacetVertices[i] == pFacetVertices[j])
+              return false;
+        return true;
+      }
+      std::vector<Index> sorted(pFacetVertices+first,pFacetVertices+last);
+      std::sort(sorted.begin(),sorted.end());
+      return std::adjacent_find(sorted.begin(),sorted.end()) == sorted.end();
+    }
+  };
+
+  // one pass of the radix sort: digit histogram per range, then the
+  // stable scatter of every range at its offsets
+  struct Digit_counter
+  {
+    const boost::uint64_t *pKeys;
+    unsigned int shift;
+    unsigned int *pCounts;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      unsigned int *pCount = pCounts + range*RADIX;
+      for(std::size_t i = begin; i < end; i++)
+        pCount[(pKeys[i] >> shift) & (RADIX-1)]++;
+    }
+  };
+
+  struct Digit_scatter
+  {
+    const boost::uint64_t *pKeys;
+    const unsigned int *pIds;
+    boost::uint64_t *pKeysOut;
+    unsigned int *pIdsOut;
+    unsigned int shift;
+    const unsigned int *pOffsets;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      unsigned int offsets[RADIX];
+      std::copy(pOffsets+range*RADIX,pOffsets+(range+1)*RADIX,offsets);
+      if(pIds == NULL)
+      {
+        for(std::size_t i = begin; i < end; i++)
+          pKeysOut[offsets[(pKeys[i] >> shift) & (RADIX-1)]++] = pKeys[i];
+        return;
+      }
+      for(std::size_t i = begin; i < end; i++)
+      {
+        unsigned int o = offsets[(pKeys[i] >> shift) & (RADIX-1)]++;
+        pKeysOut[o] = pKeys[i];
+        pIdsOut[o] = pIds[i];
+      }
+    }
+  };
+
+  void sort_keys()
+  {
+    std::size_t nb = m_keys.size();
+    if(nb == 0)
+      return;
+    std::size_t grain = 1 << 15;
+    std::size_t nb_ranges = ParallelUtils::nb_ranges(nb,grain);
+    m_keys_tmp.resize(nb);
+    m_ids_tmp.resize(m_ids.size());
+    std::vector<unsigned int> counts;
+    unsigned int bits = m_id_bits + 2*m_vertex_bits;
+    for(unsigned int shift = m_id_bits; shift < bits; shift += RADIX_BITS)
+    {
+      counts.assign(nb_ranges*RADIX,0);
+      Digit_counter counter;
+      counter.pKeys = &m_keys[0];
+      counter.shift = shift;
+      counter.pCounts = &counts[0];
+      ParallelUtils::parallel_for(0,nb,counter,grain);
+
+      // digit major, range minor offsets, a digit shared by all
+      // keys leaves the order as is
+      unsigned int sum = 0;
+      bool single = false;
+      for(unsigned int d = 0; d < RADIX; d++)
+      {
+        unsigned int total = 0;
+        for(std::size_t r = 0; r < nb_ranges; r++)
+        {
+          unsigned int c = counts[r*RADIX+d];
+          counts[r*RADIX+d] = sum;
+          sum += c;
+          total += c;
+        }
+        if(total == nb)
+          single = true;
+      }
+      if(single)
+        continue;
+
+      Digit_scatter scatter;
+      scatter.pKeys = &m_keys[0];
+      scatter.pIds = m_ids.empty() ? NULL : &m_ids[0];
+      scatter.pKeysOut = &m_keys_tmp[0];
+      scatter.pIdsOut = m_ids_tmp.empty() ? NULL : &m_ids_tmp[0];
+      scatter.shift = shift;
+      scatter.pOffsets = &counts[0];
+      ParallelUtils::parallel_for(0,nb,scatter,grain);
+      m_keys.swap(m_keys_tmp);
+      m_ids.swap(m_ids_tmp);
+    }
+  }
+
+  // runs of equal keys starting in [begin,end): two halfedges of
+  // opposite directions are paired, a single one gets a border
+  // halfedge in the second pass, numbered in sorted order
+  struct Edge_pairer
+  {
+    Mesh_halfedges *pHalfedges;
+    bool assign_borders;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Mesh_halfedges& m = *pHalfedges;
+      std::size_t nb = m.m_keys.size();
+      unsigned int border = (unsigned int)(nb + m.m_counts[range]);
+      std::size_t i = begin;
+      while(i > 0 && i < end && m.key(i) == m.key(i-1))
+        i++;
+      while(i < end)
+      {
+        boost::uint64_t key = m.key(i);
+        std::size_t j = i+1;
+        while(j < nb && m.key(j) == key)
+          j++;
+        unsigned int h = m.id(i);
+        if(j == i+1)
+        {
+          if(assign_borders)
+          {
+            // from the vertex h points to back to where h comes from
+            unsigned int to = (unsigned int)((key >> m.m_vertex_bits) ^
+                              (key & ((boost::uint64_t(1) << m.m_vertex_bits)-1)) ^
+                              m.vertex[h]);
+            m.opposite[h] = border;
+            m.opposite[border] = h;
+            m.vertex[border] = to;
+            border++;
+          }
+          else
+            m.m_counts[range]++;
+        }
+        else if(!assign_borders)
+        {
+          unsigned int g = m.id(i+1);
+          if(j > i+2 || m.vertex[h] == m.vertex[g])
+          {
+            // the lowest one, the runs are not in halfedge order
+            if(std::min(h,g) < m.m_errors[range].item)
+            {
+              m.m_errors[range].type = EDGE_ERROR;
+              m.m_errors[range].item = std::min(h,g);
+            }
+          }
+          else
+          {
+            m.opposite[h] = g;
+            m.opposite[g] = h;
+          }
+        }
+        i = j;
+      }
+    }
+  };
+
+  struct Border_linker
+  {
+    Mesh_halfedges *pHalfedges;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Mesh_halfedges& m = *pHalfedges;
+      for(std::size_t h = begin; h < end; h++)
+      {
+        unsigned int n = m.m_border_out[m.vertex[h]];
+        if(n == NONE)
+        {
+          m.m_errors[range].type = VERTEX_ERROR;
+          m.m_errors[range].item = m.vertex[h];
+          return;
+        }
+        m.next[h] = n;
+      }
+    }
+  };
+
+  struct Umbrella_checker
+  {
+    Mesh_halfedges *pHalfedges;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Mesh_halfedges& m = *pHalfedges;
+      for(std::size_t v = begin; v < end; v++)
+      {
+        unsigned int start = m.vertex_halfedge[v];
+        if(start == NONE)
+          continue;
+        unsigned int h = start;
+        unsigned int n = 0;
+        do
+        {
+          h = m.opposite[m.next[h]];
+          n++;
+        }
+        while(h != start && n <= m.m_counts[v]);
+        if(n != m.m_counts[v])
+        {
+          m.m_errors[range].type = VERTEX_ERROR;
+          m.m_errors[range].item = (unsigned int)v;
+          return;
+        }
+      }
+    }
+  };
+};
+
+// creates the facets and halfedges of a Mesh_halfedges in a HalfedgeDS
+// whose vertices are already there, halfedge(i) and facet(f) give them
+template <class HDS>
+class Halfedge_linker
+{
+public:
+  typedef typename HDS::Vertex_handle Vertex_handle;
+  typedef typename HDS::Halfedge_handle Halfedge_handle;
+  typedef typename HDS::Face_handle Face_handle;
+  typedef typename HDS::Halfedge Halfedge;
+  typedef typename HDS::Face Face;
+  typedef typename Halfedge::Base HBase;
+
+private:
+  std::vector<Halfedge_handle> m_halfedges;
+  std::vector<Face_handle> m_facets;
+
+public:
+  Halfedge_linker() {}
+  ~Halfedge_linker() {}
+
+  Halfedge_handle halfedge(std::size_t i) const { return m_halfedges[i]; }
+  Face_handle facet(std::size_t f) const { return m_facets[f]; }
+
+  // vertices[v] is the handle of vertex v, the HalfedgeDS must have
+  // room for the new facets and halfedges
+  void link(HDS& hds,
+            const Mesh_halfedges& halfedges,
+            const std::vector<Vertex_handle>& vertices,
+            std::size_t nb_facets)
+  {
+    // the HalfedgeDS stores opposite halfedges together
+    std::size_t nb = halfedges.size_of_halfedges();
+    m_halfedges.assign(nb,Halfedge_handle());
+    for(std::size_t h = 0; h < nb; h++)
+    {
+      unsigned int g = halfedges.opposite[h];
+      if(h < g)
+      {
+        m_halfedges[h] = hds.edges_push_back(Halfedge(),Halfedge());
+        m_halfedges[g] = m_halfedges[h]->opposite();
+      }
+    }
+    CGAL::HalfedgeDS_decorator<HDS> decorator(hds);
+    m_facets.resize(nb_facets);
+    for(std::size_t f = 0; f < nb_facets; f++)
+      m_facets[f] = decorator.faces_push_back(Face());
+
+    Halfedge_setter halfedge_setter;
+    halfedge_setter.pHalfedges = &halfedges;
+    halfedge_setter.pHandles = nb ? &m_halfedges[0] : NULL;
+    halfedge_setter.pVertices = vertices.empty() ? NULL : &vertices[0];
+    halfedge_setter.pFacets = nb_facets ? &m_facets[0] : NULL;
+    ParallelUtils::parallel_for(0,nb,halfedge_setter,1<<14);
+
+    Vertex_setter vertex_setter;
+    vertex_setter.pHalfedges = &halfedges;
+    vertex_setter.pHandles = halfedge_setter.pHandles;
+    vertex_setter.pVertices = halfedge_setter.pVertices;
+    ParallelUtils::parallel_for(0,vertices.size(),vertex_setter,1<<14);
+  }
+
+private:
+  struct Halfedge_setter
+  {
+    const Mesh_halfedges *pHalfedges;
+    const Halfedge_handle *pHandles;
+    const Vertex_handle *pVertices;
+    const Face_handle *pFacets;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      CGAL::HalfedgeDS_items_decorator<HDS> decorator;
+      const Mesh_halfedges& m = *pHalfedges;
+      for(std::size_t h = begin; h < end; h++)
+      {
+        Halfedge_handle e = pHandles[h];
+        Halfedge_handle n = pHandles[m.next[h]];
+        e->HBase::set_next(n);
+        decorator.set_prev(n,e);
+        e->HBase::set_vertex(pVertices[m.vertex[h]]);
+        unsigned int f = m.facet[h];
+        if(f == Mesh_halfedges::NONE)
+          decorator.set_face(e,Face_handle());
+        else
+        {
+          decorator.set_face(e,pFacets[f]);
+          // the first corner of a facet is its halfedge unless given
+          if(m.facet_halfedge.empty() ? h == 0 || m.facet[h-1] != f
+                                      : m.facet_halfedge[f] == h)
+            decorator.set_face_halfedge(pFacets[f],e);
+        }
+      }
+    }
+  };
+
+  struct Vertex_setter
+  {
+    const Mesh_halfedges *pHalfedges;
+    const Halfedge_handle *pHandles;
+    const Vertex_handle *pVertices;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      CGAL::HalfedgeDS_items_decorator<HDS> decorator;
+      const Mesh_halfedges& m = *pHalfedges;
+      for(std::size_t v = begin; v < end; v++)
+      {
+        unsigned int h = m.vertex_halfedge[v];
+        decorator.set_vertex_halfedge(pVertices[v],
+          h == Mesh_halfedges::NONE ? Halfedge_handle() : pHandles[h]);
+      }
+    }
+  };
+};
+
+#endif
@@ -0,0 +1,35 @@
+/***************************************************************************
+mesh_kernel.h  -  the geometric kernel of the meshes
+----------------------------------------------------------------------------
+Enriched_Polyhedron_kernel is chosen at compile time:
+
+  CGALQT_KERNEL_SIMPLE_DOUBLE   CGAL::Simple_cartesian<double>
+  CGALQT_KERNEL_SIMPLE_FLOAT    CGAL::Simple_cartesian<float>
+  neither                       CGAL::Cartesian<double>
+
+Cartesian shares the coordinates of its points and vectors through
+reference counted handles, every copy touches a counter. Simple_cartesian
+keeps them in place. Polyhedron, Surface_mesh, Polyhedron_view and the
+parsers follow the kernel, Bench/bench_kernel compares the three.
+***************************************************************************/
+
+#ifndef MESH_KERNEL_H
+#define MESH_KERNEL_H
+
+#include "config.h"
+
+#if defined(CGALQT_KERNEL_SIMPLE_DOUBLE) || defined(CGALQT_KERNEL_SIMPLE_FLOAT)
+#include <CGAL/Simple_cartesian.h>
+#else
+#include <CGAL/Cartesian.h>
+#endif
+
+#if defined(CGALQT_KERNEL_SIMPLE_DOUBLE)
+typedef CGAL::Simple_cartesian<double> Enriched_Polyhedron_kernel;
+#elif defined(CGALQT_KERNEL_SIMPLE_FLOAT)
+typedef CGAL::Simple_cartesian<float> Enriched_Polyhedron_kernel;
+#else
+typedef CGAL::Cartesian<double> Enriched_Polyhedron_kernel;
+#endif
+
+#endif
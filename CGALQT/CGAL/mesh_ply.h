@@ -0,0 +1,788 @@
+/***************************************************************************
+mesh_ply.h  -  PLY reader and writer
+----------------------------------------------------------------------------
+ascii, binary_little_endian and binary_big_endian files. The reader keeps
+vertex positions, normals (nx,ny,nz) and colors (red,green,blue) and the
+face vertex_indices lists, other elements and properties are skipped.
+Binary vertex records of fixed size are decoded in place by several
+threads, face lists are copied straight from the mapped file. Compressed
+files are parsed from the window of decompressed blocks as they come,
+fixed size records by batches of BATCH_SIZE bytes. The vertices go to
+the preview, if any, as they are decoded.
+***************************************************************************/
+
+#ifndef MESH_PLY_H
+#define MESH_PLY_H
+
+#include "config.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "indexed_mesh.h"
+#include "compressedfile.h"
+#include "numparse.h"
+#include "numformat.h"
+#include "mesh_preview.h"
+#include "parallelutils.h"
+#include "stringutils.h"
+
+class Ply_types
+{
+private:
+  Ply_types();
+  ~Ply_types();
+
+public:
+  enum Type { INT8 = 0, UINT8, INT16, UINT16, INT32, UINT32, FLOAT32, FLOAT64, NONE };
+
+  static Type from_name(const std::string& name)
+  {
+    static const char *names[][2] = {
+      { "char", "int8" }, { "uchar", "uint8" }, { "short", "int16" }, { "ushort", "uint16" },
+      { "int", "int32" }, { "uint", "uint32" }, { "float", "float32" }, { "double", "float64" } };
+    for(int t = 0; t < NONE; t++)
+      if(name == names[t][0] || name == names[t][1])
+        return (Type)t;
+    return NONE;
+  }
+
+  static std::size_t size(Type type)
+  {
+    static const std::size_t sizes[] = { 1, 1, 2, 2, 4, 4, 4, 8, 0 };
+    return sizes[type];
+  }
+
+  static bool host_little_endian()
+  {
+    unsigned int one = 1;
+    return *(const unsigned char*)&one == 1;
+  }
+
+  // binary value at p, byte swapped if the file byte order is not the host one
+  static double value(const char *p, Type type, bool swap)
+  {
+    char bytes[8];
+    std::size_t n = size(type);
+    if(swap)
+      for(std::size_t i = 0; i < n; i++)
+        bytes[i] = p[n-1-i];
+    else
+      memcpy(bytes,p,n);
+    switch(type)
+    {
+    case INT8:    return get<signed char>(bytes);
+    case UINT8:   return get<unsigned char>(bytes);
+    case INT16:   return get<short>(bytes);
+    case UINT16:  return get<unsigned short>(bytes);
+    case INT32:   return get<int>(bytes);
+    case UINT32:  return get<unsigned int>(bytes);
+    case FLOAT32: return get<float>(bytes);
+    case FLOAT64: return get<double>(bytes);
+    default:      return 0.0;
+    }
+  }
+
+  // 0..1 float colors are scaled, integer colors are 0..255
+  static unsigned char to_color(double value, Type type)
+  {
+    if(type == FLOAT32 || type == FLOAT64)
+      value *= 255.0;
+    value = std::max(0.0,std::min(255.0,value));
+    return (unsigned char)(value + 0.5);
+  }
+
+private:
+  template <class T>
+  static T get(const char *bytes)
+  {
+    T v;
+    memcpy(&v,bytes,sizeof(T));
+    return v;
+  }
+};
+
+template <class FT>
+class Parser_ply
+{
+private:
+  enum Format { ASCII, BINARY_LITTLE_ENDIAN, BINARY_BIG_ENDIAN };
+  enum { BATCH_SIZE = 1 << 22 };
+
+  // vertex properties the mesh keeps
+  enum { X = 0, Y, Z, NX, NY, NZ, RED, GREEN, BLUE, NB_FIELDS };
+
+  struct Property
+  {
+    std::string name;
+    Ply_types::Type type;
+    // count type of a list property, NONE for a scalar
+    Ply_types::Type count_type;
+  };
+
+  struct Element
+  {
+    std::string name;
+    std::size_t count;
+    std::vector<Property> properties;
+
+    // record size, 0 if the element has list properties
+    std::size_t stride() const
+    {
+      std::size_t size = 0;
+      for(std::size_t i = 0; i < properties.size(); i++)
+      {
+        if(properties[i].count_type != Ply_types::NONE)
+          return 0;
+        size += Ply_types::size(properties[i].type);
+      }
+      return size;
+    }
+  };
+
+  // decodes fixed size binary vertex records [begin,end), pData
+  // is record first
+  struct Vertex_decoder
+  {
+    const char *pData;
+    std::size_t first;
+    std::size_t stride;
+    std::size_t offsets[NB_FIELDS];
+    Ply_types::Type types[NB_FIELDS];
+    bool swap;
+    FT *pPoints;
+    FT *pNormals;
+    unsigned char *pColors;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t v = begin; v < end; v++)
+      {
+        const char *pRecord = pData + (v-first)*stride;
+        for(int k = 0; k < 3; k++)
+          pPoints[3*v+k] = (FT)Ply_types::value(pRecord+offsets[X+k],types[X+k],swap);
+        if(pNormals != NULL)
+          for(int k = 0; k < 3; k++)
+            pNormals[3*v+k] = (FT)Ply_types::value(pRecord+offsets[NX+k],types[NX+k],swap);
+        if(pColors != NULL)
+          for(int k = 0; k < 3; k++)
+            pColors[3*v+k] = Ply_types::to_color(Ply_types::value(pRecord+offsets[RED+k],types[RED+k],swap),types[RED+k]);
+      }
+    }
+  };
+
+  const char *m_p;
+  const char *m_end;
+  InputWindow *m_pWindow;
+  Mesh_preview *m_pPreview;
+  Format m_format;
+  std::vector<Element> m_elements;
+  std::string m_error;
+
+public:
+  Parser_ply() { m_p = m_end = NULL; m_pWindow = NULL; m_pPreview = NULL; m_format = ASCII; }
+  ~Parser_ply() {}
+
+  const std::string& error() const { return m_error; }
+
+  void set_preview(Mesh_preview *pPreview) { m_pPreview = pPreview; }
+
+  bool read(const char *pFilename,
+            Indexed_mesh<FT>& indexed_mesh)
+  {
+    indexed_mesh.clear();
+    InputWindow window;
+    if(!window.open(pFilename))
+    {
+      m_error = "can not open file";
+      return false;
+    }
+    m_pWindow = &window;
+    m_p = window.begin();
+    m_end = window.end();
+    bool ok = parse_elements(indexed_mesh);
+    m_pWindow = NULL;
+    if(window.eof() && window.error())
+      return fail("decompression failed");
+    return ok;
+  }
+
+  bool parse(const char *begin,
+             const char *end,
+             Indexed_mesh<FT>& indexed_mesh)
+  {
+    m_pWindow = NULL;
+    m_p = begin;
+    m_end = end;
+    return parse_elements(indexed_mesh);
+  }
+
+private:
+  bool parse_elements(Indexed_mesh<FT>& indexed_mesh)
+  {
+    m_error.clear();
+    m_elements.clear();
+    if(!parse_header())
+      return false;
+
+    // the elements come in any order, the indices are checked
+    // once the vertices are known
+    bool has_vertices = false;
+    bool has_facets = false;
+    for(std::size_t e = 0; e < m_elements.size(); e++)
+    {
+      const Element& element = m_elements[e];
+      bool ok;
+      if(element.name == "vertex" && !has_vertices)
+      {
+        ok = read_vertices(element,indexed_mesh);
+        has_vertices = true;
+      }
+      else if(element.name == "face")
+      {
+        ok = read_facets(element,indexed_mesh);
+        has_facets = true;
+      }
+      else
+        ok = skip_element(element);
+      if(!ok)
+        return false;
+    }
+    return !has_facets || check_indices(indexed_mesh);
+  }
+
+  bool fail(const std::string& message)
+  {
+    m_error = message;
+    return false;
+  }
+
+  // at least n bytes ahead in the window, if the file has them
+  void fill(std::size_t n)
+  {
+    if(m_pWindow != NULL)
+      m_pWindow->fill(m_p,m_end,n);
+  }
+
+  // records of a mapped file at once, those of a stream by batches
+  std::size_t batch(std::size_t count, std::size_t stride) const
+  {
+    if(m_pWindow == NULL)
+      return count;
+    return std::min(count,std::max<std::size_t>(1,BATCH_SIZE/stride));
+  }
+
+  bool binary() const { return m_format != ASCII; }
+  bool swap() const { return (m_format == BINARY_LITTLE_ENDIAN) != Ply_types::host_little_endian(); }
+
+  /************************************************************************/
+  /* header                                                               */
+  /************************************************************************/
+  bool next_header_line(std::vector<std::string>& words)
+  {
+    words.clear();
+    fill(InputWindow::MAX_RECORD);
+    if(m_p >= m_end)
+      return false;
+    const char *line_end = m_p;
+    NumParse::skip_line(line_end,m_end);
+    const char *p = m_p;
+    for(;;)
+    {
+      while(p < line_end && (NumParse::is_space(*p) || NumParse::is_eol(*p)))
+        p++;
+      if(p >= line_end)
+        break;
+      const char *word = p;
+      NumParse::skip_token(p,line_end);
+      words.push_back(std::string(word,p));
+    }
+    m_p = line_end;
+    return true;
+  }
+
+  bool parse_header()
+  {
+    std::vector<std::string> words;
+    if(!next_header_line(words) || words.size() != 1 || words[0] != "ply")
+      return fail("missing ply header");
+
+    bool has_format = false;
+    for(;;)
+    {
+      if(!next_header_line(words))
+        return fail("missing end_header");
+      if(words.empty() || words[0] == "comment" || words[0] == "obj_info")
+        continue;
+      if(words[0] == "end_header")
+        break;
+
+      if(words[0] == "format" && words.size() == 3)
+      {
+        if(words[1] == "ascii")
+          m_format = ASCII;
+        else if(words[1] == "binary_little_endian")
+          m_format = BINARY_LITTLE_ENDIAN;
+        else if(words[1] == "binary_big_endian")
+          m_format = BINARY_BIG_ENDIAN;
+        else
+          return fail("unknown format " + words[1]);
+        has_format = true;
+      }
+      else if(words[0] == "element" && words.size() == 3)
+      {
+        Element element;
+        element.name = words[1];
+        int count;
+        const char *p = words[2].c_str();
+        if(!NumParse::parse_int(p,p+words[2].size(),count) || count < 0)
+          return fail("invalid element count " + words[2]);
+        element.count = (std::size_t)count;
+        m_elements.push_back(element);
+      }
+      else if(words[0] == "property" && !m_elements.empty())
+      {
+        Property property;
+        if(words.size() == 3)
+        {
+          property.count_type = Ply_types::NONE;
+          property.type = Ply_types::from_name(words[1]);
+          property.name = words[2];
+        }
+        else if(words.size() == 5 && words[1] == "list")
+        {
+          property.count_type = Ply_types::from_name(words[2]);
+          property.type = Ply_types::from_name(words[3]);
+          property.name = words[4];
+          if(property.count_type == Ply_types::NONE)
+            return fail("unknown property type " + words[2]);
+        }
+        else
+          return fail("invalid property");
+        if(property.type == Ply_types::NONE)
+          return fail("unknown property type in " + property.name);
+        m_elements.back().properties.push_back(property);
+      }
+      else
+        return fail("invalid header line " + words[0]);
+    }
+    if(!has_format)
+      return fail("missing format");
+    return true;
+  }
+
+  static int find(const Element& element, const char *pName)
+  {
+    for(std::size_t i = 0; i < element.properties.size(); i++)
+      if(element.properties[i].name == pName)
+        return (int)i;
+    return -1;
+  }
+
+  /************************************************************************/
+  /* vertices                                                             */
+  /************************************************************************/
+  bool read_vertices(const Element& element,
+                     Indexed_mesh<FT>& indexed_mesh)
+  {
+    static const char *names[NB_FIELDS] = { "x", "y", "z", "nx", "ny", "nz", "red", "green", "blue" };
+    int fields[NB_FIELDS];
+    for(int k = 0; k < NB_FIELDS; k++)
+    {
+      fields[k] = find(element,names[k]);
+      if(fields[k] >= 0 && element.properties[fields[k]].count_type != Ply_types::NONE)
+        return fail(std::string("list property ") + names[k]);
+    }
+    if(fields[X] < 0 || fields[Y] < 0 || fields[Z] < 0)
+      return fail("vertex without x,y,z");
+    bool has_normals = fields[NX] >= 0 && fields[NY] >= 0 && fields[NZ] >= 0;
+    bool has_colors = fields[RED] >= 0 && fields[GREEN] >= 0 && fields[BLUE] >= 0;
+
+    std::size_t nb = element.count;
+    indexed_mesh.points.resize(3*nb);
+    if(has_normals)
+      indexed_mesh.vertex_normals.resize(3*nb);
+    if(has_colors)
+      indexed_mesh.vertex_colors.resize(3*nb);
+    if(nb == 0)
+      return true;
+    if(m_pPreview != NULL)
+      m_pPreview->set_size(nb);
+    std::size_t reported = 0;
+
+    Vertex_decoder decoder;
+    decoder.pPoints = &indexed_mesh.points[0];
+    decoder.pNormals = has_normals ? &indexed_mesh.vertex_normals[0] : NULL;
+    decoder.pColors = has_colors ? &indexed_mesh.vertex_colors[0] : NULL;
+    for(int k = 0; k < NB_FIELDS; k++)
+      decoder.types[k] = fields[k] >= 0 ? element.properties[fields[k]].type : Ply_types::NONE;
+
+    std::size_t stride = element.stride();
+    if(binary() && stride > 0)
+    {
+      for(int k = 0; k < NB_FIELDS; k++)
+      {
+        decoder.offsets[k] = 0;
+        for(int i = 0; i < fields[k]; i++)
+          decoder.offsets[k] += Ply_types::size(element.properties[i].type);
+      }
+      decoder.stride = stride;
+      decoder.swap = swap();
+      for(std::size_t v = 0; v < nb; )
+      {
+        std::size_t n = batch(nb-v,stride);
+        fill(n*stride);
+        if((std::size_t)(m_end-m_p)/stride < n)
+          return fail("truncated vertex element");
+        decoder.pData = m_p;
+        decoder.first = v;
+        ParallelUtils::parallel_for(v,v+n,decoder,1<<16);
+        m_p += n*stride;
+        v += n;
+        if(m_pPreview != NULL)
+          m_pPreview->report(decoder.pPoints,v,reported,true);
+      }
+      if(m_pPreview != NULL)
+        m_pPreview->flush();
+      return true;
+    }
+
+    // ascii, or binary records with list properties
+    std::vector<double> values(element.properties.size());
+    for(std::size_t v = 0; v < nb; v++)
+    {
+      for(std::size_t i = 0; i < element.properties.size(); i++)
+        if(!read_property(element.properties[i],values[i]))
+          return fail("vertex " + StringUtils::to_string(v) + ": unexpected end of data");
+      for(int k = 0; k < 3; k++)
+        decoder.pPoints[3*v+k] = (FT)values[fields[X+k]];
+      if(has_normals)
+        for(int k = 0; k < 3; k++)
+          decoder.pNormals[3*v+k] = (FT)values[fields[NX+k]];
+      if(has_colors)
+        for(int k = 0; k < 3; k++)
+          decoder.pColors[3*v+k] = Ply_types::to_color(values[fields[RED+k]],decoder.types[RED+k]);
+      if(m_pPreview != NULL)
+        m_pPreview->report(decoder.pPoints,v+1,reported,v+1 == nb);
+    }
+    if(m_pPreview != NULL)
+      m_pPreview->flush();
+    return true;
+  }
+
+  /************************************************************************/
+  /* facets                                                               */
+  /************************************************************************/
+  bool read_facets(const Element& element,
+                   Indexed_mesh<FT>& indexed_mesh)
+  {
+    int field = find(element,"vertex_indices");
+    if(field < 0)
+      field = find(element,"vertex_index");
+    if(field < 0 || element.properties[field].count_type == Ply_types::NONE)
+      return fail("face without vertex_indices list");
+
+    const Property& list = element.properties[field];
+    indexed_mesh.facet_begin.reserve(indexed_mesh.facet_begin.size()+element.count);
+    indexed_mesh.facet_vertices.reserve(indexed_mesh.facet_vertices.size()+3*element.count);
+
+    // the usual binary layout, a single list of 32 bits indices
+    // in host byte order, is copied without conversion
+    bool direct = binary() && !swap() && element.properties.size() == 1 &&
+                  (list.type == Ply_types::INT32 || list.type == Ply_types::UINT32);
+
+    for(std::size_t f = 0; f < element.count; f++)
+    {
+      for(std::size_t i = 0; i < element.properties.size(); i++)
+      {
+        const Property& property = element.properties[i];
+        if((int)i != field)
+        {
+          double dummy;
+          if(!skip_property(property,dummy))
+            return fail("face " + StringUtils::to_string(f) + ": unexpected end of data");
+          continue;
+        }
+
+        double count;
+        if(!read_value(property.count_type,count))
+          return fail("face " + StringUtils::to_string(f) + ": unexpected end of data");
+        if(count < 3)
+          return fail("face " + StringUtils::to_string(f) + ": facet with less than 3 vertices");
+        std::size_t degree = (std::size_t)count;
+        std::size_t first = indexed_mesh.facet_vertices.size();
+
+        if(direct)
+        {
+          fill(4*degree);
+          if((std::size_t)(m_end-m_p)/4 < degree)
+            return fail("face " + StringUtils::to_string(f) + ": unexpected end of data");
+          indexed_mesh.facet_vertices.resize(first+degree);
+          memcpy(&indexed_mesh.facet_vertices[first],m_p,4*degree);
+          m_p += 4*degree;
+        }
+        else
+        {
+          for(std::size_t k = 0; k < degree; k++)
+          {
+            double index;
+            if(!read_value(property.type,index))
+              return fail("face " + StringUtils::to_string(f) + ": unexpected end of data");
+            indexed_mesh.facet_vertices.push_back((int)index);
+          }
+        }
+
+        indexed_mesh.facet_begin.push_back((unsigned int)indexed_mesh.facet_vertices.size());
+      }
+    }
+    return true;
+  }
+
+  bool check_indices(const Indexed_mesh<FT>& indexed_mesh)
+  {
+    int nb_vertices = (int)indexed_mesh.size_of_vertices();
+    for(std::size_t f = 0; f < indexed_mesh.size_of_facets(); f++)
+      for(unsigned int k = indexed_mesh.facet_begin[f]; k < indexed_mesh.facet_begin[f+1]; k++)
+      {
+        int index = indexed_mesh.facet_vertices[k];
+        if(index < 0 || index >= nb_vertices)
+          return fail("face " + StringUtils::to_string(f) + ": vertex index out of range");
+      }
+    return true;
+  }
+
+  /************************************************************************/
+  /* values                                                               */
+  /************************************************************************/
+  bool skip_element(const Element& element)
+  {
+    std::size_t stride = element.stride();
+    if(binary() && stride > 0)
+    {
+      for(std::size_t r = 0; r < element.count; )
+      {
+        std::size_t n = batch(element.count-r,stride);
+        fill(n*stride);
+        if((std::size_t)(m_end-m_p)/stride < n)
+          return fail("truncated " + element.name + " element");
+        m_p += n*stride;
+        r += n;
+      }
+      return true;
+    }
+    for(std::size_t r = 0; r < element.count; r++)
+      for(std::size_t i = 0; i < element.properties.size(); i++)
+      {
+        double dummy;
+        if(!skip_property(element.properties[i],dummy))
+          return fail("truncated " + element.name + " element");
+      }
+    return true;
+  }
+
+  // reads a scalar property, or skips a list one
+  bool read_property(const Property& property, double& value)
+  {
+    if(property.count_type != Ply_types::NONE)
+      return skip_property(property,value);
+    return read_value(property.type,value);
+  }
+
+  bool skip_property(const Property& property, double& value)
+  {
+    if(property.count_type == Ply_types::NONE)
+      return read_value(property.type,value);
+    double count;
+    if(!read_value(property.count_type,count) || count < 0)
+      return false;
+    for(std::size_t k = 0; k < (std::size_t)count; k++)
+      if(!read_value(property.type,value))
+        return false;
+    return true;
+  }
+
+  // a value or a text record of a stream is always whole in the window
+  bool read_value(Ply_types::Type type, double& value)
+  {
+    if(m_end - m_p < 256)
+      fill(InputWindow::MAX_RECORD);
+    if(binary())
+    {
+      std::size_t size = Ply_types::size(type);
+      if((std::size_t)(m_end-m_p) < size)
+        return false;
+      value = Ply_types::value(m_p,type,swap());
+      m_p += size;
+      return true;
+    }
+    NumParse::skip_blanks(m_p,m_end);
+    return NumParse::parse_double(m_p,m_end,value);
+  }
+};
+
+// write a polyhedron with Enriched_items as PLY, positions as double,
+// normals as float and colors as uchar when they come from the file
+template <class Polyhedron>
+class Ply_mesh_writer
+{
+private:
+  typedef typename Polyhedron::Vertex_iterator                    Vertex_iterator;
+  typedef typename Polyhedron::Facet_iterator                     Facet_iterator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator   HF_circulator;
+
+  OutputFile m_file;
+  std::vector<char> m_buffer;
+  bool m_binary;
+  bool m_ok;
+
+public:
+  Ply_mesh_writer() { m_binary = true; m_ok = true; }
+  ~Ply_mesh_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             Polyhedron& mesh,
+             bool binary = true)
+  {
+    m_binary = binary;
+    bool normals = mesh.has_vertex_normals();
+    bool colors = mesh.has_vertex_colors();
+
+    // vertex indices are stored in vertex tags
+    mesh.set_index_vertices();
+    unsigned int max_degree = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+      max_degree = std::max(max_degree,Polyhedron::degree(pFacet));
+
+    if(!m_file.open(pFilename))
+      return false;
+    m_buffer.clear();
+    m_buffer.reserve(1<<20);
+    m_ok = true;
+
+    std::string header = "ply\nformat ";
+    if(!binary)
+      header += "ascii";
+    else if(Ply_types::host_little_endian())
+      header += "binary_little_endian";
+    else
+      header += "binary_big_endian";
+    header += " 1.0\ncomment CGALQT\n";
+    header += "element vertex " + StringUtils::to_string(mesh.size_of_vertices()) + "\n";
+    header += "property double x\nproperty double y\nproperty double z\n";
+    if(normals)
+      header += "property float nx\nproperty float ny\nproperty float nz\n";
+    if(colors)
+      header += "property uchar red\nproperty uchar green\nproperty uchar blue\n";
+    header += "element face " + StringUtils::to_string(mesh.size_of_facets()) + "\n";
+    header += max_degree <= 255 ? "property list uchar int vertex_indices\n" :
+                                  "property list int int vertex_indices\n";
+    header += "end_header\n";
+    put(header.c_str(),header.size());
+
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++)
+    {
+      const typename Polyhedron::Point& point = pVertex->point();
+      put_double(point.x(),' ');
+      put_double(point.y(),' ');
+      put_double(point.z(),normals || colors ? ' ' : '\n');
+      if(normals)
+      {
+        const typename Polyhedron::Vertex::Normal_3& normal = pVertex->normal();
+        put_float(normal.x(),' ');
+        put_float(normal.y(),' ');
+        put_float(normal.z(),colors ? ' ' : '\n');
+      }
+      if(colors)
+      {
+        CColor color = mesh.vertex_color(pVertex);
+        put_uchar(color.r(),' ');
+        put_uchar(color.g(),' ');
+        put_uchar(color.b(),'\n');
+      }
+    }
+
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      unsigned int degree = Polyhedron::degree(pFacet);
+      if(max_degree <= 255)
+        put_uchar((unsigned char)degree,' ');
+      else
+        put_int((int)degree,' ');
+      HF_circulator pHalfedge = pFacet->facet_begin();
+      for(unsigned int k = 0; k < degree; k++, pHalfedge++)
+        put_int(pHalfedge->vertex()->tag(),k+1 < degree ? ' ' : '\n');
+    }
+
+    flush();
+    bool ok = m_file.close() && m_ok;
+    if(!ok)
+      remove(pFilename);
+    return ok;
+  }
+
+private:
+  // binary: the raw value, ascii: the value followed by separator
+  void put_double(double value, char separator)
+  {
+    if(m_binary)
+      return put(&value,sizeof(value));
+    char text[NumFormat::MAX_CHARS+1];
+    char *p = NumFormat::format_double(value,text);
+    *p++ = separator;
+    put(text,p-text);
+  }
+
+  // ascii keeps the double digits, readers narrow them
+  void put_float(double value, char separator)
+  {
+    if(m_binary)
+    {
+      float f = (float)value;
+      return put(&f,sizeof(f));
+    }
+    put_double(value,separator);
+  }
+
+  void put_int(int value, char separator)
+  {
+    if(m_binary)
+      return put(&value,sizeof(value));
+    char text[NumFormat::MAX_CHARS+1];
+    char *p = NumFormat::format_int(value,text);
+    *p++ = separator;
+    put(text,p-text);
+  }
+
+  void put_uchar(unsigned char value, char separator)
+  {
+    if(m_binary)
+      return put(&value,1);
+    put_int(value,separator);
+  }
+
+  void put(const void *pData, std::size_t size)
+  {
+    const char *p = (const char*)pData;
+    m_buffer.insert(m_buffer.end(),p,p+size);
+    if(m_buffer.size() >= (1<<20))
+      flush();
+  }
+
+  void flush()
+  {
+    if(!m_buffer.empty() &&
+       !m_file.write(&m_buffer[0],m_buffer.size()))
+      m_ok = false;
+    m_buffer.clear();
+  }
+};
+
+#endif
@@ -0,0 +1,108 @@
+/***************************************************************************
+mesh_preview.h  -  subsampled vertex positions for a quick first display
+----------------------------------------------------------------------------
+The parsers pass the vertices they decode to a Mesh_preview as they go,
+plain or compressed, so the points can be shown while the rest of the
+file is parsed and the mesh prepared; nothing is read twice. One vertex
+out of k is kept: k follows from the vertex count when the header gives
+it (OFF, PLY, binary STL, .cqm), otherwise it doubles every time half
+of the points left are taken (OBJ, ascii STL). The points are passed by
+batches of BATCH, the OBJ chunks add theirs from their own threads.
+***************************************************************************/
+
+#ifndef MESH_PREVIEW_H
+#define MESH_PREVIEW_H
+
+#include "config.h"
+#include <vector>
+#include <algorithm>
+#include <boost/thread/mutex.hpp>
+
+class Mesh_preview
+{
+public:
+  // points per call of points(), at most in total, and vertices a
+  // parser decodes between two calls of add()
+  enum { BATCH = 1<<12, MAX_POINTS = 1<<20, REPORT = 1<<14 };
+
+  Mesh_preview() : m_step(1), m_total(0), m_threshold(MAX_POINTS/2), m_known(false), m_stopped(false) {}
+  virtual ~Mesh_preview() {}
+
+public:
+  // the vertex count of the header
+  void set_size(std::size_t nb_vertices)
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    m_step = std::max<std::size_t>(1,(nb_vertices+MAX_POINTS-1)/MAX_POINTS);
+    m_known = true;
+  }
+
+  // x,y,z of the vertices [first,end) just decoded, the indices
+  // count from the start of the file or of a chunk
+  template <class FT>
+  void add(const FT *points, std::size_t first, std::size_t end)
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if(m_stopped)
+      return;
+    std::size_t v = (first+m_step-1)/m_step*m_step;
+    for(; v < end; v += m_step)
+    {
+      for(int k = 0; k < 3; k++)
+        m_points.push_back((float)points[3*(v-first)+k]);
+      if(m_points.size() >= 3*BATCH && !pass())
+        return;
+    }
+  }
+
+  // the vertices [reported,nb) of points once there are REPORT of
+  // them, or all of them
+  template <class FT>
+  void report(const FT *points, std::size_t nb, std::size_t& reported, bool all = false)
+  {
+    if(nb - reported >= REPORT || (all && nb > reported))
+    {
+      add(points+3*reported,reported,nb);
+      reported = nb;
+    }
+  }
+
+  // the points not passed yet, at the end of the parse
+  void flush()
+  {
+    boost::mutex::scoped_lock lock(m_mutex);
+    if(!m_stopped && !m_points.empty())
+      pass();
+  }
+
+  bool stopped() const { return m_stopped; }
+
+protected:
+  // gets the points of a batch, false stops the preview
+  virtual bool points(std::vector<float>& points) = 0;
+
+private:
+  bool pass()
+  {
+    m_total += m_points.size()/3;
+    m_stopped = !points(m_points) || m_total >= MAX_POINTS;
+    m_points.clear();
+    if(!m_known && m_total >= m_threshold)
+    {
+      m_step *= 2;
+      m_threshold += (MAX_POINTS-m_threshold)/2;
+    }
+    return !m_stopped;
+  }
+
+private:
+  boost::mutex m_mutex;
+  std::vector<float> m_points;
+  std::size_t m_step;
+  std::size_t m_total;
+  std::size_t m_threshold;
+  bool m_known;
+  volatile bool m_stopped;
+};
+
+#endif
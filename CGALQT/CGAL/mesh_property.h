@@ -0,0 +1,282 @@
+/***************************************************************************
+mesh_property.h  -  attributes attached to the elements of a mesh on demand
+----------------------------------------------------------------------------
+A Property_container holds one dense array per attribute for one kind of
+element (vertices, halfedges or facets), all of the container size and
+addressed by the element index. An algorithm adds the attributes it needs
+by name and removes them when done, so a mesh only pays for what is in use.
+Property_map<T> is the typed handle on one array, T picks the precision:
+Packed_vector_3<float> for display normals, the kernel Vector_3 where the
+computation needs doubles.
+Only Enriched_surface_mesh keeps its attributes here. The Polyhedron_3
+nodes of Enriched_items still carry their tag, dirty flag, normal, degree
+and valence in every item, since Polyhedron_3 creates items in
+split_facet() and create_center_vertex() without a stable index to key
+an array with.
+***************************************************************************/
+
+#ifndef MESH_PROPERTY_H
+#define MESH_PROPERTY_H
+
+#include "config.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// x,y,z without the reference counting of the kernel vectors, converts
+// from and to any type with operator[] and a 3 coordinates constructor
+template <class F>
+struct Packed_vector_3
+{
+  F v[3];
+
+  Packed_vector_3() { v[0] = v[1] = v[2] = (F)0; }
+  template <class Vector>
+  Packed_vector_3(const Vector& vec)
+  {
+    for(int k = 0; k < 3; k++)
+      v[k] = (F)vec[k];
+  }
+
+  F operator[](int k) const { return v[k]; }
+
+  template <class Vector>
+  Vector to() const { return Vector(v[0],v[1],v[2]); }
+};
+
+class Property_array_base
+{
+public:
+  Property_array_base(const std::string& name) : m_name(name) {}
+  virtual ~Property_array_base() {}
+
+  const std::string& name() const { return m_name; }
+
+  virtual Property_array_base *clone() const = 0;
+  virtual void reserve(std::size_t n) = 0;
+  virtual void resize(std::size_t n) = 0;
+  virtual void push_back() = 0;
+  // item 'to' gets the value of item 'from'
+  virtual void copy(std::size_t from, std::size_t to) = 0;
+  // item i gets the default value again
+  virtual void reset(std::size_t i) = 0;
+  virtual void shrink() = 0;
+  virtual std::size_t bytes() const = 0;
+
+private:
+  std::string m_name;
+};
+
+template <class T>
+class Property_array : public Property_array_base
+{
+public:
+  typedef T& reference;
+  typedef T *pointer;
+
+  Property_array(const std::string& name, const T& value)
+    : Property_array_base(name), m_default(value) {}
+
+  Property_array_base *clone() const { return new Property_array<T>(*this); }
+  void reserve(std::size_t n) { m_data.reserve(n); }
+  void resize(std::size_t n) { m_data.resize(n,m_default); }
+  void push_back() { m_data.push_back(m_default); }
+  void copy(std::size_t from, std::size_t to) { m_data[to] = m_data[from]; }
+  void reset(std::size_t i) { m_data[i] = m_default; }
+  void shrink() { std::vector<T>(m_data).swap(m_data); }
+  std::size_t bytes() const { return m_data.capacity()*sizeof(T); }
+
+  reference operator[](std::size_t i) { return m_data[i]; }
+  const T& default_value() const { return m_default; }
+  pointer data() { return m_data.empty() ? NULL : &m_data[0]; }
+
+private:
+  std::vector<T> m_data;
+  T m_default;
+};
+
+// bool is stored as unsigned char, std::vector<bool> has no references
+// and no data()
+template <>
+class Property_array<bool> : public Property_array_base
+{
+public:
+  typedef unsigned char& reference;
+  typedef unsigned char *pointer;
+
+  Property_array(const std::string& name, const bool& value)
+    : Property_array_base(name), m_default(value) {}
+
+  Property_array_base *clone() const { return new Property_array<bool>(*this); }
+  void reserve(std::size_t n) { m_data.reserve(n); }
+  void resize(std::size_t n) { m_data.resize(n,(unsigned char)m_default); }
+  void push_back() { m_data.push_back((unsigned char)m_default); }
+  void copy(std::size_t from, std::size_t to) { m_data[to] = m_data[from]; }
+  void reset(std::size_t i) { m_data[i] = (unsigned char)m_default; }
+  void shrink() { std::vector<unsigned char>(m_data).swap(m_data); }
+  std::size_t bytes() const { return m_data.capacity(); }
+
+  reference operator[](std::size_t i) { return m_data[i]; }
+  const bool& default_value() const { return m_default; }
+  pointer data() { return m_data.empty() ? NULL : &m_data[0]; }
+
+private:
+  std::vector<unsigned char> m_data;
+  bool m_default;
+};
+
+// a handle on one array of a container, null if the property is not there
+template <class T>
+class Property_map
+{
+public:
+  typedef typename Property_array<T>::reference reference;
+  typedef typename Property_array<T>::pointer pointer;
+
+  Property_map() : m_pArray(NULL) {}
+  explicit Property_map(Property_array<T> *pArray) : m_pArray(pArray) {}
+
+  bool is_valid() const { return m_pArray != NULL; }
+  reference operator[](std::size_t i) const { return (*m_pArray)[i]; }
+  const T& default_value() const { return m_pArray->default_value(); }
+  pointer data() const { return m_pArray->data(); }
+
+  Property_array<T> *array() const { return m_pArray; }
+
+private:
+  Property_array<T> *m_pArray;
+};
+
+class Property_container
+{
+public:
+  Property_container() : m_size(0), m_capacity_hint(0) {}
+  Property_container(const Property_container& c) : m_size(0), m_capacity_hint(0) { *this = c; }
+  ~Property_container() { remove_all(); }
+
+  Property_container& operator=(const Property_container& c)
+  {
+    if(this == &c)
+      return *this;
+    remove_all();
+    for(std::size_t i = 0; i < c.m_arrays.size(); i++)
+      m_arrays.push_back(c.m_arrays[i]->clone());
+    m_size = c.m_size;
+    m_capacity_hint = c.m_capacity_hint;
+    return *this;
+  }
+
+  std::size_t size() const { return m_size; }
+  std::size_t size_of_properties() const { return m_arrays.size(); }
+
+  // the property 'name', added with 'value' for every item if it is
+  // not there yet. A null map if 'name' is taken by another type.
+  template <class T>
+  Property_map<T> add(const std::string& name, const T& value = T())
+  {
+    Property_map<T> map = get<T>(name);
+    if(map.is_valid() || exists(name))
+      return map;
+    Property_array<T> *pArray = new Property_array<T>(name,value);
+    pArray->reserve(m_capacity_hint);
+    pArray->resize(m_size);
+    m_arrays.push_back(pArray);
+    return Property_map<T>(pArray);
+  }
+
+  // a null map if there is no property 'name' of type T
+  template <class T>
+  Property_map<T> get(const std::string& name) const
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      if(m_arrays[i]->name() == name)
+        return Property_map<T>(dynamic_cast<Property_array<T>*>(m_arrays[i]));
+    return Property_map<T>();
+  }
+
+  bool exists(const std::string& name) const
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      if(m_arrays[i]->name() == name)
+        return true;
+    return false;
+  }
+
+  // frees the array, 'map' becomes null
+  template <class T>
+  void remove(Property_map<T>& map)
+  {
+    std::vector<Property_array_base*>::iterator it =
+      std::find(m_arrays.begin(),m_arrays.end(),(Property_array_base*)map.array());
+    if(it != m_arrays.end())
+    {
+      delete *it;
+      m_arrays.erase(it);
+    }
+    map = Property_map<T>();
+  }
+
+  void remove_all()
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      delete m_arrays[i];
+    m_arrays.clear();
+    m_size = 0;
+  }
+
+  // the arrays added later reserve as much
+  void reserve(std::size_t n)
+  {
+    m_capacity_hint = n;
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      m_arrays[i]->reserve(n);
+  }
+
+  void resize(std::size_t n)
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      m_arrays[i]->resize(n);
+    m_size = n;
+  }
+
+  // a new item with the default values, returns its index
+  std::size_t push_back()
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      m_arrays[i]->push_back();
+    return m_size++;
+  }
+
+  void copy(std::size_t from, std::size_t to)
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      m_arrays[i]->copy(from,to);
+  }
+
+  void reset(std::size_t i)
+  {
+    for(std::size_t a = 0; a < m_arrays.size(); a++)
+      m_arrays[a]->reset(i);
+  }
+
+  void shrink()
+  {
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      m_arrays[i]->shrink();
+  }
+
+  std::size_t bytes() const
+  {
+    std::size_t n = 0;
+    for(std::size_t i = 0; i < m_arrays.size(); i++)
+      n += m_arrays[i]->bytes();
+    return n;
+  }
+
+private:
+  std::vector<Property_array_base*> m_arrays;
+  std::size_t m_size;
+  std::size_t m_capacity_hint;
+};
+
+#endif
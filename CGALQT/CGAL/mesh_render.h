@@ -0,0 +1,288 @@
+/***************************************************************************
+mesh_render.h  -  OpenGL drawing and picking of a half-edge mesh
+----------------------------------------------------------------------------
+Mesh_renderer draws any mesh with the Enriched_polyhedron interface:
+facet iterators and circulators, point(), normal(), vertex_color(),
+tag(), dirty() and selected(). Enriched_polyhedron and Enriched_surface_mesh
+both forward their gl_* calls to it. The facets are named by their rank
+in facet iteration order, gl_processhits maps the names back the same way.
+***************************************************************************/
+
+#ifndef MESH_RENDER_H
+#define MESH_RENDER_H
+
+#include "config.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "stringutils.h"
+#include "uglyfont.h"
+
+// tag for processhits
+struct processhits_normal{};
+struct processhits_plus{};
+struct processhits_minus{};
+
+template <class Mesh>
+class Mesh_renderer
+{
+public:
+  typedef typename Mesh::FT FT;
+  typedef typename Mesh::Point Point;
+  typedef typename Mesh::Vector Vector;
+  typedef typename Mesh::Vertex_handle Vertex_handle;
+  typedef typename Mesh::Facet_handle Facet_handle;
+  typedef typename Mesh::Facet_iterator Facet_iterator;
+  typedef typename Mesh::Edge_iterator Edge_iterator;
+  typedef typename Mesh::Point_iterator Point_iterator;
+  typedef typename Mesh::Halfedge_around_facet_circulator Halfedge_around_facet_circulator;
+  typedef typename Mesh::Halfedge_around_vertex_circulator Halfedge_around_vertex_circulator;
+
+public:
+  static void gl_draw(Mesh& mesh, bool smooth_shading, bool use_normals, bool use_colors = false)
+  {
+    // vertex colors replace the material of the lit surface
+    use_colors = use_colors && mesh.has_vertex_colors();
+    if(use_colors)
+    {
+      glColorMaterial(GL_FRONT,GL_AMBIENT_AND_DIFFUSE);
+      glEnable(GL_COLOR_MATERIAL);
+    }
+
+    GLuint name = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++, name++)
+    {
+      glLoadName(name);
+      glBegin(GL_POLYGON);
+      gl_draw_facet(mesh,pFacet,smooth_shading,use_normals,use_colors);
+      glEnd();
+    }
+    glFlush();
+
+    if(use_colors)
+      glDisable(GL_COLOR_MATERIAL);
+  }
+
+  // the vertex tags of the selected facets
+  static void gl_draw_number(Mesh& mesh)
+  {
+    std::vector<Facet_handle> facets;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      if(pFacet->selected())
+      {
+        gl_draw_facet_tag(pFacet);
+        facets.push_back(pFacet);
+      }
+    }
+    glFlush();
+
+    // clear the dirty flags for the next frame
+    for(std::size_t i = 0; i < facets.size(); i++)
+    {
+      Halfedge_around_facet_circulator pHalfedge = facets[i]->facet_begin();
+      do
+        pHalfedge->vertex()->dirty(false);
+      while(++pHalfedge != facets[i]->facet_begin());
+    }
+  }
+
+  static void gl_draw_selectedfaces(Mesh& mesh)
+  {
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      if(pFacet->selected())
+      {
+        glBegin(GL_POLYGON);
+        gl_draw_facet(mesh,pFacet,false,false);
+        glEnd();
+      }
+    }
+    glFlush();
+  }
+
+  static void gl_draw_lines(Mesh& mesh)
+  {
+    glBegin(GL_LINES);
+    for(Edge_iterator h = mesh.edges_begin();
+        h != mesh.edges_end();
+        h++)
+    {
+      const Point& p1 = h->prev()->vertex()->point();
+      const Point& p2 = h->vertex()->point();
+      glVertex3f(p1[0],p1[1],p1[2]);
+      glVertex3f(p2[0],p2[1],p2[2]);
+    }
+    glEnd();
+  }
+
+  static void gl_draw_points(Mesh& mesh)
+  {
+    glBegin(GL_POINTS);
+    for(Point_iterator pPoint = mesh.points_begin();
+        pPoint != mesh.points_end();
+        pPoint++)
+      glVertex3f(pPoint->x(),pPoint->y(),pPoint->z());
+    glEnd();
+  }
+
+  static void gl_draw_bounding_box(Mesh& mesh)
+  {
+    FT lo[3] = { mesh.xmin(), mesh.ymin(), mesh.zmin() };
+    FT hi[3] = { mesh.xmax(), mesh.ymax(), mesh.zmax() };
+    glBegin(GL_LINES);
+    for(int k = 0; k < 3; k++)
+    {
+      // the 4 edges along axis k
+      int a = (k+1)%3, b = (k+2)%3;
+      for(int corner = 0; corner < 4; corner++)
+      {
+        FT p[3];
+        p[a] = (corner & 1) ? hi[a] : lo[a];
+        p[b] = (corner & 2) ? hi[b] : lo[b];
+        p[k] = lo[k];
+        glVertex3f(p[0],p[1],p[2]);
+        p[k] = hi[k];
+        glVertex3f(p[0],p[1],p[2]);
+      }
+    }
+    glEnd();
+  }
+
+  //process hits, the names are the ranks of the facets
+  static void gl_processhits(Mesh& mesh, GLint hits, GLuint buffer[], processhits_normal)
+  {
+    if(hits == 0)
+      return;
+    std::vector<bool> hit;
+    mark_hits(mesh,hits,buffer,hit);
+    std::size_t i = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++, i++)
+      pFacet->selected(hit[i]);
+  }
+
+  static void gl_processhits(Mesh& mesh, GLint hits, GLuint buffer[], processhits_plus)
+  {
+    if(hits == 0)
+      return;
+    std::vector<bool> hit;
+    mark_hits(mesh,hits,buffer,hit);
+    std::size_t i = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++, i++)
+      if(hit[i])
+        pFacet->selected(true);
+  }
+
+  static void gl_processhits(Mesh& mesh, GLint hits, GLuint buffer[], processhits_minus)
+  {
+    if(hits == 0)
+      return;
+    std::vector<bool> hit;
+    mark_hits(mesh,hits,buffer,hit);
+    std::size_t i = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++, i++)
+      if(hit[i])
+        pFacet->selected(!pFacet->selected());
+  }
+
+  static void gl_draw_facet(const Mesh& mesh, Facet_handle pFacet, bool smooth_shading, bool use_normals, bool use_colors = false)
+  {
+    // one normal per face
+    if(use_normals && !smooth_shading)
+    {
+      const Vector& normal = pFacet->normal();
+      glNormal3f(normal[0],normal[1],normal[2]);
+    }
+
+    // revolve around current face to get vertices
+    Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
+    do
+    {
+      // one normal per vertex
+      if(use_normals && smooth_shading)
+      {
+        const Vector& normal = pHalfedge->vertex()->normal();
+        glNormal3f(normal[0],normal[1],normal[2]);
+      }
+
+      if(use_colors)
+      {
+        CColor color = mesh.vertex_color(pHalfedge->vertex());
+        glColor3ub(color.r(),color.g(),color.b());
+      }
+
+      // polygon assembly is performed per vertex
+      const Point& point = pHalfedge->vertex()->point();
+      glVertex3d(point[0],point[1],point[2]);
+    }
+    while(++pHalfedge != pFacet->facet_begin());
+  }
+
+private:
+  // hit[i] is true if the facet of rank i was picked
+  static void mark_hits(Mesh& mesh, GLint hits, GLuint buffer[], std::vector<bool>& hit)
+  {
+    hit.assign(mesh.size_of_facets(),false);
+    for(int i = 0; i < hits; i++)
+    {
+      CGAL_assertion(buffer[i*4] == 1);
+      hit[buffer[i*4 + 3]] = true;
+    }
+  }
+
+  // compute average edge length around a vertex
+  static FT average_edge_length_around(Vertex_handle pVertex)
+  {
+    FT sum = 0.0;
+    Halfedge_around_vertex_circulator pHalfEdge = pVertex->vertex_begin();
+    Halfedge_around_vertex_circulator end = pHalfEdge;
+    int degree = 0;
+    CGAL_For_all(pHalfEdge,end)
+    {
+      Vector vec = pHalfEdge->vertex()->point()-
+        pHalfEdge->opposite()->vertex()->point();
+      sum += std::sqrt(vec*vec);
+      degree++;
+    }
+    return sum / (FT) degree;
+  }
+
+  static void gl_draw_facet_tag(Facet_handle pFacet)
+  {
+    Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
+    static float scale_ratio = -1.0;
+    if(scale_ratio < 0.0)
+      scale_ratio = average_edge_length_around(pHalfedge->vertex())/3.0;
+    do
+    {
+      Vertex_handle v = pHalfedge->vertex();
+      if(v->dirty())
+        continue;
+      v->dirty(true);
+      std::string tagstr = StringUtils::to_string(v->tag());
+      const Point& point = v->point();
+
+      glPushMatrix();
+      glTranslatef(point[0],point[1],point[2]);
+      glScalef(scale_ratio,scale_ratio,scale_ratio);
+      YsDrawUglyFont(tagstr.c_str(),0);
+      glPopMatrix();
+    }
+    while(++pHalfedge != pFacet->facet_begin());
+  }
+};
+
+#endif
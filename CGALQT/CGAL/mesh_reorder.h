@@ -0,0 +1,365 @@
+/***************************************************************************
+mesh_reorder.h  -  vertices and facets in the order of a Hilbert curve
+----------------------------------------------------------------------------
+The vertices keep the order they were created in, so after a subdivision
+the new ones sit far from their neighbours and every circulator walk
+misses the cache. Indexed_reorder sorts the vertices of an indexed face set
+along a 3D Hilbert curve through the bounding box, then the facets by
+the lowest new index among their vertices; the corners of a facet keep
+their order so the control edges stay with their halfedges.
+scattering() is the fraction of the edges whose two vertices are more
+than WINDOW apart in vertex order, the reordering pays off once it is
+above THRESHOLD.
+Mesh_reorder does the same on a half-edge mesh (Enriched_polyhedron,
+Enriched_surface_mesh) by rebuilding it from sorted arrays.
+A model reordered on load or after a subdivision is saved back out in
+the new order, its vertex and facet indices differ from the file read.
+***************************************************************************/
+
+#ifndef MESH_REORDER_H
+#define MESH_REORDER_H
+
+#include "config.h"
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include "indexed_mesh.h"
+#include "mesh_halfedges.h"
+#include "parallelutils.h"
+
+template <class FT>
+class Indexed_reorder
+{
+public:
+  typedef Indexed_mesh<FT> Mesh;
+
+  // about the vertices of a few cache pages, and the fraction of far
+  // edges right after a sqrt3 step is above 0.5
+  enum { WINDOW = 512 };
+  static double threshold() { return 0.25; }
+
+private:
+  enum { BITS = 16 };
+  typedef std::pair<boost::uint64_t,unsigned int> Key;
+
+  // Hilbert keys of the points of [begin,end)
+  struct Hilbert_keys
+  {
+    const FT *pPoints;
+    double lo[3];
+    double scale[3];
+    Key *pKeys;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t v = begin; v < end; v++)
+      {
+        unsigned int x[3];
+        for(int k = 0; k < 3; k++)
+        {
+          double q = (pPoints[3*v+k] - lo[k])*scale[k];
+          x[k] = q <= 0.0 ? 0u : (unsigned int)std::min(q,(double)((1 << BITS)-1));
+        }
+        pKeys[v] = Key(hilbert_key(x),(unsigned int)v);
+      }
+    }
+  };
+
+public:
+  // fraction of the edges joining vertices more than WINDOW apart,
+  // the interior edges are counted once per facet; M is an Indexed_mesh
+  // or a Binary_mesh_view
+  template <class M>
+  static double scattering(const M& mesh)
+  {
+    std::size_t nb_indices = mesh.size_of_indices();
+    if(nb_indices == 0)
+      return 0.0;
+    std::size_t far = 0;
+    for(std::size_t f = 0; f < mesh.size_of_facets(); f++)
+    {
+      unsigned int first = mesh.facet_begin[f];
+      unsigned int last = mesh.facet_begin[f+1];
+      for(unsigned int i = first; i < last; i++)
+        if(is_far(mesh.facet_vertices[i],mesh.facet_vertices[i+1 < last ? i+1 : first]))
+          far++;
+    }
+    return (double)far/(double)nb_indices;
+  }
+
+  static bool is_far(int a, int b)
+  {
+    return a > b ? a - b > WINDOW : b - a > WINDOW;
+  }
+
+  // sort the vertices along the curve and the facets after them, the
+  // optional pFacetOrder gets the old index of every new facet
+  static void reorder(Mesh& mesh, std::vector<unsigned int> *pFacetOrder = NULL)
+  {
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_facets = mesh.size_of_facets();
+    std::vector<unsigned int> vertex_order;
+    vertex_order_of(mesh,vertex_order);
+    std::vector<unsigned int> new_vertex(nb_vertices);
+    for(std::size_t v = 0; v < nb_vertices; v++)
+      new_vertex[vertex_order[v]] = (unsigned int)v;
+
+    // counting sort of the facets by their lowest new vertex,
+    // stable so that the facets of a vertex keep their order
+    std::vector<unsigned int> counts(nb_vertices+1,0);
+    std::vector<unsigned int> first_vertex(nb_facets);
+    for(std::size_t f = 0; f < nb_facets; f++)
+    {
+      unsigned int lowest = (unsigned int)nb_vertices;
+      for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++)
+        lowest = std::min(lowest,new_vertex[mesh.facet_vertices[i]]);
+      first_vertex[f] = lowest;
+      counts[lowest]++;
+    }
+    ParallelUtils::prefix_sum(counts);
+    std::vector<unsigned int> facet_order(nb_facets);
+    for(std::size_t f = 0; f < nb_facets; f++)
+      facet_order[counts[first_vertex[f]]++] = (unsigned int)f;
+
+    Mesh sorted;
+    sorted.reserve(nb_vertices,nb_facets,mesh.size_of_indices());
+    permute(mesh.points,vertex_order,3,sorted.points);
+    permute(mesh.vertex_normals,vertex_order,3,sorted.vertex_normals);
+    permute(mesh.vertex_colors,vertex_order,3,sorted.vertex_colors);
+    permute(mesh.facet_normals,facet_order,3,sorted.facet_normals);
+    for(std::size_t f = 0; f < nb_facets; f++)
+    {
+      unsigned int first = mesh.facet_begin[facet_order[f]];
+      unsigned int last = mesh.facet_begin[facet_order[f]+1];
+      for(unsigned int i = first; i < last; i++)
+      {
+        sorted.facet_vertices.push_back((int)new_vertex[mesh.facet_vertices[i]]);
+        if(mesh.has_control_edges())
+          sorted.control_edges.push_back(mesh.control_edges[i]);
+      }
+      sorted.facet_begin.push_back((unsigned int)sorted.facet_vertices.size());
+    }
+
+    swap(mesh,sorted);
+    if(pFacetOrder)
+      pFacetOrder->swap(facet_order);
+  }
+
+  // Skilling, "Programming the Hilbert curve" (2004): the transposed
+  // key of x, then its bits interleaved from the highest one
+  static boost::uint64_t hilbert_key(unsigned int x[3])
+  {
+    const unsigned int M = 1u << (BITS-1);
+    for(unsigned int Q = M; Q > 1; Q >>= 1)
+    {
+      unsigned int P = Q - 1;
+      for(int i = 0; i < 3; i++)
+      {
+        if(x[i] & Q)
+          x[0] ^= P;
+        else
+        {
+          unsigned int t = (x[0] ^ x[i]) & P;
+          x[0] ^= t;
+          x[i] ^= t;
+        }
+      }
+    }
+    x[1] ^= x[0];
+    x[2] ^= x[1];
+    unsigned int t = 0;
+    for(unsigned int Q = M; Q > 1; Q >>= 1)
+      if(x[2] & Q)
+        t ^= Q - 1;
+    for(int i = 0; i < 3; i++)
+      x[i] ^= t;
+
+    boost::uint64_t key = 0;
+    for(int b = BITS-1; b >= 0; b--)
+      for(int i = 0; i < 3; i++)
+        key = (key << 1) | ((x[i] >> b) & 1);
+    return key;
+  }
+
+private:
+  // old index of every new vertex
+  static void vertex_order_of(const Mesh& mesh, std::vector<unsigned int>& order)
+  {
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    order.resize(nb_vertices);
+    if(nb_vertices == 0)
+      return;
+    Hilbert_keys keys;
+    keys.pPoints = &mesh.points[0];
+    for(int k = 0; k < 3; k++)
+    {
+      double lo = mesh.points[k], hi = mesh.points[k];
+      for(std::size_t v = 1; v < nb_vertices; v++)
+      {
+        lo = std::min(lo,(double)mesh.points[3*v+k]);
+        hi = std::max(hi,(double)mesh.points[3*v+k]);
+      }
+      keys.lo[k] = lo;
+      keys.scale[k] = hi > lo ? (double)((1 << BITS)-1)/(hi-lo) : 0.0;
+    }
+    std::vector<Key> sorted(nb_vertices);
+    keys.pKeys = &sorted[0];
+    ParallelUtils::parallel_for(0,nb_vertices,keys,1 << 14);
+    std::sort(sorted.begin(),sorted.end());
+    for(std::size_t v = 0; v < nb_vertices; v++)
+      order[v] = sorted[v].second;
+  }
+
+  // items of 'width' values in the new order, empty stays empty
+  template <class T>
+  static void permute(const std::vector<T>& in,
+                      const std::vector<unsigned int>& order,
+                      std::size_t width,
+                      std::vector<T>& out)
+  {
+    if(in.empty())
+      return;
+    out.resize(order.size()*width);
+    for(std::size_t i = 0; i < order.size(); i++)
+      std::copy(in.begin()+order[i]*width,in.begin()+(order[i]+1)*width,out.begin()+i*width);
+  }
+
+  static void swap(Mesh& a, Mesh& b)
+  {
+    a.points.swap(b.points);
+    a.facet_begin.swap(b.facet_begin);
+    a.facet_vertices.swap(b.facet_vertices);
+    a.vertex_normals.swap(b.vertex_normals);
+    a.vertex_colors.swap(b.vertex_colors);
+    a.facet_normals.swap(b.facet_normals);
+    a.control_edges.swap(b.control_edges);
+  }
+};
+
+// the same on any mesh with the Enriched_polyhedron interface
+template <class Mesh>
+class Mesh_reorder
+{
+public:
+  typedef typename Mesh::FT FT;
+  typedef typename Mesh::Vector Vector;
+  typedef typename Mesh::Vertex_iterator Vertex_iterator;
+  typedef typename Mesh::Facet_iterator Facet_iterator;
+  typedef typename Mesh::Edge_iterator Edge_iterator;
+  typedef typename Mesh::Halfedge_around_facet_circulator Halfedge_around_facet_circulator;
+  typedef Indexed_reorder<FT> Reorder;
+
+public:
+  // see Indexed_reorder::scattering, the vertex tags are overwritten
+  static double scattering(Mesh& mesh)
+  {
+    mesh.set_index_vertices();
+    std::size_t nb = 0, far = 0;
+    for(Edge_iterator h = mesh.edges_begin();
+        h != mesh.edges_end();
+        h++, nb++)
+      if(Reorder::is_far(h->vertex()->tag(),h->opposite()->vertex()->tag()))
+        far++;
+    return nb ? (double)far/(double)nb : 0.0;
+  }
+
+  // rebuild in Hilbert order with the points, normals, colors, control
+  // edges and facet selection. A mesh the bulk builder would not take
+  // back (non-manifold vertex) is left as is and false returned
+  static bool reorder(Mesh& mesh, std::string& error)
+  {
+    Indexed_mesh<FT> arrays;
+    std::vector<unsigned char> selected;
+    extract(mesh,arrays,selected);
+
+    Mesh_halfedges halfedges;
+    if(!halfedges.build(&arrays.facet_begin[0],arrays.size_of_facets(),
+                        arrays.size_of_indices() ? &arrays.facet_vertices[0] : NULL,
+                        arrays.size_of_vertices()))
+    {
+      error = halfedges.error();
+      return false;
+    }
+    halfedges.clear();
+
+    std::vector<unsigned int> facet_order;
+    Reorder::reorder(arrays,&facet_order);
+    mesh.clear();
+    if(!mesh.build(arrays,error))
+      return false;
+    std::size_t f = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++, f++)
+      pFacet->selected(selected[facet_order[f]] != 0);
+    return true;
+  }
+
+  static bool reorder_if_scattered(Mesh& mesh, double threshold)
+  {
+    if(scattering(mesh) <= threshold)
+      return false;
+    std::string error;
+    return reorder(mesh,error);
+  }
+
+private:
+  // the mesh as arrays in iteration order, corner i of a facet is
+  // the halfedge pointing to facet_vertices[i]
+  static void extract(Mesh& mesh, Indexed_mesh<FT>& arrays, std::vector<unsigned char>& selected)
+  {
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_facets = mesh.size_of_facets();
+    arrays.clear();
+    arrays.reserve(nb_vertices,nb_facets,mesh.size_of_halfedges());
+    arrays.vertex_normals.reserve(3*nb_vertices);
+    arrays.facet_normals.reserve(3*nb_facets);
+    arrays.control_edges.reserve(mesh.size_of_halfedges());
+    bool colors = mesh.has_vertex_colors();
+    if(colors)
+      arrays.vertex_colors.reserve(3*nb_vertices);
+
+    mesh.set_index_vertices();
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++)
+    {
+      Vector normal = pVertex->normal();
+      for(int k = 0; k < 3; k++)
+      {
+        arrays.points.push_back(pVertex->point()[k]);
+        arrays.vertex_normals.push_back(normal[k]);
+      }
+      if(colors)
+      {
+        CColor color = mesh.vertex_color(pVertex);
+        arrays.vertex_colors.push_back(color.r());
+        arrays.vertex_colors.push_back(color.g());
+        arrays.vertex_colors.push_back(color.b());
+      }
+    }
+
+    selected.reserve(nb_facets);
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
+      do
+      {
+        arrays.facet_vertices.push_back(pHalfedge->vertex()->tag());
+        arrays.control_edges.push_back(pHalfedge->control_edge() ? 1 : 0);
+      }
+      while(++pHalfedge != pFacet->facet_begin());
+      arrays.facet_begin.push_back((unsigned int)arrays.facet_vertices.size());
+      Vector normal = pFacet->normal();
+      for(int k = 0; k < 3; k++)
+        arrays.facet_normals.push_back(normal[k]);
+      selected.push_back(pFacet->selected() ? 1 : 0);
+    }
+  }
+};
+
+#endif
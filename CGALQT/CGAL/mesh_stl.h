@@ -0,0 +1,458 @@
+/***************************************************************************
+mesh_stl.h  -  STL reader and writer
+----------------------------------------------------------------------------
+STL is a triangle soup: the reader gives every facet its own vertices
+and Vertex_welder merges them before the mesh is built. A file whose
+size matches 84 + 50 * (triangle count) is binary, otherwise it has to
+start with "solid" and is read as ascii. A compressed file is parsed
+while it is decompressed, before its size is known: it is ascii when
+its "solid" line is followed by "facet" or "endsolid", otherwise
+binary and its size is checked at the end. Stored facet normals are
+not kept, the mesh normals are computed after loading. The vertices go
+to the preview, if any, as they are decoded.
+***************************************************************************/
+
+#ifndef MESH_STL_H
+#define MESH_STL_H
+
+#include "config.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "indexed_mesh.h"
+#include "compressedfile.h"
+#include "numparse.h"
+#include "numformat.h"
+#include "mesh_preview.h"
+#include "parallelutils.h"
+#include "stringutils.h"
+
+class Stl_types
+{
+private:
+  Stl_types();
+  ~Stl_types();
+
+public:
+  // binary STL is little endian
+  static float get_float(const char *p)
+  {
+    char bytes[4];
+    if(host_little_endian())
+      memcpy(bytes,p,4);
+    else
+      for(int i = 0; i < 4; i++)
+        bytes[i] = p[3-i];
+    float v;
+    memcpy(&v,bytes,4);
+    return v;
+  }
+
+  static void put_float(float v, char *p)
+  {
+    memcpy(p,&v,4);
+    if(!host_little_endian())
+      std::swap(p[0],p[3]), std::swap(p[1],p[2]);
+  }
+
+  static boost::uint32_t get_uint32(const char *p)
+  {
+    const unsigned char *q = (const unsigned char*)p;
+    return (boost::uint32_t)q[0] | ((boost::uint32_t)q[1] << 8) |
+           ((boost::uint32_t)q[2] << 16) | ((boost::uint32_t)q[3] << 24);
+  }
+
+  static void put_uint32(boost::uint32_t v, char *p)
+  {
+    for(int i = 0; i < 4; i++)
+      p[i] = (char)((v >> (8*i)) & 0xFF);
+  }
+
+  static bool host_little_endian()
+  {
+    unsigned int one = 1;
+    return *(const unsigned char*)&one == 1;
+  }
+};
+
+template <class FT>
+class Parser_stl
+{
+private:
+  enum { HEADER_SIZE = 84, RECORD_SIZE = 50, BATCH = 1 << 16 };
+
+  // decodes binary triangles [begin,end), pData is triangle first
+  struct Triangle_decoder
+  {
+    const char *pData;
+    std::size_t first;
+    FT *pPoints;
+    unsigned int *pFacetBegin;
+    int *pFacetVertices;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t t = begin; t < end; t++)
+      {
+        // 12 bytes normal, 3 x 12 bytes vertices, 2 bytes attribute
+        const char *p = pData + (t-first)*RECORD_SIZE + 12;
+        for(int k = 0; k < 9; k++)
+          pPoints[9*t+k] = (FT)Stl_types::get_float(p+4*k);
+        for(int k = 0; k < 3; k++)
+          pFacetVertices[3*t+k] = (int)(3*t+k);
+        pFacetBegin[t+1] = (unsigned int)(3*t+3);
+      }
+    }
+  };
+
+  const char *m_p;
+  const char *m_end;
+  InputWindow *m_pWindow;
+  Mesh_preview *m_pPreview;
+  std::string m_error;
+
+public:
+  Parser_stl() { m_p = m_end = NULL; m_pWindow = NULL; m_pPreview = NULL; }
+  ~Parser_stl() {}
+
+  const std::string& error() const { return m_error; }
+
+  void set_preview(Mesh_preview *pPreview) { m_pPreview = pPreview; }
+
+  bool read(const char *pFilename,
+            Indexed_mesh<FT>& indexed_mesh)
+  {
+    indexed_mesh.clear();
+    InputWindow window;
+    if(!window.open(pFilename))
+    {
+      m_error = "can not open file";
+      return false;
+    }
+    m_pWindow = &window;
+    m_p = window.begin();
+    m_end = window.end();
+    bool ok = parse_data(indexed_mesh);
+    m_pWindow = NULL;
+    if(window.eof() && window.error())
+      return fail("decompression failed");
+    return ok;
+  }
+
+  bool parse(const char *begin,
+             const char *end,
+             Indexed_mesh<FT>& indexed_mesh)
+  {
+    m_pWindow = NULL;
+    m_p = begin;
+    m_end = end;
+    return parse_data(indexed_mesh);
+  }
+
+private:
+  bool parse_data(Indexed_mesh<FT>& indexed_mesh)
+  {
+    m_error.clear();
+    fill(InputWindow::MAX_RECORD);
+
+    // the whole file is there, its size tells a binary one
+    if(m_pWindow == NULL || m_pWindow->eof())
+    {
+      std::size_t size = m_end - m_p;
+      if(size >= HEADER_SIZE)
+      {
+        std::size_t nb = Stl_types::get_uint32(m_p+80);
+        if((size-HEADER_SIZE)/RECORD_SIZE == nb && (size-HEADER_SIZE)%RECORD_SIZE == 0)
+        {
+          m_p += HEADER_SIZE;
+          return parse_binary(nb,indexed_mesh);
+        }
+      }
+      NumParse::skip_blanks(m_p,m_end);
+      if((std::size_t)(m_end-m_p) >= 5 && memcmp(m_p,"solid",5) == 0)
+        return parse_ascii(indexed_mesh);
+      return fail(size >= HEADER_SIZE ? "binary STL size does not match the triangle count" :
+                                        "not a STL file");
+    }
+
+    if(ascii_header())
+      return parse_ascii(indexed_mesh);
+    std::size_t nb = Stl_types::get_uint32(m_p+80);
+    m_p += HEADER_SIZE;
+    if(!parse_binary(nb,indexed_mesh))
+      return false;
+    fill(1);
+    if(m_p != m_end)
+      return fail("binary STL size does not match the triangle count");
+    return true;
+  }
+
+  bool fail(const std::string& message)
+  {
+    m_error = message;
+    return false;
+  }
+
+  // at least n bytes ahead in the window, if the file has them
+  void fill(std::size_t n)
+  {
+    if(m_pWindow != NULL)
+      m_pWindow->fill(m_p,m_end,n);
+  }
+
+  // a "solid" line followed by "facet" or "endsolid"
+  bool ascii_header() const
+  {
+    const char *p = m_p;
+    NumParse::skip_blanks(p,m_end);
+    if(m_end-p < 5 || memcmp(p,"solid",5) != 0)
+      return false;
+    NumParse::skip_line(p,m_end);
+    NumParse::skip_blanks(p,m_end);
+    return (m_end-p >= 5 && memcmp(p,"facet",5) == 0) ||
+           (m_end-p >= 8 && memcmp(p,"endsolid",8) == 0);
+  }
+
+  // the triangles of a mapped file at once, those of a stream by
+  // batches as they are decompressed; the count of a stream is only
+  // checked at its end, at most 64 batches are reserved on its word
+  bool parse_binary(std::size_t nb,
+                    Indexed_mesh<FT>& indexed_mesh)
+  {
+    std::size_t nb_reserved = m_pWindow == NULL ? nb : std::min<std::size_t>(nb,64*BATCH);
+    indexed_mesh.reserve(3*nb_reserved,nb_reserved,3*nb_reserved);
+    if(m_pPreview != NULL)
+      m_pPreview->set_size(3*nb);
+    std::size_t reported = 0;
+    Triangle_decoder decoder;
+    for(std::size_t t = 0; t < nb; )
+    {
+      std::size_t batch = m_pWindow == NULL ? nb : std::min<std::size_t>(nb-t,BATCH);
+      fill(batch*RECORD_SIZE);
+      if((std::size_t)(m_end-m_p) < batch*RECORD_SIZE)
+        return fail("binary STL size does not match the triangle count");
+      indexed_mesh.points.resize(9*(t+batch));
+      indexed_mesh.facet_begin.resize(t+batch+1);
+      indexed_mesh.facet_vertices.resize(3*(t+batch));
+      decoder.pData = m_p;
+      decoder.first = t;
+      decoder.pPoints = &indexed_mesh.points[0];
+      decoder.pFacetBegin = &indexed_mesh.facet_begin[0];
+      decoder.pFacetVertices = &indexed_mesh.facet_vertices[0];
+      ParallelUtils::parallel_for(t,t+batch,decoder,1<<15);
+      m_p += batch*RECORD_SIZE;
+      t += batch;
+      if(m_pPreview != NULL)
+        m_pPreview->report(decoder.pPoints,3*t,reported,true);
+    }
+    if(m_pPreview != NULL)
+      m_pPreview->flush();
+    return true;
+  }
+
+  // solid name
+  //   facet normal nx ny nz
+  //     outer loop
+  //       vertex x y z (3 times)
+  //     endloop
+  //   endfacet
+  // endsolid name
+  bool parse_ascii(Indexed_mesh<FT>& indexed_mesh)
+  {
+    std::size_t nb_loop = 0;
+    std::size_t reported = 0;
+    for(;;)
+    {
+      fill(InputWindow::MAX_RECORD);
+      NumParse::skip_blanks(m_p,m_end);
+      if(m_p >= m_end)
+      {
+        fill(1);
+        if(m_p >= m_end)
+          break;
+        continue;
+      }
+      const char *token = m_p;
+      NumParse::skip_token(m_p,m_end);
+      std::size_t length = m_p - token;
+
+      if(length == 6 && memcmp(token,"vertex",6) == 0)
+      {
+        for(int k = 0; k < 3; k++)
+        {
+          double x;
+          NumParse::skip_spaces(m_p,m_end);
+          if(!NumParse::parse_double(m_p,m_end,x))
+            return fail("facet " + StringUtils::to_string(indexed_mesh.size_of_facets()) + ": expected 3 vertex coordinates");
+          indexed_mesh.points.push_back((FT)x);
+        }
+        indexed_mesh.facet_vertices.push_back((int)indexed_mesh.facet_vertices.size());
+        nb_loop++;
+        if(m_pPreview != NULL)
+          m_pPreview->report(&indexed_mesh.points[0],indexed_mesh.points.size()/3,reported);
+      }
+      else if(length == 7 && memcmp(token,"endloop",7) == 0)
+      {
+        if(nb_loop < 3)
+          return fail("facet " + StringUtils::to_string(indexed_mesh.size_of_facets()) + ": facet with less than 3 vertices");
+        indexed_mesh.facet_begin.push_back((unsigned int)indexed_mesh.facet_vertices.size());
+        nb_loop = 0;
+      }
+      // solid, facet, normal, outer, loop, endfacet, endsolid,
+      // names and normal coordinates are skipped
+    }
+    if(nb_loop != 0)
+      return fail("missing endloop");
+    if(m_pPreview != NULL && !indexed_mesh.points.empty())
+    {
+      m_pPreview->report(&indexed_mesh.points[0],indexed_mesh.points.size()/3,reported,true);
+      m_pPreview->flush();
+    }
+    return true;
+  }
+};
+
+// write a polyhedron as STL, larger facets are split in triangle fans
+// and every triangle gets the normal of its facet
+template <class Polyhedron>
+class Stl_mesh_writer
+{
+private:
+  typedef typename Polyhedron::Facet_iterator                     Facet_iterator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator   HF_circulator;
+  typedef typename Polyhedron::Point                              Point;
+
+  OutputFile m_file;
+  std::vector<char> m_buffer;
+  bool m_ok;
+
+public:
+  Stl_mesh_writer() { m_ok = true; }
+  ~Stl_mesh_writer() {}
+
+public:
+  bool write(const char *pFilename,
+             Polyhedron& mesh,
+             bool binary = true)
+  {
+    boost::uint32_t nb = 0;
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+      nb += Polyhedron::degree(pFacet)-2;
+
+    if(!m_file.open(pFilename))
+      return false;
+    m_buffer.clear();
+    m_buffer.reserve(1<<20);
+    m_ok = true;
+
+    if(binary)
+    {
+      char header[84];
+      memset(header,0,sizeof(header));
+      strcpy(header,"binary STL written by CGALQT");
+      Stl_types::put_uint32(nb,header+80);
+      put(header,sizeof(header));
+    }
+    else
+      put_text("solid CGALQT\n");
+
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      HF_circulator pHalfedge = pFacet->facet_begin();
+      const Point& p0 = pHalfedge->vertex()->point();
+      ++pHalfedge;
+      for(unsigned int k = 2; k < Polyhedron::degree(pFacet); k++)
+      {
+        const Point& p1 = pHalfedge->vertex()->point();
+        ++pHalfedge;
+        const Point& p2 = pHalfedge->vertex()->point();
+        if(binary)
+          put_binary(pFacet->normal(),p0,p1,p2);
+        else
+          put_ascii(pFacet->normal(),p0,p1,p2);
+      }
+    }
+
+    if(!binary)
+      put_text("endsolid CGALQT\n");
+
+    flush();
+    bool ok = m_file.close() && m_ok;
+    if(!ok)
+      remove(pFilename);
+    return ok;
+  }
+
+private:
+  template <class Normal>
+  void put_binary(const Normal& n, const Point& p0, const Point& p1, const Point& p2)
+  {
+    char record[50];
+    const Point *points[3] = { &p0, &p1, &p2 };
+    for(int k = 0; k < 3; k++)
+      Stl_types::put_float((float)n[k],record+4*k);
+    for(int i = 0; i < 3; i++)
+      for(int k = 0; k < 3; k++)
+        Stl_types::put_float((float)(*points[i])[k],record+12+12*i+4*k);
+    record[48] = record[49] = 0;
+    put(record,sizeof(record));
+  }
+
+  template <class Normal>
+  void put_ascii(const Normal& n, const Point& p0, const Point& p1, const Point& p2)
+  {
+    put_text("facet normal");
+    put_xyz(n[0],n[1],n[2]);
+    put_text("\nouter loop\n");
+    const Point *points[3] = { &p0, &p1, &p2 };
+    for(int i = 0; i < 3; i++)
+    {
+      put_text("vertex");
+      put_xyz((*points[i])[0],(*points[i])[1],(*points[i])[2]);
+      put_text("\n");
+    }
+    put_text("endloop\nendfacet\n");
+  }
+
+  void put_xyz(double x, double y, double z)
+  {
+    char text[3*NumFormat::MAX_CHARS+3];
+    char *p = text;
+    *p++ = ' ';
+    p = NumFormat::format_double(x,p);
+    *p++ = ' ';
+    p = NumFormat::format_double(y,p);
+    *p++ = ' ';
+    p = NumFormat::format_double(z,p);
+    put(text,p-text);
+  }
+
+  void put_text(const char *pText)
+  {
+    put(pText,strlen(pText));
+  }
+
+  void put(const void *pData, std::size_t size)
+  {
+    const char *p = (const char*)pData;
+    m_buffer.insert(m_buffer.end(),p,p+size);
+    if(m_buffer.size() >= (1<<20))
+      flush();
+  }
+
+  void flush()
+  {
+    if(!m_buffer.empty() &&
+       !m_file.write(&m_buffer[0],m_buffer.size()))
+      m_ok = false;
+    m_buffer.clear();
+  }
+};
+
+#endif
@@ -0,0 +1,238 @@
+/***************************************************************************
+mesh_text.h  -  OBJ and OFF writers
+----------------------------------------------------------------------------
+Vertices and facets are formatted in batches: every thread formats a
+contiguous range into its own buffer, the buffers are then written to the
+file in range order, so the output is the same whatever the thread count.
+Coordinates are written with the shortest digits that read back exactly.
+***************************************************************************/
+
+#ifndef MESH_TEXT_H
+#define MESH_TEXT_H
+
+#include "config.h"
+#include <cstdio>
+#include <vector>
+#include <algorithm>
+#include "numformat.h"
+#include "parallelutils.h"
+#include "compressedfile.h"
+
+template <class Polyhedron>
+class Text_mesh_writer
+{
+private:
+  typedef typename Polyhedron::Vertex_handle                      Vertex_handle;
+  typedef typename Polyhedron::Vertex_iterator                    Vertex_iterator;
+  typedef typename Polyhedron::Facet_handle                       Facet_handle;
+  typedef typename Polyhedron::Facet_iterator                     Facet_iterator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator   HF_circulator;
+
+  // items formatted by one thread in one batch
+  enum { BATCH = 1<<15 };
+
+  // output of one range, only the first 'size' bytes are used
+  struct Buffer
+  {
+    std::vector<char> data;
+    std::size_t size;
+
+    Buffer() { size = 0; }
+
+    char *reserve(std::size_t n)
+    {
+      if(size + n > data.size())
+        data.resize(std::max(2*data.size(),size+n));
+      return &data[size];
+    }
+    void commit(char *end) { size = end - &data[0]; }
+  };
+
+  // formats vertices [begin,end) into buffers[range]
+  struct Vertex_formatter
+  {
+    const std::vector<Vertex_handle> *pVertices;
+    std::vector<Buffer> *pBuffers;
+    bool off;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Buffer& buffer = (*pBuffers)[range];
+      buffer.size = 0;
+      char *p = buffer.reserve((end-begin)*(3*NumFormat::MAX_CHARS+5));
+      for(std::size_t i = begin; i < end; i++)
+      {
+        const Vertex_handle& pVertex = (*pVertices)[i];
+        if(!off)
+        {
+          *p++ = 'v';
+          *p++ = ' ';
+        }
+        p = NumFormat::format_double(pVertex->point().x(),p);
+        *p++ = ' ';
+        p = NumFormat::format_double(pVertex->point().y(),p);
+        *p++ = ' ';
+        p = NumFormat::format_double(pVertex->point().z(),p);
+        *p++ = '\n';
+      }
+      buffer.commit(p);
+    }
+  };
+
+  // formats facets [begin,end) into buffers[range],
+  // OBJ: "f i1 i2 ..." (indices + incr), OFF: "n i1 i2 ..."
+  struct Facet_formatter
+  {
+    const std::vector<Facet_handle> *pFacets;
+    std::vector<Buffer> *pBuffers;
+    bool off;
+    int incr;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Buffer& buffer = (*pBuffers)[range];
+      buffer.size = 0;
+      for(std::size_t i = begin; i < end; i++)
+      {
+        const Facet_handle& pFacet = (*pFacets)[i];
+        char *p = buffer.reserve(NumFormat::MAX_CHARS+2);
+        if(off)
+          p = NumFormat::format_int((int)Polyhedron::degree(pFacet),p);
+        else
+          *p++ = 'f';
+        buffer.commit(p);
+
+        HF_circulator pHalfedge = pFacet->facet_begin();
+        do
+        {
+          p = buffer.reserve(NumFormat::MAX_CHARS+2);
+          *p++ = ' ';
+          p = NumFormat::format_int(pHalfedge->vertex()->tag()+incr,p);
+          buffer.commit(p);
+        }
+        while(++pHalfedge != pFacet->facet_begin());
+
+        p = buffer.reserve(1);
+        *p++ = '\n';
+        buffer.commit(p);
+      }
+    }
+  };
+
+  std::vector<Vertex_handle> m_vertices;
+  std::vector<Facet_handle> m_facets;
+  std::vector<Buffer> m_buffers;
+  OutputFile m_file;
+  bool m_ok;
+
+public:
+  Text_mesh_writer() { m_ok = true; }
+  ~Text_mesh_writer() {}
+
+public:
+  bool write_obj(const char *pFilename,
+                 Polyhedron& mesh,
+                 int incr = 1) // 1-based by default
+  {
+    return write(pFilename,mesh,false,incr);
+  }
+
+  bool write_off(const char *pFilename,
+                 Polyhedron& mesh)
+  {
+    return write(pFilename,mesh,true,0);
+  }
+
+private:
+  bool write(const char *pFilename,
+             Polyhedron& mesh,
+             bool off,
+             int incr)
+  {
+    // gather the handles for the formatting threads,
+    // the vertex indices are stored in vertex tags on the way
+    m_vertices.clear();
+    m_vertices.reserve(mesh.size_of_vertices());
+    int index = 0;
+    for(Vertex_iterator pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
+        pVertex++)
+    {
+      pVertex->tag(index++);
+      m_vertices.push_back(pVertex);
+    }
+    m_facets.clear();
+    m_facets.reserve(mesh.size_of_facets());
+    for(Facet_iterator pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+      m_facets.push_back(pFacet);
+
+    if(!m_file.open(pFilename))
+      return false;
+    m_ok = true;
+    m_buffers.resize(ParallelUtils::nb_threads());
+
+    if(off)
+    {
+      // OFF
+      // #vertices #facets #edges
+      char header[3*NumFormat::MAX_CHARS+8] = "OFF\n";
+      char *p = header + 4;
+      p = NumFormat::format_int((int)m_vertices.size(),p);
+      *p++ = ' ';
+      p = NumFormat::format_int((int)m_facets.size(),p);
+      *p++ = ' ';
+      *p++ = '0';
+      *p++ = '\n';
+      put(header,p-header);
+    }
+
+    Vertex_formatter vertex_formatter;
+    vertex_formatter.pVertices = &m_vertices;
+    vertex_formatter.pBuffers = &m_buffers;
+    vertex_formatter.off = off;
+    format(m_vertices.size(),vertex_formatter);
+
+    Facet_formatter facet_formatter;
+    facet_formatter.pFacets = &m_facets;
+    facet_formatter.pBuffers = &m_buffers;
+    facet_formatter.off = off;
+    facet_formatter.incr = incr;
+    format(m_facets.size(),facet_formatter);
+
+    std::vector<Vertex_handle>().swap(m_vertices);
+    std::vector<Facet_handle>().swap(m_facets);
+    std::vector<Buffer>().swap(m_buffers);
+
+    bool ok = m_file.close() && m_ok;
+    if(!ok)
+      remove(pFilename);
+    return ok;
+  }
+
+  // format items [0,count) by batches of at most BATCH items per
+  // thread, each batch is written as soon as it is complete
+  template <class Formatter>
+  void format(std::size_t count, Formatter formatter)
+  {
+    std::size_t batch = (std::size_t)BATCH*m_buffers.size();
+    for(std::size_t begin = 0; begin < count && m_ok; begin += batch)
+    {
+      std::size_t end = std::min(count,begin+batch);
+      std::size_t grain = BATCH/8;
+      ParallelUtils::parallel_for(begin,end,formatter,grain);
+      std::size_t nb = ParallelUtils::nb_ranges(end-begin,grain);
+      for(std::size_t i = 0; i < nb; i++)
+        put(&m_buffers[i].data[0],m_buffers[i].size);
+    }
+  }
+
+  void put(const char *pData, std::size_t size)
+  {
+    if(size > 0 && !m_file.write(pData,size))
+      m_ok = false;
+  }
+};
+
+#endif
@@ -0,0 +1,680 @@
+/***************************************************************************
+mesh_view.h  -  indexed face set ready for display
+----------------------------------------------------------------------------
+An Indexed_mesh with what the viewer needs on top of it: normals,
+bounding box, pure triangle / quad type, facet selection and the OpenGL
+drawing. It takes several times less memory than the Polyhedron_3 with
+Enriched_items and is enough to look at a model, select facets and save
+snapshots. build() makes the half-edge mesh once a topology operation
+needs it; the normals and the selection are carried over.
+read_binary() keeps the .cqm mapped: the drawing, the type, the bounding
+box and build() read the mapped arrays, which are only copied into the
+Indexed_mesh before the first change (mesh(), normals, reorder, weld).
+***************************************************************************/
+
+#ifndef MESH_VIEW_H
+#define MESH_VIEW_H
+
+#include "config.h"
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include "indexed_mesh.h"
+#include "parser_off.h"
+#include "mesh_binary.h"
+#include "mesh_archive.h"
+#include "mesh_ply.h"
+#include "mesh_stl.h"
+#include "mesh_preview.h"
+#include "mesh_weld.h"
+#include "mesh_render.h"
+#include "mesh_reorder.h"
+#include "parallelutils.h"
+#include "stringutils.h"
+#include "uglyfont.h"
+
+template <class FT>
+class Indexed_view
+{
+public:
+  typedef Indexed_mesh<FT> Mesh;
+
+private:
+  // facet normals of [begin,end)
+  struct Facet_normals
+  {
+    Mesh *pMesh;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t f = begin; f < end; f++)
+      {
+        double normal[3];
+        facet_normal(*pMesh,f,normal);
+        for(int k = 0; k < 3; k++)
+          pMesh->facet_normals[3*f+k] = (FT)normal[k];
+      }
+    }
+  };
+
+public:
+  Indexed_view()
+  {
+    m_mapped = false;
+    m_pure_triangle = false;
+    m_pure_quad = false;
+    for(int k = 0; k < 3; k++)
+      m_bbox_min[k] = m_bbox_max[k] = 0.0;
+  }
+  ~Indexed_view() {}
+
+public:
+  // the arrays of a mapped .cqm are copied first, see read_binary()
+  Mesh& mesh() { edit(); return m_mesh; }
+
+  std::size_t size_of_vertices() const { return m_mapped ? m_binary.size_of_vertices() : m_mesh.size_of_vertices(); }
+  std::size_t size_of_facets() const { return m_mapped ? m_binary.size_of_facets() : m_mesh.size_of_facets(); }
+  // edges shared by two facets are counted once
+  std::size_t size_of_edges() { compute_edges(); return m_edges.size()/2; }
+
+  /************************************************************************/
+  /* mesh attributes                                                      */
+  /************************************************************************/
+  void compute_type()
+  {
+    m_pure_triangle = m_mapped ? is_pure_degree(m_binary,3) : is_pure_degree(m_mesh,3);
+    m_pure_quad = m_mapped ? is_pure_degree(m_binary,4) : is_pure_degree(m_mesh,4);
+  }
+
+  bool is_pure_triangle() const { return m_pure_triangle; }
+  bool is_pure_quad() const { return m_pure_quad; }
+  bool has_vertex_colors() const { return m_mapped ? m_binary.has_vertex_colors() : m_mesh.has_vertex_colors(); }
+  bool has_vertex_normals() const { return m_mapped ? m_binary.has_vertex_normals() : m_mesh.has_vertex_normals(); }
+  bool has_facet_normals() const { return m_mapped ? m_binary.has_facet_normals() : m_mesh.has_facet_normals(); }
+  // a mapped .cqm was checked when it was opened
+  bool is_valid() const { return m_mapped || m_mesh.is_valid(); }
+
+  void compute_normals()
+  {
+    compute_normals_per_facet();
+    compute_normals_per_vertex();
+  }
+
+  void compute_normals_per_facet()
+  {
+    edit();
+    m_mesh.facet_normals.resize(3*size_of_facets());
+    if(size_of_facets() == 0)
+      return;
+    Facet_normals normals;
+    normals.pMesh = &m_mesh;
+    ParallelUtils::parallel_for(0,size_of_facets(),normals,1<<14);
+  }
+
+  // sum of the normals of the incident facets, like Vertex_normal
+  void compute_normals_per_vertex()
+  {
+    edit();
+    std::vector<double> sums(3*size_of_vertices(),0.0);
+    for(std::size_t f = 0; f < size_of_facets(); f++)
+    {
+      const FT *n = &m_mesh.facet_normals[3*f];
+      for(unsigned int i = m_mesh.facet_begin[f]; i < m_mesh.facet_begin[f+1]; i++)
+      {
+        double *sum = &sums[3*m_mesh.facet_vertices[i]];
+        for(int k = 0; k < 3; k++)
+          sum[k] += n[k];
+      }
+    }
+    m_mesh.vertex_normals.resize(3*size_of_vertices());
+    for(std::size_t v = 0; v < size_of_vertices(); v++)
+    {
+      normalize(&sums[3*v]);
+      for(int k = 0; k < 3; k++)
+        m_mesh.vertex_normals[3*v+k] = (FT)sums[3*v+k];
+    }
+  }
+
+  void compute_bounding_box()
+  {
+    if(m_mapped)
+      compute_bounding_box(m_binary);
+    else
+      compute_bounding_box(m_mesh);
+  }
+
+  FT xmin() const { return m_bbox_min[0]; }
+  FT xmax() const { return m_bbox_max[0]; }
+  FT ymin() const { return m_bbox_min[1]; }
+  FT ymax() const { return m_bbox_max[1]; }
+  FT zmin() const { return m_bbox_min[2]; }
+  FT zmax() const { return m_bbox_max[2]; }
+
+  bool is_selected(std::size_t f) const { return !m_selected.empty() && m_selected[f] != 0; }
+  void select(std::size_t f, bool selected)
+  {
+    if(m_selected.empty() && !selected)
+      return;
+    m_selected.resize(size_of_facets(),0);
+    m_selected[f] = selected ? 1 : 0;
+  }
+  void clear_selection() { m_selected.clear(); }
+
+  // same formula as Facet_normal, for any indexed face set
+  // (Indexed_mesh, Binary_mesh_view)
+  template <class M>
+  static void facet_normal(const M& mesh, std::size_t f, double normal[3])
+  {
+    unsigned int first = mesh.facet_begin[f];
+    unsigned int degree = mesh.facet_begin[f+1] - first;
+    for(int k = 0; k < 3; k++)
+      normal[k] = 0.0;
+    for(unsigned int i = 0; i < degree; i++)
+    {
+      const typename M::Coord *p0 = &mesh.points[3*mesh.facet_vertices[first+i]];
+      const typename M::Coord *p1 = &mesh.points[3*mesh.facet_vertices[first+(i+1)%degree]];
+      const typename M::Coord *p2 = &mesh.points[3*mesh.facet_vertices[first+(i+2)%degree]];
+      double u[3], v[3], n[3];
+      for(int k = 0; k < 3; k++)
+      {
+        u[k] = p1[k] - p0[k];
+        v[k] = p2[k] - p1[k];
+      }
+      n[0] = u[1]*v[2] - u[2]*v[1];
+      n[1] = u[2]*v[0] - u[0]*v[2];
+      n[2] = u[0]*v[1] - u[1]*v[0];
+      normalize(n);
+      for(int k = 0; k < 3; k++)
+        normal[k] += n[k];
+    }
+    normalize(normal);
+  }
+
+  /************************************************************************/
+  /* half-edge mesh and file io                                           */
+  /************************************************************************/
+  // fill an empty Enriched_polyhedron, the facets keep their order
+  template <class Polyhedron>
+  bool build(Polyhedron& polyhedron, std::string& error)
+  {
+    if(!(m_mapped ? polyhedron.build(m_binary,error) : polyhedron.build(m_mesh,error)))
+      return false;
+    polyhedron.bbox() = typename Polyhedron::Iso_cuboid(xmin(),ymin(),zmin(),
+                                                        xmax(),ymax(),zmax());
+    polyhedron.compute_type();
+    if(!m_selected.empty())
+    {
+      std::size_t f = 0;
+      for(typename Polyhedron::Facet_iterator pFacet = polyhedron.facets_begin();
+          pFacet != polyhedron.facets_end();
+          pFacet++, f++)
+        pFacet->selected(m_selected[f] != 0);
+    }
+    return true;
+  }
+
+  // the readers match the Enriched_polyhedron ones, see there;
+  // the parsers pass the vertices to pPreview as they decode them
+  bool read_off(const char *pFilename, std::string& error, double weld_epsilon = -1.0,
+                Mesh_preview *pPreview = NULL)
+  {
+    unmap();
+    Parser_off<FT> parser;
+    parser.set_preview(pPreview);
+    if(!parser.read(pFilename,m_mesh))
+    {
+      error = parser.error();
+      return false;
+    }
+    if(weld_epsilon >= 0.0)
+      weld(weld_epsilon);
+    return true;
+  }
+
+  bool read_stl(const char *pFilename, std::string& error, double weld_epsilon = 0.0,
+                Mesh_preview *pPreview = NULL)
+  {
+    unmap();
+    Parser_stl<FT> parser;
+    parser.set_preview(pPreview);
+    if(!parser.read(pFilename,m_mesh))
+    {
+      error = parser.error();
+      return false;
+    }
+    weld(std::max(0.0,weld_epsilon));
+    return true;
+  }
+
+  bool read_ply(const char *pFilename, std::string& error, bool& has_normals,
+                Mesh_preview *pPreview = NULL)
+  {
+    unmap();
+    Parser_ply<FT> parser;
+    parser.set_preview(pPreview);
+    if(!parser.read(pFilename,m_mesh))
+    {
+      error = parser.error();
+      return false;
+    }
+    has_normals = m_mesh.has_vertex_normals();
+    return true;
+  }
+
+  // the file stays mapped, see edit()
+  bool read_binary(const char *pFilename, std::string& error, bool& has_normals,
+                   Mesh_preview *pPreview = NULL)
+  {
+    unmap();
+    m_mesh.clear();
+    if(!m_binary.open(pFilename,error))
+      return false;
+    m_mapped = true;
+    std::size_t nb_vertices = m_binary.size_of_vertices();
+    if(pPreview != NULL)
+    {
+      std::size_t reported = 0;
+      pPreview->set_size(nb_vertices);
+      pPreview->report(m_binary.points,nb_vertices,reported,true);
+      pPreview->flush();
+    }
+    has_normals = m_binary.has_vertex_normals() && m_binary.has_facet_normals();
+    return true;
+  }
+
+  bool read_archive(const char *pFilename, std::string& error)
+  {
+    unmap();
+    Mesh_archive_reader<FT> reader;
+    if(!reader.read(pFilename,m_mesh))
+    {
+      error = reader.error();
+      return false;
+    }
+    return true;
+  }
+
+  // the arrays along a Hilbert curve, see Indexed_reorder; the
+  // selection follows its facets
+  bool reorder_if_scattered(double threshold = Indexed_reorder<FT>::threshold())
+  {
+    double scattering = m_mapped ? Indexed_reorder<FT>::scattering(m_binary) :
+                                   Indexed_reorder<FT>::scattering(m_mesh);
+    if(scattering <= threshold)
+      return false;
+    edit();
+    std::vector<unsigned int> facet_order;
+    Indexed_reorder<FT>::reorder(m_mesh,&facet_order);
+    if(!m_selected.empty())
+    {
+      std::vector<unsigned char> selected(facet_order.size());
+      for(std::size_t f = 0; f < facet_order.size(); f++)
+        selected[f] = m_selected[facet_order[f]];
+      m_selected.swap(selected);
+    }
+    std::vector<unsigned int>().swap(m_edges);
+    return true;
+  }
+
+  // merge the vertices closer than epsilon, see Vertex_welder
+  void weld(double epsilon)
+  {
+    edit();
+    Vertex_welder<FT> welder;
+    welder.weld(m_mesh,epsilon);
+  }
+
+  // with pSourceFilename the file is a sidecar cache of that model;
+  // a mapped .cqm is copied first, it may be the file written
+  bool write_binary(const char *pFilename, const char *pSourceFilename = NULL)
+  {
+    edit();
+    Binary_indexed_writer<Mesh> writer;
+    return writer.write(pFilename,m_mesh,pSourceFilename);
+  }
+
+  /************************************************************************/
+  /* opengl part                                                          */
+  /************************************************************************/
+  // the facets are named first_name + index for picking
+  void gl_draw(bool smooth_shading, bool use_normals, bool use_colors = false, std::size_t first_name = 0)
+  {
+    use_colors = use_colors && has_vertex_colors();
+    use_normals = use_normals && (smooth_shading ? has_vertex_normals() : has_facet_normals());
+    if(use_colors)
+    {
+      glColorMaterial(GL_FRONT,GL_AMBIENT_AND_DIFFUSE);
+      glEnable(GL_COLOR_MATERIAL);
+    }
+
+    for(std::size_t f = 0; f < size_of_facets(); f++)
+    {
+      glLoadName((GLuint)(first_name + f));
+      glBegin(GL_POLYGON);
+      if(m_mapped)
+        gl_draw_facet(m_binary,f,smooth_shading,use_normals,use_colors);
+      else
+        gl_draw_facet(m_mesh,f,smooth_shading,use_normals,use_colors);
+      glEnd();
+    }
+    glFlush();
+
+    if(use_colors)
+      glDisable(GL_COLOR_MATERIAL);
+  }
+
+  void gl_draw_lines()
+  {
+    compute_edges();
+    if(m_edges.empty())
+      return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    gl_vertex_pointer();
+    glDrawElements(GL_LINES,(GLsizei)m_edges.size(),GL_UNSIGNED_INT,&m_edges[0]);
+    glDisableClientState(GL_VERTEX_ARRAY);
+  }
+
+  void gl_draw_points()
+  {
+    if(size_of_vertices() == 0)
+      return;
+    glEnableClientState(GL_VERTEX_ARRAY);
+    gl_vertex_pointer();
+    glDrawArrays(GL_POINTS,0,(GLsizei)size_of_vertices());
+    glDisableClientState(GL_VERTEX_ARRAY);
+  }
+
+  void gl_draw_bounding_box()
+  {
+    glBegin(GL_LINES);
+    for(int k = 0; k < 3; k++)
+    {
+      // the 4 edges along axis k
+      int a = (k+1)%3, b = (k+2)%3;
+      for(int corner = 0; corner < 4; corner++)
+      {
+        FT p[3];
+        p[a] = (corner & 1) ? m_bbox_max[a] : m_bbox_min[a];
+        p[b] = (corner & 2) ? m_bbox_max[b] : m_bbox_min[b];
+        p[k] = m_bbox_min[k];
+        glVertex3f(p[0],p[1],p[2]);
+        p[k] = m_bbox_max[k];
+        glVertex3f(p[0],p[1],p[2]);
+      }
+    }
+    glEnd();
+  }
+
+  void gl_draw_selectedfaces()
+  {
+    if(m_selected.empty())
+      return;
+    for(std::size_t f = 0; f < size_of_facets(); f++)
+    {
+      if(m_selected[f])
+      {
+        glBegin(GL_POLYGON);
+        if(m_mapped)
+          gl_draw_facet(m_binary,f,false,false);
+        else
+          gl_draw_facet(m_mesh,f,false,false);
+        glEnd();
+      }
+    }
+    glFlush();
+  }
+
+  // the vertex indices of the selected facets
+  void gl_draw_number()
+  {
+    if(m_mapped)
+      gl_draw_number(m_binary);
+    else
+      gl_draw_number(m_mesh);
+  }
+
+  //process hits, the names are the facet indices
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_normal)
+  {
+    if(hits == 0)
+      return;
+    m_selected.assign(size_of_facets(),0);
+    for(int i = 0; i < hits; i++)
+      m_selected[buffer[i*4 + 3]] = 1;
+  }
+
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_plus)
+  {
+    if(hits == 0)
+      return;
+    m_selected.resize(size_of_facets(),0);
+    for(int i = 0; i < hits; i++)
+      m_selected[buffer[i*4 + 3]] = 1;
+  }
+
+  void gl_processhits(GLint hits, GLuint buffer[], processhits_minus)
+  {
+    if(hits == 0)
+      return;
+    m_selected.resize(size_of_facets(),0);
+    for(int i = 0; i < hits; i++)
+    {
+      unsigned char& selected = m_selected[buffer[i*4 + 3]];
+      selected = !selected;
+    }
+  }
+
+private:
+  static void normalize(double *v)
+  {
+    double sqnorm = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+    if(sqnorm != 0.0)
+    {
+      double norm = std::sqrt(sqnorm);
+      for(int k = 0; k < 3; k++)
+        v[k] /= norm;
+    }
+  }
+
+  static GLenum gl_type() { return sizeof(FT) == sizeof(float) ? GL_FLOAT : GL_DOUBLE; }
+
+  void gl_vertex_pointer()
+  {
+    if(m_mapped)
+      glVertexPointer(3,GL_DOUBLE,0,m_binary.points);
+    else
+      glVertexPointer(3,gl_type(),0,&m_mesh.points[0]);
+  }
+
+  // the members below read an Indexed_mesh or a mapped .cqm
+  template <class M>
+  static bool is_pure_degree(const M& mesh, unsigned int d)
+  {
+    for(std::size_t f = 0; f < mesh.size_of_facets(); f++)
+      if(mesh.degree(f) != d)
+        return false;
+    return true;
+  }
+
+  template <class M>
+  void compute_bounding_box(const M& mesh)
+  {
+    if(mesh.size_of_vertices() == 0)
+      return;
+    for(int k = 0; k < 3; k++)
+      m_bbox_min[k] = m_bbox_max[k] = (FT)mesh.points[k];
+    for(std::size_t v = 1; v < mesh.size_of_vertices(); v++)
+      for(int k = 0; k < 3; k++)
+      {
+        FT x = (FT)mesh.points[3*v+k];
+        m_bbox_min[k] = std::min(m_bbox_min[k],x);
+        m_bbox_max[k] = std::max(m_bbox_max[k],x);
+      }
+  }
+
+  // the edges as pairs of vertex indices, built on the first use
+  void compute_edges()
+  {
+    if(!m_edges.empty() || size_of_facets() == 0)
+      return;
+    if(m_mapped)
+      compute_edges(m_binary);
+    else
+      compute_edges(m_mesh);
+  }
+
+  template <class M>
+  void compute_edges(const M& mesh)
+  {
+    std::vector<boost::uint64_t> keys(mesh.size_of_indices());
+    for(std::size_t f = 0; f < mesh.size_of_facets(); f++)
+    {
+      unsigned int first = mesh.facet_begin[f];
+      unsigned int last = mesh.facet_begin[f+1];
+      for(unsigned int i = first; i < last; i++)
+      {
+        boost::uint64_t a = (boost::uint32_t)mesh.facet_vertices[i];
+        boost::uint64_t b = (boost::uint32_t)mesh.facet_vertices[i+1 < last ? i+1 : first];
+        keys[i] = a < b ? (a << 32) | b : (b << 32) | a;
+      }
+    }
+    std::sort(keys.begin(),keys.end());
+    keys.erase(std::unique(keys.begin(),keys.end()),keys.end());
+    m_edges.resize(2*keys.size());
+    for(std::size_t e = 0; e < keys.size(); e++)
+    {
+      m_edges[2*e] = (unsigned int)(keys[e] >> 32);
+      m_edges[2*e+1] = (unsigned int)(keys[e] & 0xFFFFFFFF);
+    }
+  }
+
+  template <class M>
+  static FT average_edge_length(const M& mesh, std::size_t f)
+  {
+    unsigned int first = mesh.facet_begin[f];
+    unsigned int degree = mesh.degree(f);
+    double sum = 0.0;
+    for(unsigned int i = 0; i < degree; i++)
+    {
+      const typename M::Coord *p = &mesh.points[3*mesh.facet_vertices[first+i]];
+      const typename M::Coord *q = &mesh.points[3*mesh.facet_vertices[first+(i+1)%degree]];
+      sum += std::sqrt((p[0]-q[0])*(p[0]-q[0]) + (p[1]-q[1])*(p[1]-q[1]) + (p[2]-q[2])*(p[2]-q[2]));
+    }
+    return (FT)(sum/degree);
+  }
+
+  template <class M>
+  void gl_draw_number(const M& mesh)
+  {
+    if(m_selected.empty())
+      return;
+    std::vector<bool> drawn(mesh.size_of_vertices(),false);
+    static float scale_ratio = -1.0;
+    for(std::size_t f = 0; f < mesh.size_of_facets(); f++)
+    {
+      if(!m_selected[f])
+        continue;
+      if(scale_ratio < 0.0)
+        scale_ratio = average_edge_length(mesh,f)/3.0;
+      for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++)
+      {
+        int v = mesh.facet_vertices[i];
+        if(drawn[v])
+          continue;
+        drawn[v] = true;
+        std::string tagstr = StringUtils::to_string(v);
+        const typename M::Coord *point = &mesh.points[3*v];
+
+        glPushMatrix();
+        glTranslatef(point[0],point[1],point[2]);
+        glScalef(scale_ratio,scale_ratio,scale_ratio);
+        YsDrawUglyFont(tagstr.c_str(),0);
+        glPopMatrix();
+      }
+    }
+    glFlush();
+  }
+
+  template <class M>
+  static void gl_draw_facet(const M& mesh, std::size_t f, bool smooth_shading, bool use_normals, bool use_colors = false)
+  {
+    // one normal per face
+    if(use_normals && !smooth_shading)
+    {
+      const typename M::Coord *normal = &mesh.facet_normals[3*f];
+      glNormal3f(normal[0],normal[1],normal[2]);
+    }
+
+    for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++)
+    {
+      int v = mesh.facet_vertices[i];
+      // one normal per vertex
+      if(use_normals && smooth_shading)
+      {
+        const typename M::Coord *normal = &mesh.vertex_normals[3*v];
+        glNormal3f(normal[0],normal[1],normal[2]);
+      }
+
+      if(use_colors)
+      {
+        const unsigned char *color = &mesh.vertex_colors[3*v];
+        glColor3ub(color[0],color[1],color[2]);
+      }
+
+      const typename M::Coord *point = &mesh.points[3*v];
+      glVertex3d(point[0],point[1],point[2]);
+    }
+  }
+
+  // the arrays of the mapped .cqm into the Indexed_mesh, before its
+  // first change
+  void edit()
+  {
+    if(!m_mapped)
+      return;
+    std::size_t nb_vertices = m_binary.size_of_vertices();
+    std::size_t nb_facets = m_binary.size_of_facets();
+    std::size_t nb_indices = m_binary.size_of_indices();
+    m_mesh.clear();
+    m_mesh.points.assign(m_binary.points,m_binary.points+3*nb_vertices);
+    m_mesh.facet_begin.assign(m_binary.facet_begin,m_binary.facet_begin+nb_facets+1);
+    m_mesh.facet_vertices.assign(m_binary.facet_vertices,m_binary.facet_vertices+nb_indices);
+    if(m_binary.has_vertex_normals())
+      m_mesh.vertex_normals.assign(m_binary.vertex_normals,m_binary.vertex_normals+3*nb_vertices);
+    if(m_binary.has_facet_normals())
+      m_mesh.facet_normals.assign(m_binary.facet_normals,m_binary.facet_normals+3*nb_facets);
+    if(m_binary.has_control_edges())
+      m_mesh.control_edges.assign(m_binary.control_edges,m_binary.control_edges+nb_indices);
+    if(m_binary.has_vertex_colors())
+      m_mesh.vertex_colors.assign(m_binary.vertex_colors,m_binary.vertex_colors+3*nb_vertices);
+    unmap();
+  }
+
+  void unmap()
+  {
+    m_binary.close();
+    m_mapped = false;
+  }
+
+private:
+  Mesh m_mesh;
+  // read_binary() leaves the arrays there until edit()
+  Binary_mesh_view m_binary;
+  bool m_mapped;
+  FT m_bbox_min[3];
+  FT m_bbox_max[3];
+
+  // type
+  bool m_pure_triangle;
+  bool m_pure_quad;
+
+  // 1 for the selected facets, empty until the first selection
+  std::vector<unsigned char> m_selected;
+  // pairs of vertex indices, see compute_edges()
+  std::vector<unsigned int> m_edges;
+};
+
+#endif
@@ -0,0 +1,331 @@
+/***************************************************************************
+mesh_weld.h  -  duplicate vertex welding on an Indexed_mesh
+----------------------------------------------------------------------------
+Vertices are hashed into a grid of 4*epsilon wide cells. In parallel,
+every vertex looks for the lowest indexed vertex within epsilon in its own
+cell and in the neighbor cells closer than epsilon (at most 8 cells), then
+a serial pass joins it to that vertex's representative. With epsilon 0
+only equal positions are merged. The result does not depend on the
+thread count. Facets are remapped, repeated corners removed and facets
+left with less than 3 corners dropped.
+***************************************************************************/
+
+#ifndef MESH_WELD_H
+#define MESH_WELD_H
+
+#include "config.h"
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <boost/cstdint.hpp>
+#include "indexed_mesh.h"
+#include "parallelutils.h"
+
+template <class FT>
+class Vertex_welder
+{
+private:
+  struct Cell
+  {
+    boost::int64_t x, y, z;
+    bool operator==(const Cell& c) const { return x == c.x && y == c.y && z == c.z; }
+  };
+
+  // grid cell and hash bucket of every vertex
+  struct Cell_locator
+  {
+    const FT *pPoints;
+    double epsilon;
+    unsigned int mask;
+    Cell *pCells;
+    unsigned int *pBuckets;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t v = begin; v < end; v++)
+      {
+        pCells[v] = cell(pPoints+3*v,epsilon);
+        pBuckets[v] = bucket(pCells[v],mask);
+      }
+    }
+  };
+
+  // lowest indexed vertex within epsilon, the vertex itself if none
+  struct Neighbor_finder
+  {
+    const FT *pPoints;
+    double epsilon;
+    unsigned int mask;
+    const Cell *pCells;
+    const unsigned int *pBucketBegin;
+    const unsigned int *pSorted;
+    unsigned int *pFirst;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      bool exact = epsilon <= 0.0;
+      double epsilon2 = epsilon*epsilon;
+      for(std::size_t v = begin; v < end; v++)
+      {
+        const FT *p = pPoints+3*v;
+        unsigned int first = (unsigned int)v;
+
+        // neighbor cell along each axis if the vertex is
+        // within epsilon of the face they share
+        int side[3] = { 0, 0, 0 };
+        if(!exact)
+        {
+          const Cell& c = pCells[v];
+          side[0] = side_of(p[0],c.x,epsilon);
+          side[1] = side_of(p[1],c.y,epsilon);
+          side[2] = side_of(p[2],c.z,epsilon);
+        }
+
+        for(int dx = 0; dx <= (side[0] != 0); dx++)
+          for(int dy = 0; dy <= (side[1] != 0); dy++)
+            for(int dz = 0; dz <= (side[2] != 0); dz++)
+            {
+              Cell c = pCells[v];
+              c.x += dx*side[0];
+              c.y += dy*side[1];
+              c.z += dz*side[2];
+              unsigned int b = bucket(c,mask);
+              // bucket entries are sorted by vertex index
+              for(unsigned int i = pBucketBegin[b]; i < pBucketBegin[b+1]; i++)
+              {
+                unsigned int u = pSorted[i];
+                if(u >= first)
+                  break;
+                if(!(pCells[u] == c))
+                  continue;
+                const FT *q = pPoints+3*u;
+                bool close;
+                if(exact)
+                  close = p[0] == q[0] && p[1] == q[1] && p[2] == q[2];
+                else
+                {
+                  double x = p[0]-q[0], y = p[1]-q[1], z = p[2]-q[2];
+                  close = x*x+y*y+z*z <= epsilon2;
+                }
+                if(close)
+                  first = u;
+              }
+            }
+        pFirst[v] = first;
+      }
+    }
+  };
+
+  // cell width in epsilon units
+  enum { CELL_SCALE = 4 };
+
+  std::vector<Cell> m_cells;
+  std::vector<unsigned int> m_buckets;
+  std::vector<unsigned int> m_bucket_begin;
+  std::vector<unsigned int> m_sorted;
+  std::vector<unsigned int> m_first;
+
+public:
+  Vertex_welder() {}
+  ~Vertex_welder() {}
+
+public:
+  // merge the vertices closer than epsilon, returns the
+  // number of removed vertices
+  std::size_t weld(Indexed_mesh<FT>& mesh, double epsilon)
+  {
+    std::size_t nb = mesh.size_of_vertices();
+    if(nb == 0)
+      return 0;
+    if(epsilon < 0.0)
+      epsilon = 0.0;
+
+    // spatial hash, a power of 2 buckets for at least one per vertex
+    unsigned int nb_buckets = 1;
+    while(nb_buckets < nb)
+      nb_buckets <<= 1;
+    m_cells.resize(nb);
+    m_buckets.resize(nb);
+    Cell_locator locator;
+    locator.pPoints = &mesh.points[0];
+    locator.epsilon = epsilon;
+    locator.mask = nb_buckets-1;
+    locator.pCells = &m_cells[0];
+    locator.pBuckets = &m_buckets[0];
+    ParallelUtils::parallel_for(0,nb,locator,1<<14);
+
+    // counting sort of the vertices by bucket, stable so
+    // that every bucket lists its vertices in index order
+    m_bucket_begin.assign(nb_buckets+1,0);
+    for(std::size_t v = 0; v < nb; v++)
+      m_bucket_begin[m_buckets[v]]++;
+    ParallelUtils::prefix_sum(m_bucket_begin);
+    m_sorted.resize(nb);
+    for(std::size_t v = 0; v < nb; v++)
+      m_sorted[m_bucket_begin[m_buckets[v]]++] = (unsigned int)v;
+    // the scatter moved every begin to the next bucket's one
+    for(unsigned int b = nb_buckets; b > 0; b--)
+      m_bucket_begin[b] = m_bucket_begin[b-1];
+    m_bucket_begin[0] = 0;
+
+    m_first.resize(nb);
+    Neighbor_finder finder;
+    finder.pPoints = &mesh.points[0];
+    finder.epsilon = epsilon;
+    finder.mask = nb_buckets-1;
+    finder.pCells = &m_cells[0];
+    finder.pBucketBegin = &m_bucket_begin[0];
+    finder.pSorted = &m_sorted[0];
+    finder.pFirst = &m_first[0];
+    ParallelUtils::parallel_for(0,nb,finder,1<<12);
+
+    // first[v] <= v, so one pass in index order resolves the
+    // representatives, then the kept vertices are renumbered
+    std::vector<int> index(nb);
+    std::size_t nb_kept = 0;
+    for(std::size_t v = 0; v < nb; v++)
+    {
+      unsigned int first = m_first[v];
+      if(first == v)
+      {
+        index[v] = (int)nb_kept;
+        copy_vertex(mesh,v,nb_kept++);
+      }
+      else
+        index[v] = index[first];
+    }
+    mesh.points.resize(3*nb_kept);
+    if(mesh.has_vertex_normals())
+      mesh.vertex_normals.resize(3*nb_kept);
+    if(mesh.has_vertex_colors())
+      mesh.vertex_colors.resize(3*nb_kept);
+
+    remap_facets(mesh,index);
+
+    std::vector<Cell>().swap(m_cells);
+    std::vector<unsigned int>().swap(m_buckets);
+    std::vector<unsigned int>().swap(m_bucket_begin);
+    std::vector<unsigned int>().swap(m_sorted);
+    std::vector<unsigned int>().swap(m_first);
+    return nb - nb_kept;
+  }
+
+private:
+  static Cell cell(const FT *p, double epsilon)
+  {
+    Cell c;
+    if(epsilon > 0.0)
+    {
+      // clamped so that the neighbor cells do not overflow
+      const double limit = 4.0e18;
+      double width = CELL_SCALE*epsilon;
+      c.x = (boost::int64_t)std::max(-limit,std::min(limit,std::floor(p[0]/width)));
+      c.y = (boost::int64_t)std::max(-limit,std::min(limit,std::floor(p[1]/width)));
+      c.z = (boost::int64_t)std::max(-limit,std::min(limit,std::floor(p[2]/width)));
+    }
+    else
+    {
+      // exact match, -0 and +0 share a cell
+      double x = p[0]+0.0, y = p[1]+0.0, z = p[2]+0.0;
+      memcpy(&c.x,&x,sizeof(x));
+      memcpy(&c.y,&y,sizeof(y));
+      memcpy(&c.z,&z,sizeof(z));
+    }
+    return c;
+  }
+
+  // -1 or 1 if x is within epsilon of the low or high face of its cell
+  static int side_of(double x, boost::int64_t cell, double epsilon)
+  {
+    double width = CELL_SCALE*epsilon;
+    double offset = x - (double)cell*width;
+    if(offset < epsilon)
+      return -1;
+    if(width - offset <= epsilon)
+      return 1;
+    return 0;
+  }
+
+  static unsigned int bucket(const Cell& c, unsigned int mask)
+  {
+    boost::uint64_t h = mix((boost::uint64_t)c.x);
+    h = mix(h ^ (boost::uint64_t)c.y);
+    h = mix(h ^ (boost::uint64_t)c.z);
+    return (unsigned int)h & mask;
+  }
+
+  // 64 bits finalizer of MurmurHash3, the exact mode cells are
+  // double bit patterns whose low bits are often all zero
+  static boost::uint64_t mix(boost::uint64_t k)
+  {
+    k ^= k >> 33;
+    k *= 0xFF51AFD7ED558CCDULL;
+    k ^= k >> 33;
+    k *= 0xC4CEB9FE1A85EC53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  // move vertex 'from' and its attributes to slot 'to' <= from
+  static void copy_vertex(Indexed_mesh<FT>& mesh, std::size_t from, std::size_t to)
+  {
+    if(from == to)
+      return;
+    for(int k = 0; k < 3; k++)
+    {
+      mesh.points[3*to+k] = mesh.points[3*from+k];
+      if(mesh.has_vertex_normals())
+        mesh.vertex_normals[3*to+k] = mesh.vertex_normals[3*from+k];
+      if(mesh.has_vertex_colors())
+        mesh.vertex_colors[3*to+k] = mesh.vertex_colors[3*from+k];
+    }
+  }
+
+  // renumber the facet corners in place, dropping repeated
+  // consecutive corners and the facets that collapse
+  static void remap_facets(Indexed_mesh<FT>& mesh, const std::vector<int>& index)
+  {
+    bool control_edges = mesh.has_control_edges();
+    bool facet_normals = mesh.has_facet_normals();
+    std::size_t nb_facets = mesh.size_of_facets();
+    std::size_t out = 0;
+    std::size_t nb_kept = 0;
+    unsigned int last = 0;
+    for(std::size_t f = 0; f < nb_facets; f++)
+    {
+      // facet_begin is rewritten behind the read position
+      unsigned int first = last;
+      last = mesh.facet_begin[f+1];
+      std::size_t start = out;
+      for(unsigned int i = first; i < last; i++)
+      {
+        int v = index[mesh.facet_vertices[i]];
+        if(out > start && mesh.facet_vertices[out-1] == v)
+          continue;
+        mesh.facet_vertices[out] = v;
+        if(control_edges)
+          mesh.control_edges[out] = mesh.control_edges[i];
+        out++;
+      }
+      while(out-start > 1 && mesh.facet_vertices[out-1] == mesh.facet_vertices[start])
+        out--;
+      if(out-start < 3)
+      {
+        out = start;
+        continue;
+      }
+      if(facet_normals)
+        for(int k = 0; k < 3; k++)
+          mesh.facet_normals[3*nb_kept+k] = mesh.facet_normals[3*f+k];
+      mesh.facet_begin[++nb_kept] = (unsigned int)out;
+    }
+    mesh.facet_begin.resize(nb_kept+1);
+    mesh.facet_vertices.resize(out);
+    if(control_edges)
+      mesh.control_edges.resize(out);
+    if(facet_normals)
+      mesh.facet_normals.resize(3*nb_kept);
+  }
+};
+
+#endif
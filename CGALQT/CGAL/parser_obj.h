@@ -2,91 +2,234 @@
 #define PARSEROBJ_H
 
 #include "config.h"
-#include <CGAL/Polyhedron_incremental_builder_3.h>
+#include <vector>
+#include <algorithm>
+#include <deque>
 #include "Enriched_polyhedron.h"
+#include "indexed_mesh.h"
+#include "mesh_weld.h"
+#include "mappedfile.h"
+#include "compressedfile.h"
+#include "numparse.h"
+#include "stringutils.h"
+#include "parallelutils.h"
+#include "mesh_preview.h"
 
-template <class HDS>
-class Builder_obj : public CGAL::Modifier_base<HDS>
+// vertices and facets found in one line-aligned chunk of an obj file
+template <class FT>
+struct Obj_chunk
 {
-private:
-  typedef typename HDS::Vertex::Point Point;
-  typedef typename CGAL::Polyhedron_incremental_builder_3<HDS> Builder;
-  FILE *m_pFile;
+  std::vector<FT> points;
+  std::vector<unsigned int> degrees;
+  // 0-based vertex indices, negative (relative) references are
+  // stored relative to the first vertex of the chunk until merged
+  std::vector<int> indices;
+  std::vector<std::size_t> relative;
+  bool error;
+  // lines before the malformed one, counted from the chunk start
+  std::size_t error_line;
 
-public:
-  Builder_obj(FILE *pFile)
+  Obj_chunk() { error = false; error_line = 0; }
+
+  void swap(Obj_chunk& chunk)
   {
-    m_pFile = pFile;
+    points.swap(chunk.points);
+    degrees.swap(chunk.degrees);
+    indices.swap(chunk.indices);
+    relative.swap(chunk.relative);
+    std::swap(error,chunk.error);
+    std::swap(error_line,chunk.error_line);
   }
-  ~Builder_obj() {}
+};
+
+template <class FT>
+class Obj_chunk_parser
+{
+private:
+  const std::vector<const char*> *m_pBounds;
+  std::vector< Obj_chunk<FT> > *m_pChunks;
+  Mesh_preview *m_pPreview;
 
-  void operator()(HDS& hds)
+public:
+  Obj_chunk_parser(const std::vector<const char*> *pBounds,
+                   std::vector< Obj_chunk<FT> > *pChunks,
+                   Mesh_preview *pPreview = NULL)
   {
-    Builder builder(hds,true);
-    builder.begin_surface(3,1,6);
-      read_vertices(builder);
-      read_facets(builder);
-    builder.end_surface();
+    m_pBounds = pBounds;
+    m_pChunks = pChunks;
+    m_pPreview = pPreview;
   }
 
-private:
-  // read vertex coordinates
-  void read_vertices(Builder &builder)
+  void operator()(std::size_t i)
   {
-    fseek(m_pFile,0,SEEK_SET);
-    char pLine[512];
-    while(fgets(pLine,512,m_pFile))
-      if(pLine[0] == 'v')
-      {
-        float x,y,z;
-        if(sscanf(pLine,"v %f %f %f",&x,&y,&z) == 3)
-          builder.add_vertex(Point(x,y,z));
-      }
+    parse((*m_pBounds)[i],(*m_pBounds)[i+1],(*m_pChunks)[i],m_pPreview);
   }
 
-  // read facets and uv coordinates per halfedge
-  void read_facets(Builder &builder)
+  // the vertices of the chunk go to the preview, if any, as they
+  // are parsed
+  static void parse(const char *p, const char *end, Obj_chunk<FT>& chunk,
+                    Mesh_preview *pPreview = NULL)
   {
-    fseek(m_pFile,0,SEEK_SET);
-    char pLine[512];
-    while(fgets(pLine,512,m_pFile))
-    {
-      char *pTmp = pLine;
-      if(pTmp[0] == 'f')
-      {
-        int index,n;
-        char index_ascii[512],n_ascii[512];
+    const char *begin = p;
+    std::size_t reported = 0;
+    // ~30 bytes per vertex line, ~20 per facet line in typical files
+    chunk.points.reserve((end-p)/10);
+    chunk.indices.reserve((end-p)/8);
+    chunk.degrees.reserve((end-p)/24);
 
-        // create facet        
-        builder.begin_facet();
+    while(p < end)
+    {
+      NumParse::skip_blanks(p,end);
+      if(p+1 >= end)
+        break;
 
-        pTmp += 2; // jump after 'f '
-        if(strstr(pTmp,"//"))
-          while(sscanf(pTmp,"%d//%d",&index,&n))
+      if(p[0] == 'v' && NumParse::is_space(p[1]))
+      {
+        // v x y z [w]
+        p++;
+        double x,y,z;
+        NumParse::skip_spaces(p,end);
+        bool ok = NumParse::parse_double(p,end,x);
+        NumParse::skip_spaces(p,end);
+        ok = ok && NumParse::parse_double(p,end,y);
+        NumParse::skip_spaces(p,end);
+        ok = ok && NumParse::parse_double(p,end,z);
+        if(!ok)
+        {
+          fail(begin,p,chunk);
+          return;
+        }
+        chunk.points.push_back((FT)x);
+        chunk.points.push_back((FT)y);
+        chunk.points.push_back((FT)z);
+        if(pPreview != NULL)
+          pPreview->report(&chunk.points[0],chunk.points.size()/3,reported);
+      }
+      else if(p[0] == 'f' && NumParse::is_space(p[1]))
+      {
+        // f v v/vt v/vt/vn v//vn ...
+        p++;
+        int nb_local = (int)(chunk.points.size()/3);
+        unsigned int degree = 0;
+        for(;;)
+        {
+          NumParse::skip_spaces(p,end);
+          if(p >= end || NumParse::is_eol(*p))
+            break;
+          int index;
+          if(!NumParse::parse_int(p,end,index) || index == 0)
           {
-            itoa(index,index_ascii,10);
-            itoa(n,n_ascii,10);
-            builder.add_vertex_to_facet(index-1);
-            pTmp += (2 + strlen(index_ascii) + strlen(n_ascii));
-            if(strlen(pTmp) < 3)
-              break;
-            else
-              pTmp += 1;
+            fail(begin,p,chunk);
+            return;
           }
-        else
-          while(sscanf(pTmp,"%d",&index))
+          // texture and normal indices are not used
+          NumParse::skip_token(p,end);
+          if(index > 0)
+            chunk.indices.push_back(index-1);
+          else
           {
-            itoa(index,index_ascii,10);
-            pTmp += strlen(index_ascii);
-            builder.add_vertex_to_facet(index-1);
-            if(strlen(pTmp) < 3)
-              break;
-            else
-              pTmp += 1;
+            chunk.relative.push_back(chunk.indices.size());
+            chunk.indices.push_back(nb_local+index);
           }
-        builder.end_facet();
+          degree++;
+        }
+        chunk.degrees.push_back(degree);
       }
+      NumParse::skip_line(p,end);
     }
+    if(pPreview != NULL && !chunk.points.empty())
+      pPreview->report(&chunk.points[0],chunk.points.size()/3,reported,true);
+  }
+
+private:
+  static void fail(const char *begin, const char *p, Obj_chunk<FT>& chunk)
+  {
+    chunk.error = true;
+    chunk.error_line = std::count(begin,p,'\n');
+  }
+};
+
+// copy the chunks into the final arrays, each chunk
+// knows where its vertices, facets and indices go
+template <class FT>
+class Obj_chunk_merger
+{
+private:
+  std::vector< Obj_chunk<FT> > *m_pChunks;
+  const std::vector<std::size_t> *m_pVertexBase;
+  const std::vector<std::size_t> *m_pFacetBase;
+  const std::vector<std::size_t> *m_pIndexBase;
+  Indexed_mesh<FT> *m_pIndexedMesh;
+
+public:
+  Obj_chunk_merger(std::vector< Obj_chunk<FT> > *pChunks,
+                   const std::vector<std::size_t> *pVertexBase,
+                   const std::vector<std::size_t> *pFacetBase,
+                   const std::vector<std::size_t> *pIndexBase,
+                   Indexed_mesh<FT> *pIndexedMesh)
+  {
+    m_pChunks = pChunks;
+    m_pVertexBase = pVertexBase;
+    m_pFacetBase = pFacetBase;
+    m_pIndexBase = pIndexBase;
+    m_pIndexedMesh = pIndexedMesh;
+  }
+
+  void operator()(std::size_t i)
+  {
+    Obj_chunk<FT>& chunk = (*m_pChunks)[i];
+    std::size_t vertex_base = (*m_pVertexBase)[i];
+    std::size_t facet_base = (*m_pFacetBase)[i];
+    std::size_t index_base = (*m_pIndexBase)[i];
+
+    if(!chunk.points.empty())
+      std::copy(chunk.points.begin(),chunk.points.end(),
+                m_pIndexedMesh->points.begin() + 3*vertex_base);
+
+    for(std::size_t k = 0; k < chunk.relative.size(); k++)
+      chunk.indices[chunk.relative[k]] += (int)vertex_base;
+    if(!chunk.indices.empty())
+      std::copy(chunk.indices.begin(),chunk.indices.end(),
+                m_pIndexedMesh->facet_vertices.begin() + index_base);
+
+    unsigned int offset = (unsigned int)index_base;
+    for(std::size_t k = 0; k < chunk.degrees.size(); k++)
+    {
+      m_pIndexedMesh->facet_begin[facet_base+k] = offset;
+      offset += chunk.degrees[k];
+    }
+
+    // release the chunk memory as soon as possible
+    std::vector<FT>().swap(chunk.points);
+    std::vector<int>().swap(chunk.indices);
+    std::vector<unsigned int>().swap(chunk.degrees);
+  }
+};
+
+// parses separate line-aligned pieces of text, one chunk each
+template <class FT>
+class Obj_piece_parser
+{
+private:
+  std::vector< std::vector<char> > *m_pPieces;
+  std::vector< Obj_chunk<FT> > *m_pChunks;
+  Mesh_preview *m_pPreview;
+
+public:
+  Obj_piece_parser(std::vector< std::vector<char> > *pPieces,
+                   std::vector< Obj_chunk<FT> > *pChunks,
+                   Mesh_preview *pPreview = NULL)
+  {
+    m_pPieces = pPieces;
+    m_pChunks = pChunks;
+    m_pPreview = pPreview;
+  }
+
+  void operator()(std::size_t i)
+  {
+    const std::vector<char>& piece = (*m_pPieces)[i];
+    if(!piece.empty())
+      Obj_chunk_parser<FT>::parse(&piece[0],&piece[0]+piece.size(),(*m_pChunks)[i],m_pPreview);
   }
 };
 
@@ -95,21 +238,201 @@ class Parser_obj
 {
 public:
     typedef typename Enriched_polyhedron<kernel,items>::HalfedgeDS HalfedgeDS;
-    Parser_obj() {}
+    typedef typename kernel::FT FT;
+    Parser_obj() { m_pPreview = NULL; }
     ~Parser_obj() {}
 
+    // what went wrong after a failed read, with the line number
+    // when the file is not compressed
+    const std::string& error() const { return m_error; }
+
+    // the chunks pass their vertices to it while they are parsed
+    void set_preview(Mesh_preview *pPreview) { m_pPreview = pPreview; }
+
 public:
+    // with weld_epsilon >= 0 the vertices closer than
+    // weld_epsilon are merged before building the mesh
     bool read(const char*pFilename,
-              Enriched_polyhedron<kernel,items> *pMesh)
+              Enriched_polyhedron<kernel,items> *pMesh,
+              double weld_epsilon = -1.0)
     {
       CGAL_assertion(pMesh != NULL);
-      FILE *pFile = fopen(pFilename,"rt");
-      if(pFile == NULL)
+      Indexed_mesh<FT> indexed_mesh;
+      if(!read(pFilename,indexed_mesh))
         return false;
-      Builder_obj<HalfedgeDS> builder(pFile);
+      if(weld_epsilon >= 0.0)
+      {
+        Vertex_welder<FT> welder;
+        welder.weld(indexed_mesh,weld_epsilon);
+      }
+      Builder_indexed<HalfedgeDS,Indexed_mesh<FT> > builder(&indexed_mesh);
       pMesh->delegate(builder);
-      fclose(pFile);
+      if(builder.error())
+      {
+        m_error = builder.message();
+        return false;
+      }
+      return true;
+    }
+
+    // parse the whole file into flat arrays: the file is mapped
+    // once, cut in line-aligned chunks parsed in parallel, then
+    // the chunks are concatenated in file order
+    bool read(const char*pFilename,
+              Indexed_mesh<FT>& indexed_mesh)
+    {
+      indexed_mesh.clear();
+      m_error.clear();
+      if(Compression::from_filename(pFilename) != Compression::NONE)
+        return read_compressed(pFilename,indexed_mesh);
+      MappedFile file;
+      if(!file.open(pFilename))
+      {
+        m_error = "can not open file";
+        return false;
+      }
+      if(file.size() == 0)
+        return true;
+      return parse(file.begin(),file.end(),indexed_mesh);
+    }
+
+    bool parse(const char *begin,
+               const char *end,
+               Indexed_mesh<FT>& indexed_mesh)
+    {
+      // at least 1MB of text per chunk
+      std::vector<const char*> bounds;
+      std::size_t nb = ParallelUtils::nb_ranges(end-begin,1<<20);
+      MappedFile::split_lines(begin,end,nb,bounds);
+      std::size_t nb_chunks = bounds.size()-1;
+
+      std::vector< Obj_chunk<FT> > chunks(nb_chunks);
+      ParallelUtils::parallel_tasks(nb_chunks,
+        Obj_chunk_parser<FT>(&bounds,&chunks,m_pPreview));
+      if(m_pPreview != NULL)
+        m_pPreview->flush();
+      if(!merge(chunks,indexed_mesh))
+      {
+        // only failed reads pay for counting the lines of the
+        // chunks before the malformed one
+        for(std::size_t i = 0; i < nb_chunks; i++)
+          if(chunks[i].error)
+          {
+            std::size_t line = std::count(begin,bounds[i],'\n') + chunks[i].error_line + 1;
+            m_error = "line " + StringUtils::to_string(line) + ": malformed vertex or facet";
+            break;
+          }
+        return false;
+      }
+      return true;
+    }
+
+private:
+    // .gz and .zst files: the decompression thread fills the next
+    // blocks while the complete lines of the previous ones are
+    // parsed, nb_threads() blocks at a time
+    bool read_compressed(const char*pFilename,
+                         Indexed_mesh<FT>& indexed_mesh)
+    {
+      DecompressingReader reader;
+      if(!reader.open(pFilename))
+      {
+        m_error = "can not open file";
+        return false;
+      }
+
+      std::deque< Obj_chunk<FT> > parsed;
+      std::vector< std::vector<char> > pieces;
+      std::vector<char> block;
+      std::vector<char> tail; // incomplete last line of the previous block
+      bool more = true;
+      while(more)
+      {
+        more = reader.next(block);
+        if(more)
+        {
+          // the piece ends with the last complete line of the block
+          std::size_t length = block.size();
+          while(length > 0 && block[length-1] != '\n')
+            length--;
+          if(length == 0)
+            tail.insert(tail.end(),block.begin(),block.end());
+          else
+          {
+            pieces.push_back(std::vector<char>());
+            std::vector<char>& piece = pieces.back();
+            piece.reserve(tail.size()+length);
+            piece.insert(piece.end(),tail.begin(),tail.end());
+            piece.insert(piece.end(),block.begin(),block.begin()+length);
+            tail.assign(block.begin()+length,block.end());
+          }
+        }
+        else if(!tail.empty())
+          pieces.push_back(tail);
+
+        if(pieces.size() >= ParallelUtils::nb_threads() || (!more && !pieces.empty()))
+        {
+          std::vector< Obj_chunk<FT> > chunks(pieces.size());
+          ParallelUtils::parallel_tasks(pieces.size(),
+            Obj_piece_parser<FT>(&pieces,&chunks,m_pPreview));
+          for(std::size_t i = 0; i < chunks.size(); i++)
+          {
+            parsed.push_back(Obj_chunk<FT>());
+            parsed.back().swap(chunks[i]);
+          }
+          pieces.clear();
+        }
+      }
+      if(m_pPreview != NULL)
+        m_pPreview->flush();
+      if(reader.error())
+      {
+        m_error = "decompression failed";
+        return false;
+      }
+
+      std::vector< Obj_chunk<FT> > chunks(parsed.size());
+      for(std::size_t i = 0; i < chunks.size(); i++)
+        chunks[i].swap(parsed[i]);
+      if(!merge(chunks,indexed_mesh))
+      {
+        m_error = "malformed vertex or facet";
+        return false;
+      }
       return true;
     }
+
+    // concatenate the chunks in order into the indexed mesh
+    bool merge(std::vector< Obj_chunk<FT> >& chunks,
+               Indexed_mesh<FT>& indexed_mesh)
+    {
+      std::size_t nb_chunks = chunks.size();
+      std::vector<std::size_t> vertex_base(nb_chunks);
+      std::vector<std::size_t> facet_base(nb_chunks);
+      std::vector<std::size_t> index_base(nb_chunks);
+      for(std::size_t i = 0; i < nb_chunks; i++)
+      {
+        if(chunks[i].error)
+          return false;
+        vertex_base[i] = chunks[i].points.size()/3;
+        facet_base[i] = chunks[i].degrees.size();
+        index_base[i] = chunks[i].indices.size();
+      }
+      std::size_t nb_vertices = ParallelUtils::prefix_sum(vertex_base);
+      std::size_t nb_facets = ParallelUtils::prefix_sum(facet_base);
+      std::size_t nb_indices = ParallelUtils::prefix_sum(index_base);
+
+      indexed_mesh.points.resize(3*nb_vertices);
+      indexed_mesh.facet_begin.resize(nb_facets+1);
+      indexed_mesh.facet_vertices.resize(nb_indices);
+      ParallelUtils::parallel_tasks(nb_chunks,
+        Obj_chunk_merger<FT>(&chunks,&vertex_base,&facet_base,&index_base,&indexed_mesh));
+      indexed_mesh.facet_begin[nb_facets] = (unsigned int)nb_indices;
+      return true;
+    }
+
+private:
+    Mesh_preview *m_pPreview;
+    std::string m_error;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,247 @@
+#ifndef PARSEROFF_H
+#define PARSEROFF_H
+
+#include "config.h"
+#include <string>
+#include <vector>
+#include "indexed_mesh.h"
+#include "compressedfile.h"
+#include "numparse.h"
+#include "mesh_preview.h"
+#include "stringutils.h"
+
+// OFF, COFF, NOFF, CNOFF and STOFF text files. The header counts
+// size the arrays, records are scanned straight from the mapped
+// file, or from the window of decompressed blocks as they come;
+// colors and texture coordinates are skipped. The vertices go to
+// the preview, if any, as they are read.
+template <class FT>
+class Parser_off
+{
+private:
+  const char *m_p;
+  const char *m_end;
+  InputWindow *m_pWindow;
+  Mesh_preview *m_pPreview;
+  unsigned int m_line;
+  std::string m_error;
+
+public:
+  Parser_off() { m_p = m_end = NULL; m_pWindow = NULL; m_pPreview = NULL; m_line = 1; }
+  ~Parser_off() {}
+
+  // "line n: what went wrong" after a failed read
+  const std::string& error() const { return m_error; }
+
+  void set_preview(Mesh_preview *pPreview) { m_pPreview = pPreview; }
+
+  bool read(const char *pFilename,
+            Indexed_mesh<FT>& indexed_mesh)
+  {
+    indexed_mesh.clear();
+    InputWindow window;
+    if(!window.open(pFilename))
+    {
+      m_error = "can not open file";
+      return false;
+    }
+    m_pWindow = &window;
+    bool ok = parse_records(window.begin(),window.end(),indexed_mesh);
+    m_pWindow = NULL;
+    if(window.eof() && window.error())
+    {
+      m_error = "decompression failed";
+      return false;
+    }
+    return ok;
+  }
+
+  bool parse(const char *begin,
+             const char *end,
+             Indexed_mesh<FT>& indexed_mesh)
+  {
+    m_pWindow = NULL;
+    return parse_records(begin,end,indexed_mesh);
+  }
+
+private:
+  bool parse_records(const char *begin,
+                     const char *end,
+                     Indexed_mesh<FT>& indexed_mesh)
+  {
+    int nb_vertices, nb_facets;
+    bool has_normals;
+    if(!parse_header(begin,end,nb_vertices,nb_facets,has_normals))
+      return false;
+
+    indexed_mesh.reserve(nb_vertices,nb_facets,3*(std::size_t)nb_facets);
+    if(has_normals)
+      indexed_mesh.vertex_normals.reserve(3*(std::size_t)nb_vertices);
+    if(m_pPreview != NULL)
+      m_pPreview->set_size(nb_vertices);
+    std::size_t reported = 0;
+
+    // vertex records: x y z [nx ny nz] [colors] [texture]
+    for(int v = 0; v < nb_vertices; v++)
+    {
+      double x,y,z;
+      if(!next_record() ||
+         !read_double(x) || !read_double(y) || !read_double(z))
+        return fail("expected 3 vertex coordinates");
+      indexed_mesh.points.push_back((FT)x);
+      indexed_mesh.points.push_back((FT)y);
+      indexed_mesh.points.push_back((FT)z);
+      if(has_normals)
+      {
+        if(!read_double(x) || !read_double(y) || !read_double(z))
+          return fail("expected 3 normal coordinates");
+        indexed_mesh.vertex_normals.push_back((FT)x);
+        indexed_mesh.vertex_normals.push_back((FT)y);
+        indexed_mesh.vertex_normals.push_back((FT)z);
+      }
+      skip_line();
+      if(m_pPreview != NULL)
+        m_pPreview->report(&indexed_mesh.points[0],v+1,reported,v+1 == nb_vertices);
+    }
+    if(m_pPreview != NULL)
+      m_pPreview->flush();
+
+    // facet records: n i1 ... in [colors]
+    for(int f = 0; f < nb_facets; f++)
+    {
+      int degree;
+      if(!next_record() || !read_int(degree))
+        return fail("expected facet degree");
+      if(degree < 3)
+        return fail("facet with less than 3 vertices");
+      for(int i = 0; i < degree; i++)
+      {
+        int index;
+        if(!read_int(index))
+          return fail("expected facet vertex index");
+        if(index < 0 || index >= nb_vertices)
+          return fail("vertex index out of range");
+        indexed_mesh.facet_vertices.push_back(index);
+      }
+      indexed_mesh.facet_begin.push_back((unsigned int)indexed_mesh.facet_vertices.size());
+      skip_line();
+    }
+    return true;
+  }
+
+  bool parse_header(const char *begin,
+                   const char *end,
+                   int& nb_vertices,
+                   int& nb_facets,
+                   bool& has_normals)
+  {
+    m_p = begin;
+    m_end = end;
+    m_line = 1;
+    m_error.clear();
+
+    // header: [ST][C][N]OFF keyword, optional for plain OFF
+    has_normals = false;
+    if(!next_record())
+      return fail("empty file");
+    if(!NumParse::is_digit(*m_p))
+    {
+      const char *keyword = m_p;
+      NumParse::skip_token(m_p,m_end);
+      std::string tag(keyword,m_p);
+      if(tag.size() < 3 || tag.compare(tag.size()-3,3,"OFF") != 0)
+        return fail("missing OFF header");
+      std::string flags = tag.substr(0,tag.size()-3);
+      if(flags.find('4') != std::string::npos ||
+         flags.find('n') != std::string::npos)
+        return fail("only 3D OFF files are supported");
+      has_normals = flags.find('N') != std::string::npos;
+      NumParse::skip_spaces(m_p,m_end);
+      if(m_p + 6 <= m_end && std::string(m_p,m_p+6) == "BINARY")
+        return fail("binary OFF files are not supported");
+    }
+
+    // counts: #vertices #facets #edges
+    int nb_edges;
+    if(!next_record() || !read_int(nb_vertices) || !read_int(nb_facets) || !read_int(nb_edges) ||
+       nb_vertices < 0 || nb_facets < 0)
+      return fail("invalid vertex/facet counts");
+    skip_line();
+    return true;
+  }
+
+  bool fail(const char *pMessage)
+  {
+    m_error = "line " + StringUtils::to_string(m_line) + ": " + pMessage;
+    return false;
+  }
+
+  // at least a record ahead in the window, if the file has it
+  void fill()
+  {
+    if(m_pWindow != NULL)
+      m_pWindow->fill(m_p,m_end,InputWindow::MAX_RECORD);
+  }
+
+  // move to the first character of the next record,
+  // skipping blank lines and comments
+  bool next_record()
+  {
+    for(;;)
+    {
+      fill();
+      if(m_p >= m_end)
+        return false;
+      char c = *m_p;
+      if(c == '\n')
+      {
+        m_line++;
+        m_p++;
+      }
+      else if(NumParse::is_space(c) || c == '\r')
+        m_p++;
+      else if(c == '#')
+        skip_line();
+      else
+        return true;
+    }
+  }
+
+  // a line longer than the window is skipped window by window
+  void skip_line()
+  {
+    for(;;)
+    {
+      const char *p = m_p;
+      NumParse::skip_line(m_p,m_end);
+      if(m_p > p && m_p[-1] == '\n')
+      {
+        m_line++;
+        return;
+      }
+      if(m_pWindow == NULL || m_pWindow->eof())
+        return;
+      fill();
+    }
+  }
+
+  // numbers of a record are separated by spaces or tabs only,
+  // the window is refilled within a long facet record
+  bool read_int(int& value)
+  {
+    if(m_end - m_p < 256)
+      fill();
+    NumParse::skip_spaces(m_p,m_end);
+    return NumParse::parse_int(m_p,m_end,value);
+  }
+
+  bool read_double(double& value)
+  {
+    if(m_end - m_p < 256)
+      fill();
+    NumParse::skip_spaces(m_p,m_end);
+    return NumParse::parse_double(m_p,m_end,value);
+  }
+};
+
+#endif
@@ -12,6 +12,10 @@ email                : pierre.alliez@sophia.inria.fr
 #include "config.h"
 #include "enriched_polyhedron.h"
 #include "builder.h"
+#include "parallelutils.h"
+#include "indexed_mesh.h"
+#include <vector>
+#include <string>
 
 // Implemented from:
 // Stam and Loop. Quad/Triangle Subdivision. 
@@ -32,7 +36,7 @@ private:
   typedef typename Vertex::Point        Point;
   typedef typename HDS::Face_handle     Face_handle;
   typedef typename HDS::Halfedge_handle Halfedge_handle;
-  typedef typename CGAL::Enriched_polyhedron_incremental_builder_3<HDS> builder;
+  typedef typename CGAL::Mesh_builder<HDS>::type builder;
   Polyhedron *m_pMesh;
 
 public:
@@ -48,8 +52,48 @@ public:
   // subdivision
   void operator()( HDS& hds)
   {
+    // exact sizes: a vertex per original vertex, per edge and per
+    // non-triangle facet, a triangle gives 4 triangles and a n-gon n
+    // quads, each border halfedge is split in two
+    std::size_t nb_vertices = m_pMesh->size_of_vertices() +
+                              m_pMesh->size_of_halfedges() / 2;
+    std::size_t nb_facets = 0;
+    std::size_t nb_halfedges = 0;
+    std::size_t max_valence = 0;
+    typename Polyhedron::Facet_iterator pFacet;
+    for(pFacet = m_pMesh->facets_begin();
+        pFacet != m_pMesh->facets_end();
+        pFacet++)
+    {
+      std::size_t degree = Polyhedron::degree(pFacet);
+      if(degree == 3)
+      {
+        nb_facets += 4;
+        nb_halfedges += 12;
+      }
+      else
+      {
+        nb_vertices++;
+        nb_facets += degree;
+        nb_halfedges += 4 * degree;
+        max_valence = std::max(max_valence,degree);
+      }
+    }
+    typename Polyhedron::Halfedge_iterator pHalfedge;
+    for(pHalfedge = m_pMesh->halfedges_begin();
+        pHalfedge != m_pMesh->halfedges_end();
+        pHalfedge++)
+      if(pHalfedge->is_border())
+        nb_halfedges += 2;
+    typename Polyhedron::Vertex_iterator pVertex;
+    for(pVertex = m_pMesh->vertices_begin();
+        pVertex != m_pMesh->vertices_end();
+        pVertex++)
+      max_valence = std::max(max_valence,(std::size_t)Polyhedron::valence(pVertex));
+
     builder B(hds,true);
-    B.begin_surface(3,1,6);
+    B.use_edge_map(max_valence > builder::EDGE_MAP_VALENCE);
+    B.begin_surface(nb_vertices,nb_facets,nb_halfedges);
       add_vertices(B);
       add_facets(B);
     B.end_surface();
@@ -60,7 +104,7 @@ public:
   {
     // put original vertices
     int index = 0;
-    Polyhedron::Vertex_iterator pVertex;
+    typename Polyhedron::Vertex_iterator pVertex;
     for(pVertex = m_pMesh->vertices_begin();
         pVertex != m_pMesh->vertices_end();
         pVertex++)
@@ -72,7 +116,7 @@ public:
 
     // as many as #edges
     m_pMesh->tag_halfedges(-1);
-    Polyhedron::Halfedge_iterator pHalfedge;
+    typename Polyhedron::Halfedge_iterator pHalfedge;
     for(pHalfedge = m_pMesh->halfedges_begin();
         pHalfedge != m_pMesh->halfedges_end();
         pHalfedge++)
@@ -96,7 +140,7 @@ public:
 
     // and as many as #facets with degree > 3
     m_pMesh->tag_facets(-1);
-    Polyhedron::Facet_iterator pFacet;
+    typename Polyhedron::Facet_iterator pFacet;
     for(pFacet = m_pMesh->facets_begin();
         pFacet != m_pMesh->facets_end();
         pFacet++)
@@ -120,7 +164,7 @@ public:
   // add facets
   void add_facets(builder &B)
   {
-    Polyhedron::Facet_iterator pFacet;
+    typename Polyhedron::Facet_iterator pFacet;
     for(pFacet = m_pMesh->facets_begin();
         pFacet != m_pMesh->facets_end();
         pFacet++)
@@ -130,7 +174,7 @@ public:
 
       if(degree == 3)
       {
-        Polyhedron::Halfedge_handle pHalfedge = pFacet->halfedge();
+        typename Polyhedron::Halfedge_handle pHalfedge = pFacet->halfedge();
         int i0 = pHalfedge->tag();
         int i1 = pHalfedge->vertex()->tag();
         int i2 = pHalfedge->next()->tag();
@@ -207,7 +251,7 @@ public:
         CGAL_assertion(i1 >= 0);
 
         // for each halfedge
-        Polyhedron::Halfedge_around_facet_circulator h;
+        typename Polyhedron::Halfedge_around_facet_circulator h;
         h = pFacet->facet_begin();
         do
         {
@@ -262,135 +306,398 @@ public:
     return 0.0f;
   }
   
-  // smooth vertex positions
+  // smooth vertex positions, the vertices are split in ranges over
+  // the threads of ParallelUtils, each writes its own part of pPos
   static void smooth(Polyhedron *pMesh,
                      bool smooth_boundary = true)
   {
     CGAL_assertion(pMesh != NULL);
 
-    // alloc position vectors
+    // the vertices by index, the list is walked once
     unsigned int nb_vertices = pMesh->size_of_vertices();
-    kernel::FT *pPos = new kernel::FT[3*nb_vertices];
-    CGAL_assertion(pPos != NULL);
-
-    // compute new positions
-    unsigned int index = 0;
-    Polyhedron::Vertex_iterator pVertex;
+    std::vector<typename Polyhedron::Vertex_handle> vertices;
+    vertices.reserve(nb_vertices);
+    typename Polyhedron::Vertex_iterator pVertex;
     for(pVertex = pMesh->vertices_begin();
         pVertex != pMesh->vertices_end();
         pVertex++)
+      vertices.push_back(pVertex);
+
+    // alloc position vectors
+    typename kernel::FT *pPos = new typename kernel::FT[3*nb_vertices];
+    CGAL_assertion(pPos != NULL);
+
+    // compute new positions
+    Smoother smoother;
+    smoother.pMesh = pMesh;
+    smoother.pVertices = nb_vertices ? &vertices[0] : NULL;
+    smoother.pPos = pPos;
+    smoother.smooth_boundary = smooth_boundary;
+    ParallelUtils::parallel_for(0,nb_vertices,smoother,1<<12);
+
+    // set new positions, on one thread: with CGAL::Cartesian the
+    // points share reference counted coordinates
+    for(unsigned int index = 0; index < nb_vertices; index++)
     {
-      // border vertices will not move
-      if(Polyhedron::is_border(pVertex))
+      Point& point = vertices[index]->point();
+      point = Point(pPos[3*index],
+                    pPos[3*index+1],
+                    pPos[3*index+2]);
+    }
+
+    // cleanup
+    CGALQT_DELETE_ARRAY(pPos);
+  }
+
+private:
+  // the new positions of the vertices [begin,end), the mesh is only read
+  struct Smoother
+  {
+    Polyhedron *pMesh;
+    const typename Polyhedron::Vertex_handle *pVertices;
+    typename kernel::FT *pPos;
+    bool smooth_boundary;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t index = begin; index < end; index++)
+        smooth_vertex(pMesh,pVertices[index],smooth_boundary,&pPos[3*index]);
+    }
+  };
+
+  // new position of pVertex into pPos[0..2]
+  static void smooth_vertex(Polyhedron *pMesh,
+                            typename Polyhedron::Vertex_handle pVertex,
+                            bool smooth_boundary,
+                            typename kernel::FT *pPos)
+  {
+    // border vertices will not move
+    if(Polyhedron::is_border(pVertex))
+    {
+      // do not smooth it
+      const Point& curr = pVertex->point();
+      if(!smooth_boundary)
       {
-        // do not smooth it
-        const Point& curr = pVertex->point();
-        if(!smooth_boundary)
-        {
-          pPos[3*index]   = curr.x();
-          pPos[3*index+1] = curr.y();
-          pPos[3*index+2] = curr.z();
-        }
-        // smooth using [1/4 1/2 1/4] cubic B-spline averaging mask
-        else 
-        {
-          const Polyhedron::Halfedge_handle& pHalfedge =
-            pMesh->get_border_halfedge(pVertex);
-          CGAL_assertion(pHalfedge != NULL);
-          const Point& next = pHalfedge->next()->vertex()->point();
-          const Point& prev = pHalfedge->prev()->vertex()->point();
-          pPos[3*index]   = 0.25f*prev.x() + 0.5f*curr.x() + 0.25f*next.x();
-          pPos[3*index+1] = 0.25f*prev.y() + 0.5f*curr.y() + 0.25f*next.y();
-          pPos[3*index+2] = 0.25f*prev.z() + 0.5f*curr.z() + 0.25f*next.z();
-        }
-      } // end is border
-      else
+        pPos[0] = curr.x();
+        pPos[1] = curr.y();
+        pPos[2] = curr.z();
+      }
+      // smooth using [1/4 1/2 1/4] cubic B-spline averaging mask
+      else 
       {
+        const typename Polyhedron::Halfedge_handle& pHalfedge =
+          pMesh->get_border_halfedge(pVertex);
+        CGAL_assertion(pHalfedge != NULL);
+        const Point& next = pHalfedge->next()->vertex()->point();
+        const Point& prev = pHalfedge->prev()->vertex()->point();
+        pPos[0] = 0.25f*prev.x() + 0.5f*curr.x() + 0.25f*next.x();
+        pPos[1] = 0.25f*prev.y() + 0.5f*curr.y() + 0.25f*next.y();
+        pPos[2] = 0.25f*prev.z() + 0.5f*curr.z() + 0.25f*next.z();
+      }
+      return;
+    }
 
-        unsigned int nb_quads = 0;
-        unsigned int nb_edges = 0;
+    unsigned int nb_quads = 0;
+    unsigned int nb_edges = 0;
+
+    // rotate around vertex to count #edges and #quads
+    typename Polyhedron::Halfedge_around_vertex_circulator
+      pHalfEdge = pVertex->vertex_begin();
+    typename Polyhedron::Halfedge_around_vertex_circulator end = pHalfEdge;
+    CGAL_For_all(pHalfEdge,end)
+    {
+      const typename Polyhedron::Facet_handle& pFacet = pHalfEdge->facet();
+      CGAL_assertion(pFacet != NULL);
+      unsigned int degree = Polyhedron::degree(pFacet);
+      CGAL_assertion(degree == 4 || degree == 3);
+      if(degree == 4)
+        nb_quads++;
+      nb_edges++;
+    }
+
+    // compute coefficients
+    typename kernel::FT ne = (typename kernel::FT)nb_edges;
+    typename kernel::FT nq = (typename kernel::FT)nb_quads;
+    typename kernel::FT alpha = 1.0f / (1.0f + ne/2.0f + nq/4.0f);
+    typename kernel::FT beta = alpha / 2.0f;  // edges
+    typename kernel::FT gamma = alpha / 4.0f; // corners of incident quads
+    typename kernel::FT eta = correcting_factor(nb_edges,nb_quads);
+
+    // new position
+    pPos[0] = alpha * pVertex->point().x();
+    pPos[1] = alpha * pVertex->point().y();
+    pPos[2] = alpha * pVertex->point().z();
+
+    // rotate around vertex to compute new position
+    pHalfEdge = pVertex->vertex_begin();
+    end = pHalfEdge;
+    CGAL_For_all(pHalfEdge,end)
+    {
+      const typename Polyhedron::Facet_handle& pFacet = pHalfEdge->facet();
+      CGAL_assertion(pFacet != NULL);
+      unsigned int degree = Polyhedron::degree(pFacet);
+      CGAL_assertion(degree == 4 || degree == 3);
 
-        // rotate around vertex to count #edges and #quads
-        Polyhedron::Halfedge_around_vertex_circulator
-          pHalfEdge = pVertex->vertex_begin();
-        Polyhedron::Halfedge_around_vertex_circulator end = pHalfEdge;
-        CGAL_For_all(pHalfEdge,end)
+      // add edge-vertex contribution
+      const Point& point = pHalfEdge->prev()->vertex()->point();
+      pPos[0] += beta * point.x();
+      pPos[1] += beta * point.y();
+      pPos[2] += beta * point.z();
+
+      // add corner vertex contribution
+      if(degree == 4)
+      {
+        const Point& corner = pHalfEdge->next()->next()->vertex()->point();
+        pPos[0] += gamma * corner.x();
+        pPos[1] += gamma * corner.y();
+        pPos[2] += gamma * corner.z();
+      }
+    }
+
+    // apply correction
+    pPos[0] = pPos[0] + eta*(pPos[0]-pVertex->point().x());
+    pPos[1] = pPos[1] + eta*(pPos[1]-pVertex->point().y());
+    pPos[2] = pPos[2] + eta*(pPos[2]-pVertex->point().z());
+  }
+};
+
+// One refinement level into flat arrays, without the incremental
+// builder: the output sizes follow from the facet degrees, each facet
+// gets its range of new facets, indices and barycenter by prefix sums,
+// then the points and facets are written over the threads of
+// ParallelUtils. The vertices, facets and control edges come in the
+// order CModifierQuadTriangle adds them.
+template <class Polyhedron,class kernel>
+class CRefinerQuadTriangle
+{
+public:
+  typedef typename kernel::FT FT;
+  typedef Indexed_mesh<FT> Mesh_arrays;
+
+private:
+  typedef typename Polyhedron::Point Point;
+  typedef typename Polyhedron::Vertex_handle Vertex_handle;
+  typedef typename Polyhedron::Halfedge_handle Halfedge_handle;
+  typedef typename Polyhedron::Facet_handle Facet_handle;
+
+  // the original vertices first
+  struct Vertex_copier
+  {
+    const Vertex_handle *pVertices;
+    FT *pPoints;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t v = begin; v < end; v++)
+      {
+        const Point& point = pVertices[v]->point();
+        pPoints[3*v]   = point.x();
+        pPoints[3*v+1] = point.y();
+        pPoints[3*v+2] = point.z();
+      }
+    }
+  };
+
+  // then one per edge, simple edge bisection
+  struct Edge_splitter
+  {
+    const Halfedge_handle *pEdges;
+    FT *pPoints;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t e = begin; e < end; e++)
+      {
+        const Point& p1 = pEdges[e]->vertex()->point();
+        const Point& p2 = pEdges[e]->opposite()->vertex()->point();
+        pPoints[3*e]   = 0.5f*(p1.x()+p2.x());
+        pPoints[3*e+1] = 0.5f*(p1.y()+p2.y());
+        pPoints[3*e+2] = 0.5f*(p1.z()+p2.z());
+      }
+    }
+  };
+
+  // the new facets of [begin,end): a triangle is 1-to-4 subdivided,
+  // a n-gon gets its barycenter (the points from first_center on) and
+  // n quads around it
+  struct Facet_refiner
+  {
+    Polyhedron *pMesh;
+    const Facet_handle *pFacets;
+    const unsigned int *pFirstFacet;
+    const unsigned int *pFirstIndex;
+    const unsigned int *pFirstCenter;
+    unsigned int first_center;
+    FT *pPoints;
+    unsigned int *pFacetBegin;
+    int *pIndices;
+    unsigned char *pControls;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t f = begin; f < end; f++)
+      {
+        Facet_handle pFacet = pFacets[f];
+        unsigned int facet = pFirstFacet[f];
+        unsigned int index = pFirstIndex[f];
+        if(Polyhedron::degree(pFacet) == 3)
         {
-          const Polyhedron::Facet_handle& pFacet = pHalfEdge->facet();
-          CGAL_assertion(pFacet != NULL);
-          unsigned int degree = Polyhedron::degree(pFacet);
-          CGAL_assertion(degree == 4 || degree == 3);
-          if(degree == 4)
-            nb_quads++;
-          nb_edges++;
+          Halfedge_handle pHalfedge = pFacet->halfedge();
+          int i0 = pHalfedge->tag();
+          int i1 = pHalfedge->vertex()->tag();
+          int i2 = pHalfedge->next()->tag();
+          int i3 = pHalfedge->next()->vertex()->tag();
+          int i4 = pHalfedge->next()->next()->tag();
+          int i5 = pHalfedge->next()->next()->vertex()->tag();
+          bool c0 = pHalfedge->control_edge();
+          bool c1 = pHalfedge->next()->control_edge();
+          bool c2 = pHalfedge->next()->next()->control_edge();
+          add_triangle(facet,index,i1,i2,i0,c0,c1,false);
+          add_triangle(facet,index,i3,i4,i2,c1,c2,false);
+          add_triangle(facet,index,i5,i0,i4,c2,c0,false);
+          // center face
+          add_triangle(facet,index,i0,i2,i4,false,false,false);
         }
-
-        // compute coefficients
-        kernel::FT ne = (kernel::FT)nb_edges;
-        kernel::FT nq = (kernel::FT)nb_quads;
-        kernel::FT alpha = 1.0f / (1.0f + ne/2.0f + nq/4.0f);
-        kernel::FT beta = alpha / 2.0f;  // edges
-        kernel::FT gamma = alpha / 4.0f; // corners of incident quads
-        kernel::FT eta = correcting_factor(nb_edges,nb_quads);
-
-        // new position
-        pPos[3*index]   = alpha * pVertex->point().x();
-        pPos[3*index+1] = alpha * pVertex->point().y();
-        pPos[3*index+2] = alpha * pVertex->point().z();
-
-        // rotate around vertex to compute new position
-        pHalfEdge = pVertex->vertex_begin();
-        end = pHalfEdge;
-        CGAL_For_all(pHalfEdge,end)
+        else
         {
-          const Polyhedron::Facet_handle& pFacet = pHalfEdge->facet();
-          CGAL_assertion(pFacet != NULL);
-          unsigned int degree = Polyhedron::degree(pFacet);
-          CGAL_assertion(degree == 4 || degree == 3);
-
-          // add edge-vertex contribution
-          const Point& point = pHalfEdge->prev()->vertex()->point();
-          pPos[3*index]   += beta * point.x();
-          pPos[3*index+1] += beta * point.y();
-          pPos[3*index+2] += beta * point.z();
-
-          // add corner vertex contribution
-          if(degree == 4)
+          // i1: index of barycenter vertex
+          unsigned int i1 = first_center + pFirstCenter[f];
+          Point barycenter;
+          pMesh->compute_facet_center(pFacet,barycenter);
+          pPoints[3*i1]   = barycenter.x();
+          pPoints[3*i1+1] = barycenter.y();
+          pPoints[3*i1+2] = barycenter.z();
+
+          // a quad per halfedge, i2,3,4: indices of three consecutive
+          // vertices on halfedges
+          typename Polyhedron::Halfedge_around_facet_circulator h;
+          h = pFacet->facet_begin();
+          do
           {
-            const Point& corner = pHalfEdge->next()->next()->vertex()->point();
-            pPos[3*index]   += gamma * corner.x();
-            pPos[3*index+1] += gamma * corner.y();
-            pPos[3*index+2] += gamma * corner.z();
+            pIndices[index]   = h->vertex()->tag();
+            pIndices[index+1] = h->next()->tag();
+            pIndices[index+2] = (int)i1;
+            pIndices[index+3] = h->tag();
+            pControls[index]   = h->control_edge() ? 1 : 0;
+            pControls[index+1] = h->next()->control_edge() ? 1 : 0;
+            pControls[index+2] = 0;
+            pControls[index+3] = 0;
+            index += 4;
+            pFacetBegin[++facet] = index;
           }
+          while(++h != pFacet->facet_begin());
         }
+      }
+    }
 
-        // apply correction
-        pPos[3*index] = pPos[3*index] +
-          eta*(pPos[3*index]-pVertex->point().x());
-        pPos[3*index+1] = pPos[3*index+1] +
-          eta*(pPos[3*index+1]-pVertex->point().y());
-        pPos[3*index+2] = pPos[3*index+2] +
-          eta*(pPos[3*index+2]-pVertex->point().z());
-
-      } // end !is border
-      index++;
+    // the control edge flags go to the halfedges pointing to a, b and c
+    void add_triangle(unsigned int& facet, unsigned int& index,
+                      int a, int b, int c, bool ca, bool cb, bool cc)
+    {
+      pIndices[index]   = a;
+      pIndices[index+1] = b;
+      pIndices[index+2] = c;
+      pControls[index]   = ca ? 1 : 0;
+      pControls[index+1] = cb ? 1 : 0;
+      pControls[index+2] = cc ? 1 : 0;
+      index += 3;
+      pFacetBegin[++facet] = index;
     }
+  };
 
-    // set new positions
-    index = 0;
-    for(pVertex = pMesh->vertices_begin();
-        pVertex != pMesh->vertices_end();
+public:
+  // 'mesh' refined once into 'arrays', its vertex and halfedge tags
+  // are overwritten with the indices of the new vertices
+  static void refine(Polyhedron& mesh, Mesh_arrays& arrays)
+  {
+    // the handles by index, the lists are walked once
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_edges = mesh.size_of_halfedges() / 2;
+    std::size_t nb_facets = mesh.size_of_facets();
+    std::vector<Vertex_handle> vertices;
+    std::vector<Halfedge_handle> edges;
+    std::vector<Facet_handle> facets;
+    vertices.reserve(nb_vertices);
+    edges.reserve(nb_edges);
+    facets.reserve(nb_facets);
+
+    int index = 0;
+    typename Polyhedron::Vertex_iterator pVertex;
+    for(pVertex = mesh.vertices_begin();
+        pVertex != mesh.vertices_end();
         pVertex++)
     {
-      Point& point = pVertex->point();
-      point = Point(pPos[3*index],
-                    pPos[3*index+1],
-                    pPos[3*index+2]);
+      pVertex->tag(index++);
+      vertices.push_back(pVertex);
+    }
+    typename Polyhedron::Edge_iterator pEdge;
+    for(pEdge = mesh.edges_begin();
+        pEdge != mesh.edges_end();
+        pEdge++)
+    {
+      pEdge->tag(index);
+      pEdge->opposite()->tag(index);
       index++;
+      edges.push_back(pEdge);
     }
 
-    // cleanup
-    CGALQT_DELETE_ARRAY(pPos);
+    // 4 triangles for a triangle, n quads and a barycenter for a n-gon
+    std::vector<unsigned int> first_facet(nb_facets);
+    std::vector<unsigned int> first_index(nb_facets);
+    std::vector<unsigned int> first_center(nb_facets);
+    typename Polyhedron::Facet_iterator pFacet;
+    for(pFacet = mesh.facets_begin();
+        pFacet != mesh.facets_end();
+        pFacet++)
+    {
+      std::size_t f = facets.size();
+      unsigned int degree = Polyhedron::degree(pFacet);
+      CGAL_assertion(degree >= 3);
+      first_facet[f] = degree == 3 ? 4 : degree;
+      first_index[f] = degree == 3 ? 12 : 4*degree;
+      first_center[f] = degree == 3 ? 0 : 1;
+      facets.push_back(pFacet);
+    }
+    std::size_t nb_new_facets = ParallelUtils::prefix_sum(first_facet);
+    std::size_t nb_indices = ParallelUtils::prefix_sum(first_index);
+    std::size_t nb_centers = ParallelUtils::prefix_sum(first_center);
+    // V' = V + E + F - F3
+    CGAL_assertion(nb_centers == nb_facets - mesh.size_of_facets_of_degree(3));
+    std::size_t nb_new_vertices = nb_vertices + nb_edges + nb_centers;
+
+    arrays.clear();
+    arrays.points.resize(3*nb_new_vertices);
+    arrays.facet_begin.resize(nb_new_facets+1,0);
+    arrays.facet_vertices.resize(nb_indices);
+    arrays.control_edges.resize(nb_indices);
+    if(nb_new_vertices == 0)
+      return;
+    FT *pPoints = &arrays.points[0];
+
+    Vertex_copier copier;
+    copier.pVertices = nb_vertices ? &vertices[0] : NULL;
+    copier.pPoints = pPoints;
+    ParallelUtils::parallel_for(0,nb_vertices,copier,1<<14);
+
+    Edge_splitter splitter;
+    splitter.pEdges = nb_edges ? &edges[0] : NULL;
+    splitter.pPoints = pPoints + 3*nb_vertices;
+    ParallelUtils::parallel_for(0,nb_edges,splitter,1<<14);
+
+    if(nb_facets == 0)
+      return;
+    Facet_refiner refiner;
+    refiner.pMesh = &mesh;
+    refiner.pFacets = &facets[0];
+    refiner.pFirstFacet = &first_facet[0];
+    refiner.pFirstIndex = &first_index[0];
+    refiner.pFirstCenter = &first_center[0];
+    refiner.first_center = (unsigned int)(nb_vertices + nb_edges);
+    refiner.pPoints = pPoints;
+    refiner.pFacetBegin = &arrays.facet_begin[0];
+    refiner.pIndices = &arrays.facet_vertices[0];
+    refiner.pControls = &arrays.control_edges[0];
+    ParallelUtils::parallel_for(0,nb_facets,refiner,1<<12);
   }
 };
 
@@ -407,9 +714,18 @@ class CSubdivider_quad_triangle
                    Polyhedron &NewMesh,
                    const bool smooth_boundary = true)
     {
-      // subdivide, then smooth
+      // subdivide into arrays, build in bulk, then smooth. A mesh
+      // the bulk construction refuses (a vertex joining two fans)
+      // goes through the incremental builder
+      typename CRefinerQuadTriangle<Polyhedron,kernel>::Mesh_arrays arrays;
+      CRefinerQuadTriangle<Polyhedron,kernel>::refine(OriginalMesh,arrays);
+      std::string error;
       CModifierQuadTriangle<HalfedgeDS,Polyhedron,kernel> builder(&OriginalMesh);
-      NewMesh.delegate(builder);
+      if(!NewMesh.build(arrays,error))
+      {
+        NewMesh.clear();
+        NewMesh.delegate(builder);
+      }
       builder.smooth(&NewMesh,smooth_boundary);
     }
 };
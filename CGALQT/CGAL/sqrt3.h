@@ -3,6 +3,13 @@
 
 #include "config.h"
 #include "Enriched_polyhedron.h"
+#include "indexed_mesh.h"
+#include "parallelutils.h"
+#include "color.h"
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
 
 template <class Polyhedron,class kernel>
 class CSubdivider_sqrt3
@@ -35,16 +42,618 @@ class CSubdivider_sqrt3
 
       for(int i=0;i<iter;i++)
       {
-        // subdivision
-        subdivide(P);
+        // subdivision, the boundary every other step
+        bool border = (i & 1) != 0;
+        if(refine(P,border))
+          continue;
 
-        // boundary subdivision   
-        if(i & 1)
+        // a vertex refine() refuses, flip the edges
+        subdivide(P);
+        if(border)
           subdivide_border(P);
       }
       return true;
     }
 
+  private:
+    typedef typename kernel::FT FT;
+    typedef typename Polyhedron::Vertex_handle Vertex_handle;
+    typedef typename Polyhedron::Facet_handle Facet_handle;
+    typedef typename Polyhedron::Halfedge_iterator Halfedge_iterator;
+    typedef typename Polyhedron::Halfedge_around_vertex_circulator HV_mutable_circulator;
+    enum { NONE = Mesh_halfedges::NONE };
+
+    // the new mesh of a step in arrays: the old vertices, one center per
+    // facet and on a border step two vertices per border edge, then two
+    // triangles per interior edge (the flipped one), one per border edge
+    // or three on a border step
+    struct Refinement
+    {
+      Indexed_mesh<FT> arrays;
+      std::vector<unsigned char> selected;
+    };
+
+    // A step of subdivide() and subdivide_border() leaves the items in an
+    // order refine() writes directly. create_center_vertex() joins the
+    // vertex of each halfedge h of a facet, from the halfedge of the
+    // facet, to the center by a spoke; the triangle of h is appended but
+    // the first one, which keeps the facet. The flip of the interior edge
+    // a->b between the centers c and d, in edge order, turns the triangle
+    // of a->b into d,b,c with halfedge c->d and the one of b->a into c,a,d
+    // with halfedge d->c, and gives a and b the spokes c->a and d->b. The
+    // border step trisects the border halfedge p->q of each border edge,
+    // in edge order, next to q first: the triangle keeps c,q,x1 with
+    // halfedge x1->c, then c,x1,x2 and x2,p,c are appended. Polyhedron_3
+    // erases the flipped edge and the facet of b->a and appends the new
+    // ones, Enriched_surface_mesh puts them back in their place.
+    //
+    // The old halfedges are numbered in iteration order by tag(), the
+    // edge iterator gives the lower one of each edge. The spoke of corner
+    // g, the g-th halfedge around the facets, is the new halfedge
+    // spoke_base+2g towards the center and the next one back. The
+    // triangles get slots in creation order, a facet is the rank of its
+    // slot among the ones kept.
+    struct Step
+    {
+      bool in_place;
+      bool border;
+      std::size_t nb_facets;
+      unsigned int first_center;
+      unsigned int first_split;
+      unsigned int spoke_base;
+      unsigned int flip_base;
+      unsigned int split_base;
+      unsigned int first_flip_facet;
+      unsigned int first_split_facet;
+      const Facet_handle *pFacets;
+      const Halfedge_handle *pEdges;
+      const Halfedge_handle *pBorders;
+      // by facet, then the border edges before an edge
+      const unsigned int *pFirstCorner;
+      const unsigned int *pFirstBorder;
+      // by old halfedge: its corner, new number and edge
+      unsigned int *pCorner;
+      unsigned int *pOut;
+      unsigned int *pEdge;
+      // kept or not by slot, then the facet
+      unsigned int *pSlot;
+      FT *pPoints;
+      int *pIndices;
+      unsigned char *pSelected;
+      Mesh_halfedges *pConnectivity;
+
+      unsigned int spoke(unsigned int g) const { return spoke_base + 2*g; }
+      unsigned int spoke_back(unsigned int g) const { return spoke_base + 2*g + 1; }
+
+      // the slot of the triangle of corner g of facet f
+      unsigned int slot(unsigned int g, unsigned int f) const
+      {
+        return g == pFirstCorner[f] ? f : (unsigned int)nb_facets + g - f - 1;
+      }
+
+      // the facet of the triangle of the old halfedge h
+      unsigned int facet(Halfedge_handle h) const
+      {
+        return pSlot[slot(pCorner[h->tag()],(unsigned int)h->facet()->tag())];
+      }
+
+      // facet f from its halfedge h0 pointing to v0, then h1 and h2
+      void add_triangle(unsigned int f,
+                        unsigned int h0, int v0,
+                        unsigned int h1, int v1,
+                        unsigned int h2, int v2,
+                        unsigned char selected)
+      {
+        Mesh_halfedges& m = *pConnectivity;
+        pIndices[3*f]   = v0;
+        pIndices[3*f+1] = v1;
+        pIndices[3*f+2] = v2;
+        m.next[h0] = h1;
+        m.next[h1] = h2;
+        m.next[h2] = h0;
+        m.vertex[h0] = (unsigned int)v0;
+        m.vertex[h1] = (unsigned int)v1;
+        m.vertex[h2] = (unsigned int)v2;
+        m.facet[h0] = m.facet[h1] = m.facet[h2] = f;
+        m.facet_halfedge[f] = h0;
+        pSelected[f] = selected;
+      }
+
+      void add_border(unsigned int h, int v, unsigned int next)
+      {
+        Mesh_halfedges& m = *pConnectivity;
+        m.next[h] = next;
+        m.vertex[h] = (unsigned int)v;
+        m.facet[h] = NONE;
+      }
+    };
+
+    struct Facet_degrees
+    {
+      const Facet_handle *pFacets;
+      unsigned int *pDegrees;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t f = begin; f < end; f++)
+          pDegrees[f] = (unsigned int)pFacets[f]->facet_degree();
+      }
+    };
+
+    // the centers, as create_center_vertex() puts them, with the corners
+    // and the triangle slots of their facets
+    struct Facet_centers
+    {
+      Step *pStep;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        Step& s = *pStep;
+        for(std::size_t f = begin; f < end; f++)
+        {
+          Facet_handle pFacet = s.pFacets[f];
+          unsigned int g = s.pFirstCorner[f];
+          Vector vec( 0.0, 0.0, 0.0);
+          std::size_t order = 0;
+          HF_circulator h = pFacet->facet_begin();
+          do {
+              vec = vec + ( h->vertex()->point() - CGAL::ORIGIN);
+              ++ order;
+              // Polyhedron_3 erases the triangle of the second halfedge
+              // of an interior edge
+              Halfedge_handle o = h->opposite();
+              s.pCorner[h->tag()] = g;
+              s.pSlot[s.slot(g,(unsigned int)f)] =
+                s.in_place || o->is_border() || h->tag() < o->tag() ? 1 : 0;
+              g++;
+          } while ( ++h != pFacet->facet_begin());
+          CGAL_assertion( order >= 3);
+          unsigned int center = s.first_center + (unsigned int)f;
+          set_point(&s.pPoints[3*center],CGAL::ORIGIN + (vec / (FT)order));
+          s.pConnectivity->vertex_halfedge[center] = s.spoke(s.pFirstCorner[f]);
+        }
+      }
+    };
+
+    // the new numbers of the old halfedges: the same in place, else the
+    // border edges first and the flipped ones after the spokes
+    struct Edge_halfedges
+    {
+      Step *pStep;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        Step& s = *pStep;
+        Mesh_halfedges& m = *s.pConnectivity;
+        for(std::size_t i = begin; i < end; i++)
+        {
+          Halfedge_handle e = s.pEdges[i];
+          unsigned int h = (unsigned int)e->tag();
+          unsigned int g = (unsigned int)e->opposite()->tag();
+          unsigned int nb_borders = s.pFirstBorder[i];
+          unsigned int first = h, second = g;
+          if(!s.in_place)
+          {
+            first = e->is_border_edge() ? 2*nb_borders :
+                    s.flip_base + 2*((unsigned int)i - nb_borders);
+            second = first + 1;
+          }
+          s.pOut[h] = first;
+          s.pOut[g] = second;
+          s.pEdge[h] = s.pEdge[g] = (unsigned int)i;
+          m.opposite[first] = second;
+          m.opposite[second] = first;
+        }
+      }
+    };
+
+    // the old vertices smoothed as Smooth_old_vertex does, walking the
+    // umbrella of the unrefined mesh from the same halfedge: the old
+    // neighbors come in the same order. The border vertices follow
+    // smooth_border_vertices() on a border step and stay on the others.
+    // Each range counts the halfedges it circulates and the vertices with
+    // several holes.
+    struct Old_vertices
+    {
+      Step *pStep;
+      const Vertex_handle *pVertices;
+      const FT *pAlpha;
+      std::size_t nb_alpha;
+      std::size_t *pHalfedges;
+      std::size_t *pNonManifold;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t range)
+      {
+        Step& s = *pStep;
+        FT *pPoints = s.pPoints;
+        std::size_t nb_halfedges = 0, nb_non_manifold = 0;
+        for(std::size_t v = begin; v < end; v++)
+        {
+          Vertex_handle pVertex = pVertices[v];
+          const Point& point = pVertex->point();
+          std::size_t degree = 0, nb_borders = 0;
+          unsigned int last = NONE;
+          HV_mutable_circulator pBorder, pLast;
+          HV_mutable_circulator h = pVertex->vertex_begin();
+          do {
+              if(h->is_border())
+              {
+                pBorder = h;
+                nb_borders++;
+              }
+              else if(!h->opposite()->is_border())
+              {
+                unsigned int edge = (unsigned int)std::min(h->tag(),h->opposite()->tag());
+                if(last == NONE || edge > last)
+                {
+                  last = edge;
+                  pLast = h;
+                }
+              }
+              degree++;
+          } while ( ++h != pVertex->vertex_begin());
+          nb_halfedges += degree;
+
+          // the border halfedge on a border step, else the spoke the flip
+          // of the last interior edge gives
+          unsigned int halfedge;
+          if(s.border && nb_borders == 1)
+            halfedge = s.pOut[pBorder->tag()];
+          else if(last != NONE)
+            halfedge = s.spoke_back(s.pCorner[pLast->opposite()->prev()->tag()]);
+          else
+            halfedge = s.pOut[pVertex->halfedge()->tag()];
+          s.pConnectivity->vertex_halfedge[v] = halfedge;
+
+          if(nb_borders > 1)
+          {
+            nb_non_manifold++;
+            set_point(&pPoints[3*v],point);
+          }
+          else if(nb_borders == 1)
+          {
+            if(!s.border)
+            {
+              set_point(&pPoints[3*v],point);
+              continue;
+            }
+            Vector v0 = pBorder->opposite()->vertex()->point() - CGAL::ORIGIN;
+            Vector v1 = point - CGAL::ORIGIN;
+            Vector v2 = pBorder->next()->vertex()->point() - CGAL::ORIGIN;
+            set_point(&pPoints[3*v],CGAL::ORIGIN + ( 4.0 * v0 + 19.0 * v1 +  4.0 * v2) / 27.0);
+          }
+          else
+          {
+            FT alpha = degree < nb_alpha ? pAlpha[degree] : smoothing_weight(degree);
+            Vector vec = (point - CGAL::ORIGIN) * ( 1.0f - alpha);
+            h = pVertex->vertex_begin();
+            do {
+                vec = vec + ( h->opposite()->vertex()->point() - CGAL::ORIGIN)
+                  * alpha / (FT)degree;
+            } while ( ++h != pVertex->vertex_begin());
+            set_point(&pPoints[3*v],CGAL::ORIGIN + vec);
+          }
+        }
+        pHalfedges[range] = nb_halfedges;
+        pNonManifold[range] = nb_non_manifold;
+      }
+    };
+
+    // the border step trisects the border halfedge u->w of each border
+    // edge: x1 next to w, then x2 next to u
+    struct Border_vertices
+    {
+      Step *pStep;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        Step& s = *pStep;
+        for(std::size_t b = begin; b < end; b++)
+        {
+          Halfedge_handle e = s.pBorders[b];
+          Vector t = e->prev()->opposite()->vertex()->point() - CGAL::ORIGIN;
+          Vector u = e->opposite()->vertex()->point() - CGAL::ORIGIN;
+          Vector w = e->vertex()->point() - CGAL::ORIGIN;
+          Vector z = e->next()->vertex()->point() - CGAL::ORIGIN;
+          unsigned int x1 = s.first_split + 2*(unsigned int)b;
+          set_point(&s.pPoints[3*x1],CGAL::ORIGIN + (10.0 * u + 16.0 * w +        z) / 27.0);
+          set_point(&s.pPoints[3*x1+3],CGAL::ORIGIN + (       t + 16.0 * u + 10.0 * w) / 27.0);
+          // x1 gets the inner halfedge w->x1, x2 the new x1->x2
+          s.pConnectivity->vertex_halfedge[x1] = s.pOut[e->opposite()->tag()];
+          s.pConnectivity->vertex_halfedge[x1+1] = s.split_base + 8*(unsigned int)b;
+        }
+      }
+    };
+
+    // the triangles of the edges [begin,end) and their border halfedges,
+    // the selection of their facets goes with them the way the edge flips
+    // copy it
+    struct Edge_triangles
+    {
+      Step *pStep;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        Step& s = *pStep;
+        for(std::size_t i = begin; i < end; i++)
+        {
+          Halfedge_handle e = s.pEdges[i];
+          unsigned int nb_borders = s.pFirstBorder[i];
+          if(!e->is_border_edge())
+          {
+            // a->b between the centers c and d, flipped to c-d
+            Halfedge_handle o = e->opposite();
+            int a = o->vertex()->tag();
+            int b = e->vertex()->tag();
+            int c = (int)s.first_center + e->facet()->tag();
+            int d = (int)s.first_center + o->facet()->tag();
+            unsigned char selected = e->facet()->selected() ? 1 : 0;
+            unsigned int flipped = s.in_place ? s.facet(o) :
+                                   s.first_flip_facet + (unsigned int)i - nb_borders;
+            s.add_triangle(s.facet(e),
+                           s.pOut[e->tag()],d,
+                           s.spoke_back(s.pCorner[o->prev()->tag()]),b,
+                           s.spoke(s.pCorner[e->tag()]),c,selected);
+            s.add_triangle(flipped,
+                           s.pOut[o->tag()],c,
+                           s.spoke_back(s.pCorner[e->prev()->tag()]),a,
+                           s.spoke(s.pCorner[o->tag()]),d,selected);
+            continue;
+          }
+
+          // the inner halfedge w->u in the facet of c, the border one u->w
+          Halfedge_handle h = e->is_border() ? e->opposite() : e;
+          Halfedge_handle g = h->opposite();
+          int u = h->vertex()->tag();
+          int w = g->vertex()->tag();
+          int c = (int)s.first_center + h->facet()->tag();
+          unsigned char selected = h->facet()->selected() ? 1 : 0;
+          unsigned int inner = s.pOut[h->tag()];
+          unsigned int outer = s.pOut[g->tag()];
+          unsigned int to_c = s.spoke(s.pCorner[h->tag()]);
+          unsigned int from_c = s.spoke_back(s.pCorner[h->prev()->tag()]);
+          if(!s.border)
+          {
+            s.add_triangle(s.facet(h),inner,u,to_c,c,from_c,w,selected);
+            s.add_border(outer,w,s.pOut[g->next()->tag()]);
+            continue;
+          }
+
+          // u->x2->x1->w, the new edges x1->x2, x2->u, x1->c and x2->c
+          // in that order, each from the halfedge named
+          int x1 = (int)(s.first_split + 2*nb_borders);
+          int x2 = x1 + 1;
+          unsigned int n = s.split_base + 8*nb_borders;
+          unsigned int f = s.first_split_facet + 2*nb_borders;
+          s.add_triangle(s.facet(h),n+4,c,from_c,w,inner,x1,selected);
+          s.add_triangle(f,n+6,c,n+5,x1,n,x2,selected);
+          s.add_triangle(f+1,n+7,x2,n+2,u,to_c,c,selected);
+          unsigned int next = s.pFirstBorder[s.pEdge[g->next()->tag()]];
+          s.add_border(outer,w,s.split_base + 8*next + 3);
+          s.add_border(n+3,x2,n+1);
+          s.add_border(n+1,x1,outer);
+        }
+      }
+    };
+
+    enum { MAX_ALPHA = 64 };
+
+    static void set_point(FT *pPoint, const Point& point)
+    {
+      pPoint[0] = point.x();
+      pPoint[1] = point.y();
+      pPoint[2] = point.z();
+    }
+
+  public:
+    // alpha of Smooth_old_vertex for an old vertex of valence degree
+    static FT smoothing_weight(std::size_t degree)
+    {
+      return (4.0f - 2.0f * (FT)cos( 2.0f * PI / (FT)degree)) / 9.0f;
+    }
+
+    // one step written into arrays and their connectivity, then built in
+    // place of P: the points, the order of the vertices, edges and facets
+    // and the halfedge of each are the ones subdivide() and
+    // subdivide_border() leave (Step). The vertex, halfedge and facet
+    // tags are overwritten. False with P untouched if P has a vertex on
+    // several holes or joining several fans.
+    bool refine(Polyhedron& P, bool border)
+    {
+      // the handles by index, the lists are walked once
+      std::size_t nb_vertices = P.size_of_vertices();
+      std::size_t nb_facets = P.size_of_facets();
+      std::size_t nb_halfedges = P.size_of_halfedges();
+      std::size_t nb_edges = nb_halfedges / 2;
+      std::vector<Vertex_handle> vertices;
+      std::vector<Facet_handle> facets;
+      std::vector<Halfedge_handle> edges;
+      std::vector<Halfedge_handle> borders;
+      vertices.reserve(nb_vertices);
+      facets.reserve(nb_facets);
+      edges.reserve(nb_edges);
+
+      int index = 0;
+      for(Vertex_iterator pVertex = P.vertices_begin();
+          pVertex != P.vertices_end();
+          pVertex++)
+      {
+        pVertex->tag(index++);
+        vertices.push_back(pVertex);
+      }
+      index = 0;
+      for(Facet_iterator pFacet = P.facets_begin();
+          pFacet != P.facets_end();
+          pFacet++)
+      {
+        pFacet->tag(index++);
+        facets.push_back(pFacet);
+      }
+      index = 0;
+      for(Halfedge_iterator pHalfedge = P.halfedges_begin();
+          pHalfedge != P.halfedges_end();
+          pHalfedge++)
+        pHalfedge->tag(index++);
+
+      std::vector<unsigned int> first_border(nb_edges);
+      for(Edge_iterator pEdge = P.edges_begin();
+          pEdge != P.edges_end();
+          pEdge++)
+      {
+        bool border_edge = pEdge->is_border_edge();
+        first_border[edges.size()] = border_edge ? 1 : 0;
+        edges.push_back(pEdge);
+        if(border && border_edge)
+          borders.push_back(pEdge->is_border() ? pEdge : pEdge->opposite());
+      }
+      std::size_t nb_border_edges = ParallelUtils::prefix_sum(first_border);
+
+      const std::size_t grain = 1 << 12;
+      std::vector<unsigned int> first_corner(nb_facets+1,0);
+      Facet_degrees degrees;
+      degrees.pFacets = &facets[0];
+      degrees.pDegrees = &first_corner[0];
+      ParallelUtils::parallel_for(0,nb_facets,degrees,grain);
+      std::size_t nb_corners = ParallelUtils::prefix_sum(first_corner);
+
+      // 2 triangles per interior edge, 1 or 3 per border edge
+      std::size_t nb_splits = borders.size();
+      std::size_t nb_new_vertices = nb_vertices + nb_facets + 2*nb_splits;
+      std::size_t nb_new_facets = nb_corners + 2*nb_splits;
+      std::size_t nb_new_halfedges = nb_halfedges + 2*nb_corners + 8*nb_splits;
+      if(nb_new_halfedges >= NONE)
+        return false;
+
+      // the smoothing weights of the usual valences
+      FT alpha[MAX_ALPHA];
+      alpha[0] = (FT)0;
+      for(std::size_t degree = 1; degree < MAX_ALPHA; degree++)
+        alpha[degree] = smoothing_weight(degree);
+
+      Refinement refinement;
+      Indexed_mesh<FT>& arrays = refinement.arrays;
+      arrays.points.resize(3*nb_new_vertices);
+      arrays.facet_begin.resize(nb_new_facets+1);
+      for(std::size_t f = 0; f <= nb_new_facets; f++)
+        arrays.facet_begin[f] = (unsigned int)(3*f);
+      arrays.facet_vertices.resize(3*nb_new_facets);
+      refinement.selected.resize(nb_new_facets);
+      Mesh_halfedges connectivity;
+      connectivity.next.resize(nb_new_halfedges);
+      connectivity.opposite.resize(nb_new_halfedges);
+      connectivity.vertex.resize(nb_new_halfedges);
+      connectivity.facet.resize(nb_new_halfedges);
+      connectivity.vertex_halfedge.resize(nb_new_vertices);
+      connectivity.facet_halfedge.resize(nb_new_facets);
+      std::vector<unsigned int> corner(nb_halfedges), out(nb_halfedges), edge(nb_halfedges);
+      std::vector<unsigned int> slot(nb_corners);
+
+      Step step;
+      step.in_place = Polyhedron::FLIPS_IN_PLACE != 0;
+      step.border = border;
+      step.nb_facets = nb_facets;
+      step.first_center = (unsigned int)nb_vertices;
+      step.first_split = (unsigned int)(nb_vertices + nb_facets);
+      step.spoke_base = (unsigned int)(step.in_place ? nb_halfedges : 2*nb_border_edges);
+      step.flip_base = (unsigned int)(2*nb_border_edges + 2*nb_corners);
+      step.split_base = (unsigned int)(nb_halfedges + 2*nb_corners);
+      step.first_flip_facet = (unsigned int)(nb_corners - (nb_edges - nb_border_edges));
+      step.first_split_facet = (unsigned int)nb_corners;
+      step.pFacets = &facets[0];
+      step.pEdges = &edges[0];
+      step.pBorders = borders.empty() ? NULL : &borders[0];
+      step.pFirstCorner = &first_corner[0];
+      step.pFirstBorder = &first_border[0];
+      step.pCorner = &corner[0];
+      step.pOut = &out[0];
+      step.pEdge = &edge[0];
+      step.pSlot = &slot[0];
+      step.pPoints = &arrays.points[0];
+      step.pIndices = &arrays.facet_vertices[0];
+      step.pSelected = &refinement.selected[0];
+      step.pConnectivity = &connectivity;
+
+      Facet_centers centers;
+      centers.pStep = &step;
+      ParallelUtils::parallel_for(0,nb_facets,centers,grain);
+      ParallelUtils::prefix_sum(slot);
+      Edge_halfedges numbers;
+      numbers.pStep = &step;
+      ParallelUtils::parallel_for(0,nb_edges,numbers,grain);
+
+      std::size_t nb_ranges = ParallelUtils::nb_ranges(nb_vertices,grain);
+      std::vector<std::size_t> halfedges(nb_ranges,0);
+      std::vector<std::size_t> non_manifold(nb_ranges,0);
+      Old_vertices smoother;
+      smoother.pStep = &step;
+      smoother.pVertices = nb_vertices ? &vertices[0] : NULL;
+      smoother.pAlpha = alpha;
+      smoother.nb_alpha = MAX_ALPHA;
+      smoother.pHalfedges = &halfedges[0];
+      smoother.pNonManifold = &non_manifold[0];
+      ParallelUtils::parallel_for(0,nb_vertices,smoother,grain);
+      std::size_t nb_circulated = 0;
+      for(std::size_t r = 0; r < nb_ranges; r++)
+      {
+        nb_circulated += halfedges[r];
+        if(non_manifold[r] > 0)
+          return false;
+      }
+      // the umbrellas do not cover a vertex joining several fans
+      if(nb_circulated != nb_halfedges)
+        return false;
+
+      Border_vertices trisection;
+      trisection.pStep = &step;
+      ParallelUtils::parallel_for(0,nb_splits,trisection,grain);
+
+      Edge_triangles triangles;
+      triangles.pStep = &step;
+      ParallelUtils::parallel_for(0,nb_edges,triangles,grain);
+      // the spokes and the edges of the border step come in pairs
+      for(std::size_t h = step.spoke_base; h < step.spoke_base + 2*nb_corners; h++)
+        connectivity.opposite[h] = (unsigned int)(h ^ 1);
+      for(std::size_t h = step.split_base; h < nb_new_halfedges; h++)
+        connectivity.opposite[h] = (unsigned int)(h ^ 1);
+
+      // a new vertex copies the color of an old one: a center the one of
+      // the halfedge of its facet, x1 and x2 the one of u
+      if(P.has_vertex_colors())
+      {
+        arrays.vertex_colors.resize(3*nb_new_vertices);
+        for(std::size_t v = 0; v < nb_new_vertices; v++)
+        {
+          Vertex_handle pVertex;
+          if(v < nb_vertices)
+            pVertex = vertices[v];
+          else if(v < nb_vertices + nb_facets)
+            pVertex = facets[v-nb_vertices]->halfedge()->vertex();
+          else
+            pVertex = borders[(v-nb_vertices-nb_facets)/2]->opposite()->vertex();
+          CColor color = P.vertex_color(pVertex);
+          arrays.vertex_colors[3*v]   = color.r();
+          arrays.vertex_colors[3*v+1] = color.g();
+          arrays.vertex_colors[3*v+2] = color.b();
+        }
+      }
+
+      vertices.clear();
+      facets.clear();
+      edges.clear();
+      borders.clear();
+      std::string error;
+      P.clear();
+      bool ok = P.build(arrays,error,&connectivity);
+      CGAL_assertion(ok);
+      std::size_t f = 0;
+      for(Facet_iterator pFacet = P.facets_begin();
+          pFacet != P.facets_end();
+          pFacet++, f++)
+        pFacet->selected(refinement.selected[f] != 0);
+      return ok;
+    }
+
+  public:
     // Flip edge
     void flip_edge(Polyhedron& P, Halfedge_handle e)
     {
@@ -131,7 +740,7 @@ class CSubdivider_sqrt3
               smooth_border_vertices( e, std::back_inserter(pts));
       } while ( e++ != last_e);
       e = P.edges_begin(); // copy smoothed points back
-      std::vector<Point>::iterator i = pts.begin();
+      typename std::vector<Point>::iterator i = pts.begin();
       do {
           if ( e->opposite()->is_border()) {
               e->vertex()->point() = *i++;
@@ -159,7 +768,7 @@ class CSubdivider_sqrt3
           ++ order;
       } while ( ++h != f->facet_begin());
       CGAL_assertion( order >= 3); // guaranteed by definition of Polyhedron
-      Point center =  CGAL::ORIGIN + (vec / (kernel::FT)order);
+      Point center =  CGAL::ORIGIN + (vec / (typename kernel::FT)order);
       Halfedge_handle new_center = P.create_center_vertex( f->halfedge());
       new_center->vertex()->point() = center;
     }
@@ -172,7 +781,7 @@ class CSubdivider_sqrt3
             if ( degree & 1) // odd degree only at border vertices
                 return v.point();
             degree = degree / 2;
-            kernel::FT alpha = (4.0f - 2.0f * (kernel::FT)cos( 2.0f * PI / (kernel::FT)degree)) / 9.0f;
+            typename kernel::FT alpha = (4.0f - 2.0f * (typename kernel::FT)cos( 2.0f * PI / (typename kernel::FT)degree)) / 9.0f;
             Vector vec = (v.point() - CGAL::ORIGIN) * ( 1.0f - alpha);
             HV_circulator h = v.vertex_begin();
             do {
@@ -185,7 +794,7 @@ class CSubdivider_sqrt3
                     return v.point();
                 }
                 vec = vec + ( h->opposite()->vertex()->point() - CGAL::ORIGIN)
-                  * alpha / (kernel::FT)degree;
+                  * alpha / (typename kernel::FT)degree;
                 ++ h;
                 CGAL_assertion( h != v.vertex_begin()); // even degree guaranteed
                 ++ h;
@@ -195,7 +804,7 @@ class CSubdivider_sqrt3
     };    
 
     template <class OutputIterator>
-    void smooth_border_vertices(typename Halfedge_handle e,
+    void smooth_border_vertices(Halfedge_handle e,
                                 OutputIterator out)
     {
         CGAL_precondition( e->is_border());
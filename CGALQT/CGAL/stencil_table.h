@@ -0,0 +1,670 @@
+/***************************************************************************
+stencil_table.h  -  refined vertices as weights over the control vertices
+----------------------------------------------------------------------------
+Loop, Catmull-Clark, quad/triangle and sqrt(3) are linear in the vertex
+positions and their weights only depend on the topology. A Stencil_table
+keeps, for each vertex of a refined level, the sparse weights of the
+control vertices it is made of, in compressed rows. CStencil_builder
+subdivides a mesh level by level, writes the rows of each level over the
+vertices of the previous one, and composes them with the rows found so
+far, so the table of level N reads the control vertices directly. Moving
+control vertices then only takes one parallel sparse product instead of
+all the levels again; the refined mesh keeps its topology.
+***************************************************************************/
+
+#ifndef STENCIL_TABLE_H
+#define STENCIL_TABLE_H
+
+#include "config.h"
+#include "parallelutils.h"
+#include "sqrt3.h"
+#include "quad-triangle.h"
+#include "subdivision.h"
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+
+template <class FT>
+class Stencil_table
+{
+public:
+  // vertex i is the sum of weights[k] * control[indices[k]]
+  // for k in [row_begin[i],row_begin[i+1])
+  std::vector<unsigned int> row_begin;
+  std::vector<int> indices;
+  std::vector<FT> weights;
+
+public:
+  Stencil_table() : m_nb_controls(0) { clear(); }
+  ~Stencil_table() {}
+
+  void clear()
+  {
+    row_begin.assign(1,0);
+    indices.clear();
+    weights.clear();
+    m_nb_controls = 0;
+  }
+
+  void swap(Stencil_table& table)
+  {
+    row_begin.swap(table.row_begin);
+    indices.swap(table.indices);
+    weights.swap(table.weights);
+    std::swap(m_nb_controls,table.m_nb_controls);
+  }
+
+  std::size_t size_of_rows() const { return row_begin.size()-1; }
+  std::size_t size_of_controls() const { return m_nb_controls; }
+  std::size_t size_of_weights() const { return weights.size(); }
+
+  // each of the n controls as itself
+  void identity(std::size_t n)
+  {
+    clear();
+    m_nb_controls = n;
+    for(std::size_t i = 0; i < n; i++)
+    {
+      add((int)i,(FT)1);
+      end_row();
+    }
+  }
+
+  // rows are written one after the other, an index may come twice
+  void begin_rows(std::size_t nb_controls)
+  {
+    clear();
+    m_nb_controls = nb_controls;
+  }
+  void add(int index, FT weight)
+  {
+    indices.push_back(index);
+    weights.push_back(weight);
+  }
+  void end_row() { row_begin.push_back((unsigned int)indices.size()); }
+
+  // x,y,z of the rows from the x,y,z of the controls
+  void apply(const FT *pControls, FT *pPoints) const
+  {
+    if(size_of_rows() == 0)
+      return;
+    Evaluator evaluator;
+    evaluator.pRowBegin = &row_begin[0];
+    evaluator.pIndices = indices.empty() ? NULL : &indices[0];
+    evaluator.pWeights = weights.empty() ? NULL : &weights[0];
+    evaluator.pControls = pControls;
+    evaluator.pPoints = pPoints;
+    ParallelUtils::parallel_for(0,size_of_rows(),evaluator,1<<12);
+  }
+
+  // the rows of 'level', over the rows of this table, written over
+  // the controls of this table into 'result'
+  void compose(const Stencil_table& level, Stencil_table& result) const
+  {
+    CGAL_assertion(level.size_of_controls() == size_of_rows());
+    std::size_t nb_rows = level.size_of_rows();
+    result.clear();
+    result.m_nb_controls = m_nb_controls;
+    result.row_begin.resize(nb_rows+1,0);
+    if(nb_rows == 0)
+      return;
+
+    // each range merges its rows into its own buffer, the buffers are
+    // copied in place once the row sizes are summed
+    const std::size_t grain = 1 << 10;
+    std::vector<Stencil_table> buffers(ParallelUtils::nb_ranges(nb_rows,grain));
+    Composer composer;
+    composer.pTable = this;
+    composer.pLevel = &level;
+    composer.pBuffers = &buffers[0];
+    composer.pRowSizes = &result.row_begin[0];
+    ParallelUtils::parallel_for(0,nb_rows,composer,grain);
+
+    std::size_t nb_weights = ParallelUtils::prefix_sum(result.row_begin);
+    result.row_begin[nb_rows] = (unsigned int)nb_weights;
+    result.indices.resize(nb_weights);
+    result.weights.resize(nb_weights);
+    if(nb_weights == 0)
+      return;
+    Copier copier;
+    copier.pBuffers = &buffers[0];
+    copier.pRowBegin = &result.row_begin[0];
+    copier.pIndices = &result.indices[0];
+    copier.pWeights = &result.weights[0];
+    ParallelUtils::parallel_for(0,nb_rows,copier,grain);
+  }
+
+  std::size_t bytes() const
+  {
+    return row_begin.capacity()*sizeof(unsigned int) +
+           indices.capacity()*sizeof(int) +
+           weights.capacity()*sizeof(FT);
+  }
+
+private:
+  // the rows [begin,end), three sums over a contiguous run of weights
+  struct Evaluator
+  {
+    const unsigned int *pRowBegin;
+    const int *pIndices;
+    const FT *pWeights;
+    const FT *pControls;
+    FT *pPoints;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t i = begin; i < end; i++)
+      {
+        FT x = 0, y = 0, z = 0;
+        unsigned int last = pRowBegin[i+1];
+        for(unsigned int k = pRowBegin[i]; k < last; k++)
+        {
+          const FT *pControl = &pControls[3*pIndices[k]];
+          FT w = pWeights[k];
+          x += w * pControl[0];
+          y += w * pControl[1];
+          z += w * pControl[2];
+        }
+        pPoints[3*i]   = x;
+        pPoints[3*i+1] = y;
+        pPoints[3*i+2] = z;
+      }
+    }
+  };
+
+  // products of a level row with the rows it names, summed by control
+  // in a dense row of the range, into the buffer of the range by index
+  struct Composer
+  {
+    const Stencil_table *pTable;
+    const Stencil_table *pLevel;
+    Stencil_table *pBuffers;
+    unsigned int *pRowSizes;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      Stencil_table& buffer = pBuffers[range];
+      std::vector<FT> sums(pTable->size_of_controls(),(FT)0);
+      std::vector<unsigned char> used(pTable->size_of_controls(),0);
+      std::vector<int> controls;
+      for(std::size_t i = begin; i < end; i++)
+      {
+        controls.clear();
+        for(unsigned int k = pLevel->row_begin[i]; k < pLevel->row_begin[i+1]; k++)
+        {
+          int j = pLevel->indices[k];
+          FT w = pLevel->weights[k];
+          for(unsigned int l = pTable->row_begin[j]; l < pTable->row_begin[j+1]; l++)
+          {
+            int index = pTable->indices[l];
+            if(!used[index])
+            {
+              used[index] = 1;
+              controls.push_back(index);
+            }
+            sums[index] += w * pTable->weights[l];
+          }
+        }
+        std::sort(controls.begin(),controls.end());
+
+        std::size_t size = buffer.indices.size();
+        for(std::size_t c = 0; c < controls.size(); c++)
+        {
+          int index = controls[c];
+          if(sums[index] != 0)
+            buffer.add(index,sums[index]);
+          sums[index] = 0;
+          used[index] = 0;
+        }
+        pRowSizes[i] = (unsigned int)(buffer.indices.size() - size);
+      }
+    }
+  };
+
+  struct Copier
+  {
+    const Stencil_table *pBuffers;
+    const unsigned int *pRowBegin;
+    int *pIndices;
+    FT *pWeights;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t range)
+    {
+      const Stencil_table& buffer = pBuffers[range];
+      std::copy(buffer.indices.begin(),buffer.indices.end(),pIndices + pRowBegin[begin]);
+      std::copy(buffer.weights.begin(),buffer.weights.end(),pWeights + pRowBegin[begin]);
+      CGAL_assertion(pRowBegin[begin] + buffer.indices.size() == pRowBegin[end]);
+    }
+  };
+
+private:
+  std::size_t m_nb_controls;
+};
+
+/************************************************************************/
+/* the tables of the subdivision schemes                                */
+/************************************************************************/
+template <class Polyhedron,class kernel>
+class CStencil_builder
+{
+public:
+  typedef typename kernel::FT FT;
+  typedef Stencil_table<FT> Table;
+
+  enum Scheme { LOOP, CATMULL_CLARK, QUAD_TRIANGLE, SQRT3 };
+
+private:
+  typedef CSubdivision_level<Polyhedron,kernel> Level;
+  typedef typename Polyhedron::Vertex_handle Vertex_handle;
+  typedef typename Polyhedron::Halfedge_handle Halfedge_handle;
+  typedef typename Polyhedron::Facet_handle Facet_handle;
+  typedef typename Polyhedron::Vertex_iterator Vertex_iterator;
+  typedef typename Polyhedron::Edge_iterator Edge_iterator;
+  typedef typename Polyhedron::Facet_iterator Facet_iterator;
+  typedef typename Polyhedron::Halfedge_around_vertex_circulator HV_circulator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator HF_circulator;
+  typedef CModifierQuadTriangle<typename Polyhedron::HalfedgeDS,Polyhedron,kernel> Quad_triangle;
+
+public:
+  CStencil_builder() : m_smooth_boundary(true) {}
+  ~CStencil_builder() {}
+
+  // the quad/triangle border rule, as CSubdivider_quad_triangle has it
+  void smooth_boundary(bool smooth) { m_smooth_boundary = smooth; }
+
+  // P subdivided 'levels' times in place the way the subdividers do it,
+  // 'table' gives its vertices from the points P had, in vertex order.
+  // False if a level cannot be built (a vertex joining several fans),
+  // P then holds the levels done and 'table' is empty.
+  bool build(Polyhedron& P, Scheme scheme, int levels, Table& table)
+  {
+    table.identity(P.size_of_vertices());
+    if(P.size_of_facets() == 0)
+      return levels == 0;
+    if(scheme == SQRT3)
+      P.normalize_border();
+
+    for(int i = 0; i < levels; i++)
+    {
+      bool ok = false;
+      switch(scheme)
+      {
+      case LOOP: ok = loop_level(P); break;
+      case CATMULL_CLARK: ok = catmull_clark_level(P); break;
+      case QUAD_TRIANGLE: ok = quad_triangle_level(P,table); break;
+      case SQRT3: ok = sqrt3_level(P,(i & 1) != 0); break;
+      }
+      if(!ok)
+      {
+        table.clear();
+        return false;
+      }
+      table.compose(m_rows,m_composed);
+      table.swap(m_composed);
+    }
+    return true;
+  }
+
+  // the refined mesh of 'table' moved to new control points,
+  // see set_points() in indexed_mesh.h
+  static void evaluate(const Table& table, const std::vector<FT>& controls,
+                       Polyhedron& refined, std::vector<FT>& points)
+  {
+    CGAL_assertion(controls.size() == 3*table.size_of_controls());
+    points.resize(3*table.size_of_rows());
+    if(!points.empty())
+      table.apply(&controls[0],&points[0]);
+    set_points(refined,points);
+  }
+
+private:
+  // the umbrellas cover the halfedges, the bulk constructions take P
+  static bool is_fan_manifold(Polyhedron& P)
+  {
+    std::size_t nb_halfedges = 0;
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+    {
+      HV_circulator h = pVertex->vertex_begin();
+      do {
+          nb_halfedges++;
+      } while(++h != pVertex->vertex_begin());
+    }
+    return nb_halfedges == P.size_of_halfedges();
+  }
+
+  void add_facet(Facet_handle pFacet, FT weight)
+  {
+    HF_circulator h = pFacet->facet_begin();
+    do {
+        m_rows.add(h->vertex()->tag(),weight);
+    } while(++h != pFacet->facet_begin());
+  }
+
+  // border_node() of the Loop and Catmull-Clark masks for the vertex
+  // of h, the inner halfedge of a border edge
+  void add_border_node(Halfedge_handle h)
+  {
+    m_rows.add(h->opposite()->prev()->opposite()->vertex()->tag(),(FT)1/8);
+    m_rows.add(h->vertex()->tag(),(FT)6/8);
+    m_rows.add(h->opposite()->vertex()->tag(),(FT)1/8);
+  }
+
+  // the inner halfedge of a border edge ending at each border vertex
+  void find_borders(std::vector<Halfedge_handle>& borders)
+  {
+    borders.assign(m_level.vertices.size(),Halfedge_handle());
+    for(std::size_t e = m_level.nb_interior_edges; e < m_level.edges.size(); e++)
+      borders[m_level.edges[e]->vertex()->tag()] = m_level.edges[e];
+  }
+
+  // the old vertices then the edges, as CSubdivider_loop puts them
+  bool loop_level(Polyhedron& P)
+  {
+    m_level.gather(P);
+    m_rows.begin_rows(m_level.vertices.size());
+    std::vector<Halfedge_handle> borders;
+    find_borders(borders);
+    for(std::size_t v = 0; v < m_level.vertices.size(); v++)
+    {
+      if(borders[v] != Halfedge_handle())
+        add_border_node(borders[v]);
+      else
+      {
+        Vertex_handle pVertex = m_level.vertices[v];
+        std::size_t n = Polyhedron::valence(pVertex);
+        FT self, other;
+        if(n == 6)
+        {
+          self = (FT)10/16;
+          other = (FT)1/16;
+        }
+        else
+        {
+          FT Cn = (FT) (5.0/8.0 - std::sqrt(3+2*std::cos(6.283/n))/64.0);
+          FT Sw = n*(1-Cn)/Cn;
+          FT W = n/Cn;
+          self = Sw/W;
+          other = 1/W;
+        }
+        m_rows.add(pVertex->tag(),self);
+        HV_circulator h = pVertex->vertex_begin();
+        do {
+            m_rows.add(h->opposite()->vertex()->tag(),other);
+        } while(++h != pVertex->vertex_begin());
+      }
+      m_rows.end_row();
+    }
+    for(std::size_t e = 0; e < m_level.edges.size(); e++)
+    {
+      Halfedge_handle edge = m_level.edges[e];
+      if(e < m_level.nb_interior_edges)
+      {
+        m_rows.add(edge->vertex()->tag(),(FT)3/8);
+        m_rows.add(edge->opposite()->vertex()->tag(),(FT)3/8);
+        m_rows.add(edge->next()->vertex()->tag(),(FT)1/8);
+        m_rows.add(edge->opposite()->next()->vertex()->tag(),(FT)1/8);
+      }
+      else
+      {
+        m_rows.add(edge->vertex()->tag(),(FT)1/2);
+        m_rows.add(edge->opposite()->vertex()->tag(),(FT)1/2);
+      }
+      m_rows.end_row();
+    }
+    return m_loop.subdivide(P,1);
+  }
+
+  // the old vertices, the edges then the facets, as
+  // CSubdivider_catmull_clark puts them
+  bool catmull_clark_level(Polyhedron& P)
+  {
+    m_level.gather(P);
+    m_rows.begin_rows(m_level.vertices.size());
+    std::vector<Halfedge_handle> borders;
+    find_borders(borders);
+    for(std::size_t v = 0; v < m_level.vertices.size(); v++)
+    {
+      if(borders[v] != Halfedge_handle())
+        add_border_node(borders[v]);
+      else
+      {
+        // (Q + 2R + (n-3)S)/n, R the mean of the edge midpoints and
+        // Q the mean of the facet points
+        Vertex_handle pVertex = m_level.vertices[v];
+        FT n = (FT)Polyhedron::valence(pVertex);
+        m_rows.add(pVertex->tag(),(n-3)/n + 1/n);
+        HV_circulator h = pVertex->vertex_begin();
+        do {
+            m_rows.add(h->opposite()->vertex()->tag(),1/(n*n));
+            add_facet(h->facet(),1/(n*n*(FT)Polyhedron::degree(h->facet())));
+        } while(++h != pVertex->vertex_begin());
+      }
+      m_rows.end_row();
+    }
+    for(std::size_t e = 0; e < m_level.edges.size(); e++)
+    {
+      Halfedge_handle edge = m_level.edges[e];
+      if(e < m_level.nb_interior_edges)
+      {
+        m_rows.add(edge->vertex()->tag(),(FT)1/4);
+        m_rows.add(edge->opposite()->vertex()->tag(),(FT)1/4);
+        add_facet(edge->facet(),1/(4*(FT)Polyhedron::degree(edge->facet())));
+        add_facet(edge->opposite()->facet(),1/(4*(FT)Polyhedron::degree(edge->opposite()->facet())));
+      }
+      else
+      {
+        m_rows.add(edge->vertex()->tag(),(FT)1/2);
+        m_rows.add(edge->opposite()->vertex()->tag(),(FT)1/2);
+      }
+      m_rows.end_row();
+    }
+    for(std::size_t f = 0; f < m_level.facets.size(); f++)
+    {
+      add_facet(m_level.facets[f],1/(FT)Polyhedron::degree(m_level.facets[f]));
+      m_rows.end_row();
+    }
+    return m_catmull_clark.subdivide(P,1);
+  }
+
+  // the split of CRefinerQuadTriangle composed into 'table' here, the
+  // smoothing of the refined mesh is the level
+  bool quad_triangle_level(Polyhedron& P, Table& table)
+  {
+    if(!is_fan_manifold(P))
+      return false;
+
+    // the old vertices, the edges then the centers of the n-gons
+    m_rows.begin_rows(P.size_of_vertices());
+    int index = 0;
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+    {
+      pVertex->tag(index);
+      m_rows.add(index++,(FT)1);
+      m_rows.end_row();
+    }
+    for(Edge_iterator pEdge = P.edges_begin();
+        pEdge != P.edges_end();
+        pEdge++)
+    {
+      m_rows.add(pEdge->vertex()->tag(),(FT)0.5f);
+      m_rows.add(pEdge->opposite()->vertex()->tag(),(FT)0.5f);
+      m_rows.end_row();
+    }
+    for(Facet_iterator pFacet = P.facets_begin();
+        pFacet != P.facets_end();
+        pFacet++)
+    {
+      unsigned int degree = Polyhedron::degree(pFacet);
+      if(degree == 3)
+        continue;
+      add_facet(pFacet,1/(FT)degree);
+      m_rows.end_row();
+    }
+
+    typename CRefinerQuadTriangle<Polyhedron,kernel>::Mesh_arrays arrays;
+    CRefinerQuadTriangle<Polyhedron,kernel>::refine(P,arrays);
+    std::string error;
+    Mesh_halfedges connectivity;
+    if(!arrays.build_halfedges(connectivity,error))
+      return false;
+    P.clear();
+    bool ok = P.build(arrays,error,&connectivity);
+    CGAL_assertion(ok);
+    if(!ok)
+      return false;
+    CGAL_assertion(m_rows.size_of_rows() == P.size_of_vertices());
+    table.compose(m_rows,m_composed);
+    table.swap(m_composed);
+
+    // smooth_vertex() as weights
+    m_rows.begin_rows(P.size_of_vertices());
+    P.set_index_vertices();
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+    {
+      int self = pVertex->tag();
+      if(Polyhedron::is_border(pVertex))
+      {
+        if(!m_smooth_boundary)
+          m_rows.add(self,(FT)1);
+        else
+        {
+          Halfedge_handle pHalfedge = P.get_border_halfedge(pVertex);
+          m_rows.add(pHalfedge->prev()->vertex()->tag(),(FT)0.25f);
+          m_rows.add(self,(FT)0.5f);
+          m_rows.add(pHalfedge->next()->vertex()->tag(),(FT)0.25f);
+        }
+        m_rows.end_row();
+        continue;
+      }
+
+      unsigned int nb_quads = 0;
+      unsigned int nb_edges = 0;
+      HV_circulator h = pVertex->vertex_begin();
+      do {
+          if(Polyhedron::degree(h->facet()) == 4)
+            nb_quads++;
+          nb_edges++;
+      } while(++h != pVertex->vertex_begin());
+
+      FT ne = (FT)nb_edges;
+      FT nq = (FT)nb_quads;
+      FT alpha = 1.0f / (1.0f + ne/2.0f + nq/4.0f);
+      FT beta = alpha / 2.0f;
+      FT gamma = alpha / 4.0f;
+      FT eta = Quad_triangle::correcting_factor(nb_edges,nb_quads);
+
+      // p + eta (p - v)
+      m_rows.add(self,(1+eta)*alpha - eta);
+      h = pVertex->vertex_begin();
+      do {
+          m_rows.add(h->prev()->vertex()->tag(),(1+eta)*beta);
+          if(Polyhedron::degree(h->facet()) == 4)
+            m_rows.add(h->next()->next()->vertex()->tag(),(1+eta)*gamma);
+      } while(++h != pVertex->vertex_begin());
+      m_rows.end_row();
+    }
+    return true;
+  }
+
+  // the old vertices, the centers then two points per border edge on
+  // a border step, as CSubdivider_sqrt3::refine() puts them
+  bool sqrt3_level(Polyhedron& P, bool border)
+  {
+    typedef CSubdivider_sqrt3<Polyhedron,kernel> Sqrt3;
+    m_rows.begin_rows(P.size_of_vertices());
+    int index = 0;
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+      pVertex->tag(index++);
+
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+    {
+      std::size_t degree = 0, nb_borders = 0;
+      Halfedge_handle pBorder;
+      HV_circulator h = pVertex->vertex_begin();
+      do {
+          if(h->is_border())
+          {
+            pBorder = h;
+            nb_borders++;
+          }
+          degree++;
+      } while(++h != pVertex->vertex_begin());
+
+      if(nb_borders > 1)
+        return false;
+      if(nb_borders == 1 && !border)
+        m_rows.add(pVertex->tag(),(FT)1);
+      else if(nb_borders == 1)
+      {
+        m_rows.add(pBorder->opposite()->vertex()->tag(),(FT)4/27);
+        m_rows.add(pVertex->tag(),(FT)19/27);
+        m_rows.add(pBorder->next()->vertex()->tag(),(FT)4/27);
+      }
+      else
+      {
+        FT alpha = Sqrt3::smoothing_weight(degree);
+        m_rows.add(pVertex->tag(),1 - alpha);
+        h = pVertex->vertex_begin();
+        do {
+            m_rows.add(h->opposite()->vertex()->tag(),alpha/(FT)degree);
+        } while(++h != pVertex->vertex_begin());
+      }
+      m_rows.end_row();
+    }
+
+    for(Facet_iterator pFacet = P.facets_begin();
+        pFacet != P.facets_end();
+        pFacet++)
+    {
+      add_facet(pFacet,1/(FT)Polyhedron::degree(pFacet));
+      m_rows.end_row();
+    }
+
+    // the border halfedge u->w trisected: x1 next to w, then x2
+    if(border)
+      for(Edge_iterator pEdge = P.edges_begin();
+          pEdge != P.edges_end();
+          pEdge++)
+      {
+        if(!pEdge->is_border_edge())
+          continue;
+        Halfedge_handle e = pEdge->is_border() ? pEdge : pEdge->opposite();
+        int t = e->prev()->opposite()->vertex()->tag();
+        int u = e->opposite()->vertex()->tag();
+        int w = e->vertex()->tag();
+        int z = e->next()->vertex()->tag();
+        m_rows.add(u,(FT)10/27);
+        m_rows.add(w,(FT)16/27);
+        m_rows.add(z,(FT)1/27);
+        m_rows.end_row();
+        m_rows.add(t,(FT)1/27);
+        m_rows.add(u,(FT)16/27);
+        m_rows.add(w,(FT)10/27);
+        m_rows.end_row();
+      }
+
+    return m_sqrt3.refine(P,border);
+  }
+
+private:
+  bool m_smooth_boundary;
+  Level m_level;
+  Table m_rows;
+  Table m_composed;
+  CSubdivider_loop<Polyhedron,kernel> m_loop;
+  CSubdivider_catmull_clark<Polyhedron,kernel> m_catmull_clark;
+  CSubdivider_sqrt3<Polyhedron,kernel> m_sqrt3;
+};
+
+#endif
@@ -0,0 +1,972 @@
+/***************************************************************************
+subdivision.h  -  Loop, Catmull-Clark and Doo-Sabin on flat arrays
+----------------------------------------------------------------------------
+The three schemes of CGAL::Subdivision_method_3, for both mesh types. A
+level tags the elements, computes the new points with the stencils of
+the CGAL 3.4 masks in parallel ranges, writes the refined facets into an
+Indexed_mesh and builds it in place of the mesh in one pass. The points
+are computed with the operations of the masks in the same order, and
+for Loop and Catmull-Clark they come in the CGAL order: the old
+vertices, the edges with the border ones last (normalize_border), then
+the facets. Doo-Sabin writes the facet corners then the border points,
+and the facets of the facets, of the edges then of the vertices, which
+need not be the order of DQQ_1step. They match a serial transcription
+of the masks bit for bit; bench_schemes compares the points and the
+facets with those of CGAL, in order or vertex by vertex. A subdivider
+keeps its buffers from one level to the next.
+***************************************************************************/
+
+#ifndef SUBDIVISION_H
+#define SUBDIVISION_H
+
+#include "config.h"
+#include "enriched_polyhedron.h"
+#include "indexed_mesh.h"
+#include "parallelutils.h"
+#include "color.h"
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+// the handles and the buffers of one level, reused by the next one
+template <class Polyhedron,class kernel>
+class CSubdivision_level
+{
+public:
+  typedef typename kernel::FT FT;
+  typedef Indexed_mesh<FT> Mesh_arrays;
+  typedef typename Polyhedron::Point Point;
+  typedef typename Polyhedron::Vertex_handle Vertex_handle;
+  typedef typename Polyhedron::Halfedge_handle Halfedge_handle;
+  typedef typename Polyhedron::Facet_handle Facet_handle;
+  typedef typename Polyhedron::Vertex_iterator Vertex_iterator;
+  typedef typename Polyhedron::Edge_iterator Edge_iterator;
+  typedef typename Polyhedron::Facet_iterator Facet_iterator;
+
+  enum { GRAIN = 1 << 12 };
+
+public:
+  // the handles by index, the vertex and facet tags are the indices
+  std::vector<Vertex_handle> vertices;
+  std::vector<Facet_handle> facets;
+  // the interior edges then the border ones by their inner halfedge,
+  // both halfedges tagged nb vertices + the edge index
+  std::vector<Halfedge_handle> edges;
+  std::size_t nb_interior_edges;
+
+  // per facet or per vertex counts, prefix summed
+  std::vector<unsigned int> first_facet;
+  std::vector<unsigned int> first_index;
+  std::vector<unsigned char> on_border;
+  // halfedges circulated and vertices refused by each range
+  std::vector<std::size_t> halfedges;
+  std::vector<std::size_t> refused;
+
+  Mesh_arrays arrays;
+  std::vector<unsigned char> selected;
+
+public:
+  CSubdivision_level() : nb_interior_edges(0) {}
+
+  // the lists are walked once, the edges in the order CGAL finds
+  // them once the border is normalized
+  void gather(Polyhedron& P)
+  {
+    P.normalize_border();
+    vertices.clear();
+    facets.clear();
+    edges.clear();
+    vertices.reserve(P.size_of_vertices());
+    facets.reserve(P.size_of_facets());
+    edges.reserve(P.size_of_halfedges() / 2);
+
+    int index = 0;
+    for(Vertex_iterator pVertex = P.vertices_begin();
+        pVertex != P.vertices_end();
+        pVertex++)
+    {
+      pVertex->tag(index++);
+      vertices.push_back(pVertex);
+    }
+    index = 0;
+    for(Facet_iterator pFacet = P.facets_begin();
+        pFacet != P.facets_end();
+        pFacet++)
+    {
+      pFacet->tag(index++);
+      facets.push_back(pFacet);
+    }
+
+    Edge_iterator pEdge;
+    for(pEdge = P.edges_begin(); pEdge != P.edges_end(); pEdge++)
+      if(!pEdge->is_border_edge())
+        edges.push_back(pEdge);
+    nb_interior_edges = edges.size();
+    for(pEdge = P.edges_begin(); pEdge != P.edges_end(); pEdge++)
+      if(pEdge->is_border_edge())
+        edges.push_back(pEdge->is_border() ? pEdge->opposite() : pEdge);
+    for(std::size_t e = 0; e < edges.size(); e++)
+    {
+      edges[e]->tag((int)(vertices.size() + e));
+      edges[e]->opposite()->tag((int)(vertices.size() + e));
+    }
+  }
+
+  // room for the new mesh in the arrays of the previous level
+  FT *resize(std::size_t nb_vertices, std::size_t nb_facets, std::size_t nb_indices)
+  {
+    arrays.clear();
+    arrays.points.resize(3*nb_vertices);
+    arrays.facet_begin.resize(nb_facets+1,0);
+    arrays.facet_vertices.resize(nb_indices);
+    selected.assign(nb_facets,0);
+    return nb_vertices ? &arrays.points[0] : NULL;
+  }
+
+  // one counter per range of n items, zeroed
+  void ranges(std::size_t n)
+  {
+    std::size_t nb_ranges = ParallelUtils::nb_ranges(n,GRAIN);
+    halfedges.assign(nb_ranges,0);
+    refused.assign(nb_ranges,0);
+  }
+
+  // the umbrellas do not cover a vertex joining several fans
+  bool umbrellas_cover(const Polyhedron& P) const
+  {
+    std::size_t nb_circulated = 0;
+    for(std::size_t r = 0; r < halfedges.size(); r++)
+    {
+      nb_circulated += halfedges[r];
+      if(refused[r] > 0)
+        return false;
+    }
+    return nb_circulated == P.size_of_halfedges();
+  }
+
+  // the old vertices keep their color, the new ones get the default
+  void copy_colors(const Polyhedron& P)
+  {
+    if(!P.has_vertex_colors())
+      return;
+    std::size_t nb_new_vertices = arrays.size_of_vertices();
+    arrays.vertex_colors.resize(3*nb_new_vertices);
+    CColor color = MESHCOLOR;
+    for(std::size_t v = 0; v < nb_new_vertices; v++)
+    {
+      if(v < vertices.size())
+        color = P.vertex_color(vertices[v]);
+      else if(v == vertices.size())
+        color = MESHCOLOR;
+      arrays.vertex_colors[3*v]   = color.r();
+      arrays.vertex_colors[3*v+1] = color.g();
+      arrays.vertex_colors[3*v+2] = color.b();
+    }
+  }
+
+  // P replaced by the arrays, the facets get their selection back.
+  // False with P untouched if the new facets are not a manifold
+  bool build(Polyhedron& P)
+  {
+    vertices.clear();
+    facets.clear();
+    edges.clear();
+    std::string error;
+    Mesh_halfedges connectivity;
+    if(!arrays.build_halfedges(connectivity,error))
+      return false;
+    P.clear();
+    bool ok = P.build(arrays,error,&connectivity);
+    CGAL_assertion(ok);
+    std::size_t f = 0;
+    for(Facet_iterator pFacet = P.facets_begin();
+        pFacet != P.facets_end();
+        pFacet++, f++)
+      pFacet->selected(selected[f] != 0);
+    return ok;
+  }
+
+  // border_node() of the Loop and Catmull-Clark masks for the inner
+  // halfedge u->v of a border edge: the midpoint, and v between its
+  // border neighbors w and u
+  struct Border_nodes
+  {
+    const Halfedge_handle *pEdges;
+    FT *pEdgePoints;
+    FT *pPoints;
+    unsigned char *pOnBorder;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t e = begin; e < end; e++)
+      {
+        Halfedge_handle h = pEdges[e];
+        const Point& ep1 = h->vertex()->point();
+        const Point& ep2 = h->opposite()->vertex()->point();
+        FT *pEdge = &pEdgePoints[3*e];
+        pEdge[0] = (ep1.x()+ep2.x())/2;
+        pEdge[1] = (ep1.y()+ep2.y())/2;
+        pEdge[2] = (ep1.z()+ep2.z())/2;
+
+        const Point& vp1  = h->opposite()->vertex()->point();
+        const Point& vp0  = h->vertex()->point();
+        const Point& vp_1 = h->opposite()->prev()->opposite()->vertex()->point();
+        int v = h->vertex()->tag();
+        pPoints[3*v]   = (vp_1.x() + 6*vp0.x() + vp1.x())/8;
+        pPoints[3*v+1] = (vp_1.y() + 6*vp0.y() + vp1.y())/8;
+        pPoints[3*v+2] = (vp_1.z() + 6*vp0.z() + vp1.z())/8;
+        pOnBorder[v] = 1;
+      }
+    }
+  };
+};
+
+/************************************************************************/
+/* Loop: a vertex per edge, n corner triangles and the polygon of the   */
+/* edge points per n-gon                                                */
+/************************************************************************/
+template <class Polyhedron,class kernel>
+class CSubdivider_loop
+{
+  typedef CSubdivision_level<Polyhedron,kernel> Level;
+  typedef typename Level::FT FT;
+  typedef typename Level::Point Point;
+  typedef typename Level::Vertex_handle Vertex_handle;
+  typedef typename Level::Halfedge_handle Halfedge_handle;
+  typedef typename Level::Facet_handle Facet_handle;
+  typedef typename Polyhedron::Halfedge_around_vertex_circulator HV_circulator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator HF_circulator;
+
+  public:
+    CSubdivider_loop() {}
+    ~CSubdivider_loop() {}
+
+  public:
+    // false if a level cannot be built, P then holds the levels done
+    bool subdivide(Polyhedron& P, int iter = 1)
+    {
+      if(P.size_of_facets() == 0)
+        return false;
+      for(int i = 0; i < iter; i++)
+        if(!refine(P))
+          return false;
+      return true;
+    }
+
+  private:
+    // edge_node() on the halfedge the edge iterator gives
+    struct Edge_nodes
+    {
+      const Halfedge_handle *pEdges;
+      FT *pPoints;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t e = begin; e < end; e++)
+        {
+          Halfedge_handle edge = pEdges[e];
+          const Point& p1 = edge->vertex()->point();
+          const Point& p2 = edge->opposite()->vertex()->point();
+          const Point& f1 = edge->next()->vertex()->point();
+          const Point& f2 = edge->opposite()->next()->vertex()->point();
+          pPoints[3*e]   = (3*(p1.x()+p2.x())+f1.x()+f2.x())/8;
+          pPoints[3*e+1] = (3*(p1.y()+p2.y())+f1.y()+f2.y())/8;
+          pPoints[3*e+2] = (3*(p1.z()+p2.z())+f1.z()+f2.z())/8;
+        }
+      }
+    };
+
+    // vertex_node() off the border, every umbrella is counted
+    struct Vertex_nodes
+    {
+      const Vertex_handle *pVertices;
+      const unsigned char *pOnBorder;
+      FT *pPoints;
+      std::size_t *pHalfedges;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t range)
+      {
+        std::size_t nb_halfedges = 0;
+        for(std::size_t v = begin; v < end; v++)
+        {
+          Vertex_handle pVertex = pVertices[v];
+          std::size_t n = 0;
+          FT R[] = {0.0, 0.0, 0.0};
+          HV_circulator vcir = pVertex->vertex_begin();
+          do {
+              const Point& p = vcir->opposite()->vertex()->point();
+              R[0] += p.x();  R[1] += p.y();  R[2] += p.z();
+              n++;
+          } while(++vcir != pVertex->vertex_begin());
+          nb_halfedges += n;
+          if(pOnBorder[v])
+            continue;
+
+          const Point& S = pVertex->point();
+          FT *pPoint = &pPoints[3*v];
+          if(n == 6)
+          {
+            pPoint[0] = (10*S.x()+R[0])/16;
+            pPoint[1] = (10*S.y()+R[1])/16;
+            pPoint[2] = (10*S.z()+R[2])/16;
+          }
+          else
+          {
+            // the weights as the CGAL 3.4 mask has them
+            FT Cn = (FT) (5.0/8.0 - std::sqrt(3+2*std::cos(6.283/n))/64.0);
+            FT Sw = n*(1-Cn)/Cn;
+            FT W = n/Cn;
+            pPoint[0] = (Sw*S.x()+R[0])/W;
+            pPoint[1] = (Sw*S.y()+R[1])/W;
+            pPoint[2] = (Sw*S.z()+R[2])/W;
+          }
+        }
+        pHalfedges[range] = nb_halfedges;
+      }
+    };
+
+    // the corner triangle of each halfedge, then the inner polygon
+    struct Facets
+    {
+      const Facet_handle *pFacets;
+      const unsigned int *pFirstFacet;
+      const unsigned int *pFirstIndex;
+      unsigned int *pFacetBegin;
+      int *pIndices;
+      unsigned char *pSelected;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t f = begin; f < end; f++)
+        {
+          Facet_handle pFacet = pFacets[f];
+          unsigned int facet = pFirstFacet[f];
+          unsigned int index = pFirstIndex[f];
+          unsigned char selected = pFacet->selected() ? 1 : 0;
+          unsigned int degree = 0;
+          HF_circulator h = pFacet->facet_begin();
+          do {
+              pFacetBegin[facet] = index;
+              pSelected[facet++] = selected;
+              pIndices[index++] = h->vertex()->tag();
+              pIndices[index++] = h->next()->tag();
+              pIndices[index++] = h->tag();
+              degree++;
+          } while(++h != pFacet->facet_begin());
+
+          pFacetBegin[facet] = index;
+          pSelected[facet] = selected;
+          do {
+              pIndices[index++] = h->tag();
+          } while(++h != pFacet->facet_begin());
+          CGAL_assertion(index == pFirstIndex[f] + 4*degree);
+        }
+      }
+    };
+
+    bool refine(Polyhedron& P)
+    {
+      Level& level = m_level;
+      level.gather(P);
+      std::size_t nb_vertices = level.vertices.size();
+      std::size_t nb_edges = level.edges.size();
+      std::size_t nb_facets = level.facets.size();
+
+      level.first_facet.resize(nb_facets);
+      level.first_index.resize(nb_facets);
+      for(std::size_t f = 0; f < nb_facets; f++)
+      {
+        unsigned int degree = Polyhedron::degree(level.facets[f]);
+        level.first_facet[f] = degree + 1;
+        level.first_index[f] = 4*degree;
+      }
+      std::size_t nb_new_facets = ParallelUtils::prefix_sum(level.first_facet);
+      std::size_t nb_indices = ParallelUtils::prefix_sum(level.first_index);
+      FT *pPoints = level.resize(nb_vertices+nb_edges,nb_new_facets,nb_indices);
+
+      // the border first, serial: a few edges
+      level.on_border.assign(nb_vertices,0);
+      typename Level::Border_nodes border;
+      border.pEdges = &level.edges[0];
+      border.pEdgePoints = pPoints + 3*nb_vertices;
+      border.pPoints = pPoints;
+      border.pOnBorder = &level.on_border[0];
+      border(level.nb_interior_edges,nb_edges,0);
+
+      level.ranges(nb_vertices);
+      Vertex_nodes smoother;
+      smoother.pVertices = &level.vertices[0];
+      smoother.pOnBorder = &level.on_border[0];
+      smoother.pPoints = pPoints;
+      smoother.pHalfedges = &level.halfedges[0];
+      ParallelUtils::parallel_for(0,nb_vertices,smoother,Level::GRAIN);
+      if(!level.umbrellas_cover(P))
+        return false;
+
+      Edge_nodes splitter;
+      splitter.pEdges = &level.edges[0];
+      splitter.pPoints = pPoints + 3*nb_vertices;
+      ParallelUtils::parallel_for(0,level.nb_interior_edges,splitter,Level::GRAIN);
+
+      Facets refiner;
+      refiner.pFacets = &level.facets[0];
+      refiner.pFirstFacet = &level.first_facet[0];
+      refiner.pFirstIndex = &level.first_index[0];
+      refiner.pFacetBegin = &level.arrays.facet_begin[0];
+      refiner.pIndices = &level.arrays.facet_vertices[0];
+      refiner.pSelected = &level.selected[0];
+      ParallelUtils::parallel_for(0,nb_facets,refiner,Level::GRAIN);
+      level.arrays.facet_begin[nb_new_facets] = (unsigned int)nb_indices;
+
+      level.copy_colors(P);
+      return level.build(P);
+    }
+
+  private:
+    Level m_level;
+};
+
+/************************************************************************/
+/* Catmull-Clark: a vertex per edge and per facet, a n-gon gives n      */
+/* quads                                                                */
+/************************************************************************/
+template <class Polyhedron,class kernel>
+class CSubdivider_catmull_clark
+{
+  typedef CSubdivision_level<Polyhedron,kernel> Level;
+  typedef typename Level::FT FT;
+  typedef typename Level::Point Point;
+  typedef typename Level::Vertex_handle Vertex_handle;
+  typedef typename Level::Halfedge_handle Halfedge_handle;
+  typedef typename Level::Facet_handle Facet_handle;
+  typedef typename Polyhedron::Halfedge_around_vertex_circulator HV_circulator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator HF_circulator;
+
+  public:
+    CSubdivider_catmull_clark() {}
+    ~CSubdivider_catmull_clark() {}
+
+  public:
+    // false if a level cannot be built, P then holds the levels done
+    bool subdivide(Polyhedron& P, int iter = 1)
+    {
+      if(P.size_of_facets() == 0)
+        return false;
+      for(int i = 0; i < iter; i++)
+        if(!refine(P))
+          return false;
+      return true;
+    }
+
+  private:
+    // facet_node(), the quad of each halfedge around it
+    struct Facets
+    {
+      const Facet_handle *pFacets;
+      const unsigned int *pFirstIndex;
+      unsigned int first_facet_point;
+      FT *pFacetPoints;
+      unsigned int *pFacetBegin;
+      int *pIndices;
+      unsigned char *pSelected;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t f = begin; f < end; f++)
+        {
+          Facet_handle pFacet = pFacets[f];
+          FT p[] = {0.0, 0.0, 0.0};
+          int n = 0;
+          HF_circulator hcir = pFacet->facet_begin();
+          do {
+              const Point& q = hcir->vertex()->point();
+              p[0] = p[0] + q.x();
+              p[1] = p[1] + q.y();
+              p[2] = p[2] + q.z();
+              ++n;
+          } while(++hcir != pFacet->facet_begin());
+          FT *pPoint = &pFacetPoints[3*f];
+          pPoint[0] = p[0]/FT(n);
+          pPoint[1] = p[1]/FT(n);
+          pPoint[2] = p[2]/FT(n);
+
+          unsigned int index = pFirstIndex[f];
+          unsigned int facet = index / 4;
+          unsigned char selected = pFacet->selected() ? 1 : 0;
+          int center = (int)(first_facet_point + f);
+          do {
+              pFacetBegin[facet] = index;
+              pSelected[facet++] = selected;
+              pIndices[index++] = hcir->vertex()->tag();
+              pIndices[index++] = hcir->next()->tag();
+              pIndices[index++] = center;
+              pIndices[index++] = hcir->tag();
+          } while(++hcir != pFacet->facet_begin());
+        }
+      }
+    };
+
+    // edge_node() with the points of the two facets
+    struct Edge_nodes
+    {
+      const Halfedge_handle *pEdges;
+      const FT *pFacetPoints;
+      FT *pPoints;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t e = begin; e < end; e++)
+        {
+          Halfedge_handle edge = pEdges[e];
+          const Point& p1 = edge->vertex()->point();
+          const Point& p2 = edge->opposite()->vertex()->point();
+          const FT *f1 = &pFacetPoints[3*edge->facet()->tag()];
+          const FT *f2 = &pFacetPoints[3*edge->opposite()->facet()->tag()];
+          pPoints[3*e]   = (p1.x()+p2.x()+f1[0]+f2[0])/4;
+          pPoints[3*e+1] = (p1.y()+p2.y()+f1[1]+f2[1])/4;
+          pPoints[3*e+2] = (p1.z()+p2.z()+f1[2]+f2[2])/4;
+        }
+      }
+    };
+
+    // vertex_node() off the border, every umbrella is counted
+    struct Vertex_nodes
+    {
+      const Vertex_handle *pVertices;
+      const unsigned char *pOnBorder;
+      const FT *pFacetPoints;
+      FT *pPoints;
+      std::size_t *pHalfedges;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t range)
+      {
+        std::size_t nb_halfedges = 0;
+        for(std::size_t v = begin; v < end; v++)
+        {
+          Vertex_handle pVertex = pVertices[v];
+          HV_circulator vcir = pVertex->vertex_begin();
+          if(pOnBorder[v])
+          {
+            do {
+                nb_halfedges++;
+            } while(++vcir != pVertex->vertex_begin());
+            continue;
+          }
+
+          FT Q[] = {0.0, 0.0, 0.0}, R[] = {0.0, 0.0, 0.0};
+          const Point& S = pVertex->point();
+          int n = 0;
+          do {
+              const Point& p2 = vcir->opposite()->vertex()->point();
+              R[0] += (S.x()+p2.x())/2;
+              R[1] += (S.y()+p2.y())/2;
+              R[2] += (S.z()+p2.z())/2;
+              const FT *q = &pFacetPoints[3*vcir->facet()->tag()];
+              Q[0] += q[0];
+              Q[1] += q[1];
+              Q[2] += q[2];
+              n++;
+          } while(++vcir != pVertex->vertex_begin());
+          nb_halfedges += n;
+          R[0] /= n;    R[1] /= n;    R[2] /= n;
+          Q[0] /= n;    Q[1] /= n;    Q[2] /= n;
+
+          FT *pPoint = &pPoints[3*v];
+          pPoint[0] = (Q[0] + 2*R[0] + S.x()*(n-3))/n;
+          pPoint[1] = (Q[1] + 2*R[1] + S.y()*(n-3))/n;
+          pPoint[2] = (Q[2] + 2*R[2] + S.z()*(n-3))/n;
+        }
+        pHalfedges[range] = nb_halfedges;
+      }
+    };
+
+    bool refine(Polyhedron& P)
+    {
+      Level& level = m_level;
+      level.gather(P);
+      std::size_t nb_vertices = level.vertices.size();
+      std::size_t nb_edges = level.edges.size();
+      std::size_t nb_facets = level.facets.size();
+
+      level.first_index.resize(nb_facets);
+      for(std::size_t f = 0; f < nb_facets; f++)
+        level.first_index[f] = 4*Polyhedron::degree(level.facets[f]);
+      std::size_t nb_indices = ParallelUtils::prefix_sum(level.first_index);
+      std::size_t nb_new_facets = nb_indices / 4;
+      std::size_t first_facet_point = nb_vertices + nb_edges;
+      FT *pPoints = level.resize(first_facet_point+nb_facets,nb_new_facets,nb_indices);
+      FT *pFacetPoints = pPoints + 3*first_facet_point;
+
+      // the facet points first, the edges and the vertices read them
+      Facets refiner;
+      refiner.pFacets = &level.facets[0];
+      refiner.pFirstIndex = &level.first_index[0];
+      refiner.first_facet_point = (unsigned int)first_facet_point;
+      refiner.pFacetPoints = pFacetPoints;
+      refiner.pFacetBegin = &level.arrays.facet_begin[0];
+      refiner.pIndices = &level.arrays.facet_vertices[0];
+      refiner.pSelected = &level.selected[0];
+      ParallelUtils::parallel_for(0,nb_facets,refiner,Level::GRAIN);
+      level.arrays.facet_begin[nb_new_facets] = (unsigned int)nb_indices;
+
+      level.on_border.assign(nb_vertices,0);
+      typename Level::Border_nodes border;
+      border.pEdges = &level.edges[0];
+      border.pEdgePoints = pPoints + 3*nb_vertices;
+      border.pPoints = pPoints;
+      border.pOnBorder = &level.on_border[0];
+      border(level.nb_interior_edges,nb_edges,0);
+
+      level.ranges(nb_vertices);
+      Vertex_nodes smoother;
+      smoother.pVertices = &level.vertices[0];
+      smoother.pOnBorder = &level.on_border[0];
+      smoother.pFacetPoints = pFacetPoints;
+      smoother.pPoints = pPoints;
+      smoother.pHalfedges = &level.halfedges[0];
+      ParallelUtils::parallel_for(0,nb_vertices,smoother,Level::GRAIN);
+      if(!level.umbrellas_cover(P))
+        return false;
+
+      Edge_nodes splitter;
+      splitter.pEdges = &level.edges[0];
+      splitter.pFacetPoints = pFacetPoints;
+      splitter.pPoints = pPoints + 3*nb_vertices;
+      ParallelUtils::parallel_for(0,level.nb_interior_edges,splitter,Level::GRAIN);
+
+      level.copy_colors(P);
+      return level.build(P);
+    }
+
+  private:
+    Level m_level;
+};
+
+/************************************************************************/
+/* Doo-Sabin: a vertex per facet corner, the border edges get two.      */
+/* Each facet shrinks to its corners, each edge gives a quad and each   */
+/* vertex the polygon of its corners, two border points close it on    */
+/* the border (the boundary is corner cut at 1/4 and 3/4).             */
+/************************************************************************/
+template <class Polyhedron,class kernel>
+class CSubdivider_doo_sabin
+{
+  typedef CSubdivision_level<Polyhedron,kernel> Level;
+  typedef typename Level::FT FT;
+  typedef typename Level::Point Point;
+  typedef typename Level::Vertex_handle Vertex_handle;
+  typedef typename Level::Halfedge_handle Halfedge_handle;
+  typedef typename Level::Facet_handle Facet_handle;
+  typedef typename Polyhedron::Halfedge_around_vertex_circulator HV_circulator;
+  typedef typename Polyhedron::Halfedge_around_facet_circulator HF_circulator;
+
+  public:
+    CSubdivider_doo_sabin() {}
+    ~CSubdivider_doo_sabin() {}
+
+  public:
+    // false if a level cannot be built (a vertex on several holes,
+    // joining several fans or of valence 2), P then holds the levels done
+    bool subdivide(Polyhedron& P, int iter = 1)
+    {
+      if(P.size_of_facets() == 0)
+        return false;
+      for(int i = 0; i < iter; i++)
+        if(!refine(P))
+          return false;
+      return true;
+    }
+
+  private:
+    static void set_color(const Polyhedron *pMesh, unsigned char *pColors, int v, Vertex_handle pVertex)
+    {
+      if(pColors == NULL)
+        return;
+      CColor color = pMesh->vertex_color(pVertex);
+      pColors[3*v]   = color.r();
+      pColors[3*v+1] = color.g();
+      pColors[3*v+2] = color.b();
+    }
+
+    // corner_node() of the halfedge 'he' of a n-gon
+    static void corner_node(Halfedge_handle he, std::size_t n, FT *pPoint)
+    {
+      FT cv[] = {0.0, 0.0, 0.0};
+      Halfedge_handle heh = he;
+      if(n == 4)
+      {
+        const Point& p0 = heh->vertex()->point();
+        const Point& p1 = heh->next()->vertex()->point();
+        const Point& p2 = heh->next()->next()->vertex()->point();
+        const Point& p3 = heh->prev()->vertex()->point();
+        cv[0] = cv[0] + p0.x()*9;  cv[1] = cv[1] + p0.y()*9;  cv[2] = cv[2] + p0.z()*9;
+        cv[0] = cv[0] + p1.x()*3;  cv[1] = cv[1] + p1.y()*3;  cv[2] = cv[2] + p1.z()*3;
+        cv[0] = cv[0] + p2.x();    cv[1] = cv[1] + p2.y();    cv[2] = cv[2] + p2.z();
+        cv[0] = cv[0] + p3.x()*3;  cv[1] = cv[1] + p3.y()*3;  cv[2] = cv[2] + p3.z()*3;
+        cv[0] = cv[0]/16;  cv[1] = cv[1]/16;  cv[2] = cv[2]/16;
+      }
+      else
+      {
+        FT a;
+        for(std::size_t i = 0; i < n; ++i, heh = heh->next())
+        {
+          a = (i == 0) ? (FT) ((FT)1/(FT)4 + (FT)5/(FT)(4*n)) :
+            (FT) (3+2*std::cos(2*i*3.141593/n))/(FT)(4*n);
+          const Point& p = heh->vertex()->point();
+          cv[0] = cv[0] + p.x()*a;
+          cv[1] = cv[1] + p.y()*a;
+          cv[2] = cv[2] + p.z()*a;
+        }
+      }
+      pPoint[0] = cv[0];
+      pPoint[1] = cv[1];
+      pPoint[2] = cv[2];
+    }
+
+    // border_node(): the point of the edge of 'he' next to its vertex
+    static void border_node(Halfedge_handle he, FT *pPoint)
+    {
+      const Point& p1 = he->vertex()->point();
+      const Point& p2 = he->opposite()->vertex()->point();
+      pPoint[0] = (3*p1.x()+p2.x())/4;
+      pPoint[1] = (3*p1.y()+p2.y())/4;
+      pPoint[2] = (3*p1.z()+p2.z())/4;
+    }
+
+    // the corners, facet by facet: a halfedge is tagged with the corner
+    // of its vertex in its facet, the facet shrinks to them
+    struct Corners
+    {
+      const Polyhedron *pMesh;
+      const Facet_handle *pFacets;
+      const unsigned int *pFacetBegin;
+      FT *pPoints;
+      unsigned char *pColors;
+      int *pIndices;
+      unsigned char *pSelected;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t f = begin; f < end; f++)
+        {
+          Facet_handle pFacet = pFacets[f];
+          unsigned int index = pFacetBegin[f];
+          std::size_t n = pFacetBegin[f+1] - index;
+          HF_circulator h = pFacet->facet_begin();
+          do {
+              h->tag((int)index);
+              corner_node(h,n,&pPoints[3*index]);
+              set_color(pMesh,pColors,(int)index,h->vertex());
+              pIndices[index] = (int)index;
+              index++;
+          } while(++h != pFacet->facet_begin());
+          pSelected[f] = pFacet->selected() ? 1 : 0;
+        }
+      }
+    };
+
+    // the border halfedge u->v of each border edge is tagged with its
+    // point next to v, the point next to u follows
+    struct Border_points
+    {
+      const Polyhedron *pMesh;
+      const Halfedge_handle *pBorders;
+      unsigned int first_point;
+      FT *pPoints;
+      unsigned char *pColors;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t b = begin; b < end; b++)
+        {
+          Halfedge_handle h = pBorders[b]->opposite();
+          int index = (int)(first_point + 2*b);
+          h->tag(index);
+          border_node(h,&pPoints[3*index]);
+          border_node(h->opposite(),&pPoints[3*(index+1)]);
+          set_color(pMesh,pColors,index,h->vertex());
+          set_color(pMesh,pColors,index+1,h->opposite()->vertex());
+        }
+      }
+    };
+
+    // the size of the polygon of each vertex: its corners, and two
+    // border points in place of the hole
+    struct Vertex_degrees
+    {
+      const Vertex_handle *pVertices;
+      unsigned int *pDegrees;
+      std::size_t *pHalfedges;
+      std::size_t *pRefused;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t range)
+      {
+        std::size_t nb_halfedges = 0, nb_refused = 0;
+        for(std::size_t v = begin; v < end; v++)
+        {
+          std::size_t n = 0, nb_borders = 0;
+          HV_circulator h = pVertices[v]->vertex_begin();
+          do {
+              if(h->is_border())
+                nb_borders++;
+              n++;
+          } while(++h != pVertices[v]->vertex_begin());
+          nb_halfedges += n;
+          if(nb_borders == 1)
+            n++;
+          if(nb_borders > 1 || n < 3)
+            nb_refused++;
+          pDegrees[v] = (unsigned int)n;
+        }
+        pHalfedges[range] = nb_halfedges;
+        pRefused[range] = nb_refused;
+      }
+    };
+
+    // the quad of each edge, between the corners of its ends in both
+    // facets, the border points on the border side
+    struct Edge_facets
+    {
+      const Halfedge_handle *pEdges;
+      unsigned int first_facet;
+      unsigned int first_index;
+      unsigned int *pFacetBegin;
+      int *pIndices;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t e = begin; e < end; e++)
+        {
+          Halfedge_handle h = pEdges[e];
+          Halfedge_handle o = h->opposite();
+          unsigned int index = first_index + 4*(unsigned int)e;
+          pFacetBegin[first_facet+e] = index;
+          pIndices[index]   = h->tag();
+          pIndices[index+1] = h->prev()->tag();
+          pIndices[index+2] = o->tag();
+          pIndices[index+3] = o->is_border() ? o->tag() + 1 : o->prev()->tag();
+        }
+      }
+    };
+
+    // the polygon of each vertex, its corners clockwise from the hole
+    struct Vertex_facets
+    {
+      const Vertex_handle *pVertices;
+      const unsigned int *pFirstIndex;
+      unsigned int first_facet;
+      unsigned int first_index;
+      unsigned int *pFacetBegin;
+      int *pIndices;
+
+      void operator()(std::size_t begin, std::size_t end, std::size_t)
+      {
+        for(std::size_t v = begin; v < end; v++)
+        {
+          Vertex_handle pVertex = pVertices[v];
+          unsigned int index = first_index + pFirstIndex[v];
+          pFacetBegin[first_facet+v] = index;
+
+          Halfedge_handle start = pVertex->halfedge();
+          HV_circulator h = pVertex->vertex_begin();
+          do {
+              if(h->is_border())
+                start = h;
+          } while(++h != pVertex->vertex_begin());
+
+          Halfedge_handle corner = start;
+          do {
+              pIndices[index++] = corner->tag();
+              corner = corner->opposite()->prev();
+          } while(corner != start);
+          if(start->is_border())
+            pIndices[index++] = start->next()->tag() + 1;
+        }
+      }
+    };
+
+    bool refine(Polyhedron& P)
+    {
+      Level& level = m_level;
+      level.gather(P);
+      std::size_t nb_vertices = level.vertices.size();
+      std::size_t nb_edges = level.edges.size();
+      std::size_t nb_facets = level.facets.size();
+      std::size_t nb_borders = nb_edges - level.nb_interior_edges;
+
+      level.ranges(nb_vertices);
+      level.first_facet.resize(nb_vertices);
+      Vertex_degrees degrees;
+      degrees.pVertices = &level.vertices[0];
+      degrees.pDegrees = &level.first_facet[0];
+      degrees.pHalfedges = &level.halfedges[0];
+      degrees.pRefused = &level.refused[0];
+      ParallelUtils::parallel_for(0,nb_vertices,degrees,Level::GRAIN);
+      if(!level.umbrellas_cover(P))
+        return false;
+      std::size_t nb_vertex_indices = ParallelUtils::prefix_sum(level.first_facet);
+
+      level.first_index.resize(nb_facets);
+      for(std::size_t f = 0; f < nb_facets; f++)
+        level.first_index[f] = Polyhedron::degree(level.facets[f]);
+      std::size_t nb_corners = ParallelUtils::prefix_sum(level.first_index);
+
+      // the facets, the edges then the vertices
+      std::size_t nb_new_vertices = nb_corners + 2*nb_borders;
+      std::size_t nb_new_facets = nb_facets + nb_edges + nb_vertices;
+      std::size_t nb_indices = nb_corners + 4*nb_edges + nb_vertex_indices;
+      FT *pPoints = level.resize(nb_new_vertices,nb_new_facets,nb_indices);
+      std::copy(level.first_index.begin(),level.first_index.end(),level.arrays.facet_begin.begin());
+      level.arrays.facet_begin[nb_facets] = (unsigned int)nb_corners;
+      level.arrays.facet_begin[nb_new_facets] = (unsigned int)nb_indices;
+      unsigned char *pColors = NULL;
+      if(P.has_vertex_colors())
+      {
+        level.arrays.vertex_colors.resize(3*nb_new_vertices);
+        pColors = &level.arrays.vertex_colors[0];
+      }
+
+      Corners corners;
+      corners.pMesh = &P;
+      corners.pFacets = &level.facets[0];
+      corners.pFacetBegin = &level.arrays.facet_begin[0];
+      corners.pPoints = pPoints;
+      corners.pColors = pColors;
+      corners.pIndices = &level.arrays.facet_vertices[0];
+      corners.pSelected = &level.selected[0];
+      ParallelUtils::parallel_for(0,nb_facets,corners,Level::GRAIN);
+
+      Border_points border;
+      border.pMesh = &P;
+      border.pBorders = nb_borders ? &level.edges[level.nb_interior_edges] : NULL;
+      border.first_point = (unsigned int)nb_corners;
+      border.pPoints = pPoints;
+      border.pColors = pColors;
+      ParallelUtils::parallel_for(0,nb_borders,border,Level::GRAIN);
+
+      Edge_facets edge_facets;
+      edge_facets.pEdges = &level.edges[0];
+      edge_facets.first_facet = (unsigned int)nb_facets;
+      edge_facets.first_index = (unsigned int)nb_corners;
+      edge_facets.pFacetBegin = &level.arrays.facet_begin[0];
+      edge_facets.pIndices = &level.arrays.facet_vertices[0];
+      ParallelUtils::parallel_for(0,nb_edges,edge_facets,Level::GRAIN);
+
+      Vertex_facets vertex_facets;
+      vertex_facets.pVertices = &level.vertices[0];
+      vertex_facets.pFirstIndex = &level.first_facet[0];
+      vertex_facets.first_facet = (unsigned int)(nb_facets + nb_edges);
+      vertex_facets.first_index = (unsigned int)(nb_corners + 4*nb_edges);
+      vertex_facets.pFacetBegin = &level.arrays.facet_begin[0];
+      vertex_facets.pIndices = &level.arrays.facet_vertices[0];
+      ParallelUtils::parallel_for(0,nb_vertices,vertex_facets,Level::GRAIN);
+
+      return level.build(P);
+    }
+
+  private:
+    Level m_level;
+};
+
+#endif
@@ -0,0 +1,1619 @@
+/***************************************************************************
+surface_mesh.h  -  index-based half-edge mesh
+----------------------------------------------------------------------------
+Enriched_surface_mesh keeps the half-edge connectivity in one array per
+field, addressed by 32-bit indices, where Polyhedron_3 allocates a list
+node per element. The Enriched attributes (tags, normals, colors, control
+edges, selection) are properties, see mesh_property.h, allocated the first
+time they are written: until then a read gives the default value. Handles and iterators are a mesh pointer and an
+index with the Polyhedron_3 syntax: h->next()->vertex()->point(),
+vertex and facet circulators, Edge_iterator, split_facet(), join_facet(),
+create_center_vertex(), split_vertex() and delegate(). CSubdivider_sqrt3,
+CSubdivider_quad_triangle and Mesh_renderer run on it unchanged.
+
+join_facet() leaves its edge and facet as holes that the iterators skip,
+the next split_facet() fills them, so an edge flip keeps the edge in
+place. Every other new element is appended at the end, the order
+Polyhedron_3 gives and the subdividers rely on. garbage_collection()
+packs the arrays again.
+***************************************************************************/
+
+#ifndef SURFACE_MESH_H
+#define SURFACE_MESH_H
+
+#include "config.h"
+#include <cmath>
+#include <list>
+#include <vector>
+#include <string>
+#include <iterator>
+#include <algorithm>
+#include <CGAL/circulator.h>
+#include <CGAL/Modifier_base.h>
+#include "indexed_mesh.h"
+#include "mesh_halfedges.h"
+#include "mesh_kernel.h"
+#include "mesh_property.h"
+#include "mesh_render.h"
+#include "mesh_reorder.h"
+#include "parallelutils.h"
+
+template <class kernel>
+class Enriched_surface_mesh
+{
+public:
+  typedef typename kernel::FT FT;
+  typedef typename kernel::Point_3 Point;
+  typedef typename kernel::Vector_3 Vector;
+  typedef typename kernel::Iso_cuboid_3 Iso_cuboid;
+  typedef Enriched_surface_mesh<kernel> Self;
+  // delegate() hands the mesh itself to the modifier
+  typedef Self HalfedgeDS;
+  typedef Mesh_renderer<Self> Renderer;
+  typedef std::size_t size_type;
+  // normals are for display, floats are enough
+  typedef Packed_vector_3<float> Stored_normal;
+
+  enum { NONE = 0xFFFFFFFFu };
+  // an edge flip puts the edge and facet back in place, see
+  // CSubdivider_sqrt3::refine()
+  enum { FLIPS_IN_PLACE = 1 };
+
+  class Vertex;
+  class Halfedge;
+  class Facet;
+  template <class T> class Handle;
+  class Edge_iterator;
+  class Halfedge_around_vertex_circulator;
+  class Halfedge_around_facet_circulator;
+  class Builder;
+
+  typedef Handle<Vertex> Vertex_handle;
+  typedef Handle<Halfedge> Halfedge_handle;
+  typedef Handle<Facet> Facet_handle;
+  typedef Vertex_handle Vertex_iterator;
+  typedef Halfedge_handle Halfedge_iterator;
+  typedef Facet_handle Facet_iterator;
+  typedef Facet_handle Face_handle;
+  typedef typename std::vector<Point>::iterator Point_iterator;
+  // an item is a view on the mesh, a const one can still change it
+  typedef Vertex_handle Vertex_const_handle;
+  typedef Halfedge_handle Halfedge_const_handle;
+  typedef Facet_handle Facet_const_handle;
+  typedef Halfedge_around_vertex_circulator Halfedge_around_vertex_const_circulator;
+  typedef Halfedge_around_facet_circulator Halfedge_around_facet_const_circulator;
+
+  /************************************************************************/
+  /* items                                                                */
+  /************************************************************************/
+  class Item
+  {
+  public:
+    Item() : m_pMesh(NULL), m_index(NONE) {}
+    Item(Self *pMesh, unsigned int index) : m_pMesh(pMesh), m_index(index) {}
+
+    Self *mesh() const { return m_pMesh; }
+    unsigned int index() const { return m_index; }
+
+  protected:
+    Self *m_pMesh;
+    unsigned int m_index;
+  };
+
+  class Vertex : public Item
+  {
+  public:
+    typedef typename Self::Point Point;
+    typedef Vector Normal_3;
+    typedef CColor Color;
+    typedef typename Self::Halfedge_around_vertex_circulator Halfedge_around_vertex_circulator;
+    typedef Halfedge_around_vertex_circulator Halfedge_around_vertex_const_circulator;
+
+    Vertex() {}
+    Vertex(Self *pMesh, unsigned int index) : Item(pMesh,index) {}
+
+    Point& point() const { return this->m_pMesh->m_points[this->m_index]; }
+    Normal_3 normal() const { return this->m_pMesh->get(this->m_pMesh->m_vertex_normals,this->m_index); }
+    void normal(const Normal_3& n) const { this->m_pMesh->vertex_normals()[this->m_index] = n; }
+    Color color() const { return this->m_pMesh->get(this->m_pMesh->m_vertex_colors,this->m_index,Color(MESHCOLOR)); }
+    void color(const Color& c) const { this->m_pMesh->vertex_colors()[this->m_index] = c; }
+    int& tag() const { return this->m_pMesh->vertex_tags()[this->m_index]; }
+    void tag(int t) const { tag() = t; }
+    bool dirty() const { return this->m_pMesh->get(this->m_pMesh->m_vertex_dirty,this->m_index,(unsigned char)0) != 0; }
+    void dirty(bool d) const { this->m_pMesh->vertex_dirty()[this->m_index] = d; }
+
+    // a halfedge pointing to the vertex
+    Halfedge_handle halfedge() const
+    {
+      return Halfedge_handle(this->m_pMesh,this->m_pMesh->m_vertex_halfedge[this->m_index]);
+    }
+    Halfedge_around_vertex_circulator vertex_begin() const
+    {
+      return Halfedge_around_vertex_circulator(halfedge());
+    }
+    std::size_t vertex_degree() const { return CGAL::circulator_size(vertex_begin()); }
+
+    // vertices are never removed
+    bool removed() const { return false; }
+    unsigned int capacity() const { return (unsigned int)this->m_pMesh->m_points.size(); }
+  };
+
+  class Halfedge : public Item
+  {
+  public:
+    typedef typename Self::Halfedge_around_vertex_circulator Halfedge_around_vertex_circulator;
+    typedef typename Self::Halfedge_around_facet_circulator Halfedge_around_facet_circulator;
+
+    Halfedge() {}
+    Halfedge(Self *pMesh, unsigned int index) : Item(pMesh,index) {}
+
+    Halfedge_handle next() const { return handle(this->m_pMesh->m_next[this->m_index]); }
+    Halfedge_handle prev() const { return handle(this->m_pMesh->m_prev[this->m_index]); }
+    Halfedge_handle opposite() const { return handle(this->m_pMesh->m_opposite[this->m_index]); }
+    Vertex_handle vertex() const
+    {
+      return Vertex_handle(this->m_pMesh,this->m_pMesh->m_vertex[this->m_index]);
+    }
+    // the null handle on the border
+    Facet_handle facet() const
+    {
+      return Facet_handle(this->m_pMesh,this->m_pMesh->m_facet[this->m_index]);
+    }
+    Facet_handle face() const { return facet(); }
+
+    bool is_border() const { return this->m_pMesh->m_facet[this->m_index] == NONE; }
+    bool is_border_edge() const { return is_border() || opposite()->is_border(); }
+
+    int& tag() const { return this->m_pMesh->halfedge_tags()[this->m_index]; }
+    void tag(int t) const { tag() = t; }
+    bool control_edge() const { return this->m_pMesh->get(this->m_pMesh->m_control_edges,this->m_index,(unsigned char)1) != 0; }
+    void control_edge(bool flag) const { this->m_pMesh->control_edges()[this->m_index] = flag; }
+
+    Halfedge_around_vertex_circulator vertex_begin() const
+    {
+      return Halfedge_around_vertex_circulator(handle(this->m_index));
+    }
+    Halfedge_around_facet_circulator facet_begin() const
+    {
+      return Halfedge_around_facet_circulator(handle(this->m_index));
+    }
+    std::size_t vertex_degree() const { return CGAL::circulator_size(vertex_begin()); }
+    std::size_t facet_degree() const { return CGAL::circulator_size(facet_begin()); }
+
+    bool removed() const { return this->m_pMesh->m_vertex[this->m_index] == NONE; }
+    unsigned int capacity() const { return (unsigned int)this->m_pMesh->m_next.size(); }
+
+  private:
+    Halfedge_handle handle(unsigned int h) const { return Halfedge_handle(this->m_pMesh,h); }
+  };
+
+  class Facet : public Item
+  {
+  public:
+    typedef Vector Normal_3;
+    typedef typename Self::Halfedge_around_facet_circulator Halfedge_around_facet_circulator;
+    typedef Halfedge_around_facet_circulator Halfedge_around_facet_const_circulator;
+
+    Facet() {}
+    Facet(Self *pMesh, unsigned int index) : Item(pMesh,index) {}
+
+    Halfedge_handle halfedge() const
+    {
+      return Halfedge_handle(this->m_pMesh,this->m_pMesh->m_facet_halfedge[this->m_index]);
+    }
+    Halfedge_around_facet_circulator facet_begin() const
+    {
+      return Halfedge_around_facet_circulator(halfedge());
+    }
+    std::size_t facet_degree() const { return CGAL::circulator_size(facet_begin()); }
+    bool is_triangle() const { return facet_degree() == 3; }
+    bool is_quad() const { return facet_degree() == 4; }
+
+    Normal_3 normal() const { return this->m_pMesh->get(this->m_pMesh->m_facet_normals,this->m_index); }
+    void normal(const Normal_3& n) const { this->m_pMesh->facet_normals()[this->m_index] = n; }
+    int& tag() const { return this->m_pMesh->facet_tags()[this->m_index]; }
+    void tag(int t) const { tag() = t; }
+    bool selected() const { return this->m_pMesh->get(this->m_pMesh->m_selected,this->m_index,(unsigned char)0) != 0; }
+    void selected(bool sel) const { this->m_pMesh->selected()[this->m_index] = sel; }
+
+    bool removed() const { return this->m_pMesh->m_facet_halfedge[this->m_index] == NONE; }
+    unsigned int capacity() const { return (unsigned int)this->m_pMesh->m_facet_halfedge.size(); }
+  };
+
+  /************************************************************************/
+  /* handles, iterators and circulators                                   */
+  /************************************************************************/
+  // a handle is also the iterator over the items of its kind, ++ and --
+  // skip the removed ones. NULL converts to the null handle.
+  template <class T>
+  class Handle : protected T
+  {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef T value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T* pointer;
+    typedef T& reference;
+
+    Handle() {}
+    Handle(const void *) {}
+    Handle(Self *pMesh, unsigned int index) : T(pMesh,index) {}
+
+    unsigned int index() const { return this->m_index; }
+    T* operator->() const { return const_cast<Handle*>(this); }
+    T& operator*() const { return *const_cast<Handle*>(this); }
+
+    // null handles are equal whatever their mesh
+    bool operator==(const Handle& h) const { return this->m_index == h.m_index; }
+    bool operator!=(const Handle& h) const { return this->m_index != h.m_index; }
+    bool operator<(const Handle& h) const { return this->m_index < h.m_index; }
+
+    Handle& operator++()
+    {
+      unsigned int n = this->capacity();
+      do
+        this->m_index++;
+      while(this->m_index < n && this->removed());
+      return *this;
+    }
+    Handle& operator--()
+    {
+      do
+        this->m_index--;
+      while(this->removed());
+      return *this;
+    }
+    Handle operator++(int) { Handle h(*this); ++*this; return h; }
+    Handle operator--(int) { Handle h(*this); --*this; return h; }
+  };
+
+  // one halfedge per edge, the one with the lower index
+  class Edge_iterator : public Halfedge_handle
+  {
+  public:
+    Edge_iterator() {}
+    Edge_iterator(Self *pMesh, unsigned int index) : Halfedge_handle(pMesh,index) {}
+
+    Edge_iterator& operator++()
+    {
+      unsigned int n = this->capacity();
+      do
+        this->m_index++;
+      while(this->m_index < n && !is_edge());
+      return *this;
+    }
+    Edge_iterator& operator--()
+    {
+      do
+        this->m_index--;
+      while(!is_edge());
+      return *this;
+    }
+    Edge_iterator operator++(int) { Edge_iterator e(*this); ++*this; return e; }
+    Edge_iterator operator--(int) { Edge_iterator e(*this); --*this; return e; }
+
+  private:
+    bool is_edge() const
+    {
+      return !this->removed() && this->m_index < this->m_pMesh->m_opposite[this->m_index];
+    }
+  };
+
+  // h, h->next()->opposite(), ... around the vertex of h
+  class Halfedge_around_vertex_circulator : public Halfedge_handle
+  {
+  public:
+    typedef CGAL::Bidirectional_circulator_tag iterator_category;
+    typedef std::size_t size_type;
+
+    Halfedge_around_vertex_circulator() {}
+    Halfedge_around_vertex_circulator(const Halfedge_handle& h) : Halfedge_handle(h) {}
+
+    Halfedge_around_vertex_circulator& operator++()
+    {
+      this->m_index = this->m_pMesh->m_opposite[this->m_pMesh->m_next[this->m_index]];
+      return *this;
+    }
+    Halfedge_around_vertex_circulator& operator--()
+    {
+      this->m_index = this->m_pMesh->m_prev[this->m_pMesh->m_opposite[this->m_index]];
+      return *this;
+    }
+    Halfedge_around_vertex_circulator operator++(int)
+    {
+      Halfedge_around_vertex_circulator c(*this); ++*this; return c;
+    }
+    Halfedge_around_vertex_circulator operator--(int)
+    {
+      Halfedge_around_vertex_circulator c(*this); --*this; return c;
+    }
+  };
+
+  // h, h->next(), ... around the facet of h
+  class Halfedge_around_facet_circulator : public Halfedge_handle
+  {
+  public:
+    typedef CGAL::Bidirectional_circulator_tag iterator_category;
+    typedef std::size_t size_type;
+
+    Halfedge_around_facet_circulator() {}
+    Halfedge_around_facet_circulator(const Halfedge_handle& h) : Halfedge_handle(h) {}
+
+    Halfedge_around_facet_circulator& operator++()
+    {
+      this->m_index = this->m_pMesh->m_next[this->m_index];
+      return *this;
+    }
+    Halfedge_around_facet_circulator& operator--()
+    {
+      this->m_index = this->m_pMesh->m_prev[this->m_index];
+      return *this;
+    }
+    Halfedge_around_facet_circulator operator++(int)
+    {
+      Halfedge_around_facet_circulator c(*this); ++*this; return c;
+    }
+    Halfedge_around_facet_circulator operator--(int)
+    {
+      Halfedge_around_facet_circulator c(*this); --*this; return c;
+    }
+  };
+
+  /************************************************************************/
+  /* incremental builder                                                  */
+  /************************************************************************/
+  // the interface of Enriched_polyhedron_incremental_builder_3 for an
+  // empty mesh. end_facet() links the facet loop at once, so the
+  // returned halfedge can be walked, the opposite halfedges are paired
+  // by Mesh_halfedges in end_surface()
+  class Builder
+  {
+  public:
+    enum { EDGE_MAP_VALENCE = 32 };
+
+    Builder(Self& mesh, bool verbose = false)
+      : m_mesh(mesh), m_verbose(verbose), m_error(false) {}
+    ~Builder() {}
+
+    bool error() const { return m_error; }
+    const std::string& message() const { return m_message; }
+
+    // the pairs are sorted out at the end, any valence will do
+    void use_edge_map(bool) {}
+
+    void begin_surface(std::size_t nb_vertices,
+                       std::size_t nb_facets,
+                       std::size_t nb_halfedges = 0)
+    {
+      CGAL_precondition(m_mesh.size_of_vertices() == 0);
+      m_mesh.clear();
+      m_mesh.reserve(nb_vertices,nb_halfedges,nb_facets);
+      m_facet_begin.reserve(nb_facets+1);
+      m_facet_begin.assign(1,0);
+      m_facet_vertices.clear();
+      m_facet_vertices.reserve(nb_halfedges/2);
+      m_error = false;
+    }
+
+    Vertex_handle add_vertex(const Point& p)
+    {
+      return Vertex_handle(&m_mesh,m_mesh.new_vertex(p));
+    }
+
+    void begin_facet() {}
+
+    void add_vertex_to_facet(std::size_t v)
+    {
+      m_facet_vertices.push_back((unsigned int)v);
+    }
+
+    // the halfedge pointing to the first vertex
+    Halfedge_handle end_facet()
+    {
+      unsigned int first = m_facet_begin.back();
+      unsigned int last = (unsigned int)m_facet_vertices.size();
+      if(last - first < 3)
+      {
+        fail("end_facet(): facet with less than 3 vertices");
+        return Halfedge_handle();
+      }
+      unsigned int f = m_mesh.new_facet();
+      m_mesh.m_facet_halfedge[f] = first;
+      for(unsigned int i = first; i < last; i++)
+      {
+        unsigned int next = i+1 < last ? i+1 : first;
+        m_mesh.m_next.push_back(next);
+        m_mesh.m_prev.push_back(i > first ? i-1 : last-1);
+        m_mesh.m_vertex.push_back(m_facet_vertices[i]);
+        m_mesh.m_facet.push_back(f);
+      }
+      m_mesh.m_halfedge_properties.resize(last);
+      m_facet_begin.push_back(last);
+      return Halfedge_handle(&m_mesh,first);
+    }
+
+    void end_surface()
+    {
+      if(m_error)
+        return;
+      std::string error;
+      if(!m_mesh.link(&m_facet_begin[0],m_facet_begin.size()-1,
+                      m_facet_vertices.empty() ? NULL : &m_facet_vertices[0],
+                      m_mesh.size_of_vertices(),error))
+        fail(error);
+    }
+
+    void rollback()
+    {
+      m_mesh.clear();
+      m_error = false;
+    }
+
+  private:
+    void fail(const std::string& message)
+    {
+      m_error = true;
+      m_message = message;
+      if(m_verbose)
+        std::cerr << "Enriched_surface_mesh::Builder: " << message << std::endl;
+    }
+
+  private:
+    Self& m_mesh;
+    bool m_verbose;
+    bool m_error;
+    std::string m_message;
+    std::vector<unsigned int> m_facet_begin;
+    std::vector<unsigned int> m_facet_vertices;
+  };
+
+private:
+  // facet normals of [begin,end), the formula of Facet_normal
+  struct Facet_normals
+  {
+    Self *pMesh;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t i = begin; i < end; i++)
+      {
+        if(pMesh->m_facet_halfedge[i] == NONE)
+          continue;
+        Facet_handle f(pMesh,(unsigned int)i);
+        Vector sum = CGAL::NULL_VECTOR;
+        Halfedge_around_facet_circulator h = f->facet_begin();
+        do
+        {
+          Vector normal = CGAL::cross_product(
+            h->next()->vertex()->point() - h->vertex()->point(),
+            h->next()->next()->vertex()->point() - h->next()->vertex()->point());
+          double sqnorm = normal * normal;
+          if(sqnorm != 0)
+            normal = normal / (float)std::sqrt(sqnorm);
+          sum = sum + normal;
+        }
+        while(++h != f->facet_begin());
+        float sqnorm = sum * sum;
+        if(sqnorm != 0.0)
+          sum = sum / std::sqrt(sqnorm);
+        pMesh->m_facet_normals[i] = sum;
+      }
+    }
+  };
+
+  // vertex normals of [begin,end), the formula of Vertex_normal
+  struct Vertex_normals
+  {
+    Self *pMesh;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t v = begin; v < end; v++)
+      {
+        Vector normal = CGAL::NULL_VECTOR;
+        Halfedge_around_vertex_circulator pHalfedge = Vertex(pMesh,(unsigned int)v).vertex_begin();
+        Halfedge_around_vertex_circulator end = pHalfedge;
+        CGAL_For_all(pHalfedge,end)
+          if(!pHalfedge->is_border())
+            normal = normal + pHalfedge->facet()->normal();
+        float sqnorm = normal * normal;
+        if(sqnorm != 0.0f)
+          normal = normal / (float)std::sqrt(sqnorm);
+        pMesh->m_vertex_normals[v] = normal;
+      }
+    }
+  };
+
+  // m_prev from m_next, [begin,end) of the halfedges
+  struct Prev_setter
+  {
+    const unsigned int *pNext;
+    unsigned int *pPrev;
+
+    void operator()(std::size_t begin, std::size_t end, std::size_t)
+    {
+      for(std::size_t h = begin; h < end; h++)
+        pPrev[pNext[h]] = (unsigned int)h;
+    }
+  };
+
+public:
+  Enriched_surface_mesh()
+  {
+    m_pure_quad = false;
+    m_pure_triangle = false;
+  }
+  Enriched_surface_mesh(const Self& mesh) { *this = mesh; }
+  ~Enriched_surface_mesh() {}
+
+  // the property maps are looked up again in the copied containers
+  Self& operator=(const Self& mesh)
+  {
+    if(this == &mesh)
+      return *this;
+    m_points = mesh.m_points;
+    m_vertex_halfedge = mesh.m_vertex_halfedge;
+    m_next = mesh.m_next;
+    m_prev = mesh.m_prev;
+    m_opposite = mesh.m_opposite;
+    m_vertex = mesh.m_vertex;
+    m_facet = mesh.m_facet;
+    m_facet_halfedge = mesh.m_facet_halfedge;
+    m_free_edges = mesh.m_free_edges;
+    m_free_facets = mesh.m_free_facets;
+    m_degrees = mesh.m_degrees;
+    m_vertex_properties = mesh.m_vertex_properties;
+    m_halfedge_properties = mesh.m_halfedge_properties;
+    m_facet_properties = mesh.m_facet_properties;
+    find_properties();
+    m_bbox = mesh.m_bbox;
+    m_pure_quad = mesh.m_pure_quad;
+    m_pure_triangle = mesh.m_pure_triangle;
+    return *this;
+  }
+
+  /************************************************************************/
+  /* Polyhedron_3 interface                                               */
+  /************************************************************************/
+  size_type size_of_vertices() const { return m_points.size(); }
+  size_type size_of_halfedges() const { return m_next.size() - 2*m_free_edges.size(); }
+  size_type size_of_facets() const { return m_facet_halfedge.size() - m_free_facets.size(); }
+  bool empty() const { return m_points.empty(); }
+
+  Vertex_iterator vertices_begin() { return first<Vertex>(); }
+  Vertex_iterator vertices_end() { return Vertex_iterator(this,(unsigned int)m_points.size()); }
+  Halfedge_iterator halfedges_begin() { return first<Halfedge>(); }
+  Halfedge_iterator halfedges_end() { return Halfedge_iterator(this,(unsigned int)m_next.size()); }
+  Facet_iterator facets_begin() { return first<Facet>(); }
+  Facet_iterator facets_end() { return Facet_iterator(this,(unsigned int)m_facet_halfedge.size()); }
+  Edge_iterator edges_begin()
+  {
+    Edge_iterator e(this,NONE);
+    return ++e;
+  }
+  Edge_iterator edges_end() { return Edge_iterator(this,(unsigned int)m_next.size()); }
+  Point_iterator points_begin() { return m_points.begin(); }
+  Point_iterator points_end() { return m_points.end(); }
+
+  void reserve(size_type nb_vertices, size_type nb_halfedges, size_type nb_facets)
+  {
+    m_points.reserve(nb_vertices);
+    m_vertex_halfedge.reserve(nb_vertices);
+    m_vertex_properties.reserve(nb_vertices);
+    m_next.reserve(nb_halfedges);
+    m_prev.reserve(nb_halfedges);
+    m_opposite.reserve(nb_halfedges);
+    m_vertex.reserve(nb_halfedges);
+    m_facet.reserve(nb_halfedges);
+    m_halfedge_properties.reserve(nb_halfedges);
+    m_facet_halfedge.reserve(nb_facets);
+    m_facet_properties.reserve(nb_facets);
+  }
+
+  // the properties go too
+  void clear()
+  {
+    m_points.clear();
+    m_vertex_halfedge.clear();
+    m_next.clear();
+    m_prev.clear();
+    m_opposite.clear();
+    m_vertex.clear();
+    m_facet.clear();
+    m_facet_halfedge.clear();
+    m_free_edges.clear();
+    m_free_facets.clear();
+    m_degrees.clear();
+    m_vertex_properties.remove_all();
+    m_halfedge_properties.remove_all();
+    m_facet_properties.remove_all();
+    find_properties();
+  }
+
+  // the border is told by the facet of a halfedge, nothing to sort
+  void normalize_border() {}
+
+  // runs a modifier written for Polyhedron_3::delegate(), it fills the
+  // mesh through CGAL::Mesh_builder<Enriched_surface_mesh>
+  void delegate(CGAL::Modifier_base<Self>& modifier)
+  {
+    modifier(*this);
+  }
+
+  // splits the facet of h and g by a new edge between their vertices,
+  // the new facet is the one of g and copies the attributes of the old
+  // one. Returns the new halfedge h->next().
+  Halfedge_handle split_facet(Halfedge_handle h, Halfedge_handle g)
+  {
+    unsigned int hi = h.index(), gi = g.index();
+    unsigned int f = m_facet[hi];
+    CGAL_precondition(f != NONE && m_facet[gi] == f);
+    CGAL_precondition(hi != gi && m_next[hi] != gi && m_next[gi] != hi);
+    unsigned int hn = m_next[hi], gn = m_next[gi];
+    unsigned int e = m_free_edges.empty() ? new_edge() : reuse_edge();
+    unsigned int eo = m_opposite[e];
+    unsigned int fnew = m_free_facets.empty() ? new_facet(f) : reuse_facet(f);
+    uncount_facet(f);
+
+    // e comes after h in the old facet, eo after g in the new one
+    link(hi,e);
+    link(e,gn);
+    m_vertex[e] = m_vertex[gi];
+    m_facet[e] = f;
+    link(gi,eo);
+    link(eo,hn);
+    m_vertex[eo] = m_vertex[hi];
+    set_facet_in_loop(eo,fnew);
+    m_facet_halfedge[f] = e;
+    m_facet_halfedge[fnew] = eo;
+    count_facet(f);
+    count_facet(fnew);
+    return Halfedge_handle(this,e);
+  }
+
+  // removes the edge of h and the facet of h->opposite(), the facet of
+  // h gets its halfedges. Returns h->prev().
+  Halfedge_handle join_facet(Halfedge_handle h)
+  {
+    unsigned int hi = h.index(), gi = m_opposite[hi];
+    CGAL_precondition(Vertex_handle(this,m_vertex[hi])->vertex_degree() >= 3);
+    CGAL_precondition(Vertex_handle(this,m_vertex[gi])->vertex_degree() >= 3);
+    unsigned int f = m_facet[hi], g = m_facet[gi];
+    CGAL_precondition(f != g);
+    uncount_facet(f);
+    uncount_facet(g);
+    unsigned int hp = m_prev[hi], gp = m_prev[gi];
+    link(hp,m_next[gi]);
+    link(gp,m_next[hi]);
+    set_facet_in_loop(hp,f);
+    if(f != NONE)
+      m_facet_halfedge[f] = hp;
+    count_facet(f);
+    m_vertex_halfedge[m_vertex[hp]] = hp;
+    m_vertex_halfedge[m_vertex[gp]] = gp;
+
+    // leave the holes for the next split_facet()
+    if(g != NONE)
+    {
+      m_facet_halfedge[g] = NONE;
+      m_free_facets.push_back(g);
+    }
+    m_vertex[hi] = m_vertex[gi] = NONE;
+    m_free_edges.push_back(std::min(hi,gi));
+    return Halfedge_handle(this,hp);
+  }
+
+  // triangulates the facet of h around a new vertex, a copy of
+  // h->vertex(). h keeps the old facet, the other triangles copy it.
+  // Returns h->next(), pointing to the new vertex.
+  Halfedge_handle create_center_vertex(Halfedge_handle h)
+  {
+    unsigned int hi = h.index();
+    unsigned int f = m_facet[hi];
+    CGAL_precondition(f != NONE);
+    std::vector<unsigned int> loop;
+    unsigned int x = hi;
+    do
+    {
+      loop.push_back(x);
+      x = m_next[x];
+    }
+    while(x != hi);
+
+    // edge i goes from the vertex of loop[i] (halfedge e) to the center
+    // and back (halfedge e+1)
+    std::size_t n = loop.size();
+    m_degrees[n]--;
+    if(m_degrees.size() < 4)
+      m_degrees.resize(4,0);
+    m_degrees[3] += n;
+    unsigned int center = new_vertex(m_vertex[hi]);
+    unsigned int first = new_edge();
+    for(std::size_t i = 1; i < n; i++)
+      new_edge();
+    for(std::size_t i = 0; i < n; i++)
+    {
+      unsigned int to = first + 2*(unsigned int)i;
+      unsigned int from = first + 2*(unsigned int)((i+n-1)%n) + 1;
+      unsigned int t = i == 0 ? f : new_facet(f);
+      link(loop[i],to);
+      link(to,from);
+      link(from,loop[i]);
+      m_vertex[to] = center;
+      m_vertex[from] = m_vertex[loop[(i+n-1)%n]];
+      m_facet[loop[i]] = m_facet[to] = m_facet[from] = t;
+      m_facet_halfedge[t] = loop[i];
+    }
+    m_vertex_halfedge[center] = first;
+    return Halfedge_handle(this,first);
+  }
+
+  // splits the vertex of h and g, the halfedges from h->next()->opposite()
+  // to g get a new vertex, a copy of the old one, joined to it by a new
+  // edge. Returns h->next()->opposite(), pointing to the old vertex.
+  Halfedge_handle split_vertex(Halfedge_handle h, Halfedge_handle g)
+  {
+    unsigned int hi = h.index(), gi = g.index();
+    unsigned int v = m_vertex[hi];
+    CGAL_precondition(hi != gi && m_vertex[gi] == v);
+    unsigned int fh = m_facet[hi];
+    unsigned int fg = m_facet[gi] == fh ? (unsigned int)NONE : m_facet[gi];
+    uncount_facet(fh);
+    uncount_facet(fg);
+    unsigned int hn = m_next[hi], gn = m_next[gi];
+    unsigned int vnew = new_vertex(v);
+    unsigned int e = new_edge();
+    unsigned int eo = m_opposite[e];
+
+    // eo comes after h, e after g
+    link(hi,eo);
+    link(eo,hn);
+    m_vertex[eo] = vnew;
+    m_facet[eo] = m_facet[hi];
+    link(gi,e);
+    link(e,gn);
+    m_vertex[e] = v;
+    m_facet[e] = m_facet[gi];
+    unsigned int x = eo;
+    do
+    {
+      x = m_opposite[m_next[x]];
+      m_vertex[x] = vnew;
+    }
+    while(x != gi);
+    m_vertex_halfedge[vnew] = gi;
+    m_vertex_halfedge[v] = hi;
+    count_facet(fh);
+    count_facet(fg);
+    return Halfedge_handle(this,e);
+  }
+
+  // packs the arrays after join_facet(), the indices of the halfedges
+  // and facets change
+  void garbage_collection()
+  {
+    if(m_free_edges.empty() && m_free_facets.empty())
+      return;
+    std::vector<unsigned int> halfedges, facets;
+    pack(m_vertex,halfedges);
+    pack(m_facet_halfedge,facets);
+    for(std::size_t h = 0; h < m_next.size(); h++)
+    {
+      if(halfedges[h] == NONE)
+        continue;
+      unsigned int to = halfedges[h];
+      m_next[to] = halfedges[m_next[h]];
+      m_prev[to] = halfedges[m_prev[h]];
+      m_opposite[to] = halfedges[m_opposite[h]];
+      m_vertex[to] = m_vertex[h];
+      m_facet[to] = m_facet[h] == NONE ? (unsigned int)NONE : facets[m_facet[h]];
+      m_halfedge_properties.copy(h,to);
+    }
+    std::size_t nb_halfedges = size_of_halfedges();
+    m_next.resize(nb_halfedges);
+    m_prev.resize(nb_halfedges);
+    m_opposite.resize(nb_halfedges);
+    m_vertex.resize(nb_halfedges);
+    m_facet.resize(nb_halfedges);
+    m_halfedge_properties.resize(nb_halfedges);
+    for(std::size_t f = 0; f < m_facet_halfedge.size(); f++)
+    {
+      if(facets[f] == NONE)
+        continue;
+      unsigned int to = facets[f];
+      m_facet_halfedge[to] = halfedges[m_facet_halfedge[f]];
+      m_facet_properties.copy(f,to);
+    }
+    std::size_t nb_facets = size_of_facets();
+    m_facet_halfedge.resize(nb_facets);
+    m_facet_properties.resize(nb_facets);
+    for(std::size_t v = 0; v < m_vertex_halfedge.size(); v++)
+      if(m_vertex_halfedge[v] != NONE)
+        m_vertex_halfedge[v] = halfedges[m_vertex_halfedge[v]];
+    m_free_edges.clear();
+    m_free_facets.clear();
+  }
+
+  // the links are consistent: next and prev, opposite pairs, facet
+  // loops and vertex umbrellas
+  bool is_valid(bool verbose = false, int = 0)
+  {
+    for(Halfedge_iterator h = halfedges_begin(); h != halfedges_end(); h++)
+    {
+      unsigned int i = h.index();
+      if(m_prev[m_next[i]] != i || m_opposite[m_opposite[i]] != i ||
+         m_opposite[i] == i || m_vertex[m_next[i]] == NONE ||
+         m_facet[m_next[i]] != m_facet[i] ||
+         m_vertex[m_opposite[i]] != m_vertex[m_prev[i]])
+        return invalid(verbose,"halfedge",i);
+    }
+    for(Facet_iterator f = facets_begin(); f != facets_end(); f++)
+      if(m_facet[m_facet_halfedge[f.index()]] != f.index())
+        return invalid(verbose,"facet",f.index());
+    for(Vertex_iterator v = vertices_begin(); v != vertices_end(); v++)
+    {
+      unsigned int h = m_vertex_halfedge[v.index()];
+      if(h != NONE && (h >= m_vertex.size() || m_vertex[h] != v.index()))
+        return invalid(verbose,"vertex",v.index());
+    }
+    return true;
+  }
+
+  /************************************************************************/
+  /* Enriched_polyhedron interface                                        */
+  /************************************************************************/
+  void compute_normals()
+  {
+    compute_normals_per_facet();
+    compute_normals_per_vertex();
+  }
+
+  void compute_normals_per_facet()
+  {
+    facet_normals();
+    Facet_normals normals;
+    normals.pMesh = this;
+    ParallelUtils::parallel_for(0,m_facet_halfedge.size(),normals,1<<14);
+  }
+
+  void compute_normals_per_vertex()
+  {
+    facet_normals();
+    vertex_normals();
+    Vertex_normals normals;
+    normals.pMesh = this;
+    ParallelUtils::parallel_for(0,m_points.size(),normals,1<<14);
+  }
+
+  void compute_bounding_box()
+  {
+    if(size_of_vertices() == 0)
+    {
+      CGAL_assertion(false);
+      return;
+    }
+
+    FT xmin,xmax,ymin,ymax,zmin,zmax;
+    xmin = xmax = m_points[0].x();
+    ymin = ymax = m_points[0].y();
+    zmin = zmax = m_points[0].z();
+    for(std::size_t v = 1; v < m_points.size(); v++)
+    {
+      const Point& p = m_points[v];
+
+      xmin =  std::min(xmin,p.x());
+      ymin =  std::min(ymin,p.y());
+      zmin =  std::min(zmin,p.z());
+
+      xmax =  std::max(xmax,p.x());
+      ymax =  std::max(ymax,p.y());
+      zmax =  std::max(zmax,p.z());
+    }
+    m_bbox = Iso_cuboid(xmin,ymin,zmin,
+                        xmax,ymax,zmax);
+  }
+
+  void copy_bounding_box(Self *pMesh)
+  {
+    m_bbox = pMesh->bbox();
+  }
+
+  FT xmin() { return m_bbox.xmin(); }
+  FT xmax() { return m_bbox.xmax(); }
+  FT ymin() { return m_bbox.ymin(); }
+  FT ymax() { return m_bbox.ymax(); }
+  FT zmin() { return m_bbox.zmin(); }
+  FT zmax() { return m_bbox.zmax(); }
+
+  Iso_cuboid& bbox() { return m_bbox; }
+  const Iso_cuboid bbox() const { return m_bbox; }
+
+  void compute_type()
+  {
+    m_pure_quad = is_pure_degree(4);
+    m_pure_triangle = is_pure_degree(3);
+  }
+
+  // number of facets of degree d, counted by build() and the Builder,
+  // kept by the Euler operations
+  std::size_t size_of_facets_of_degree(unsigned int d) const
+  {
+    return d < m_degrees.size() ? m_degrees[d] : 0;
+  }
+
+  // the facets per degree from scratch, after code writing the arrays
+  // some other way
+  void compute_degrees()
+  {
+    m_degrees.clear();
+    for(Facet_iterator pFacet = facets_begin(); pFacet != facets_end(); pFacet++)
+      count_facet(pFacet.index());
+  }
+
+  bool is_pure_triangle() { return m_pure_triangle; }
+  bool is_pure_quad() { return m_pure_quad; }
+
+  // true if the vertex colors come from the file or were set
+  bool has_vertex_colors() const { return m_vertex_colors.is_valid(); }
+  CColor vertex_color(Vertex_const_handle pVertex) const { return pVertex->color(); }
+  bool has_normals() const { return m_vertex_normals.is_valid(); }
+
+  /************************************************************************/
+  /* properties                                                           */
+  /************************************************************************/
+  // an algorithm attaches the attributes it needs by name, the names
+  // starting with "v:", "h:" or "f:" are taken by the Enriched ones
+  template <class T>
+  Property_map<T> add_vertex_property(const std::string& name, const T& value = T())
+  {
+    return m_vertex_properties.add(name,value);
+  }
+  template <class T>
+  Property_map<T> add_halfedge_property(const std::string& name, const T& value = T())
+  {
+    return m_halfedge_properties.add(name,value);
+  }
+  template <class T>
+  Property_map<T> add_facet_property(const std::string& name, const T& value = T())
+  {
+    return m_facet_properties.add(name,value);
+  }
+
+  template <class T>
+  void remove_vertex_property(Property_map<T>& map) { m_vertex_properties.remove(map); }
+  template <class T>
+  void remove_halfedge_property(Property_map<T>& map) { m_halfedge_properties.remove(map); }
+  template <class T>
+  void remove_facet_property(Property_map<T>& map) { m_facet_properties.remove(map); }
+
+  // frees the normals, the next compute_normals() allocates them again
+  void remove_normals()
+  {
+    m_vertex_properties.remove(m_vertex_normals);
+    m_facet_properties.remove(m_facet_normals);
+  }
+
+  // memory held by the mesh arrays and properties
+  std::size_t bytes() const
+  {
+    return m_points.capacity()*sizeof(Point) +
+      (m_vertex_halfedge.capacity() + m_next.capacity() + m_prev.capacity() +
+       m_opposite.capacity() + m_vertex.capacity() + m_facet.capacity() +
+       m_facet_halfedge.capacity())*sizeof(unsigned int) +
+      m_vertex_properties.bytes() + m_halfedge_properties.bytes() +
+      m_facet_properties.bytes();
+  }
+
+  // degree of a face
+  static unsigned int degree(Facet_handle pFace)
+  {
+    return (unsigned int)pFace->facet_degree();
+  }
+
+  // valence of a vertex
+  static unsigned int valence(Vertex_handle pVertex)
+  {
+    return (unsigned int)pVertex->vertex_degree();
+  }
+
+  // check wether a vertex is on a boundary or not
+  static bool is_border(Vertex_handle pVertex)
+  {
+    Halfedge_around_vertex_circulator pHalfEdge = pVertex->vertex_begin();
+    if(pHalfEdge == NULL) // isolated vertex
+      return true;
+    Halfedge_around_vertex_circulator d = pHalfEdge;
+    CGAL_For_all(pHalfEdge,d)
+      if(pHalfEdge->is_border())
+        return true;
+    return false;
+  }
+
+  // get any border halfedge attached to a vertex
+  Halfedge_handle get_border_halfedge(Vertex_handle pVertex)
+  {
+    Halfedge_around_vertex_circulator pHalfEdge = pVertex->vertex_begin();
+    Halfedge_around_vertex_circulator d = pHalfEdge;
+    CGAL_For_all(pHalfEdge,d)
+      if(pHalfEdge->is_border())
+        return pHalfEdge;
+    return NULL;
+  }
+
+  void set_index_facets()
+  {
+    int index = 0;
+    for(Facet_iterator pFacet = facets_begin();
+        pFacet != facets_end();
+        pFacet++)
+      pFacet->tag(index++);
+  }
+
+  void set_index_vertices()
+  {
+    Property_map<int> tags = vertex_tags();
+    for(std::size_t v = 0; v < m_points.size(); v++)
+      tags[v] = (int)v;
+  }
+
+  // tag all halfedges
+  void tag_halfedges(const int tag)
+  {
+    Property_map<int> tags = halfedge_tags();
+    std::fill(tags.data(),tags.data()+m_next.size(),tag);
+  }
+
+  // tag all facets
+  void tag_facets(const int tag)
+  {
+    Property_map<int> tags = facet_tags();
+    std::fill(tags.data(),tags.data()+m_facet_halfedge.size(),tag);
+  }
+
+  // compute facet center
+  void compute_facet_center(Facet_handle pFace,Point& center)
+  {
+    Halfedge_around_facet_circulator pHalfEdge = pFace->facet_begin();
+    Halfedge_around_facet_circulator end = pHalfEdge;
+    Vector vec(0.0,0.0,0.0);
+    int degree = 0;
+    CGAL_For_all(pHalfEdge,end)
+    {
+      vec = vec + (pHalfEdge->vertex()->point()-CGAL::ORIGIN);
+      degree++;
+    }
+    center = CGAL::ORIGIN + (vec/(FT)degree);
+  }
+
+  unsigned int nb_boundaries()
+  {
+    unsigned int nb = 0;
+    tag_halfedges(0);
+    for(Halfedge_iterator he = halfedges_begin();
+        he != halfedges_end();
+        he++)
+    {
+      if(he->is_border() && he->tag() == 0)
+      {
+        nb++;
+        Halfedge_handle curr = he;
+        do
+        {
+          curr  = curr->next();
+          curr->tag(1);
+        }
+        while(curr != he);
+      }
+    }
+    return nb;
+  }
+
+  void tag_component(Facet_handle pSeedFacet,const int tag_free,const int tag_done)
+  {
+    pSeedFacet->tag(tag_done);
+    std::list<Facet_handle> facets;
+    facets.push_front(pSeedFacet);
+    while(!facets.empty())
+    {
+      Facet_handle pFacet = facets.front();
+      facets.pop_front();
+      pFacet->tag(tag_done);
+      Halfedge_around_facet_circulator pHalfedge = pFacet->facet_begin();
+      Halfedge_around_facet_circulator end = pHalfedge;
+      CGAL_For_all(pHalfedge,end)
+      {
+        Facet_handle pNFacet = pHalfedge->opposite()->facet();
+        if(pNFacet != NULL && pNFacet->tag() == tag_free)
+        {
+          facets.push_front(pNFacet);
+          pNFacet->tag(tag_done);
+        }
+      }
+    }
+  }
+
+  unsigned int nb_components()
+  {
+    unsigned int nb = 0;
+    tag_facets(0);
+    for(Facet_iterator pFacet = facets_begin();
+        pFacet != facets_end();
+        pFacet++)
+    {
+      if(pFacet->tag() == 0)
+      {
+        nb++;
+        tag_component(pFacet,0,1);
+      }
+    }
+    return nb;
+  }
+
+  // compute the genus
+  // V - E + F + B = 2 (C - G)
+  int genus()
+  {
+    int c = nb_components();
+    int b = nb_boundaries();
+    int v = (int)size_of_vertices();
+    int e = (int)size_of_halfedges()/2;
+    int f = (int)size_of_facets();
+
+    return (2*c+e-b-f-v)/2;
+  }
+
+  // see Enriched_polyhedron, the rebuild also packs the holes
+  double scattering() { return Mesh_reorder<Self>::scattering(*this); }
+  bool reorder(std::string& error) { return Mesh_reorder<Self>::reorder(*this,error); }
+  bool reorder_if_scattered(double threshold = Indexed_reorder<FT>::threshold())
+  {
+    return Mesh_reorder<Self>::reorder_if_scattered(*this,threshold);
+  }
+
+  // fill an empty mesh from an indexed face set (Indexed_mesh,
+  // Binary_mesh_view), false with 'error' set if it is not a manifold.
+  // pHalfedges, if any, is its connectivity from build_halfedges()
+  template <class Mesh>
+  bool build(const Mesh& indexed_mesh, std::string& error,
+             Mesh_halfedges *pHalfedges = NULL)
+  {
+    const Mesh& mesh = indexed_mesh;
+    std::size_t nb_vertices = mesh.size_of_vertices();
+    std::size_t nb_facets = mesh.size_of_facets();
+    clear();
+    m_points.reserve(nb_vertices);
+    const typename Mesh::Coord *pPoint = nb_vertices ? &mesh.points[0] : NULL;
+    for(std::size_t v = 0; v < nb_vertices; v++, pPoint += 3)
+      new_vertex(Point(pPoint[0],pPoint[1],pPoint[2]));
+    if(!link(&mesh.facet_begin[0],nb_facets,
+             mesh.size_of_indices() ? &mesh.facet_vertices[0] : NULL,
+             nb_vertices,error,pHalfedges))
+    {
+      clear();
+      return false;
+    }
+
+    // normals and colors read from the file
+    if(mesh.has_vertex_normals())
+    {
+      Property_map<Stored_normal> normals = vertex_normals();
+      for(std::size_t v = 0; v < nb_vertices; v++)
+        normals[v] = &mesh.vertex_normals[3*v];
+    }
+    if(mesh.has_vertex_colors())
+    {
+      Property_map<CColor> colors = vertex_colors();
+      for(std::size_t v = 0; v < nb_vertices; v++)
+        colors[v] = CColor(mesh.vertex_colors[3*v],
+                           mesh.vertex_colors[3*v+1],
+                           mesh.vertex_colors[3*v+2]);
+    }
+    if(mesh.has_facet_normals())
+    {
+      Property_map<Stored_normal> normals = facet_normals();
+      for(std::size_t f = 0; f < nb_facets; f++)
+        normals[f] = &mesh.facet_normals[3*f];
+    }
+    // the halfedge of a facet points to its first vertex
+    if(mesh.has_control_edges())
+    {
+      Property_map<unsigned char> controls = control_edges();
+      for(std::size_t f = 0; f < nb_facets; f++)
+      {
+        unsigned int h = m_facet_halfedge[f];
+        for(unsigned int i = mesh.facet_begin[f]; i < mesh.facet_begin[f+1]; i++, h = m_next[h])
+          controls[h] = mesh.control_edges[i];
+      }
+    }
+    return true;
+  }
+
+  bool euler_split_facet()
+  {
+    bool retVal = false;
+    for(Facet_iterator pFacet = facets_begin(); pFacet != facets_end(); ++pFacet)
+    {
+      if(pFacet->selected())
+      {
+        Halfedge_handle h = pFacet->halfedge();
+        Halfedge_handle g = h->next()->next();
+        if( h == g || h->next() == g || g->next() == h)
+          continue;
+
+        Halfedge_handle newhe = split_facet(h,g);
+        newhe->facet()->selected(false);
+        newhe->opposite()->facet()->selected(false);
+        retVal = true;
+      }
+    }
+    return retVal;
+  }
+
+  bool euler_join_facet()
+  {
+    bool retVal = false;
+    for(Facet_iterator pFacet = facets_begin(); pFacet != facets_end(); ++pFacet)
+    {
+      if(pFacet->selected())
+      {
+        Halfedge_handle h = pFacet->halfedge();
+        if(h->opposite()->facet() == pFacet)
+          continue;
+        if(valence(h->vertex()) < 3 || valence(h->opposite()->vertex()) < 3)
+          continue;
+
+        Halfedge_handle new_he = join_facet(h);
+        new_he->facet()->selected(false);
+
+        retVal = true;
+      }
+    }
+    return retVal;
+  }
+
+  bool euler_create_center_vertex()
+  {
+    bool retVal = false;
+    for(Facet_iterator pFacet = facets_begin(); pFacet != facets_end(); ++pFacet)
+    {
+      if(pFacet->selected())
+      {
+        Point center;
+        compute_facet_center(pFacet,center);
+        Halfedge_handle new_center = create_center_vertex(pFacet->halfedge());
+        new_center->vertex()->point() = center;
+
+        Halfedge_around_vertex_circulator hv = new_center->vertex()->vertex_begin();
+        Halfedge_around_vertex_circulator end = hv;
+        CGAL_For_all(hv,end)
+          hv->facet()->selected(false);
+
+        retVal = true;
+      }
+    }
+    return retVal;
+  }
+
+  /************************************************************************/
+  /* opengl part                                                          */
+  /************************************************************************/
+  void gl_draw(bool smooth_shading, bool use_normals, bool use_colors = false)
+  {
+    Renderer::gl_draw(*this,smooth_shading,use_normals,use_colors);
+  }
+
+  void gl_draw_number() { Renderer::gl_draw_number(*this); }
+  void gl_draw_selectedfaces() { Renderer::gl_draw_selectedfaces(*this); }
+  void gl_draw_lines() { Renderer::gl_draw_lines(*this); }
+  void gl_draw_points() { Renderer::gl_draw_points(*this); }
+  void gl_draw_bounding_box() { Renderer::gl_draw_bounding_box(*this); }
+
+  //process hits
+  template <class Mode>
+  void gl_processhits(GLint hits, GLuint buffer[], Mode mode)
+  {
+    Renderer::gl_processhits(*this,hits,buffer,mode);
+  }
+
+private:
+  template <class T>
+  Handle<T> first()
+  {
+    Handle<T> h(this,NONE);
+    return ++h;
+  }
+
+  bool is_pure_degree(unsigned int d)
+  {
+    return size_of_facets_of_degree(d) == size_of_facets();
+  }
+
+  // the halfedges of facet f, nothing for NONE
+  unsigned int facet_size(unsigned int f) const
+  {
+    if(f == NONE)
+      return 0;
+    unsigned int n = 0, h = m_facet_halfedge[f];
+    do
+    {
+      n++;
+      h = m_next[h];
+    }
+    while(h != m_facet_halfedge[f]);
+    return n;
+  }
+
+  void count_facet(unsigned int f)
+  {
+    if(f == NONE)
+      return;
+    unsigned int d = facet_size(f);
+    if(d >= m_degrees.size())
+      m_degrees.resize(d+1,0);
+    m_degrees[d]++;
+  }
+
+  void uncount_facet(unsigned int f)
+  {
+    if(f == NONE)
+      return;
+    unsigned int d = facet_size(f);
+    CGAL_assertion(d < m_degrees.size() && m_degrees[d] > 0);
+    m_degrees[d]--;
+  }
+
+  bool invalid(bool verbose, const char *item, unsigned int index)
+  {
+    if(verbose)
+      std::cerr << "Enriched_surface_mesh::is_valid(): " << item
+                << " " << index << " is not linked properly" << std::endl;
+    return false;
+  }
+
+  void link(unsigned int h, unsigned int next)
+  {
+    m_next[h] = next;
+    m_prev[next] = h;
+  }
+
+  void set_facet_in_loop(unsigned int h, unsigned int f)
+  {
+    unsigned int x = h;
+    do
+    {
+      m_facet[x] = f;
+      x = m_next[x];
+    }
+    while(x != h);
+  }
+
+  // a vertex with the default attributes, or a copy of vertex 'copy'
+  unsigned int new_vertex(unsigned int copy)
+  {
+    unsigned int v = (unsigned int)m_points.size();
+    m_points.push_back(m_points[copy]);
+    m_vertex_halfedge.push_back(NONE);
+    m_vertex_properties.push_back();
+    m_vertex_properties.copy(copy,v);
+    return v;
+  }
+
+  unsigned int new_vertex(const Point& p)
+  {
+    unsigned int v = (unsigned int)m_points.size();
+    m_points.push_back(p);
+    m_vertex_halfedge.push_back(NONE);
+    m_vertex_properties.push_back();
+    return v;
+  }
+
+  // the pair h, h+1 with the default attributes, returns h
+  unsigned int new_edge()
+  {
+    unsigned int h = (unsigned int)m_next.size();
+    for(unsigned int i = 0; i < 2; i++)
+    {
+      m_next.push_back(NONE);
+      m_prev.push_back(NONE);
+      m_opposite.push_back(h+1-i);
+      m_vertex.push_back(NONE);
+      m_facet.push_back(NONE);
+      m_halfedge_properties.push_back();
+    }
+    return h;
+  }
+
+  unsigned int reuse_edge()
+  {
+    unsigned int h = m_free_edges.back();
+    m_free_edges.pop_back();
+    m_halfedge_properties.reset(h);
+    m_halfedge_properties.reset(m_opposite[h]);
+    return h;
+  }
+
+  // a facet with the default attributes, or a copy of facet 'copy'
+  unsigned int new_facet(unsigned int copy = NONE)
+  {
+    unsigned int f = (unsigned int)m_facet_halfedge.size();
+    m_facet_halfedge.push_back(NONE);
+    m_facet_properties.push_back();
+    if(copy != NONE)
+      m_facet_properties.copy(copy,f);
+    return f;
+  }
+
+  unsigned int reuse_facet(unsigned int copy)
+  {
+    unsigned int f = m_free_facets.back();
+    m_free_facets.pop_back();
+    m_facet_properties.copy(copy,f);
+    return f;
+  }
+
+  // the value of item i, 'value' if the property is not there
+  template <class T>
+  static T get(const Property_map<T>& map, unsigned int i, const T& value)
+  {
+    return map.is_valid() ? T(map[i]) : value;
+  }
+  static Vector get(const Property_map<Stored_normal>& map, unsigned int i)
+  {
+    return map.is_valid() ? map[i].template to<Vector>() : Vector(CGAL::NULL_VECTOR);
+  }
+
+  // the Enriched properties, added on the first write
+  Property_map<Stored_normal>& vertex_normals() { return add(m_vertex_properties,m_vertex_normals,"v:normal",Stored_normal()); }
+  Property_map<CColor>& vertex_colors() { return add(m_vertex_properties,m_vertex_colors,"v:color",CColor(MESHCOLOR)); }
+  Property_map<int>& vertex_tags() { return add(m_vertex_properties,m_vertex_tags,"v:tag",-1); }
+  Property_map<unsigned char>& vertex_dirty() { return add(m_vertex_properties,m_vertex_dirty,"v:dirty",(unsigned char)0); }
+  Property_map<int>& halfedge_tags() { return add(m_halfedge_properties,m_halfedge_tags,"h:tag",-1); }
+  Property_map<unsigned char>& control_edges() { return add(m_halfedge_properties,m_control_edges,"h:control_edge",(unsigned char)1); }
+  Property_map<Stored_normal>& facet_normals() { return add(m_facet_properties,m_facet_normals,"f:normal",Stored_normal()); }
+  Property_map<int>& facet_tags() { return add(m_facet_properties,m_facet_tags,"f:tag",-1); }
+  Property_map<unsigned char>& selected() { return add(m_facet_properties,m_selected,"f:selected",(unsigned char)0); }
+
+  template <class T>
+  static Property_map<T>& add(Property_container& properties, Property_map<T>& map,
+                              const char *name, const T& value)
+  {
+    if(!map.is_valid())
+      map = properties.add(name,value);
+    return map;
+  }
+
+  // after the containers were copied or emptied
+  void find_properties()
+  {
+    m_vertex_normals = m_vertex_properties.get<Stored_normal>("v:normal");
+    m_vertex_colors = m_vertex_properties.get<CColor>("v:color");
+    m_vertex_tags = m_vertex_properties.get<int>("v:tag");
+    m_vertex_dirty = m_vertex_properties.get<unsigned char>("v:dirty");
+    m_halfedge_tags = m_halfedge_properties.get<int>("h:tag");
+    m_control_edges = m_halfedge_properties.get<unsigned char>("h:control_edge");
+    m_facet_normals = m_facet_properties.get<Stored_normal>("f:normal");
+    m_facet_tags = m_facet_properties.get<int>("f:tag");
+    m_selected = m_facet_properties.get<unsigned char>("f:selected");
+  }
+
+  // new index of each item kept, NONE for the removed ones
+  static void pack(const std::vector<unsigned int>& items, std::vector<unsigned int>& index)
+  {
+    index.resize(items.size());
+    unsigned int n = 0;
+    for(std::size_t i = 0; i < items.size(); i++)
+      index[i] = items[i] == NONE ? (unsigned int)NONE : n++;
+  }
+
+  // the connectivity of the facets over the vertices already there,
+  // facet f gets the halfedges facet_begin[f]..facet_begin[f+1], the
+  // border ones follow, unless pHalfedges numbers them otherwise. The
+  // facet attributes set so far are kept.
+  // pHalfedges, if any, is the connectivity already built, used up
+  template <class Begin, class Index>
+  bool link(const Begin *facet_begin,
+            std::size_t nb_facets,
+            const Index *facet_vertices,
+            std::size_t nb_vertices,
+            std::string& error,
+            Mesh_halfedges *pHalfedges = NULL)
+  {
+    Mesh_halfedges built;
+    Mesh_halfedges& halfedges = pHalfedges ? *pHalfedges : built;
+    if(pHalfedges == NULL &&
+       !halfedges.build(facet_begin,nb_facets,facet_vertices,nb_vertices))
+    {
+      error = halfedges.error();
+      return false;
+    }
+    std::size_t nb = halfedges.size_of_halfedges();
+    m_next.swap(halfedges.next);
+    m_opposite.swap(halfedges.opposite);
+    m_vertex.swap(halfedges.vertex);
+    m_facet.swap(halfedges.facet);
+    m_vertex_halfedge.swap(halfedges.vertex_halfedge);
+    m_prev.resize(nb);
+    Prev_setter prev_setter;
+    prev_setter.pNext = nb ? &m_next[0] : NULL;
+    prev_setter.pPrev = nb ? &m_prev[0] : NULL;
+    ParallelUtils::parallel_for(0,nb,prev_setter,1<<14);
+    m_halfedge_properties.resize(nb);
+
+    // the first corner of a facet is its halfedge unless given
+    while(m_facet_halfedge.size() < nb_facets)
+      new_facet();
+    m_degrees.clear();
+    for(std::size_t f = 0; f < nb_facets; f++)
+    {
+      m_facet_halfedge[f] = halfedges.facet_halfedge.empty() ?
+        (unsigned int)facet_begin[f] : halfedges.facet_halfedge[f];
+      std::size_t d = facet_begin[f+1] - facet_begin[f];
+      if(d >= m_degrees.size())
+        m_degrees.resize(d+1,0);
+      m_degrees[d]++;
+    }
+    return true;
+  }
+
+private:
+  // vertices
+  std::vector<Point> m_points;
+  // a halfedge pointing to each vertex, NONE for an isolated one
+  std::vector<unsigned int> m_vertex_halfedge;
+
+  // halfedges, m_vertex is NONE for the removed ones
+  std::vector<unsigned int> m_next;
+  std::vector<unsigned int> m_prev;
+  std::vector<unsigned int> m_opposite;
+  std::vector<unsigned int> m_vertex;
+  // NONE on the border
+  std::vector<unsigned int> m_facet;
+
+  // facets, m_facet_halfedge is NONE for the removed ones
+  std::vector<unsigned int> m_facet_halfedge;
+
+  // one entry per item, removed ones included
+  Property_container m_vertex_properties;
+  Property_container m_halfedge_properties;
+  Property_container m_facet_properties;
+
+  // the Enriched attributes, null maps until written
+  Property_map<Stored_normal> m_vertex_normals;
+  Property_map<CColor> m_vertex_colors;
+  Property_map<int> m_vertex_tags;
+  Property_map<unsigned char> m_vertex_dirty;
+  Property_map<int> m_halfedge_tags;
+  Property_map<unsigned char> m_control_edges;
+  Property_map<Stored_normal> m_facet_normals;
+  Property_map<int> m_facet_tags;
+  Property_map<unsigned char> m_selected;
+
+  // holes left by join_facet(), the lower halfedge of each edge
+  std::vector<unsigned int> m_free_edges;
+  std::vector<unsigned int> m_free_facets;
+
+  // m_degrees[d] facets of degree d
+  std::vector<std::size_t> m_degrees;
+
+  Iso_cuboid m_bbox;
+
+  // type
+  bool m_pure_quad;
+  bool m_pure_triangle;
+};
+
+CGAL_BEGIN_NAMESPACE
+
+// CModifierQuadTriangle fills an Enriched_surface_mesh with its Builder
+template <class kernel>
+struct Mesh_builder< Enriched_surface_mesh<kernel> >
+{
+  typedef typename Enriched_surface_mesh<kernel>::Builder type;
+};
+
+CGAL_END_NAMESPACE
+
+// same kernel as Polyhedron, see mesh_kernel.h
+typedef Enriched_surface_mesh<Enriched_Polyhedron_kernel> Surface_mesh;
+
+#endif
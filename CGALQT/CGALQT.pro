@@ -5,20 +5,47 @@ HEADERS=./config.h \
 	./QT/mainwindow.h \
     ./QT/glmdichild.h \
 	./QT/filepropertydialog.h \
+	./QT/meshloader.h \
 	./CGAL/builder.h \
 	./CGAL/enriched_polyhedron.h \
 	./CGAL/parser_obj.h \
+	./CGAL/parser_off.h \
+	./CGAL/mesh_binary.h \
+	./CGAL/mesh_text.h \
+	./CGAL/mesh_ply.h \
+	./CGAL/mesh_stl.h \
+	./CGAL/mesh_preview.h \
+	./CGAL/mesh_view.h \
+	./CGAL/mesh_chunks.h \
+	./CGAL/mesh_archive.h \
+	./CGAL/mesh_weld.h \
+	./CGAL/mesh_halfedges.h \
+	./CGAL/mesh_kernel.h \
+	./CGAL/mesh_allocator.h \
+	./CGAL/mesh_property.h \
+	./CGAL/mesh_render.h \
+	./CGAL/mesh_reorder.h \
+	./CGAL/surface_mesh.h \
+	./CGAL/indexed_mesh.h \
 	./CGAL/sqrt3.h \
 	./CGAL/quad-triangle.h \
+	./CGAL/subdivision.h \
+	./CGAL/stencil_table.h \
 	./CGAL/enriched_polygon.h \
 	./CGAL/quad-simp.h \
 	./Util/uglyfont.h \
 	./Util/stringutils.h \
+	./Util/numparse.h \
+	./Util/numformat.h \
+	./Util/mappedfile.h \
+	./Util/compressedfile.h \
+	./Util/parallelutils.h \
 				
 SOURCES =./QT/main.cpp \
          ./QT/mainwindow.cpp \
          ./QT/glmdichild.cpp \
          ./QT/filepropertydialog.cpp \
+         ./QT/meshloader.cpp \
          ./Util/uglyfont.cpp \
 				
 RESOURCES     = ./QT/mdi.qrc
@@ -35,3 +62,16 @@ LIBS += -L$(CGALROOT)/lib -L$(CGALROOT)/auxiliary/taucs/lib -L$(BOOSTROOT)/stage
 win32:DEFINES += NOMINMAX _SECURE_SCL=0 _CRT_SECURE_NO_DEPRECATE _SCL_SECURE_NO_DEPRECATE
 
 CONFIG += stl
+
+# boost thread, filesystem and iostreams, iostreams built with zlib and
+# zstd for the .gz and .zst models, see Util/compressedfile.h and readme.txt.
+# msvc finds the boost libraries by itself (auto-linking)
+unix:LIBS += -lboost_iostreams -lboost_filesystem -lboost_thread -lboost_system -lz
+
+# the .zst models need boost 1.70 or later, uncomment to build without them
+#DEFINES += CGALQT_NO_ZSTD
+unix:!contains(DEFINES, CGALQT_NO_ZSTD):LIBS += -lzstd
+
+# kernel of the meshes, CGAL::Cartesian<double> by default, see CGAL/mesh_kernel.h
+#DEFINES += CGALQT_KERNEL_SIMPLE_DOUBLE
+#DEFINES += CGALQT_KERNEL_SIMPLE_FLOAT
@@ -97,7 +97,7 @@ MeshTab::MeshTab(int vernum, int edgenum, int facenum, QWidget *parent)
 	vernumValueLabel->setFrameStyle(QFrame::Panel | QFrame::Sunken);
 
 	QLabel *edgenumLabel = new QLabel(tr("Edges number:"));
-	QLabel *edgenumValueLabel = new QLabel(QString::number(edgenum));
+	QLabel *edgenumValueLabel = new QLabel(edgenum < 0 ? tr("unknown") : QString::number(edgenum));
 	edgenumValueLabel->setFrameStyle(QFrame::Panel | QFrame::Sunken);
 
 	QLabel *facenumLabel = new QLabel(tr("Facets number:"));
@@ -52,6 +52,7 @@ class FilePropertyDialog : public QDialog
     Q_OBJECT
 
 public:
+    //a negative edgenum shows the edges as unknown
     FilePropertyDialog(const QString &fileName, int vernum, int edgenum, int facenum, QWidget *parent = 0);
 
 private:
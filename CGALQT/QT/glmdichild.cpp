@@ -22,14 +22,15 @@
 ****************************************************************************/
 #include <QtGui>
 #include "glmdichild.h"
+#include "meshloader.h"
 //stl
 #include <iostream>
 #include <fstream>
 
 //cgal
-#include "parser_obj.h"
 #include "sqrt3.h"
 #include "quad-triangle.h"
+#include "subdivision.h"
 #include "quad-simp.h"
 #include "fallson.h"
 #include <CGAL/Subdivision_method_3.h>
@@ -49,6 +50,9 @@ GLMdiChild::GLMdiChild(QWidget *parent)
 	setCurCursor();
 
 	m_pMesh = NULL;
+	m_pView = NULL;
+	m_pChunks = NULL;
+	m_chunkListener.pChild = this;
 
 	m_renderMode = RMFlatLines;
 	m_bbox = false;
@@ -56,11 +60,14 @@ GLMdiChild::GLMdiChild(QWidget *parent)
 	m_selectedRender = true;
 	m_numberRender = false;
 	m_selectMode = SMNone;
+	m_weldEpsilon = -1.0;
 }
 
 GLMdiChild::~GLMdiChild()
 {
 	CGALQT_DELETE(m_pMesh);
+	CGALQT_DELETE(m_pView);
+	CGALQT_DELETE(m_pChunks);
 	
 	BOOST_FOREACH(EPolygon* poly, m_pPolys)
 		CGALQT_DELETE(poly);
@@ -71,41 +78,22 @@ GLMdiChild::~GLMdiChild()
 /************************************************************************/
 bool GLMdiChild::loadFile(const QString &fileName)
 {
-	QString extension = QFileInfo(fileName).suffix();
-	extension = extension.toLower();
+	QString extension = MeshLoader::modelExtension(fileName);
 
 	// mesh extension
-	if(extension == "off" || extension == "obj")
+	if(MeshLoader::canLoad(fileName))
 	{
-		if(NULL == m_pMesh)
-			m_pMesh = new Polyhedron();
-
-		if(extension == "off")
-		{
-			/************************************************************************/
-			//ok, this part code should be written into Polyhedron class
-			//such as m_pMesh->read_off()
-			/************************************************************************/
-			std::ifstream stream(qPrintable(fileName));
-			if(!stream)
-			{
-				QMessageBox::warning(this, tr("CGALQT"),tr("read file error"), QMessageBox::Close);
-				return false;
-			}
-			stream >> *m_pMesh;
-		}
-		else if(extension == "obj")
+		MeshLoader loader(fileName,m_weldEpsilon);
+		if(!loader.load())
 		{
-			/************************************************************************/
-			/* and m_pMesh->read_obj()                                             */
-			/************************************************************************/
-                        Parser_obj<Enriched_Polyhedron_kernel,Enriched_items> parser;
-			parser.read(qPrintable(fileName),m_pMesh);
+			QMessageBox::warning(this, tr("CGALQT"),tr("read file error\n%1").arg(loader.error()), QMessageBox::Close);
+			return false;
 		}
-
-		m_pMesh->compute_type();
-		m_pMesh->compute_normals();
-		m_pMesh->compute_bounding_box();
+		Polyhedron_view *pView = loader.takeView();
+		if(pView)
+			setView(pView);
+		else
+			setChunks(loader.takeChunks());
 	}
 	else if(extension == "pol")//polygon extension
 	{
@@ -135,35 +123,40 @@ bool GLMdiChild::loadFile(const QString &fileName)
     return true;
 }
 
-bool GLMdiChild::saveFile(const QString &fileName)
+bool GLMdiChild::saveFile(const QString &fileName, int archiveBits)
 {
-	QString extension = QFileInfo(fileName).suffix();
-	extension = extension.toLower();
+	QString extension = MeshLoader::modelExtension(fileName);
 
-	if(extension == "off" || extension == "obj")
+	if(extension == "off" || extension == "obj" || extension == "ply" || extension == "cqm" || extension == "stl" || extension == "cqz")
 	{
-		if(NULL == m_pMesh)
+		if(!hasMesh())
 		{
 			QMessageBox::warning(this, tr("CGALQT"),tr("write file error"), QMessageBox::Close);
 			return false;
 		}
 
-		if(extension == "off")
-		{
-			/************************************************************************/
-			/* m_pMesh->write_off()                                                 */
-			/************************************************************************/
-			std::ofstream stream(qPrintable(fileName));
-			if(!stream)
-			{
-				QMessageBox::warning(this, tr("CGALQT"),tr("write file error"), QMessageBox::Close);
-				return false;
-			}
-			stream << *m_pMesh;
-		}
+		// the binary container is written from the indexed view directly
+		bool ok = true;
+		if(extension == "cqm" && NULL == m_pMesh && m_pView)
+			ok = m_pView->write_binary(qPrintable(fileName));
+		else if(!buildMesh())
+			return false;
+		else if(extension == "off")
+			ok = m_pMesh->write_off(qPrintable(fileName));
 		else if(extension == "obj")
+			ok = m_pMesh->write_obj(qPrintable(fileName));
+		else if(extension == "ply")
+			ok = m_pMesh->write_ply(qPrintable(fileName));
+		else if(extension == "cqm")
+			ok = m_pMesh->write_binary(qPrintable(fileName));
+		else if(extension == "stl")
+			ok = m_pMesh->write_stl(qPrintable(fileName));
+		else if(extension == "cqz")
+			ok = m_pMesh->write_archive(qPrintable(fileName),archiveBits);
+		if(!ok)
 		{
-			m_pMesh->write_obj(qPrintable(fileName));
+			QMessageBox::warning(this, tr("CGALQT"),tr("write file error"), QMessageBox::Close);
+			return false;
 		}
 	}
 	else if(extension == "pol")
@@ -201,6 +194,76 @@ bool GLMdiChild::saveToBmp(const QString &fileName)
 	QImage img = this->grabFrameBuffer();
 	return img.save(fileName,0,100);
 }
+
+void GLMdiChild::setMesh(Polyhedron* pMesh)
+{
+	CGALQT_DELETE(m_pMesh);
+	CGALQT_DELETE(m_pView);
+	CGALQT_DELETE(m_pChunks);
+	m_pMesh = pMesh;
+	std::vector<float>().swap(m_preview);
+}
+
+void GLMdiChild::setView(Polyhedron_view* pView)
+{
+	CGALQT_DELETE(m_pMesh);
+	CGALQT_DELETE(m_pView);
+	CGALQT_DELETE(m_pChunks);
+	m_pView = pView;
+	std::vector<float>().swap(m_preview);
+}
+
+void GLMdiChild::setChunks(Chunked_mesh* pChunks)
+{
+	CGALQT_DELETE(m_pMesh);
+	CGALQT_DELETE(m_pView);
+	CGALQT_DELETE(m_pChunks);
+	m_pChunks = pChunks;
+	if(m_pChunks)
+		m_pChunks->set_listener(&m_chunkListener);
+	std::vector<float>().swap(m_preview);
+}
+
+void GLMdiChild::ChunkListener::chunks_loaded()
+{
+	QMetaObject::invokeMethod(pChild, "updateGL", Qt::QueuedConnection);
+}
+
+bool GLMdiChild::isPureTriangle()
+{
+	if(m_pMesh)
+		return m_pMesh->is_pure_triangle();
+	return m_pView != NULL && m_pView->is_pure_triangle();
+}
+
+bool GLMdiChild::buildMesh()
+{
+	if(m_pMesh)
+		return true;
+	if(NULL == m_pView)
+		return false;
+
+	// the view is dropped once the half-edge mesh exists
+	QApplication::setOverrideCursor(Qt::WaitCursor);
+	Polyhedron *pMesh = new Polyhedron();
+	std::string error;
+	bool ok = m_pView->build(*pMesh,error);
+	QApplication::restoreOverrideCursor();
+	if(!ok)
+	{
+		CGALQT_DELETE(pMesh);
+		QMessageBox::warning(this, tr("CGALQT"),tr("build mesh error\n%1").arg(error.c_str()), QMessageBox::Close);
+		return false;
+	}
+	setMesh(pMesh);
+	return true;
+}
+
+void GLMdiChild::addPreview(const std::vector<float>& points)
+{
+	m_preview.insert(m_preview.end(),points.begin(),points.end());
+	updateGL();
+}
 /////////////////////////////private/////////////////////////////////////////////
 void GLMdiChild::setCurrentFile(const QString &fileName)
 {
@@ -217,9 +280,13 @@ bool GLMdiChild::sqrt3Sub()
 {
         CSubdivider_sqrt3<Polyhedron,Enriched_Polyhedron_kernel> subdivider;
 
+	if(!buildMesh())
+		return false;
 	bool ret = subdivider.subdivide(*m_pMesh,1);
 	if(ret)
 	{
+		// not reordered: the next step smooths from the vertex halfedges
+		// and in the edge order this one leaves, as the edge flips did
 		m_pMesh->compute_type();
 		m_pMesh->compute_normals();
 		m_pMesh->compute_bounding_box();
@@ -231,11 +298,15 @@ bool GLMdiChild::quad_triangleSub()
 {
         CSubdivider_quad_triangle<Polyhedron,Enriched_Polyhedron_kernel> subdivider;
 
+	if(!buildMesh())
+		return false;
+
 	// alloc a new mesh
 	Polyhedron *pNewMesh = new Polyhedron;
 
 	// subdivide once
 	subdivider.subdivide(*m_pMesh,*pNewMesh,true);
+	pNewMesh->reorder_if_scattered();
 	// copy bounding box (approximate, but fast)
 	pNewMesh->copy_bounding_box(m_pMesh);
 	pNewMesh->compute_normals();
@@ -251,7 +322,16 @@ bool GLMdiChild::quad_triangleSub()
 
 bool GLMdiChild::doosabinSub()
 {
-	CGAL::Subdivision_method_3::DooSabin_subdivision(*m_pMesh);
+	if(!buildMesh())
+		return false;
+	CSubdivider_doo_sabin<Polyhedron,Enriched_Polyhedron_kernel> subdivider;
+	if(!subdivider.subdivide(*m_pMesh))
+	{
+		// a vertex the arrays cannot rebuild, CGAL edits the HalfedgeDS directly
+		CGAL::Subdivision_method_3::DooSabin_subdivision(*m_pMesh);
+		m_pMesh->compute_degrees();
+	}
+	m_pMesh->reorder_if_scattered();
 	m_pMesh->compute_type();
 	m_pMesh->compute_normals();
 	m_pMesh->compute_bounding_box();
@@ -261,7 +341,15 @@ bool GLMdiChild::doosabinSub()
 
 bool GLMdiChild::catmullclarkSub()
 {
-	CGAL::Subdivision_method_3::CatmullClark_subdivision(*m_pMesh);
+	if(!buildMesh())
+		return false;
+	CSubdivider_catmull_clark<Polyhedron,Enriched_Polyhedron_kernel> subdivider;
+	if(!subdivider.subdivide(*m_pMesh))
+	{
+		CGAL::Subdivision_method_3::CatmullClark_subdivision(*m_pMesh);
+		m_pMesh->compute_degrees();
+	}
+	m_pMesh->reorder_if_scattered();
 	m_pMesh->compute_type();
 	m_pMesh->compute_normals();
 	m_pMesh->compute_bounding_box();
@@ -270,7 +358,15 @@ bool GLMdiChild::catmullclarkSub()
 
 bool GLMdiChild::loopSub()
 {
-	CGAL::Subdivision_method_3::Loop_subdivision(*m_pMesh);
+	if(!buildMesh())
+		return false;
+	CSubdivider_loop<Polyhedron,Enriched_Polyhedron_kernel> subdivider;
+	if(!subdivider.subdivide(*m_pMesh))
+	{
+		CGAL::Subdivision_method_3::Loop_subdivision(*m_pMesh);
+		m_pMesh->compute_degrees();
+	}
+	m_pMesh->reorder_if_scattered();
 	m_pMesh->compute_type();
 	m_pMesh->compute_normals();
 	m_pMesh->compute_bounding_box();
@@ -339,7 +435,7 @@ bool GLMdiChild::fallsonSub()
 
 bool GLMdiChild::euler_split_facet()
 {
-	if( NULL == m_pMesh )
+	if(!buildMesh())
 		return false;
 
 	if(m_pMesh->euler_split_facet())
@@ -354,7 +450,7 @@ bool GLMdiChild::euler_split_facet()
 
 bool GLMdiChild::euler_join_facet()
 {
-	if( NULL == m_pMesh )
+	if(!buildMesh())
 		return false;
 
 	if(m_pMesh->euler_join_facet())
@@ -369,7 +465,7 @@ bool GLMdiChild::euler_join_facet()
 
 bool GLMdiChild::euler_create_center_vertex()
 {
-	if( NULL == m_pMesh )
+	if(!buildMesh())
 		return false;
 
 	if(m_pMesh->euler_create_center_vertex())
@@ -586,7 +682,14 @@ void GLMdiChild::paintGL()
 	glRotated(m_modelview.get_zRot() / 16.0, 0.0, 0.0, 1.0);
 	glScaled(m_modelview.get_xyzScale(), m_modelview.get_xyzScale(), m_modelview.get_xyzScale());
 
-	if(m_renderMode == RMPoints)
+	// only the chunks already read are drawn, the loader thread reads
+	// the others and m_chunkListener repaints once they are there
+	if(m_pChunks)
+		m_pChunks->update();
+
+	if(NULL == m_pMesh && NULL == m_pView && NULL == m_pChunks && !m_preview.empty())
+		paintGL_Preview();
+	else if(m_renderMode == RMPoints)
 		paintGL_Points();
 	else if(m_renderMode == RMLines)
 		paintGL_Lines();
@@ -610,6 +713,9 @@ void GLMdiChild::paintGL()
 	if(m_bbox)
 		paintGL_BBox();
 
+	if(m_pChunks)
+		paintGL_Missing();
+
 	if(m_selectMode == SMRectSel)
 		drawXORRect(m_ptStartPos, m_ptCurPos);
 
@@ -625,10 +731,25 @@ void GLMdiChild::paintGL_Points()
 	glColor3ub(POINTSCOLOR.red(),POINTSCOLOR.green(),POINTSCOLOR.blue());
 	if(m_pMesh)
 		m_pMesh->gl_draw_points();
+	else if(m_pView)
+		m_pView->gl_draw_points();
+	else if(m_pChunks)
+		m_pChunks->gl_draw_points();
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw_points();
 }
 
+void GLMdiChild::paintGL_Preview()
+{
+	glDisable(GL_LIGHTING);
+	glShadeModel(GL_FLAT);
+	glColor3ub(POINTSCOLOR.red(),POINTSCOLOR.green(),POINTSCOLOR.blue());
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3,GL_FLOAT,0,&m_preview[0]);
+	glDrawArrays(GL_POINTS,0,(GLsizei)(m_preview.size()/3));
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 void GLMdiChild::paintGL_Lines()
 {
 	glDisable(GL_LIGHTING);
@@ -636,6 +757,10 @@ void GLMdiChild::paintGL_Lines()
 	glColor3ub(LINESCOLOR.red(),LINESCOLOR.green(),LINESCOLOR.blue());
 	if(m_pMesh)
 		m_pMesh->gl_draw_lines();
+	else if(m_pView)
+		m_pView->gl_draw_lines();
+	else if(m_pChunks)
+		m_pChunks->gl_draw_lines();
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw_lines();
 }
@@ -649,6 +774,10 @@ void GLMdiChild::paintGL_BackLines()
 	glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 	if(m_pMesh)
 		m_pMesh->gl_draw(false,false);
+	else if(m_pView)
+		m_pView->gl_draw(false,false);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(false,false);
 	glColorMask(GL_TRUE,GL_TRUE,GL_TRUE,GL_TRUE);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 
@@ -658,6 +787,10 @@ void GLMdiChild::paintGL_BackLines()
 	glColor3ub(LINESCOLOR.red(),LINESCOLOR.green(),LINESCOLOR.blue());
 	if(m_pMesh)
 		m_pMesh->gl_draw(false,false);
+	else if(m_pView)
+		m_pView->gl_draw(false,false);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(false,false);
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw_lines();
 }
@@ -674,7 +807,11 @@ void GLMdiChild::paintGL_FlatLines()
 	glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 	glColor3ub(MESHCOLOR.red(),MESHCOLOR.green(),MESHCOLOR.blue());
 	if(m_pMesh)
-		m_pMesh->gl_draw(false,true);
+		m_pMesh->gl_draw(false,true,true);
+	else if(m_pView)
+		m_pView->gl_draw(false,true,true);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(false,true,true);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 
 	glDisable(GL_LIGHTING);
@@ -683,6 +820,10 @@ void GLMdiChild::paintGL_FlatLines()
 	glColor3ub(LINESCOLOR.red(),LINESCOLOR.green(),LINESCOLOR.blue());
 	if(m_pMesh)
 		m_pMesh->gl_draw(false,false);
+	else if(m_pView)
+		m_pView->gl_draw(false,false);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(false,false);
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw(false,false);
 }
@@ -697,7 +838,11 @@ void GLMdiChild::paintGL_Flat()
 	glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 	glColor3ub(MESHCOLOR.red(),MESHCOLOR.green(),MESHCOLOR.blue());
 	if(m_pMesh)
-		m_pMesh->gl_draw(false,true);
+		m_pMesh->gl_draw(false,true,true);
+	else if(m_pView)
+		m_pView->gl_draw(false,true,true);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(false,true,true);
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw(false,false);
 }
@@ -712,7 +857,11 @@ void GLMdiChild::paintGL_Smooth()
 	glPolygonMode(GL_FRONT_AND_BACK,GL_FILL);
 	glColor3ub(MESHCOLOR.red(),MESHCOLOR.green(),MESHCOLOR.blue());
 	if(m_pMesh)
-		m_pMesh->gl_draw(true,true);
+		m_pMesh->gl_draw(true,true,true);
+	else if(m_pView)
+		m_pView->gl_draw(true,true,true);
+	else if(m_pChunks)
+		m_pChunks->gl_draw(true,true,true);
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw(false,false);
 }
@@ -727,6 +876,8 @@ void GLMdiChild::paintGL_Number()
 		1.0f);
 	if(m_pMesh)
 		m_pMesh->gl_draw_number();
+	else if(m_pView)
+		m_pView->gl_draw_number();
 	BOOST_FOREACH(EPolygon* pPoly, m_pPolys)
 		pPoly->gl_draw_number();
 }
@@ -746,6 +897,10 @@ void GLMdiChild::paintGL_Selected()
 		0.3f);
 	if(m_pMesh)
 		m_pMesh->gl_draw_selectedfaces();
+	else if(m_pView)
+		m_pView->gl_draw_selectedfaces();
+	else if(m_pChunks)
+		m_pChunks->gl_draw_selectedfaces();
 	glDepthMask(GL_TRUE);
 	glDisable(GL_POLYGON_OFFSET_FILL);
 }
@@ -757,6 +912,19 @@ void GLMdiChild::paintGL_BBox()
 	glColor3ub(BBOXCOLOR.red(),BBOXCOLOR.green(),BBOXCOLOR.blue());
 	if(m_pMesh)
 		m_pMesh->gl_draw_bounding_box();
+	else if(m_pView)
+		m_pView->gl_draw_bounding_box();
+	else if(m_pChunks)
+		m_pChunks->gl_draw_bounding_box();
+}
+
+//the boxes of the visible chunks not loaded yet
+void GLMdiChild::paintGL_Missing()
+{
+	glDisable(GL_LIGHTING);
+	glShadeModel(GL_FLAT);
+	glColor3ub(BBOXCOLOR.red(),BBOXCOLOR.green(),BBOXCOLOR.blue());
+	m_pChunks->gl_draw_missing();
 }
 
 void GLMdiChild::drawXORRect(QPoint start, QPoint cur)
@@ -813,9 +981,22 @@ void GLMdiChild::doRectSelect(QPoint start, QPoint cur, ProcesshitsType type)
 		return; 
 
 	makeCurrent();
-	
+
+	if(m_pMesh)
+		doRectSelect(m_pMesh,m_pMesh->size_of_facets(),x,y,width,height,type);
+	else if(m_pView)
+		doRectSelect(m_pView,m_pView->size_of_facets(),x,y,width,height,type);
+	else if(m_pChunks)
+		doRectSelect(m_pChunks,m_pChunks->size_of_loaded_facets(),x,y,width,height,type);
+}
+
+//the facets are named by their index, see gl_draw(),
+//nbFacets is the number of facets drawn
+template <class Mesh>
+void GLMdiChild::doRectSelect(Mesh *pMesh, size_t nbFacets, int x, int y, int width, int height, ProcesshitsType type)
+{
 	long hits;	
-	int sz=m_pMesh->size_of_facets()*5;
+	int sz=nbFacets*5;
 	GLuint *selectBuf =new GLuint[sz];
 	glSelectBuffer(sz, selectBuf);
 	glRenderMode(GL_SELECT);
@@ -833,17 +1014,17 @@ void GLMdiChild::doRectSelect(QPoint start, QPoint cur, ProcesshitsType type)
 	gluPickMatrix(x, viewport[3]-y, width, height, viewport);
 	glMultMatrixd(mp);
 
-	m_pMesh->gl_draw(false,false);
+	pMesh->gl_draw(false,false);
 
 	glPopMatrix();
 	hits = glRenderMode(GL_RENDER);
 
 	if(type == PTPlus)
-		m_pMesh->gl_processhits(hits,selectBuf,processhits_plus());
+		pMesh->gl_processhits(hits,selectBuf,processhits_plus());
 	if(type == PTMinus)
-		m_pMesh->gl_processhits(hits,selectBuf,processhits_minus());
+		pMesh->gl_processhits(hits,selectBuf,processhits_minus());
 	if(type == PTNormal)
-		m_pMesh->gl_processhits(hits,selectBuf,processhits_normal());
+		pMesh->gl_processhits(hits,selectBuf,processhits_normal());
 
 	CGALQT_DELETE_ARRAY(selectBuf);
 }
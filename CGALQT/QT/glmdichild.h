@@ -30,6 +30,7 @@
 #include <CGAL/basic.h>
 #include <CGAL/enum.h>
 #include "enriched_polyhedron.h"
+#include "mesh_chunks.h"
 #include "enriched_polygon.h"
 
 class ModelView
@@ -152,7 +153,8 @@ public:
 	/************************************************************************/
 	//file
 	bool loadFile(const QString &fileName);
-	bool saveFile(const QString &fileName);
+	//archiveBits is the precision of the positions in a .cqz
+	bool saveFile(const QString &fileName, int archiveBits = Mesh_archive_header::DEFAULT_BITS);
 	bool saveToBmp(const QString &fileName);
 
 	//render mode
@@ -167,6 +169,10 @@ public:
 	void setNumberRender(bool num) {m_numberRender = num; }
 	bool getNumberRender() {return m_numberRender; }
 
+	//file
+	void setWeldEpsilon(double epsilon) { m_weldEpsilon = epsilon; }
+	double getWeldEpsilon() { return m_weldEpsilon; }
+
 	//subdivision
 	bool sqrt3Sub();
 	bool quad_triangleSub();
@@ -191,11 +197,27 @@ public:
 	bool euler_create_center_vertex();
 
 	//other
+	//the half-edge mesh, NULL as long as no topology operation needed it
 	Polyhedron* getMesh(){ return m_pMesh; }
+	//the indexed mesh a loaded model is shown with, NULL once built
+	Polyhedron_view* getView(){ return m_pView; }
+	bool hasMesh() { return m_pMesh != NULL || m_pView != NULL; }
+	//the chunks of an out-of-core model, it has no mesh in memory
+	Chunked_mesh* getChunks(){ return m_pChunks; }
+	bool isPureTriangle();
 	const std::vector<EPolygon*>& getPolys(){ return m_pPolys; }
 	size_t getPolysSize() { return m_pPolys.size(); } 
-	//void setMesh(Polyhedron* pMesh){ m_pMesh = pMesh; }
+	//takes the ownership of pMesh, usually a MeshLoader result
+	void setMesh(Polyhedron* pMesh);
+	//takes the ownership of pView, the half-edge mesh is built on demand
+	void setView(Polyhedron_view* pView);
+	//takes the ownership of pChunks, their loader thread reads them
+	//from the disk and the widget repaints as they come
+	void setChunks(Chunked_mesh* pChunks);
+	//x,y,z points drawn until a mesh is set
+	void addPreview(const std::vector<float>& points);
 	QString currentFile() { return m_strCurFile; }
+	void setCurrentFile(const QString &fileName);
 
 protected:
 	//opengl
@@ -213,8 +235,16 @@ protected:
 	
 
 private:
-	void setCurrentFile(const QString &fileName);
+	//queues a repaint from the chunk loader thread
+	struct ChunkListener : public Chunk_listener
+	{
+		GLMdiChild *pChild;
+		void chunks_loaded();
+	};
+
 	void setCurCursor(CursorType type = CTPlain);
+	//builds m_pMesh from m_pView if needed, false if there is no mesh
+	bool buildMesh();
 
 	//opengl
 	void paintGL_Points();
@@ -223,10 +253,14 @@ private:
 	void paintGL_FlatLines();
 	void paintGL_Flat();
 	void paintGL_Smooth();
+	void paintGL_Preview();
 	void paintGL_Number();
 	void paintGL_Selected();
 	void paintGL_BBox();
+	void paintGL_Missing();
 	void doRectSelect(QPoint start, QPoint cur, ProcesshitsType type);
+	template <class Mesh>
+	void doRectSelect(Mesh *pMesh, size_t nbFacets, int x, int y, int width, int height, ProcesshitsType type);
 	void drawXORRect(QPoint start, QPoint cur);
 
 private:
@@ -236,6 +270,10 @@ private:
 	QPoint m_ptCurPos;
 
 	Polyhedron *m_pMesh;
+	Polyhedron_view *m_pView;
+	Chunked_mesh *m_pChunks;
+	ChunkListener m_chunkListener;
+	std::vector<float> m_preview; //points of a mesh still loading
 	std::vector<EPolygon*> m_pPolys;
 
 	//opengl
@@ -247,6 +285,8 @@ private:
 	bool m_numberRender;
 
 	SelectMode m_selectMode; //whether in select mode
+
+	double m_weldEpsilon; //vertex weld distance when loading, < 0 to keep the vertices
 };
 
 #endif
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include <QtGui>
 #include "mainwindow.h"
 #include "glmdichild.h"
+#include "meshloader.h"
 #include "filepropertydialog.h"
 #include <vector>
 #include <boost/foreach.hpp>
@@ -53,6 +54,10 @@ void MainWindow::closeEvent(QCloseEvent *event)
     } 
 	else 
 	{
+		// the loader threads must be done before they are deleted
+		cancelLoads();
+		foreach (MeshLoader *loader, loaders)
+			loader->wait();
         writeSettings();
         event->accept();
     }
@@ -106,6 +111,31 @@ void MainWindow::createFileActions()
 	snapshotAct->setStatusTip(tr("Save Snapshot"));
 	snapshotAct->setActionGroup(fileActGroup);
 	connect(snapshotAct, SIGNAL(triggered()), this, SLOT(snapshot()));
+
+	weldAct = new QAction(tr("&Weld Duplicate Vertices..."), this);
+	weldAct->setStatusTip(tr("Merge the vertices closer than a distance when opening OBJ, OFF and STL files"));
+	weldAct->setCheckable(true);
+	connect(weldAct, SIGNAL(triggered()), this, SLOT(weld()));
+	weldEpsilon = 0.0;
+
+	cancelLoadAct = new QAction(tr("Cancel &Loading"), this);
+	cancelLoadAct->setShortcut(Qt::Key_Escape);
+	cancelLoadAct->setStatusTip(tr("Cancel the files being loaded"));
+	cancelLoadAct->setEnabled(false);
+	connect(cancelLoadAct, SIGNAL(triggered()), this, SLOT(cancelLoads()));
+
+	previewAct = new QAction(tr("Progressive &Preview"), this);
+	previewAct->setStatusTip(tr("Show the points of a model while it is loading"));
+	previewAct->setCheckable(true);
+
+	outOfCoreAct = new QAction(tr("&Out-of-Core Viewing"), this);
+	outOfCoreAct->setStatusTip(tr("Split the models in chunks on disk and keep only the visible ones in memory"));
+	outOfCoreAct->setCheckable(true);
+
+	archiveAct = new QAction(tr("&Archive Precision..."), this);
+	archiveAct->setStatusTip(tr("Bits per coordinate of the positions saved in CGALQT archives"));
+	connect(archiveAct, SIGNAL(triggered()), this, SLOT(archivePrecision()));
+	archiveBits = Mesh_archive_header::DEFAULT_BITS;
 }
 
 void MainWindow::createRenderModeActions()
@@ -316,6 +346,7 @@ void MainWindow::updateFileActions()
 	{
 		fileActGroup->setDisabled(true);
 	}
+	cancelLoadAct->setEnabled(!loaders.isEmpty());
 }
 void MainWindow::updateRenderModeActions()
 {
@@ -357,13 +388,13 @@ void MainWindow::updateSubdivisionActions()
 	if(pChild)
 	{
 		subdivisionActGroup->setDisabled(false);
-		Polyhedron* pMesh = pChild->getMesh();
+		bool hasMesh = pChild->hasMesh();
 
-		sqrt3Act->setEnabled(pMesh != NULL && pMesh->is_pure_triangle());
-		quad_triangleAct->setEnabled(pMesh != NULL);	
-		doosabinAct->setEnabled(pMesh != NULL);
-		catmullclarkAct->setEnabled(pMesh != NULL);
-		loopAct->setEnabled(pMesh != NULL && pMesh->is_pure_triangle());
+		sqrt3Act->setEnabled(pChild->isPureTriangle());
+		quad_triangleAct->setEnabled(hasMesh);	
+		doosabinAct->setEnabled(hasMesh);
+		catmullclarkAct->setEnabled(hasMesh);
+		loopAct->setEnabled(pChild->isPureTriangle());
 	}
 	else
 	{
@@ -408,9 +439,8 @@ void MainWindow::updateSimplificationActions()
 	GLMdiChild* pChild = activeMdiChild();
 	if(pChild)
 	{	
-		Polyhedron* pMesh = pChild->getMesh();
 		simplificationActGroup->setDisabled(false);
-		quadSimplifyAct->setEnabled(pMesh != NULL);
+		quadSimplifyAct->setEnabled(pChild->hasMesh());
 	}
 	else
 	{
@@ -422,12 +452,12 @@ void MainWindow::updateFallsonActions()
 	GLMdiChild* pChild = activeMdiChild();
 	if(pChild)
 	{	
-		Polyhedron* pMesh = pChild->getMesh();
+		bool hasMesh = pChild->hasMesh();
 		fallsonActGroup->setDisabled(false);
-		fallsonSubAct->setEnabled(pMesh != NULL);
-		fallson_EulerSplitFacetAct->setEnabled(pMesh != NULL);
-		fallson_EulerJoinFacetAct->setEnabled(pMesh != NULL);
-		fallson_EulerCreateCenterVertexAct->setEnabled(pMesh != NULL);
+		fallsonSubAct->setEnabled(hasMesh);
+		fallson_EulerSplitFacetAct->setEnabled(hasMesh);
+		fallson_EulerJoinFacetAct->setEnabled(hasMesh);
+		fallson_EulerCreateCenterVertexAct->setEnabled(hasMesh);
 	}
 	else
 	{
@@ -456,6 +486,12 @@ void MainWindow::createFileMenus()
 	fileMenu->addAction(propertyAct);
 	fileMenu->addAction(snapshotAct);
 	fileMenu->addSeparator();
+	fileMenu->addAction(weldAct);
+	fileMenu->addAction(previewAct);
+	fileMenu->addAction(outOfCoreAct);
+	fileMenu->addAction(archiveAct);
+	fileMenu->addAction(cancelLoadAct);
+	fileMenu->addSeparator();
 	fileMenu->addAction(exitAct);
 }
 
@@ -586,6 +622,18 @@ void MainWindow::createToolBars()
 void MainWindow::createStatusBar()
 {
     statusBar()->showMessage(tr("Ready"));
+
+	loadProgressBar = new QProgressBar;
+	loadProgressBar->setRange(0, 100);
+	loadProgressBar->setMaximumWidth(160);
+	loadProgressBar->hide();
+	statusBar()->addPermanentWidget(loadProgressBar);
+
+	cancelLoadButton = new QToolButton;
+	cancelLoadButton->setDefaultAction(cancelLoadAct);
+	cancelLoadButton->setAutoRaise(true);
+	cancelLoadButton->hide();
+	statusBar()->addPermanentWidget(cancelLoadButton);
 }
 
 void MainWindow::readSettings()
@@ -595,6 +643,11 @@ void MainWindow::readSettings()
     QSize size = settings.value("size", QSize(400, 400)).toSize();
     move(pos);
     resize(size);
+    weldAct->setChecked(settings.value("weld", false).toBool());
+    weldEpsilon = settings.value("weldEpsilon", 0.0).toDouble();
+    previewAct->setChecked(settings.value("preview", true).toBool());
+    outOfCoreAct->setChecked(settings.value("outOfCore", false).toBool());
+    archiveBits = settings.value("archiveBits", (int)Mesh_archive_header::DEFAULT_BITS).toInt();
 }
 
 void MainWindow::writeSettings()
@@ -602,6 +655,11 @@ void MainWindow::writeSettings()
     QSettings settings("Fallson", "CGALQT");
     settings.setValue("pos", pos());
     settings.setValue("size", size());
+    settings.setValue("weld", weldAct->isChecked());
+    settings.setValue("weldEpsilon", weldEpsilon);
+    settings.setValue("preview", previewAct->isChecked());
+    settings.setValue("outOfCore", outOfCoreAct->isChecked());
+    settings.setValue("archiveBits", archiveBits);
 }
 
 GLMdiChild *MainWindow::createMdiChild()
@@ -617,6 +675,51 @@ GLMdiChild *MainWindow::activeMdiChild()
     return qobject_cast<GLMdiChild *>(workspace->activeWindow());
 }
 
+MeshLoader *MainWindow::findLoader(const QString &fileName)
+{
+    QString canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
+
+    foreach (MeshLoader *loader, loaders) {
+        if (QFileInfo(loader->fileName()).canonicalFilePath() == canonicalFilePath)
+            return loader;
+    }
+    return 0;
+}
+
+//the mesh is read in its own thread, the child window is created
+//by loadPreview() at the first preview points, otherwise by
+//loadFinished() once the mesh is ready
+void MainWindow::startLoad(const QString &fileName)
+{
+	MeshLoader *loader = new MeshLoader(fileName, weldAct->isChecked() ? weldEpsilon : -1.0, this);
+	loader->setPreview(previewAct->isChecked());
+	loader->setOutOfCore(outOfCoreAct->isChecked());
+	connect(loader, SIGNAL(progress(int, const QString &)), this, SLOT(loadProgress(int, const QString &)));
+	connect(loader, SIGNAL(previewReady()), this, SLOT(loadPreview()));
+	connect(loader, SIGNAL(finished()), this, SLOT(loadFinished()));
+	loaders.append(loader);
+	loader->start();
+	updateLoadStatus();
+}
+
+void MainWindow::updateLoadStatus()
+{
+	if(loaders.isEmpty())
+	{
+		loadProgressBar->hide();
+		cancelLoadButton->hide();
+		return;
+	}
+
+	// several loads show their mean progress
+	int percent = 0;
+	foreach (MeshLoader *loader, loaders)
+		percent += loader->percent();
+	loadProgressBar->setValue(percent / loaders.size());
+	loadProgressBar->show();
+	cancelLoadButton->show();
+}
+
 GLMdiChild *MainWindow::findMdiChild(const QString &fileName)
 {
     QString canonicalFilePath = QFileInfo(fileName).canonicalFilePath();
@@ -635,19 +738,34 @@ GLMdiChild *MainWindow::findMdiChild(const QString &fileName)
 void MainWindow::open()
 {
 	QStringList filters;
-	filters.push_back(tr("All Known Formats(*.obj *.off *.pol)"));
+	filters.push_back(tr("All Known Formats(*.obj *.off *.ply *.stl *.cqm *.cqc *.cqz *.pol *.gz *.zst)"));
 	filters.push_back(tr("Wavefront 3D Object(*.obj)"));
 	filters.push_back(tr("3D Mesh Object File Format(*.off)"));
+	filters.push_back(tr("Stanford Polygon File Format(*.ply)"));
+	filters.push_back(tr("Stereolithography(*.stl)"));
+	filters.push_back(tr("CGALQT Binary Mesh(*.cqm)"));
+	filters.push_back(tr("CGALQT Chunked Mesh(*.cqc)"));
+	filters.push_back(tr("CGALQT Archive(*.cqz)"));
+	filters.push_back(tr("Compressed Model(*.gz *.zst)"));
 	filters.push_back(tr("Polygon File Format(*.pol)"));
 
-	QString fileName = QFileDialog::getOpenFileName(this,tr("open file"),QString(),filters.join("\n"));
-	if (!fileName.isEmpty()) 
+	// meshes load concurrently in the background, polygons right away
+	QStringList fileNames = QFileDialog::getOpenFileNames(this,tr("open file"),QString(),filters.join("\n"));
+	foreach (QString fileName, fileNames)
 	{
 		GLMdiChild *existing = findMdiChild(fileName);
 		if (existing) 
 		{
 			workspace->setActiveWindow(existing);
-			return;
+			continue;
+		}
+		if (findLoader(fileName))
+			continue;
+
+		if (MeshLoader::canLoad(fileName))
+		{
+			startLoad(fileName);
+			continue;
 		}
 
 		GLMdiChild *child = createMdiChild();
@@ -665,19 +783,112 @@ void MainWindow::open()
 	updateActions();
 }
 
+void MainWindow::cancelLoads()
+{
+	foreach (MeshLoader *loader, loaders)
+		loader->cancel();
+}
+
+void MainWindow::loadProgress(int, const QString &stage)
+{
+	MeshLoader *loader = qobject_cast<MeshLoader *>(sender());
+	if (!loader || loader->isCancelled())
+		return;
+	statusBar()->showMessage(tr("Loading %1: %2").arg(QFileInfo(loader->fileName()).fileName()).arg(stage));
+	updateLoadStatus();
+}
+
+void MainWindow::loadFinished()
+{
+	MeshLoader *loader = qobject_cast<MeshLoader *>(sender());
+	if (!loader)
+		return;
+	loaders.removeAll(loader);
+
+	// a preview window closed by the user cancelled the load
+	bool previewed = previewChildren.contains(loader);
+	GLMdiChild *child = previewChildren.take(loader);
+	Polyhedron_view *pView = NULL;
+	Chunked_mesh *pChunks = NULL;
+	if (!loader->isCancelled() && !(previewed && !child))
+	{
+		pView = loader->takeView();
+		pChunks = loader->takeChunks();
+	}
+	if (pView || pChunks)
+	{
+		if (!child)
+		{
+			child = createMdiChild();
+			child->setCurrentFile(loader->fileName());
+			child->showMaximized();
+		}
+		if (pView)
+			child->setView(pView);
+		else
+			child->setChunks(pChunks);
+		child->updateGL();
+		statusBar()->showMessage(tr("File loaded"), 2000);
+	}
+	else if (loader->isCancelled() || previewed)
+	{
+		if (child)
+			child->close();
+		statusBar()->showMessage(tr("Loading cancelled"), 2000);
+	}
+	else
+	{
+		statusBar()->clearMessage();
+		QMessageBox::warning(this, tr("CGALQT"),tr("read file error\n%1\n%2").arg(loader->fileName()).arg(loader->error()), QMessageBox::Close);
+	}
+
+	loader->deleteLater();
+	updateLoadStatus();
+	updateActions();
+}
+
+void MainWindow::loadPreview()
+{
+	MeshLoader *loader = qobject_cast<MeshLoader *>(sender());
+	if (!loader || loader->isCancelled() || !loaders.contains(loader))
+		return;
+
+	std::vector<float> points;
+	loader->previewPoints(points);
+	if (!previewChildren.contains(loader))
+	{
+		GLMdiChild *child = createMdiChild();
+		child->setCurrentFile(loader->fileName());
+		child->showMaximized();
+		previewChildren.insert(loader, child);
+	}
+	GLMdiChild *child = previewChildren.value(loader);
+	if (!child)
+	{
+		loader->cancel();
+		return;
+	}
+	child->addPreview(points);
+	updateActions();
+}
+
 void MainWindow::saveAs()
 {
 	GLMdiChild* pChild = activeMdiChild();
 	if(pChild)
 	{
 		size_t polysize = pChild->getPolysSize();
-		Polyhedron* pMesh = pChild->getMesh();
 
 		QStringList filters;
-		if(pMesh)
+		if(pChild->hasMesh())
 		{
 			filters.push_back(tr("Wavefront 3D Object(*.obj)"));
 			filters.push_back(tr("3D Mesh Object File Format(*.off)"));
+			filters.push_back(tr("Stanford Polygon File Format(*.ply)"));
+			filters.push_back(tr("Stereolithography(*.stl)"));
+			filters.push_back(tr("CGALQT Binary Mesh(*.cqm)"));
+			filters.push_back(tr("CGALQT Archive(*.cqz)"));
+			filters.push_back(tr("Compressed Model(*.obj.gz *.off.gz *.ply.gz *.stl.gz *.obj.zst *.off.zst *.ply.zst *.stl.zst)"));
 		}
 		if(0 != polysize)
 			filters.push_back(tr("Polygon File Format(*.pol)"));
@@ -685,7 +896,7 @@ void MainWindow::saveAs()
 		if (fileName.isEmpty())
 			return;
 
-		if (pChild->saveFile(fileName))
+		if (pChild->saveFile(fileName, archiveBits))
 			statusBar()->showMessage(tr("File saved"), 2000);
 	}
 
@@ -697,13 +908,29 @@ void MainWindow::fileproperty()
 	GLMdiChild * pChild = activeMdiChild();
 	if(pChild)
 	{
+		// a model not built yet counts its edges on the indexed view
 		Polyhedron* pMesh = pChild->getMesh();
+		Polyhedron_view* pView = pChild->getView();
+		Chunked_mesh* pChunks = pChild->getChunks();
 		if(pMesh)
 		{
 			FilePropertyDialog dialog(pChild->currentFile(),pMesh->size_of_vertices(),
 				pMesh->size_of_halfedges()/2, pMesh->size_of_facets(), this);
 			dialog.exec();
 		}
+		else if(pView)
+		{
+			FilePropertyDialog dialog(pChild->currentFile(),pView->size_of_vertices(),
+				pView->size_of_edges(), pView->size_of_facets(), this);
+			dialog.exec();
+		}
+		else if(pChunks)
+		{
+			// counting the edges would need the whole model
+			FilePropertyDialog dialog(pChild->currentFile(),pChunks->size_of_vertices(),
+				-1, pChunks->size_of_facets(), this);
+			dialog.exec();
+		}
 	}
 
 	updateActions();
@@ -731,6 +958,32 @@ void MainWindow::snapshot()
 	updateActions();
 }
 
+void MainWindow::weld()
+{
+	// the distance applies to the files opened from now on,
+	// 0 only merges the vertices at the same position
+	if(weldAct->isChecked())
+	{
+		bool ok = false;
+		double epsilon = QInputDialog::getDouble(this, tr("Weld Duplicate Vertices"), tr("Distance:"), weldEpsilon, 0.0, 1.0e10, 6, &ok);
+		if(ok)
+			weldEpsilon = epsilon;
+		else
+			weldAct->setChecked(false);
+	}
+}
+
+void MainWindow::archivePrecision()
+{
+	// the connectivity is always exact, the positions are
+	// quantized in the bounding box of the model
+	bool ok = false;
+	int bits = QInputDialog::getInteger(this, tr("Archive Precision"), tr("Bits per coordinate:"), archiveBits,
+		Mesh_archive_header::MIN_BITS, Mesh_archive_header::MAX_BITS, 1, &ok);
+	if(ok)
+		archiveBits = bits;
+}
+
 /************************************************************************/
 /* rendermode slots                                                     */
 /************************************************************************/
@@ -26,12 +26,18 @@
 
 #include "config.h"
 #include <QMainWindow>
+#include <QList>
+#include <QMap>
+#include <QPointer>
 
 class QAction;
 class QMenu;
 class QWorkspace;
 class QActionGroup;
+class QProgressBar;
+class QToolButton;
 class GLMdiChild;
+class MeshLoader;
 
 class MainWindow : public QMainWindow
 {
@@ -82,6 +88,9 @@ private:
 	GLMdiChild *createMdiChild();
 	GLMdiChild *activeMdiChild();
 	GLMdiChild *findMdiChild(const QString &fileName);
+	MeshLoader *findLoader(const QString &fileName);
+	void startLoad(const QString &fileName);
+	void updateLoadStatus();
 
 private:
 	void updateFileActions();
@@ -101,6 +110,12 @@ private slots:
     void saveAs();
 	void fileproperty();
 	void snapshot();
+	void weld();
+	void archivePrecision();
+	void cancelLoads();
+	void loadProgress(int percent, const QString &stage);
+	void loadFinished();
+	void loadPreview();
 
 	/************************************************************************/
 	/* rendermode slots                                                     */
@@ -187,6 +202,20 @@ private:
     QAction *exitAct;
 	QAction *propertyAct;
 	QAction *snapshotAct;
+	QAction *weldAct;
+	double weldEpsilon;
+	QAction *cancelLoadAct;
+	QAction *previewAct;
+	QAction *outOfCoreAct;
+	QAction *archiveAct;
+	int archiveBits;
+
+	//meshes being loaded in their own thread
+	QList<MeshLoader*> loaders;
+	QProgressBar *loadProgressBar;
+	QToolButton *cancelLoadButton;
+	//windows showing the preview of a mesh being loaded
+	QMap<MeshLoader*, QPointer<GLMdiChild> > previewChildren;
 
 	/************************************************************************/
 	/* rendermode Actions                                                   */
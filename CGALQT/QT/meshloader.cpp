@@ -0,0 +1,300 @@
+#include <QtGui>
+#include "meshloader.h"
+
+//cgal
+#include "parser_obj.h"
+#include "mesh_preview.h"
+
+//the parsers pass the points to the loader as they decode them
+struct MeshLoader::PreviewSink : public Mesh_preview
+{
+	MeshLoader *pLoader;
+	bool points(std::vector<float>& points) { return pLoader->addPreview(points); }
+};
+
+MeshLoader::MeshLoader(const QString &fileName, double weldEpsilon, QObject *parent)
+: QThread(parent)
+{
+	m_fileName = fileName;
+	m_weldEpsilon = weldEpsilon;
+	m_pView = NULL;
+	m_outOfCore = false;
+	m_pChunks = NULL;
+	m_percent = 0;
+	m_cancelled = false;
+	m_ok = false;
+	m_preview = false;
+	m_previewPending = false;
+}
+
+MeshLoader::~MeshLoader()
+{
+	wait();
+	CGALQT_DELETE(m_pView);
+	CGALQT_DELETE(m_pChunks);
+}
+
+QString MeshLoader::modelExtension(const QString &fileName)
+{
+	QString extension = QFileInfo(fileName).suffix();
+	extension = extension.toLower();
+	if(extension == "gz" || extension == "zst")
+	{
+		QString inner = QFileInfo(QFileInfo(fileName).completeBaseName()).suffix().toLower();
+		// the binary cache is mapped and polygons use a std::ifstream
+		if(inner != "cqm" && inner != "pol")
+			return inner;
+	}
+	return extension;
+}
+
+bool MeshLoader::canLoad(const QString &fileName)
+{
+	QString extension = modelExtension(fileName);
+	return extension == "off" || extension == "obj" || extension == "ply" || extension == "cqm" || extension == "stl" || extension == "cqc" || extension == "cqz";
+}
+
+Polyhedron_view* MeshLoader::takeView()
+{
+	Polyhedron_view *pView = m_ok ? m_pView : NULL;
+	if(pView)
+		m_pView = NULL;
+	return pView;
+}
+
+Chunked_mesh* MeshLoader::takeChunks()
+{
+	Chunked_mesh *pChunks = m_ok ? m_pChunks : NULL;
+	if(pChunks)
+		m_pChunks = NULL;
+	return pChunks;
+}
+
+void MeshLoader::run()
+{
+	load();
+}
+
+void MeshLoader::previewPoints(std::vector<float>& points)
+{
+	QMutexLocker locker(&m_previewMutex);
+	points.clear();
+	points.swap(m_previewPoints);
+	m_previewPending = false;
+}
+
+bool MeshLoader::addPreview(std::vector<float>& points)
+{
+	if(m_cancelled)
+		return false;
+	bool notify = false;
+	{
+		QMutexLocker locker(&m_previewMutex);
+		m_previewPoints.insert(m_previewPoints.end(),points.begin(),points.end());
+		notify = !m_previewPending;
+		m_previewPending = true;
+	}
+	if(notify)
+		emit previewReady();
+	return true;
+}
+
+bool MeshLoader::load()
+{
+	m_ok = false;
+	CGALQT_DELETE(m_pView);
+	if(!canLoad(m_fileName))
+	{
+		m_error = tr("unknown extension");
+		return false;
+	}
+	if(m_outOfCore || modelExtension(m_fileName) == "cqc")
+		return loadChunks();
+
+	// the parsing itself can not be interrupted, a cancel
+	// request is honored between the stages
+	bool has_normals = false;
+	bool write_cache = false;
+	if(!step(0, tr("reading")) || !readMesh(has_normals,write_cache))
+	{
+		CGALQT_DELETE(m_pView);
+		return false;
+	}
+
+	// the files of scanners and of other subdividers often list
+	// the neighbours far apart, see Indexed_reorder; a saved model
+	// then lists its vertices in the new order
+	if(!step(65, tr("reordering")))
+		return false;
+	m_pView->reorder_if_scattered();
+
+	if(!step(70, tr("computing type")))
+		return false;
+	m_pView->compute_type();
+	if(!has_normals)
+	{
+		if(!step(75, tr("computing normals")))
+			return false;
+		m_pView->compute_normals();
+	}
+	else if(!m_pView->has_facet_normals())
+		m_pView->compute_normals_per_facet();
+	if(!step(95, tr("computing bounding box")))
+		return false;
+	m_pView->compute_bounding_box();
+
+	// best effort, a model in a read only directory just has no cache
+	if(write_cache && step(97, tr("writing cache")))
+		m_pView->write_binary(qPrintable(m_fileName + ".cqm"),qPrintable(m_fileName));
+
+	m_ok = true;
+	m_percent = 100;
+	emit progress(100, tr("done"));
+	return true;
+}
+
+bool MeshLoader::readMesh(bool& has_normals, bool& write_cache)
+{
+	QString extension = modelExtension(m_fileName);
+	m_pView = new Polyhedron_view();
+
+	// a sidecar cache newer than the text model skips the parsing,
+	// welded models are not cached since the result depends on the epsilon,
+	// neither are archives which are meant to stay small on disk
+	QString cacheName = m_fileName + ".cqm";
+	PreviewSink sink;
+	sink.pLoader = this;
+	Mesh_preview *pPreview = m_preview ? &sink : NULL;
+	bool use_cache = extension != "cqm" && extension != "stl" && extension != "cqz" && m_weldEpsilon < 0.0;
+	bool from_cache = false;
+	std::string error;
+	if(use_cache &&
+	   Binary_mesh_view::is_fresh(qPrintable(cacheName),qPrintable(m_fileName)))
+		from_cache = m_pView->read_binary(qPrintable(cacheName),error,has_normals,pPreview);
+
+	bool ok = true;
+	if(from_cache)
+		;
+	else if(extension == "off")
+		ok = m_pView->read_off(qPrintable(m_fileName),error,m_weldEpsilon,pPreview);
+	else if(extension == "obj")
+	{
+		Parser_obj<Enriched_Polyhedron_kernel,Enriched_items> parser;
+		parser.set_preview(pPreview);
+		ok = parser.read(qPrintable(m_fileName),m_pView->mesh());
+		if(!ok)
+			error = parser.error();
+		else if(m_weldEpsilon >= 0.0)
+			m_pView->weld(m_weldEpsilon);
+	}
+	else if(extension == "ply")
+		ok = m_pView->read_ply(qPrintable(m_fileName),error,has_normals,pPreview);
+	else if(extension == "cqm")
+		ok = m_pView->read_binary(qPrintable(m_fileName),error,has_normals,pPreview);
+	else if(extension == "stl")
+		ok = m_pView->read_stl(qPrintable(m_fileName),error,std::max(0.0,m_weldEpsilon),pPreview);
+	else if(extension == "cqz")
+		ok = m_pView->read_archive(qPrintable(m_fileName),error);
+	if(!ok)
+	{
+		m_error = error.c_str();
+		return false;
+	}
+
+	// the renderer indexes the arrays directly, the manifold
+	// check is left to the half-edge build
+	if(!m_pView->is_valid())
+	{
+		m_error = tr("vertex index out of range or facet with less than 3 vertices");
+		return false;
+	}
+
+	write_cache = use_cache && !from_cache;
+	return true;
+}
+
+bool MeshLoader::loadChunks()
+{
+	CGALQT_DELETE(m_pChunks);
+
+	// the chunks are a sidecar file like the binary cache, welded
+	// models are split again since the result depends on the epsilon
+	QString chunkName = m_fileName;
+	if(modelExtension(m_fileName) != "cqc")
+	{
+		chunkName = m_fileName + ".cqc";
+		if(m_weldEpsilon >= 0.0 ||
+		   !Chunked_mesh::is_fresh(qPrintable(chunkName),qPrintable(m_fileName)))
+		{
+			if(!step(0, tr("reading")) || !writeChunks(chunkName))
+				return false;
+		}
+	}
+
+	if(!step(95, tr("opening chunks")))
+		return false;
+	m_pChunks = new Chunked_mesh();
+	std::string error;
+	if(!m_pChunks->open(qPrintable(chunkName),error))
+	{
+		m_error = error.c_str();
+		CGALQT_DELETE(m_pChunks);
+		return false;
+	}
+
+	m_ok = true;
+	m_percent = 100;
+	emit progress(100, tr("done"));
+	return true;
+}
+
+bool MeshLoader::writeChunks(const QString &chunkName)
+{
+	// a .cqm, or the fresh cache of a text model, is split through its
+	// mapping and never loaded, any other model is read in memory first
+	QString extension = modelExtension(m_fileName);
+	QString binaryName = extension == "cqm" ? m_fileName : m_fileName + ".cqm";
+	bool mapped = extension == "cqm" ||
+	              (m_weldEpsilon < 0.0 && Binary_mesh_view::is_fresh(qPrintable(binaryName),qPrintable(m_fileName)));
+
+	bool ok = false;
+	std::string error;
+	if(mapped)
+	{
+		Binary_mesh_view view;
+		if(!view.open(qPrintable(binaryName),error))
+		{
+			m_error = error.c_str();
+			return false;
+		}
+		if(!step(30, tr("writing chunks")))
+			return false;
+		Chunked_mesh_writer<Binary_mesh_view> writer;
+		ok = writer.write(qPrintable(chunkName),view,qPrintable(m_fileName));
+	}
+	else
+	{
+		bool has_normals = false;
+		bool write_cache = false;
+		if(!readMesh(has_normals,write_cache) || !step(60, tr("writing chunks")))
+		{
+			CGALQT_DELETE(m_pView);
+			return false;
+		}
+		Chunked_mesh_writer<Polyhedron_view::Mesh> writer;
+		ok = writer.write(qPrintable(chunkName),m_pView->mesh(),qPrintable(m_fileName));
+		CGALQT_DELETE(m_pView);
+	}
+	if(!ok)
+		m_error = tr("can not write %1").arg(chunkName);
+	return ok;
+}
+
+bool MeshLoader::step(int percent, const QString &stage)
+{
+	if(m_cancelled)
+		return false;
+	m_percent = percent;
+	emit progress(percent, stage);
+	return true;
+}
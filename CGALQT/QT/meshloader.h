@@ -0,0 +1,95 @@
+#ifndef MESHLOADER_H
+#define MESHLOADER_H
+
+#include "config.h"
+#include <QThread>
+#include <QString>
+#include <QMutex>
+#include <QGLWidget>
+#include <vector>
+
+#include "enriched_polyhedron.h"
+#include "mesh_chunks.h"
+
+//reads a mesh file into an indexed view and prepares it for rendering
+//(type, normals, bounding box), either in the calling thread with load()
+//or in its own thread with start(). The half-edge mesh is not built here,
+//see Indexed_view. The view is not attached to any widget until
+//takeView() is called, so the loading never touches the gui.
+//With setPreview(true), one vertex out of k is made available by
+//previewPoints() as the parser decodes them (see Mesh_preview).
+//With setOutOfCore(true), and always for .cqc files, the model is split
+//in chunks on disk instead (see Chunked_mesh), takeChunks() gives them.
+class MeshLoader : public QThread
+{
+	Q_OBJECT
+
+public:
+	MeshLoader(const QString &fileName, double weldEpsilon = -1.0, QObject *parent = 0);
+	~MeshLoader();
+
+	//the model format, "model.off.gz" and "model.obj.zst" give "off" and "obj"
+	static QString modelExtension(const QString &fileName);
+	//whether the file is a mesh this class reads
+	static bool canLoad(const QString &fileName);
+
+	bool load();
+
+	//pass a subsample of the parsed vertices to the preview
+	void setPreview(bool preview) { m_preview = preview; }
+	//moves the points sampled since the last call into points
+	void previewPoints(std::vector<float>& points);
+	//view the model through its chunks, written next to it as
+	//"model.obj.cqc" and reused while the model does not change
+	void setOutOfCore(bool outOfCore) { m_outOfCore = outOfCore; }
+
+	//the loading stops at the next stage, the mesh is then dropped
+	void cancel() { m_cancelled = true; }
+	bool isCancelled() const { return m_cancelled; }
+
+	QString fileName() const { return m_fileName; }
+	QString error() const { return m_error; }
+	int percent() const { return m_percent; }
+	//the loaded mesh, the caller owns it
+	Polyhedron_view* takeView();
+	//the chunks of an out-of-core load, the caller owns them
+	Chunked_mesh* takeChunks();
+
+signals:
+	void progress(int percent, const QString &stage);
+	//new preview points, not emitted again until they are taken
+	void previewReady();
+
+protected:
+	void run();
+
+private:
+	struct PreviewSink;
+	friend struct PreviewSink;
+
+	//false once the preview is not wanted any more
+	bool addPreview(std::vector<float>& points);
+	bool readMesh(bool& has_normals, bool& write_cache);
+	bool loadChunks();
+	bool writeChunks(const QString &chunkName);
+	//false if cancelled
+	bool step(int percent, const QString &stage);
+
+private:
+	QString m_fileName;
+	double m_weldEpsilon; //< 0 to keep the vertices
+	Polyhedron_view *m_pView;
+	bool m_outOfCore;
+	Chunked_mesh *m_pChunks;
+	QString m_error;
+	volatile int m_percent;
+	volatile bool m_cancelled;
+	bool m_ok;
+
+	bool m_preview;
+	std::vector<float> m_previewPoints; //not taken yet
+	QMutex m_previewMutex;
+	bool m_previewPending;
+};
+
+#endif
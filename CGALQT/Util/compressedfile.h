@@ -0,0 +1,428 @@
+#ifndef COMPRESSEDFILE_H
+#define COMPRESSEDFILE_H
+
+#include "config.h"
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <deque>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+
+//the .zst files need the zstd filter of boost iostreams (boost 1.70),
+//define CGALQT_NO_ZSTD to build without them, they then fail to open
+#ifndef CGALQT_NO_ZSTD
+#include <boost/version.hpp>
+#if BOOST_VERSION < 107000
+#error "the .zst files need boost 1.70 or later, update boost or define CGALQT_NO_ZSTD"
+#endif
+#include <boost/iostreams/filter/zstd.hpp>
+#endif
+#include "mappedfile.h"
+
+//compression of a file, given by its name suffix
+class Compression
+{
+private:
+	Compression();
+	~Compression();
+
+public:
+	enum Type { NONE, GZIP, ZSTD };
+
+	static Type from_filename(const char* pFilename)
+	{
+		if(has_suffix(pFilename, ".gz"))
+			return GZIP;
+		if(has_suffix(pFilename, ".zst"))
+			return ZSTD;
+		return NONE;
+	}
+
+	//false if this build can not read or write the compression
+	static bool supported(Type type)
+	{
+#ifdef CGALQT_NO_ZSTD
+		return type != ZSTD;
+#else
+		(void)type;
+		return true;
+#endif
+	}
+
+private:
+	static bool has_suffix(const char* pFilename, const char* pSuffix)
+	{
+		size_t n = strlen(pFilename), m = strlen(pSuffix);
+		if(n < m)
+			return false;
+		for(size_t i = 0; i < m; i++)
+			if(tolower((unsigned char)pFilename[n - m + i]) != pSuffix[i])
+				return false;
+		return true;
+	}
+};
+
+//blocks passed from one thread to another, at most 'capacity' waiting
+class BlockQueue
+{
+public:
+	BlockQueue(size_t capacity) : m_capacity(capacity), m_closed(false) {}
+
+	//false if the queue was closed by the consumer
+	bool push(std::vector<char>& block)
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		while(m_blocks.size() >= m_capacity && !m_closed)
+			m_not_full.wait(lock);
+		if(m_closed)
+			return false;
+		m_blocks.push_back(std::vector<char>());
+		m_blocks.back().swap(block);
+		m_not_empty.notify_one();
+		return true;
+	}
+
+	//false once the queue is closed and empty
+	bool pop(std::vector<char>& block)
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		while(m_blocks.empty() && !m_closed)
+			m_not_empty.wait(lock);
+		if(m_blocks.empty())
+			return false;
+		block.swap(m_blocks.front());
+		m_blocks.pop_front();
+		m_not_full.notify_one();
+		return true;
+	}
+
+	//no more blocks, the waiting threads are released
+	void close()
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_closed = true;
+		m_not_empty.notify_all();
+		m_not_full.notify_all();
+	}
+
+	void reset()
+	{
+		boost::mutex::scoped_lock lock(m_mutex);
+		m_blocks.clear();
+		m_closed = false;
+	}
+
+private:
+	size_t m_capacity;
+	bool m_closed;
+	std::deque< std::vector<char> > m_blocks;
+	boost::mutex m_mutex;
+	boost::condition_variable m_not_empty;
+	boost::condition_variable m_not_full;
+};
+
+//decompress a .gz or .zst file on a background thread, the
+//consumer gets the data in file order by blocks of BLOCK_SIZE
+class DecompressingReader
+{
+public:
+	enum { BLOCK_SIZE = 1 << 22, MAX_BLOCKS = 4 };
+
+	DecompressingReader() : m_queue(MAX_BLOCKS), m_pThread(NULL), m_error(false) {}
+	~DecompressingReader() { close(); }
+
+private:
+	DecompressingReader(const DecompressingReader&);
+	DecompressingReader& operator=(const DecompressingReader&);
+
+public:
+	bool open(const char* pFilename)
+	{
+		close();
+		m_type = Compression::from_filename(pFilename);
+		if(!Compression::supported(m_type))
+			return false;
+		m_file.open(pFilename, std::ios::in | std::ios::binary);
+		if(!m_file)
+			return false;
+		m_error = false;
+		m_queue.reset();
+		m_pThread = new boost::thread(boost::bind(&DecompressingReader::run, this));
+		return true;
+	}
+
+	//the next block, false at the end of the data
+	bool next(std::vector<char>& block)
+	{
+		return m_queue.pop(block);
+	}
+
+	//only meaningful once next() returned false
+	bool error() const { return m_error; }
+
+	void close()
+	{
+		if(m_pThread)
+		{
+			m_queue.close();
+			m_pThread->join();
+			delete m_pThread;
+			m_pThread = NULL;
+		}
+		if(m_file.is_open())
+			m_file.close();
+	}
+
+private:
+	void run()
+	{
+		try
+		{
+			boost::iostreams::filtering_istream in;
+#ifndef CGALQT_NO_ZSTD
+			if(m_type == Compression::ZSTD)
+				in.push(boost::iostreams::zstd_decompressor());
+			else
+#endif
+				in.push(boost::iostreams::gzip_decompressor());
+			in.push(m_file);
+			for(;;)
+			{
+				std::vector<char> block(BLOCK_SIZE);
+				in.read(&block[0], block.size());
+				block.resize((size_t)in.gcount());
+				if(block.empty())
+					break;
+				if(!m_queue.push(block))
+					break;
+			}
+			if(in.bad())
+				m_error = true;
+		}
+		catch(std::exception&)
+		{
+			m_error = true;
+		}
+		m_queue.close();
+	}
+
+	Compression::Type m_type;
+	std::ifstream m_file;
+	BlockQueue m_queue;
+	boost::thread* m_pThread;
+	volatile bool m_error;
+};
+
+//an input file read front to back through a window [begin,end): the
+//whole mapping when the file is not compressed, otherwise the blocks
+//of a DecompressingReader as they come, so that the parsing of one
+//block overlaps the decompression of the next ones. The parsers ask
+//for MAX_RECORD bytes before a text record, longer lines may be cut
+//at the end of the window.
+class InputWindow
+{
+public:
+	enum { MAX_RECORD = 1 << 16 };
+
+	InputWindow() : m_compressed(false), m_eof(true), m_error(false) {}
+	~InputWindow() {}
+
+private:
+	InputWindow(const InputWindow&);
+	InputWindow& operator=(const InputWindow&);
+
+public:
+	bool open(const char* pFilename)
+	{
+		close();
+		if(Compression::from_filename(pFilename) == Compression::NONE)
+			return m_mapped.open(pFilename);
+		if(!m_reader.open(pFilename))
+			return false;
+		m_compressed = true;
+		m_eof = false;
+		return true;
+	}
+
+	void close()
+	{
+		m_reader.close();
+		m_mapped.close();
+		std::vector<char>().swap(m_data);
+		m_compressed = false;
+		m_eof = true;
+		m_error = false;
+	}
+
+	const char* begin() const
+	{
+		if(!m_compressed)
+			return m_mapped.begin();
+		return m_data.empty() ? NULL : &m_data[0];
+	}
+	const char* end() const
+	{
+		if(!m_compressed)
+			return m_mapped.end();
+		return m_data.empty() ? NULL : &m_data[0] + m_data.size();
+	}
+
+	//no data after end()
+	bool eof() const { return m_eof; }
+	//the decompression failed, only meaningful at eof()
+	bool error() const { return m_error; }
+
+	//at least n bytes from p up to end, if the file has them: the bytes
+	//from p move to the front of the window with p and end, the next
+	//blocks come after them
+	void fill(const char*& p, const char*& end, size_t n)
+	{
+		if((size_t)(end - p) >= n || m_eof)
+			return;
+		size_t offset = p ? p - begin() : 0;
+		m_data.erase(m_data.begin(), m_data.begin() + offset);
+		while(m_data.size() < n)
+		{
+			if(!m_reader.next(m_block))
+			{
+				m_eof = true;
+				m_error = m_reader.error();
+				break;
+			}
+			m_data.insert(m_data.end(), m_block.begin(), m_block.end());
+		}
+		p = begin();
+		end = this->end();
+	}
+
+private:
+	MappedFile m_mapped;
+	DecompressingReader m_reader;
+	std::vector<char> m_data;
+	std::vector<char> m_block;
+	bool m_compressed;
+	bool m_eof;
+	bool m_error;
+};
+
+//an output file, written directly when it is not compressed, otherwise
+//the data is compressed and written by a background thread
+class OutputFile
+{
+public:
+	enum { MAX_BLOCKS = 4 };
+
+	OutputFile() : m_pFile(NULL), m_queue(MAX_BLOCKS), m_pThread(NULL), m_error(false) {}
+	~OutputFile() { close(); }
+
+private:
+	OutputFile(const OutputFile&);
+	OutputFile& operator=(const OutputFile&);
+
+public:
+	bool open(const char* pFilename)
+	{
+		close();
+		m_error = false;
+		m_type = Compression::from_filename(pFilename);
+		if(m_type == Compression::NONE)
+		{
+			m_pFile = fopen(pFilename, "wb");
+			return m_pFile != NULL;
+		}
+		if(!Compression::supported(m_type))
+			return false;
+		m_file.open(pFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+		if(!m_file)
+			return false;
+		m_queue.reset();
+		m_pThread = new boost::thread(boost::bind(&OutputFile::run, this));
+		return true;
+	}
+
+	bool write(const char* pData, size_t size)
+	{
+		if(size == 0)
+			return !m_error;
+		if(m_pFile)
+		{
+			if(fwrite(pData, 1, size, m_pFile) != size)
+				m_error = true;
+			return !m_error;
+		}
+		std::vector<char> block(pData, pData + size);
+		if(!m_pThread || !m_queue.push(block))
+			m_error = true;
+		return !m_error;
+	}
+
+	//false if anything failed since open()
+	bool close()
+	{
+		if(m_pFile)
+		{
+			if(fclose(m_pFile) != 0)
+				m_error = true;
+			m_pFile = NULL;
+		}
+		if(m_pThread)
+		{
+			m_queue.close();
+			m_pThread->join();
+			delete m_pThread;
+			m_pThread = NULL;
+		}
+		if(m_file.is_open())
+		{
+			m_file.close();
+			if(m_file.fail())
+				m_error = true;
+		}
+		return !m_error;
+	}
+
+private:
+	void run()
+	{
+		try
+		{
+			boost::iostreams::filtering_ostream out;
+#ifndef CGALQT_NO_ZSTD
+			if(m_type == Compression::ZSTD)
+				out.push(boost::iostreams::zstd_compressor());
+			else
+#endif
+				out.push(boost::iostreams::gzip_compressor());
+			out.push(m_file);
+			std::vector<char> block;
+			while(m_queue.pop(block))
+				out.write(&block[0], block.size());
+			//flushes the compressor
+			out.reset();
+			if(!m_file)
+				m_error = true;
+		}
+		catch(std::exception&)
+		{
+			m_error = true;
+		}
+		//releases a writer waiting on a full queue after an error
+		m_queue.close();
+	}
+
+	Compression::Type m_type;
+	FILE* m_pFile;
+	std::ofstream m_file;
+	BlockQueue m_queue;
+	boost::thread* m_pThread;
+	volatile bool m_error;
+};
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include "config.h"
+#include <vector>
+#include <string>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/operations.hpp>
+
+//read only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile() {}
+	~MappedFile() { close(); }
+
+private:
+	MappedFile(const MappedFile&);
+	MappedFile& operator=(const MappedFile&);
+
+public:
+	bool open(const char* pFilename)
+	{
+		close();
+		try
+		{
+			//an empty file can not be mapped, but it is a valid (empty) input
+			if(boost::filesystem::file_size(pFilename) == 0)
+				return true;
+			m_file.open(std::string(pFilename));
+		}
+		catch(std::exception&)
+		{
+			return false;
+		}
+		return m_file.is_open();
+	}
+
+	void close()
+	{
+		if(m_file.is_open())
+			m_file.close();
+	}
+
+	const char* begin() const { return m_file.is_open() ? m_file.data() : NULL; }
+	const char* end() const { return m_file.is_open() ? m_file.data() + m_file.size() : NULL; }
+	size_t size() const { return m_file.is_open() ? m_file.size() : 0; }
+
+	//split [begin,end) into at most nb chunks cut right after a '\n',
+	//bounds receives the nb_chunks+1 chunk limits
+	static void split_lines(const char* begin, const char* end, size_t nb, std::vector<const char*>& bounds)
+	{
+		bounds.clear();
+		bounds.push_back(begin);
+		if(nb == 0)
+			nb = 1;
+		size_t step = (size_t)(end - begin) / nb;
+		for(size_t i = 1; i < nb && step > 0; i++)
+		{
+			const char* p = begin + i * step;
+			if(p <= bounds.back())
+				continue;
+			while(p < end && p[-1] != '\n')
+				p++;
+			if(p >= end)
+				break;
+			bounds.push_back(p);
+		}
+		bounds.push_back(end);
+	}
+
+private:
+	boost::iostreams::mapped_file_source m_file;
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef NUMFORMAT_H
+#define NUMFORMAT_H
+
+#include "config.h"
+#include <cstring>
+#include <boost/cstdint.hpp>
+
+//locale free number formatting, the counterpart of NumParse.
+//all of them write into a caller buffer and return the end of the text
+class NumFormat
+{
+private:
+	NumFormat();
+	~NumFormat();
+
+public:
+	//enough room for any format_double() or format_int() output
+	enum { MAX_CHARS = 32 };
+
+	static char* format_int(int value, char* buffer)
+	{
+		unsigned int u = (unsigned int)value;
+		if(value < 0)
+		{
+			*buffer++ = '-';
+			u = 0u - u;
+		}
+		char digits[10];
+		int n = 0;
+		do
+		{
+			digits[n++] = (char)('0' + u % 10);
+			u /= 10;
+		}
+		while(u != 0);
+		while(n > 0)
+			*buffer++ = digits[--n];
+		return buffer;
+	}
+
+	//shortest digits that read back to the same double (Grisu2, F. Loitsch,
+	//"Printing floating-point numbers quickly and accurately with integers").
+	//the output always round trips through strtod; in rare cases it has
+	//one digit more than the optimum. plain notation for 1e-5 <= |v| < 1e21,
+	//scientific notation otherwise
+	static char* format_double(double value, char* buffer)
+	{
+		if(value != value)
+		{
+			memcpy(buffer, "nan", 3);
+			return buffer + 3;
+		}
+		boost::uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		if(bits >> 63)
+		{
+			*buffer++ = '-';
+			value = -value;
+			bits &= ~((boost::uint64_t)1 << 63);
+		}
+		if(bits == 0)
+		{
+			*buffer = '0';
+			return buffer + 1;
+		}
+		if((bits & EXPONENT_MASK) == EXPONENT_MASK)
+		{
+			memcpy(buffer, "inf", 3);
+			return buffer + 3;
+		}
+
+		int length = 0;
+		int k = 0;
+		grisu2(value, buffer, length, k);
+		return prettify(buffer, length, k);
+	}
+
+private:
+	static const boost::uint64_t EXPONENT_MASK = 0x7FF0000000000000ULL;
+	static const boost::uint64_t SIGNIFICAND_MASK = 0x000FFFFFFFFFFFFFULL;
+	static const boost::uint64_t HIDDEN_BIT = 0x0010000000000000ULL;
+
+	//f * 2^e with a 64 bits significand
+	struct DiyFp
+	{
+		boost::uint64_t f;
+		int e;
+
+		DiyFp(boost::uint64_t f_, int e_) : f(f_), e(e_) {}
+
+		explicit DiyFp(double d)
+		{
+			boost::uint64_t bits;
+			memcpy(&bits, &d, sizeof(bits));
+			int biased_e = (int)((bits & EXPONENT_MASK) >> 52);
+			f = bits & SIGNIFICAND_MASK;
+			if(biased_e != 0)
+			{
+				f += HIDDEN_BIT;
+				e = biased_e - 1075;
+			}
+			else
+				e = -1074;
+		}
+
+		DiyFp operator-(const DiyFp& rhs) const
+		{
+			return DiyFp(f - rhs.f, e);
+		}
+
+		//upper 64 bits of the 128 bits product, rounded
+		DiyFp operator*(const DiyFp& rhs) const
+		{
+			const boost::uint64_t M32 = 0xFFFFFFFFULL;
+			boost::uint64_t a = f >> 32, b = f & M32;
+			boost::uint64_t c = rhs.f >> 32, d = rhs.f & M32;
+			boost::uint64_t ac = a * c, bc = b * c, ad = a * d, bd = b * d;
+			boost::uint64_t tmp = (bd >> 32) + (ad & M32) + (bc & M32);
+			tmp += (boost::uint64_t)1 << 31;
+			return DiyFp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), e + rhs.e + 64);
+		}
+
+		DiyFp normalize(int shift) const
+		{
+			DiyFp res = *this;
+			while(!(res.f & (HIDDEN_BIT << shift)))
+			{
+				res.f <<= 1;
+				res.e--;
+			}
+			res.f <<= 11 - shift;
+			res.e -= 11 - shift;
+			return res;
+		}
+	};
+
+	//c = 10^-K, such that the product with w has its exponent in [-60,-32]
+	static DiyFp cached_power(int e, int& K)
+	{
+		//10^-348, 10^-340, ..., 10^340
+		static const boost::uint64_t powers_f[] = {
+			0xfa8fd5a0081c0288ULL, 0xbaaee17fa23ebf76ULL, 0x8b16fb203055ac76ULL,
+			0xcf42894a5dce35eaULL, 0x9a6bb0aa55653b2dULL, 0xe61acf033d1a45dfULL,
+			0xab70fe17c79ac6caULL, 0xff77b1fcbebcdc4fULL, 0xbe5691ef416bd60cULL,
+			0x8dd01fad907ffc3cULL, 0xd3515c2831559a83ULL, 0x9d71ac8fada6c9b5ULL,
+			0xea9c227723ee8bcbULL, 0xaecc49914078536dULL, 0x823c12795db6ce57ULL,
+			0xc21094364dfb5637ULL, 0x9096ea6f3848984fULL, 0xd77485cb25823ac7ULL,
+			0xa086cfcd97bf97f4ULL, 0xef340a98172aace5ULL, 0xb23867fb2a35b28eULL,
+			0x84c8d4dfd2c63f3bULL, 0xc5dd44271ad3cdbaULL, 0x936b9fcebb25c996ULL,
+			0xdbac6c247d62a584ULL, 0xa3ab66580d5fdaf6ULL, 0xf3e2f893dec3f126ULL,
+			0xb5b5ada8aaff80b8ULL, 0x87625f056c7c4a8bULL, 0xc9bcff6034c13053ULL,
+			0x964e858c91ba2655ULL, 0xdff9772470297ebdULL, 0xa6dfbd9fb8e5b88fULL,
+			0xf8a95fcf88747d94ULL, 0xb94470938fa89bcfULL, 0x8a08f0f8bf0f156bULL,
+			0xcdb02555653131b6ULL, 0x993fe2c6d07b7facULL, 0xe45c10c42a2b3b06ULL,
+			0xaa242499697392d3ULL, 0xfd87b5f28300ca0eULL, 0xbce5086492111aebULL,
+			0x8cbccc096f5088ccULL, 0xd1b71758e219652cULL, 0x9c40000000000000ULL,
+			0xe8d4a51000000000ULL, 0xad78ebc5ac620000ULL, 0x813f3978f8940984ULL,
+			0xc097ce7bc90715b3ULL, 0x8f7e32ce7bea5c70ULL, 0xd5d238a4abe98068ULL,
+			0x9f4f2726179a2245ULL, 0xed63a231d4c4fb27ULL, 0xb0de65388cc8ada8ULL,
+			0x83c7088e1aab65dbULL, 0xc45d1df942711d9aULL, 0x924d692ca61be758ULL,
+			0xda01ee641a708deaULL, 0xa26da3999aef774aULL, 0xf209787bb47d6b85ULL,
+			0xb454e4a179dd1877ULL, 0x865b86925b9bc5c2ULL, 0xc83553c5c8965d3dULL,
+			0x952ab45cfa97a0b3ULL, 0xde469fbd99a05fe3ULL, 0xa59bc234db398c25ULL,
+			0xf6c69a72a3989f5cULL, 0xb7dcbf5354e9beceULL, 0x88fcf317f22241e2ULL,
+			0xcc20ce9bd35c78a5ULL, 0x98165af37b2153dfULL, 0xe2a0b5dc971f303aULL,
+			0xa8d9d1535ce3b396ULL, 0xfb9b7cd9a4a7443cULL, 0xbb764c4ca7a44410ULL,
+			0x8bab8eefb6409c1aULL, 0xd01fef10a657842cULL, 0x9b10a4e5e9913129ULL,
+			0xe7109bfba19c0c9dULL, 0xac2820d9623bf429ULL, 0x80444b5e7aa7cf85ULL,
+			0xbf21e44003acdd2dULL, 0x8e679c2f5e44ff8fULL, 0xd433179d9c8cb841ULL,
+			0x9e19db92b4e31ba9ULL, 0xeb96bf6ebadf77d9ULL, 0xaf87023b9bf0ee6bULL
+		};
+		static const short powers_e[] = {
+			-1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+			-954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+			-688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+			-422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+			-157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+			109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+			375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+			641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+			907, 933, 960, 986, 1013, 1039, 1066
+		};
+
+		double dk = (-61 - e) * 0.30102999566398114 + 347;
+		int k = (int)dk;
+		if(dk - k > 0.0)
+			k++;
+		unsigned int index = (unsigned int)((k >> 3) + 1);
+		K = -(-348 + (int)(index << 3));
+		return DiyFp(powers_f[index], powers_e[index]);
+	}
+
+	static void grisu2(double value, char* buffer, int& length, int& K)
+	{
+		const DiyFp v(value);
+		//boundaries m- and m+ of the rounding interval of v
+		DiyFp plus = DiyFp((v.f << 1) + 1, v.e - 1).normalize(1);
+		DiyFp minus = (v.f == HIDDEN_BIT) ? DiyFp((v.f << 2) - 1, v.e - 2) : DiyFp((v.f << 1) - 1, v.e - 1);
+		minus.f <<= minus.e - plus.e;
+		minus.e = plus.e;
+
+		const DiyFp c_mk = cached_power(plus.e, K);
+		const DiyFp W = v.normalize(0) * c_mk;
+		DiyFp Wp = plus * c_mk;
+		DiyFp Wm = minus * c_mk;
+		Wm.f++;
+		Wp.f--;
+		digit_gen(W, Wp, Wp.f - Wm.f, buffer, length, K);
+	}
+
+	static void round_weed(char* buffer, int length, boost::uint64_t delta, boost::uint64_t rest,
+		boost::uint64_t ten_kappa, boost::uint64_t wp_w)
+	{
+		while(rest < wp_w && delta - rest >= ten_kappa &&
+			(rest + ten_kappa < wp_w || wp_w - rest > rest + ten_kappa - wp_w))
+		{
+			buffer[length - 1]--;
+			rest += ten_kappa;
+		}
+	}
+
+	static void digit_gen(const DiyFp& W, const DiyFp& Mp, boost::uint64_t delta, char* buffer, int& length, int& K)
+	{
+		static const unsigned int pow10[] = {
+			1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+		const DiyFp one((boost::uint64_t)1 << -Mp.e, Mp.e);
+		const DiyFp wp_w = Mp - W;
+		unsigned int p1 = (unsigned int)(Mp.f >> -one.e);
+		boost::uint64_t p2 = Mp.f & (one.f - 1);
+
+		int kappa = 1;
+		while(kappa < 10 && p1 >= pow10[kappa])
+			kappa++;
+
+		//integral part
+		length = 0;
+		while(kappa > 0)
+		{
+			unsigned int d = p1 / pow10[kappa - 1];
+			p1 %= pow10[kappa - 1];
+			if(d || length)
+				buffer[length++] = (char)('0' + d);
+			kappa--;
+			boost::uint64_t rest = ((boost::uint64_t)p1 << -one.e) + p2;
+			if(rest <= delta)
+			{
+				K += kappa;
+				round_weed(buffer, length, delta, rest, (boost::uint64_t)pow10[kappa] << -one.e, wp_w.f);
+				return;
+			}
+		}
+
+		//fractional part
+		for(;;)
+		{
+			p2 *= 10;
+			delta *= 10;
+			char d = (char)(p2 >> -one.e);
+			if(d || length)
+				buffer[length++] = (char)('0' + d);
+			p2 &= one.f - 1;
+			kappa--;
+			if(p2 < delta)
+			{
+				K += kappa;
+				int index = -kappa;
+				round_weed(buffer, length, delta, p2, one.f, wp_w.f * (index < 10 ? pow10[index] : 0));
+				return;
+			}
+		}
+	}
+
+	//digits[0,length) * 10^k as decimal text
+	static char* prettify(char* buffer, int length, int k)
+	{
+		const int kk = length + k; //10^(kk-1) <= v < 10^kk
+		if(k >= 0 && kk <= 21)
+		{
+			//1234e3 -> 1234000
+			for(int i = length; i < kk; i++)
+				buffer[i] = '0';
+			return buffer + kk;
+		}
+		if(kk > 0 && kk <= 21)
+		{
+			//1234e-2 -> 12.34
+			memmove(buffer + kk + 1, buffer + kk, length - kk);
+			buffer[kk] = '.';
+			return buffer + length + 1;
+		}
+		if(kk > -5 && kk <= 0)
+		{
+			//1234e-6 -> 0.001234
+			const int offset = 2 - kk;
+			memmove(buffer + offset, buffer, length);
+			buffer[0] = '0';
+			buffer[1] = '.';
+			for(int i = 2; i < offset; i++)
+				buffer[i] = '0';
+			return buffer + length + offset;
+		}
+		if(length == 1)
+		{
+			//1e30
+			buffer[1] = 'e';
+			return format_int(kk - 1, buffer + 2);
+		}
+		//1234e30 -> 1.234e33
+		memmove(buffer + 2, buffer + 1, length - 1);
+		buffer[1] = '.';
+		buffer[length + 1] = 'e';
+		return format_int(kk - 1, buffer + length + 2);
+	}
+};
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include "config.h"
+#include <cstdlib>
+#include <cstring>
+
+//locale free number scanners working on [p,end) character ranges,
+//all of them advance p past what they consumed
+class NumParse
+{
+private:
+	NumParse();
+	~NumParse();
+
+public:
+	static bool is_space(char c) { return c == ' ' || c == '\t'; }
+	static bool is_eol(char c) { return c == '\n' || c == '\r'; }
+	static bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+	static void skip_spaces(const char*& p, const char* end)
+	{
+		while(p < end && is_space(*p))
+			p++;
+	}
+
+	//skip spaces, tabs and line breaks
+	static void skip_blanks(const char*& p, const char* end)
+	{
+		while(p < end && (is_space(*p) || is_eol(*p)))
+			p++;
+	}
+
+	//move p to the first character of the next line
+	static void skip_line(const char*& p, const char* end)
+	{
+		const char* eol = (const char*)memchr(p, '\n', end - p);
+		p = eol ? eol + 1 : end;
+	}
+
+	//skip the rest of a token (anything up to a blank)
+	static void skip_token(const char*& p, const char* end)
+	{
+		while(p < end && !is_space(*p) && !is_eol(*p))
+			p++;
+	}
+
+	static bool parse_int(const char*& p, const char* end, int& value)
+	{
+		const char* q = p;
+		bool neg = false;
+		if(q < end && (*q == '-' || *q == '+'))
+			neg = (*q++ == '-');
+		if(q >= end || !is_digit(*q))
+			return false;
+		int v = 0;
+		while(q < end && is_digit(*q))
+			v = 10 * v + (*q++ - '0');
+		value = neg ? -v : v;
+		p = q;
+		return true;
+	}
+
+	//decimal and scientific notation. mantissas of up to 19 digits with a
+	//small exponent are converted exactly (the value is a product of two
+	//exactly representable doubles), everything else goes through strtod
+	static bool parse_double(const char*& p, const char* end, double& value)
+	{
+		const char* start = p;
+		const char* q = p;
+		bool neg = false;
+		if(q < end && (*q == '-' || *q == '+'))
+			neg = (*q++ == '-');
+
+		unsigned long long mantissa = 0;
+		int nb_digits = 0;
+		int exponent = 0;
+		bool any_digit = false;
+		while(q < end && is_digit(*q))
+		{
+			if(nb_digits < 19)
+			{
+				mantissa = 10 * mantissa + (*q - '0');
+				if(mantissa != 0)
+					nb_digits++;
+			}
+			else
+				exponent++;
+			any_digit = true;
+			q++;
+		}
+		if(q < end && *q == '.')
+		{
+			q++;
+			while(q < end && is_digit(*q))
+			{
+				if(nb_digits < 19)
+				{
+					mantissa = 10 * mantissa + (*q - '0');
+					if(mantissa != 0)
+						nb_digits++;
+					exponent--;
+				}
+				any_digit = true;
+				q++;
+			}
+		}
+		if(!any_digit)
+			return parse_double_slow(p, end, value);
+		if(q < end && (*q == 'e' || *q == 'E'))
+		{
+			const char* e = q + 1;
+			int exp10 = 0;
+			if(parse_int(e, end, exp10))
+			{
+				exponent += exp10;
+				q = e;
+			}
+		}
+
+		static const double pow10[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+			1e21, 1e22 };
+		// 2^53: larger mantissas are not exact doubles
+		if(mantissa > 9007199254740992ULL || exponent < -22 || exponent > 22)
+		{
+			p = start;
+			return parse_double_slow(p, end, value);
+		}
+
+		double v = (double)mantissa;
+		if(exponent < 0)
+			v /= pow10[-exponent];
+		else
+			v *= pow10[exponent];
+		value = neg ? -v : v;
+		p = q;
+		return true;
+	}
+
+	static bool parse_float(const char*& p, const char* end, float& value)
+	{
+		double v;
+		if(!parse_double(p, end, v))
+			return false;
+		value = (float)v;
+		return true;
+	}
+
+private:
+	//strtod needs a terminated string, copy the token first
+	static bool parse_double_slow(const char*& p, const char* end, double& value)
+	{
+		char buffer[128];
+		size_t n = 0;
+		while(p + n < end && n + 1 < sizeof(buffer) && !is_space(p[n]) && !is_eol(p[n]))
+		{
+			buffer[n] = p[n];
+			n++;
+		}
+		buffer[n] = '\0';
+		char* stop = NULL;
+		value = strtod(buffer, &stop);
+		if(stop == buffer)
+			return false;
+		p += (stop - buffer);
+		return true;
+	}
+};
+
+#endif
@@ -0,0 +1,116 @@
+#ifndef PARALLELUTILS_H
+#define PARALLELUTILS_H
+
+#include "config.h"
+#include <vector>
+#include <algorithm>
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+#include <boost/ref.hpp>
+
+class ParallelUtils
+{
+private:
+	ParallelUtils();
+	~ParallelUtils();
+
+public:
+	//the number of worker threads used by the parallel helpers,
+	//0 means one thread per hardware core
+	static void set_nb_threads(unsigned int n)
+	{
+		max_threads() = n;
+	}
+
+	static unsigned int nb_threads()
+	{
+		unsigned int n = max_threads();
+		if(n == 0)
+			n = boost::thread::hardware_concurrency();
+		if(n == 0)
+			n = 1;
+		return n;
+	}
+
+	//split [begin,end) into at most nb_threads() contiguous ranges of at
+	//least 'grain' items and call f(range_begin, range_end, range_index)
+	//for each one, the caller thread runs the last range itself.
+	//the functor is copied once per range, so per-range state is private.
+	template <class Functor>
+	static void parallel_for(size_t begin, size_t end, Functor f, size_t grain = 1024)
+	{
+		if(end <= begin)
+			return;
+
+		size_t nb = nb_ranges(end - begin, grain);
+		if(nb == 1)
+		{
+			f(begin, end, 0);
+			return;
+		}
+
+		size_t step = (end - begin + nb - 1) / nb;
+		boost::thread_group threads;
+		for(size_t i = 0; i + 1 < nb; i++)
+		{
+			size_t b = begin + i * step;
+			size_t e = std::min(end, b + step);
+			threads.create_thread(boost::bind<void>(f, b, e, i));
+		}
+		f(begin + (nb - 1) * step, end, nb - 1);
+		threads.join_all();
+	}
+
+	//call f(i) for every i in [0,nb_tasks), one thread per task
+	//and at most nb_threads() tasks in flight
+	template <class Functor>
+	static void parallel_tasks(size_t nb_tasks, Functor f)
+	{
+		size_t nb = std::max<size_t>(1, nb_threads());
+		for(size_t first = 0; first < nb_tasks; first += nb)
+		{
+			size_t last = std::min(nb_tasks, first + nb);
+			boost::thread_group threads;
+			for(size_t i = first; i + 1 < last; i++)
+				threads.create_thread(boost::bind<void>(f, i));
+			f(last - 1);
+			threads.join_all();
+		}
+	}
+
+	//number of ranges parallel_for() uses for 'count' items
+	static size_t nb_ranges(size_t count, size_t grain = 1024)
+	{
+		if(grain == 0)
+			grain = 1;
+		size_t nb = std::min<size_t>(nb_threads(), (count + grain - 1) / grain);
+		if(nb <= 1)
+			return 1;
+		//ranges of ceil(count/nb) items may cover count with fewer ranges
+		size_t step = (count + nb - 1) / nb;
+		return (count + step - 1) / step;
+	}
+
+	//exclusive prefix sum in place, returns the total
+	template <class T>
+	static T prefix_sum(std::vector<T>& values)
+	{
+		T sum = 0;
+		for(size_t i = 0; i < values.size(); i++)
+		{
+			T v = values[i];
+			values[i] = sum;
+			sum += v;
+		}
+		return sum;
+	}
+
+private:
+	static unsigned int& max_threads()
+	{
+		static unsigned int n = 0;
+		return n;
+	}
+};
+
+#endif
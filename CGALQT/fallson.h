@@ -3,6 +3,7 @@
 
 #include "config.h"
 #include "Enriched_polyhedron.h"
+#include "mesh_property.h"
 #include <CGAL/Taucs_solver_traits.h>
 using namespace CGAL;
 
@@ -25,7 +26,9 @@ class CSubdivider_fallson
 	typedef typename Polyhedron::Halfedge_around_vertex_circulator        HV_circulator;
 	typedef typename Polyhedron::Halfedge_around_facet_circulator         HF_circulator;
 
-	typedef typename Vertex::Normal_3                                     Laplacian_Coord;
+	// the laplacians are kept in double, by vertex tag
+	typedef Vector                                                        Laplacian_Coord;
+	typedef Property_map<Laplacian_Coord>                                 Laplacian_map;
 
 public:
 	CSubdivider_fallson() {}
@@ -84,9 +87,13 @@ public:
 
 	void subdivide(Polyhedron& P)
 	{
+		// the vertex tags index the properties
 		P.set_index_vertices();
-		compute_laplacian(P);
-		create_center_vertex(P);
+		Property_container vertex_properties;
+		vertex_properties.resize(P.size_of_vertices());
+		Laplacian_map laps = vertex_properties.add("lap",Laplacian_Coord(CGAL::NULL_VECTOR));
+		compute_laplacian(P,laps);
+		create_center_vertex(P,vertex_properties,laps);
 
 		std::size_t vsize = P.size_of_vertices();
 		Vertex_iterator last_v = P.vertices_end();
@@ -98,12 +105,14 @@ public:
 		CGAL_postcondition( P.is_valid());
 	}
 
-	void compute_laplacian(Polyhedron& P)
+	void compute_laplacian(Polyhedron& P, Laplacian_map laps)
 	{
-		std::for_each(P.vertices_begin(),P.vertices_end(),ComputeLap());
+		ComputeLap compute;
+		compute.laps = laps;
+		std::for_each(P.vertices_begin(),P.vertices_end(),compute);
 	}
 
-	void create_center_vertex(Polyhedron& P)
+	void create_center_vertex(Polyhedron& P, Property_container& vertex_properties, Laplacian_map laps)
 	{
 		Facet_iterator last_f = P.facets_end();
 		--last_f;
@@ -116,7 +125,7 @@ public:
 			HF_circulator h = f->facet_begin();
 			do {
 				Vertex_handle v = h->vertex();
-				lap = lap + ( v->lap() );
+				lap = lap + laps[v->tag()];
 				vec = vec + ( h->vertex()->point() - CGAL::ORIGIN);
 				++ order;
 			} while ( ++h != f->facet_begin());
@@ -125,13 +134,16 @@ public:
 			Laplacian_Coord center_lap = lap/(FT)order;
 			Halfedge_handle new_center = P.create_center_vertex( f->halfedge());
 			new_center->vertex()->point() = center;
-			new_center->vertex()->tag() = -1;
-			new_center->vertex()->lap() = center_lap;
+			int tag = (int)vertex_properties.push_back();
+			new_center->vertex()->tag() = tag;
+			laps[tag] = center_lap;
 		}while(f++ != last_f);
 	}
 
 	struct ComputeLap
 	{
+		Laplacian_map laps;
+
 		void operator()( Vertex& v )
 		{
 			std::size_t degree = CGAL::circulator_size(v.vertex_begin());
@@ -142,7 +154,7 @@ public:
 				lap = lap + ( nv->point() - v.point());
 				++ h;
 			} while ( h != v.vertex_begin());
-			v.lap() = lap/(FT)degree;
+			laps[v.tag()] = lap/(FT)degree;
 		}
 	};
 